@@ -0,0 +1,262 @@
+#include "ashtakavargacalculator.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Astro;
+
+namespace {
+
+// Build a 12-bit mask from 1-based house numbers counted from a contributor
+template <typename... Houses>
+constexpr quint16 places(Houses... houses) {
+    return static_cast<quint16>(((1u << (houses - 1)) | ... | 0u));
+}
+
+constexpr int popcount12(quint16 mask) {
+    int count = 0;
+    for (int bit = 0; bit < SignCount; ++bit) count += (mask >> bit) & 1;
+    return count;
+}
+
+// Benefic places (Parashara) for each chart [row] from each contributor
+// [column], both in the order Sun..Saturn, Ascendant
+constexpr quint16 beneficPlaces[8][8] = {
+    {   // Sun
+        places(1, 2, 4, 7, 8, 9, 10, 11),
+        places(3, 6, 10, 11),
+        places(1, 2, 4, 7, 8, 9, 10, 11),
+        places(3, 5, 6, 9, 10, 11, 12),
+        places(5, 6, 9, 11),
+        places(6, 7, 12),
+        places(1, 2, 4, 7, 8, 9, 10, 11),
+        places(3, 4, 6, 10, 11, 12)
+    },
+    {   // Moon
+        places(3, 6, 7, 8, 10, 11),
+        places(1, 3, 6, 7, 10, 11),
+        places(2, 3, 5, 6, 9, 10, 11),
+        places(1, 3, 4, 5, 7, 8, 10, 11),
+        places(1, 4, 7, 8, 10, 11, 12),
+        places(3, 4, 5, 7, 9, 10, 11),
+        places(3, 5, 6, 11),
+        places(3, 6, 10, 11)
+    },
+    {   // Mars
+        places(3, 5, 6, 10, 11),
+        places(3, 6, 11),
+        places(1, 2, 4, 7, 8, 10, 11),
+        places(3, 5, 6, 11),
+        places(6, 10, 11, 12),
+        places(6, 8, 11, 12),
+        places(1, 4, 7, 8, 9, 10, 11),
+        places(1, 3, 6, 10, 11)
+    },
+    {   // Mercury
+        places(5, 6, 9, 11, 12),
+        places(2, 4, 6, 8, 10, 11),
+        places(1, 2, 4, 7, 8, 9, 10, 11),
+        places(1, 3, 5, 6, 9, 10, 11, 12),
+        places(6, 8, 11, 12),
+        places(1, 2, 3, 4, 5, 8, 9, 11),
+        places(1, 2, 4, 7, 8, 9, 10, 11),
+        places(1, 2, 4, 6, 8, 10, 11)
+    },
+    {   // Jupiter
+        places(1, 2, 3, 4, 7, 8, 9, 10, 11),
+        places(2, 5, 7, 9, 11),
+        places(1, 2, 4, 7, 8, 10, 11),
+        places(1, 2, 4, 5, 6, 9, 10, 11),
+        places(1, 2, 3, 4, 7, 8, 10, 11),
+        places(2, 5, 6, 9, 10, 11),
+        places(3, 5, 6, 12),
+        places(1, 2, 4, 5, 6, 7, 9, 10, 11)
+    },
+    {   // Venus
+        places(8, 11, 12),
+        places(1, 2, 3, 4, 5, 8, 9, 11, 12),
+        places(3, 5, 6, 9, 11, 12),
+        places(3, 5, 6, 9, 11),
+        places(5, 8, 9, 10, 11),
+        places(1, 2, 3, 4, 5, 8, 9, 10, 11),
+        places(3, 4, 5, 8, 9, 10, 11),
+        places(1, 2, 3, 4, 5, 8, 9, 11)
+    },
+    {   // Saturn
+        places(1, 2, 4, 7, 8, 10, 11),
+        places(3, 6, 11),
+        places(3, 5, 6, 10, 11, 12),
+        places(6, 8, 9, 10, 11, 12),
+        places(5, 6, 11, 12),
+        places(6, 11, 12),
+        places(3, 5, 6, 11),
+        places(1, 3, 4, 6, 10, 11)
+    },
+    {   // Ascendant
+        places(3, 4, 6, 10, 11, 12),
+        places(3, 6, 10, 11, 12),
+        places(1, 3, 6, 10, 11),
+        places(1, 2, 4, 6, 8, 10, 11),
+        places(1, 2, 4, 5, 6, 7, 9, 10, 11),
+        places(1, 2, 3, 4, 5, 8, 9),
+        places(1, 3, 4, 6, 10, 11),
+        places(3, 6, 10, 11)
+    }
+};
+
+constexpr int tableTotal(int chart) {
+    int total = 0;
+    for (int contributor = 0; contributor < 8; ++contributor) {
+        total += popcount12(beneficPlaces[chart][contributor]);
+    }
+    return total;
+}
+
+static_assert(tableTotal(Sun) == 48 && tableTotal(Moon) == 49 &&
+              tableTotal(Mars) == 39 && tableTotal(Mercury) == 54 &&
+              tableTotal(Jupiter) == 56 && tableTotal(Venus) == 52 &&
+              tableTotal(Saturn) == 39,
+              "Bhinnashtakavarga tables must sum to 337 bindus");
+
+// Bit-sliced counters: adds a 12-bit mask to four 12-bit planes so that
+// each sign's count (0-8) is held vertically across the planes
+inline void addToPlanes(quint16 (&planes)[4], quint16 mask) {
+    quint16 carry = mask;
+    for (quint16& plane : planes) {
+        quint16 next = plane & carry;
+        plane ^= carry;
+        carry = next;
+    }
+}
+
+// Fastest geocentric daily motion of each planet in degrees, with a
+// margin; a planet this far from a sign boundary cannot reach it in a day
+constexpr double maxDailyMotion[SevenPlanets] = {
+    1.1, 16.0, 0.9, 2.5, 0.3, 1.35, 0.15
+};
+
+} // namespace
+
+AshtakavargaCalculator::AshtakavargaCalculator() {}
+
+int AshtakavargaCalculator::Ashtakavarga::bhinnaTotal(int chart) const {
+    int total = 0;
+    for (int sign = 0; sign < SignCount; ++sign) total += bhinna[chart][sign];
+    return total;
+}
+
+int AshtakavargaCalculator::Ashtakavarga::sarvaTotal() const {
+    int total = 0;
+    for (int sign = 0; sign < SignCount; ++sign) total += sarva[sign];
+    return total;
+}
+
+quint16 AshtakavargaCalculator::rotateSigns(quint16 mask, int sign) {
+    return static_cast<quint16>(((mask << sign) | (mask >> ((SignCount - sign) % SignCount))) & 0x0FFF);
+}
+
+AshtakavargaCalculator::Ashtakavarga AshtakavargaCalculator::calculate(
+    const QMap<QString, double>& planetPositions, double ascendant) const {
+
+    int signs[ContributorCount];
+    for (int p = 0; p < SevenPlanets; ++p) {
+        if (!planetPositions.contains(planetName(p))) return Ashtakavarga();
+        signs[p] = signOf(planetPositions.value(planetName(p)));
+    }
+    signs[Ascendant] = signOf(ascendant);
+
+    return calculate(signs);
+}
+
+AshtakavargaCalculator::Ashtakavarga AshtakavargaCalculator::calculate(
+    const int (&signs)[ContributorCount]) const {
+
+    Ashtakavarga result;
+
+    for (int chart = 0; chart < ContributorCount; ++chart) {
+        quint16 planes[4] = { 0, 0, 0, 0 };
+        for (int contributor = 0; contributor < ContributorCount; ++contributor) {
+            quint16 mask = rotateSigns(beneficPlaces[chart][contributor],
+                                       signs[contributor]);
+            result.prastara[chart][contributor] = mask;
+            addToPlanes(planes, mask);
+        }
+
+        // Read the vertical counts back out per sign
+        for (int sign = 0; sign < SignCount; ++sign) {
+            result.bhinna[chart][sign] = static_cast<quint8>(
+                ((planes[0] >> sign) & 1) | (((planes[1] >> sign) & 1) << 1) |
+                (((planes[2] >> sign) & 1) << 2) | (((planes[3] >> sign) & 1) << 3));
+        }
+    }
+
+    for (int sign = 0; sign < SignCount; ++sign) {
+        int total = 0;
+        for (int chart = 0; chart < SevenPlanets; ++chart) {
+            total += result.bhinna[chart][sign];
+        }
+        result.sarva[sign] = static_cast<quint8>(total);
+    }
+
+    result.valid = true;
+    return result;
+}
+
+QVector<AshtakavargaCalculator::TransitScore> AshtakavargaCalculator::scoreTransits(
+    const Ashtakavarga& natal, const QVector<TransitDay>& days) const {
+
+    QVector<TransitScore> scores(days.size());
+    if (!natal.valid) return scores;
+
+    // Pack each planet's bindus and the Sarvashtakavarga into one lookup
+    // word per sign so a day is seven table reads
+    quint16 lookup[SevenPlanets][SignCount];
+    for (int p = 0; p < SevenPlanets; ++p) {
+        for (int sign = 0; sign < SignCount; ++sign) {
+            lookup[p][sign] = static_cast<quint16>(natal.bhinna[p][sign] |
+                                                   (natal.sarva[sign] << 4));
+        }
+    }
+
+    const TransitDay* day = days.constData();
+    TransitScore* score = scores.data();
+    for (int d = 0; d < days.size(); ++d, ++day, ++score) {
+        quint16 total = 0;
+        quint8 favourable = 0;
+        for (int p = 0; p < SevenPlanets; ++p) {
+            quint16 entry = lookup[p][day->sign[p] % SignCount];
+            quint8 bindus = entry & 0x0F;
+            score->bindus[p] = bindus;
+            score->sarva[p] = static_cast<quint8>(entry >> 4);
+            total += bindus;
+            favourable |= static_cast<quint8>((bindus >= 4) << p);
+        }
+        score->total = total;
+        score->favourable = favourable;
+    }
+
+    return scores;
+}
+
+QVector<AshtakavargaCalculator::TransitDay> AshtakavargaCalculator::transitDays(
+    const Ephemeris& ephemeris, double startDay, int count) {
+
+    QVector<TransitDay> days(qMax(0, count));
+    for (int p = 0; p < SevenPlanets; ++p) {
+        for (int d = 0; d < days.size();) {
+            const double longitude = normalizeDegrees(ephemeris(p, startDay + d));
+            const int sign = signOf(longitude);
+            // Whole days before the nearest boundary could be reached
+            const double inSign = longitude - sign * 30.0;
+            const double room = std::min(inSign, 30.0 - inSign);
+            const int span = std::max(1, static_cast<int>(std::ceil(room / maxDailyMotion[p])));
+            for (const int end = std::min(days.size(), d + span); d < end; ++d) {
+                days[d].sign[p] = static_cast<quint8>(sign);
+            }
+        }
+    }
+    return days;
+}
+
+QString AshtakavargaCalculator::chartName(int chart) {
+    return chart == Ascendant ? QString("Ascendant") : QString(planetName(chart));
+}
@@ -0,0 +1,73 @@
+#ifndef ASHTAKAVARGACALCULATOR_H
+#define ASHTAKAVARGACALCULATOR_H
+
+#include <QString>
+#include <QMap>
+#include <QVector>
+#include <functional>
+#include "planetdata.h"
+
+class AshtakavargaCalculator {
+public:
+    // Charts and contributors: the seven planets followed by the ascendant
+    enum { Ascendant = Astro::SevenPlanets, ContributorCount = 8 };
+
+    struct Ashtakavarga {
+        // Prastara: for each chart, the 12-bit mask of signs in which each
+        // contributor places a bindu (bit 0 = Aries)
+        quint16 prastara[ContributorCount][ContributorCount];
+        // Bhinnashtakavarga: bindus per sign for each planet and the ascendant
+        quint8 bhinna[ContributorCount][Astro::SignCount];
+        // Sarvashtakavarga: sum of the seven planetary tables (337 in total)
+        quint8 sarva[Astro::SignCount];
+        bool valid;
+
+        Ashtakavarga() : prastara(), bhinna(), sarva(), valid(false) {}
+
+        int bhinnaTotal(int chart) const;
+        int sarvaTotal() const;
+    };
+
+    // Signs occupied by the seven planets on one transit day
+    struct TransitDay {
+        quint8 sign[Astro::SevenPlanets];
+    };
+
+    // Natal bindus met by each transiting planet on one day
+    struct TransitScore {
+        quint8 bindus[Astro::SevenPlanets];   // From the planet's own table
+        quint8 sarva[Astro::SevenPlanets];    // Sarvashtakavarga of the sign
+        quint16 total;                        // Sum of bindus
+        quint8 favourable;                    // Bit per planet with 4+ bindus
+    };
+
+    // Sidereal longitude in degrees of an Astro::Planet at a Julian day (UT)
+    using Ephemeris = std::function<double(int planet, double julianDay)>;
+
+    AshtakavargaCalculator();
+
+    // Calculate from named positions; the ascendant is the 1st cusp
+    Ashtakavarga calculate(const QMap<QString, double>& planetPositions,
+                           double ascendant) const;
+
+    // Calculate from the signs (0-11) of Sun..Saturn and the ascendant
+    Ashtakavarga calculate(const int (&signs)[ContributorCount]) const;
+
+    // Score a run of transit days (typically a year) against natal bindus
+    QVector<TransitScore> scoreTransits(const Ashtakavarga& natal,
+                                        const QVector<TransitDay>& days) const;
+
+    // Signs of the seven planets at startDay and each whole day after it.
+    // A planet is looked up again only once its fastest daily motion could
+    // have taken it out of its sign, so the slow planets cost a few calls
+    // a year.
+    static QVector<TransitDay> transitDays(const Ephemeris& ephemeris, double startDay,
+                                           int count);
+
+    static QString chartName(int chart);
+
+private:
+    static quint16 rotateSigns(quint16 mask, int sign);
+};
+
+#endif // ASHTAKAVARGACALCULATOR_H
@@ -0,0 +1,354 @@
+#include "ashtakootamatcher.h"
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+using namespace Astro;
+
+namespace {
+
+constexpr int PadaCount = AshtakootaMatcher::PADA_COUNT;
+
+// Varna rank of each sign by element: fire Kshatriya, earth Vaishya,
+// air Shudra, water Brahmin
+constexpr int varnaRank[4] = { 3, 2, 1, 4 };
+
+// Vashya groups
+enum { Chatushpada, Manava, Jalachara, Vanachara, Keeta };
+
+// Group of each sign's first and second half. Sagittarius and Capricorn
+// change group at 15 degrees.
+constexpr int vashyaGroup[SignCount][2] = {
+    { Chatushpada, Chatushpada }, { Chatushpada, Chatushpada }, { Manava, Manava },
+    { Jalachara, Jalachara }, { Vanachara, Vanachara }, { Manava, Manava },
+    { Manava, Manava }, { Keeta, Keeta }, { Manava, Chatushpada },
+    { Chatushpada, Jalachara }, { Manava, Manava }, { Jalachara, Jalachara }
+};
+
+// Half-points, groom's group by bride's
+constexpr quint8 vashyaScore[5][5] = {
+    { 4, 2, 2, 1, 2 },
+    { 2, 4, 1, 0, 2 },
+    { 2, 1, 4, 2, 2 },
+    { 0, 0, 2, 4, 0 },
+    { 2, 2, 2, 0, 4 }
+};
+
+// Yoni animal of each nakshatra: horse, elephant, sheep, serpent, dog, cat,
+// rat, cow, buffalo, tiger, deer, monkey, mongoose, lion
+constexpr int nakshatraYoni[27] = {
+    0, 1, 2, 3, 3, 4, 5, 2, 5, 6, 6, 7, 8, 9, 8, 9, 10, 10, 4, 11, 12, 11, 13, 0, 13, 7, 1
+};
+
+// Points (0-4); sworn enemies score nothing
+constexpr quint8 yoniScore[14][14] = {
+    { 4, 2, 2, 3, 2, 2, 2, 1, 0, 1, 3, 3, 2, 1 },
+    { 2, 4, 3, 3, 2, 2, 2, 2, 3, 1, 2, 3, 2, 0 },
+    { 2, 3, 4, 2, 1, 2, 1, 3, 3, 1, 2, 0, 3, 1 },
+    { 3, 3, 2, 4, 2, 1, 1, 1, 1, 2, 2, 2, 0, 2 },
+    { 2, 2, 1, 2, 4, 2, 1, 2, 2, 1, 0, 2, 1, 1 },
+    { 2, 2, 2, 1, 2, 4, 0, 2, 2, 1, 3, 3, 2, 1 },
+    { 2, 2, 1, 1, 1, 0, 4, 2, 2, 2, 2, 2, 1, 2 },
+    { 1, 2, 3, 1, 2, 2, 2, 4, 3, 0, 3, 2, 2, 1 },
+    { 0, 3, 3, 1, 2, 2, 2, 3, 4, 1, 2, 2, 2, 1 },
+    { 1, 1, 1, 2, 1, 1, 2, 0, 1, 4, 1, 1, 2, 1 },
+    { 3, 2, 2, 2, 0, 3, 2, 3, 2, 1, 4, 2, 2, 1 },
+    { 3, 3, 0, 2, 2, 3, 2, 2, 2, 1, 2, 4, 3, 2 },
+    { 2, 2, 3, 0, 1, 2, 1, 2, 2, 2, 2, 3, 4, 2 },
+    { 1, 0, 1, 2, 1, 1, 2, 1, 1, 1, 1, 2, 2, 4 }
+};
+
+// Gana of each nakshatra: 0 deva, 1 manushya, 2 rakshasa
+constexpr int nakshatraGana[27] = {
+    0, 1, 2, 1, 0, 1, 0, 0, 2, 2, 1, 1, 0, 2, 0, 2, 0, 2, 2, 1, 1, 0, 2, 2, 1, 1, 0
+};
+
+// Half-points, groom's gana by bride's
+constexpr quint8 ganaScore[3][3] = {
+    { 12, 12, 2 },
+    { 10, 12, 0 },
+    { 2, 0, 12 }
+};
+
+// Nadi runs adi, madhya, antya, antya, madhya, adi over each six nakshatras
+constexpr int nadiPattern[6] = { 0, 1, 2, 2, 1, 0 };
+
+quint8 kootaHalfPoints(int koota, int groomPada, int bridePada) {
+    const int groomStar = groomPada / 4;
+    const int brideStar = bridePada / 4;
+    const int groomSign = groomPada / 9;
+    const int brideSign = bridePada / 9;
+
+    switch (koota) {
+        case AshtakootaMatcher::Varna:
+            return varnaRank[groomSign % 4] >= varnaRank[brideSign % 4] ? 2 : 0;
+        case AshtakootaMatcher::Vashya:
+            // A pada belongs to the half of the sign it starts in
+            return vashyaScore[vashyaGroup[groomSign][groomPada % 9 > 4]]
+                              [vashyaGroup[brideSign][bridePada % 9 > 4]];
+        case AshtakootaMatcher::Tara: {
+            // Counted both ways; the 3rd, 5th and 7th taras are unfavourable
+            auto favourable = [](int from, int to) {
+                const int tara = (to - from + 27) % 27 % 9 + 1;
+                return tara != 3 && tara != 5 && tara != 7;
+            };
+            return (favourable(brideStar, groomStar) ? 3 : 0) +
+                   (favourable(groomStar, brideStar) ? 3 : 0);
+        }
+        case AshtakootaMatcher::Yoni:
+            return 2 * yoniScore[nakshatraYoni[groomStar]][nakshatraYoni[brideStar]];
+        case AshtakootaMatcher::GrahaMaitri: {
+            const int groomLord = signLord[groomSign];
+            const int brideLord = signLord[brideSign];
+            if (groomLord == brideLord) return 10;
+            const int relation[2] = { naturalRelation[groomLord][brideLord],
+                                      naturalRelation[brideLord][groomLord] };
+            const int friends = (relation[0] > 0) + (relation[1] > 0);
+            const int enemies = (relation[0] < 0) + (relation[1] < 0);
+            if (enemies == 0) return 6 + 2 * friends;     // 6, 8 or 10
+            if (enemies == 2) return 0;
+            return friends ? 2 : 1;
+        }
+        case AshtakootaMatcher::Gana:
+            return ganaScore[nakshatraGana[groomStar]][nakshatraGana[brideStar]];
+        case AshtakootaMatcher::Bhakoot: {
+            // 2/12, 5/9 and 6/8 sign placements from each other score nothing
+            const int distance = (groomSign - brideSign + 12) % 12 + 1;
+            const bool dosha = distance == 2 || distance == 12 || distance == 5 ||
+                               distance == 9 || distance == 6 || distance == 8;
+            return dosha ? 0 : 14;
+        }
+        case AshtakootaMatcher::Nadi:
+            return nadiPattern[groomStar % 6] != nadiPattern[brideStar % 6] ? 16 : 0;
+        default:
+            return 0;
+    }
+}
+
+// Total half-points of every groom pada by every bride pada
+struct ScoreTable {
+    quint8 halfPoints[PadaCount][PadaCount];
+
+    ScoreTable() {
+        for (int groom = 0; groom < PadaCount; ++groom) {
+            for (int bride = 0; bride < PadaCount; ++bride) {
+                int total = 0;
+                for (int koota = 0; koota < AshtakootaMatcher::KootaCount; ++koota) {
+                    total += kootaHalfPoints(koota, groom, bride);
+                }
+                halfPoints[groom][bride] = static_cast<quint8>(total);
+            }
+        }
+    }
+};
+
+const ScoreTable& scoreTable() {
+    static const ScoreTable table;
+    return table;
+}
+
+// The seeker's scores by candidate pada, plus one so that zero means "no
+// match" (NO_MOON and the padding). Indexed by any byte.
+struct SeekerRow {
+    alignas(16) quint8 encoded[256];
+};
+
+// Heap order that puts the worst kept match on top: fewer points, then the
+// later candidate
+inline bool better(const AshtakootaMatcher::Match& a, const AshtakootaMatcher::Match& b) {
+    return a.halfPoints > b.halfPoints ||
+           (a.halfPoints == b.halfPoints && a.candidate < b.candidate);
+}
+
+void scanRange(const SeekerRow& row, const quint8* padas, int begin, int end, int k,
+               QVector<AshtakootaMatcher::Match>& out) {
+    std::vector<AshtakootaMatcher::Match> heap;
+    heap.reserve(k);
+    // Encoded scores above the threshold enter the heap. Candidates come in
+    // pool order, so an equal score never displaces a kept one.
+    int threshold = 0;
+    auto offer = [&](int candidate, int encoded) {
+        const AshtakootaMatcher::Match match = { quint32(candidate), quint8(encoded - 1) };
+        if (int(heap.size()) < k) {
+            heap.push_back(match);
+            std::push_heap(heap.begin(), heap.end(), better);
+        } else {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = match;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+        if (int(heap.size()) == k) threshold = heap.front().halfPoints + 1;
+    };
+
+    int i = begin;
+#if defined(__SSE2__)
+    alignas(16) quint8 scores[16];
+#if defined(__SSSE3__)
+    __m128i chunks[7];
+    for (int c = 0; c < 7; ++c) {
+        chunks[c] = _mm_load_si128(reinterpret_cast<const __m128i*>(row.encoded) + c);
+    }
+    const __m128i sixteen = _mm_set1_epi8(16);
+#endif
+    for (; i + 16 <= end; i += 16) {
+        const quint8* block = padas + i;
+#if defined(__SSSE3__)
+        // Seven 16-byte pieces of the row; each shuffle fills the lanes
+        // whose pada falls in its piece. Bytes with the top bit set
+        // (NO_MOON, or below the piece) shuffle to zero.
+        __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+        __m128i score = _mm_setzero_si128();
+        for (int c = 0; c < 7; ++c) {
+            const __m128i inPiece = _mm_cmplt_epi8(index, sixteen);
+            score = _mm_or_si128(score, _mm_and_si128(inPiece, _mm_shuffle_epi8(chunks[c], index)));
+            index = _mm_sub_epi8(index, sixteen);
+        }
+#else
+        for (int lane = 0; lane < 16; ++lane) {
+            scores[lane] = row.encoded[block[lane]];
+        }
+        const __m128i score = _mm_load_si128(reinterpret_cast<const __m128i*>(scores));
+#endif
+        // Scores stay below 128, so the signed compare is exact
+        int mask = _mm_movemask_epi8(_mm_cmpgt_epi8(score, _mm_set1_epi8(char(threshold))));
+        if (!mask) continue;
+#if defined(__SSSE3__)
+        _mm_store_si128(reinterpret_cast<__m128i*>(scores), score);
+#endif
+        for (; mask; mask &= mask - 1) {
+            const int lane = qCountTrailingZeroBits(quint32(mask));
+            if (scores[lane] > threshold) offer(i + lane, scores[lane]);
+        }
+    }
+#endif
+    for (; i < end; ++i) {
+        const int encoded = row.encoded[padas[i]];
+        if (encoded > threshold) offer(i, encoded);
+    }
+
+    out.reserve(int(heap.size()));
+    for (const AshtakootaMatcher::Match& match : heap) out.append(match);
+}
+
+class ScanTask : public QRunnable {
+public:
+    ScanTask(const SeekerRow& row, const quint8* padas, int begin, int end, int k,
+             QVector<AshtakootaMatcher::Match>* out, QSemaphore* done)
+        : m_row(row), m_padas(padas), m_begin(begin), m_end(end), m_k(k),
+          m_out(out), m_done(done) {}
+
+    void run() override {
+        scanRange(m_row, m_padas, m_begin, m_end, m_k, *m_out);
+        m_done->release();
+    }
+
+private:
+    const SeekerRow& m_row;
+    const quint8* m_padas;
+    int m_begin;
+    int m_end;
+    int m_k;
+    QVector<AshtakootaMatcher::Match>* m_out;
+    QSemaphore* m_done;
+};
+
+} // namespace
+
+AshtakootaPool::AshtakootaPool() {}
+
+void AshtakootaPool::reserve(int count) {
+    m_padas.reserve(count);
+}
+
+void AshtakootaPool::append(double moonLongitude) {
+    m_padas.append(static_cast<quint8>(AshtakootaMatcher::padaOf(moonLongitude)));
+}
+
+void AshtakootaPool::appendPada(quint8 pada) {
+    m_padas.append(pada < PadaCount ? pada : NO_MOON);
+}
+
+void AshtakootaPool::clear() {
+    m_padas.clear();
+}
+
+int AshtakootaMatcher::Breakdown::total() const {
+    int sum = 0;
+    for (int koota = 0; koota < KootaCount; ++koota) sum += halfPoints[koota];
+    return sum;
+}
+
+AshtakootaMatcher::AshtakootaMatcher(int threads) {
+    m_pool.setMaxThreadCount(threads > 0 ? threads : QThread::idealThreadCount());
+    // Queries come in bursts; keep the workers between them
+    m_pool.setExpiryTimeout(-1);
+    scoreTable();
+}
+
+int AshtakootaMatcher::padaOf(double moonLongitude) {
+    return qMin(PadaCount - 1, static_cast<int>(normalizeDegrees(moonLongitude) / (360.0 / PadaCount)));
+}
+
+quint8 AshtakootaMatcher::halfPoints(int groomPada, int bridePada) {
+    return scoreTable().halfPoints[groomPada][bridePada];
+}
+
+AshtakootaMatcher::Breakdown AshtakootaMatcher::breakdown(int groomPada, int bridePada) {
+    Breakdown result;
+    for (int koota = 0; koota < KootaCount; ++koota) {
+        result.halfPoints[koota] = kootaHalfPoints(koota, groomPada, bridePada);
+    }
+    return result;
+}
+
+const char* AshtakootaMatcher::kootaName(int koota) {
+    static const char* const names[KootaCount] = {
+        "Varna", "Vashya", "Tara", "Yoni", "Graha Maitri", "Gana", "Bhakoot", "Nadi"
+    };
+    return (koota >= 0 && koota < KootaCount) ? names[koota] : "";
+}
+
+QVector<AshtakootaMatcher::Match> AshtakootaMatcher::topMatches(int seekerPada, Role role,
+                                                                const AshtakootaPool& pool, int k) {
+    if (k <= 0 || pool.size() == 0 || seekerPada < 0 || seekerPada >= PadaCount) {
+        return QVector<Match>();
+    }
+
+    SeekerRow row;
+    std::memset(row.encoded, 0, sizeof(row.encoded));
+    const ScoreTable& table = scoreTable();
+    for (int pada = 0; pada < PadaCount; ++pada) {
+        row.encoded[pada] = 1 + (role == Groom ? table.halfPoints[seekerPada][pada]
+                                               : table.halfPoints[pada][seekerPada]);
+    }
+
+    // One chunk per thread, none smaller than MIN_CHUNK; the calling
+    // thread scans the first
+    const int chunks = qBound(1, pool.size() / MIN_CHUNK, m_pool.maxThreadCount());
+    QVector<QVector<Match>> partial(chunks);
+    QSemaphore done;
+    for (int c = 1; c < chunks; ++c) {
+        const int begin = int(qint64(pool.size()) * c / chunks);
+        const int end = int(qint64(pool.size()) * (c + 1) / chunks);
+        m_pool.start(new ScanTask(row, pool.padas(), begin, end, k, &partial[c], &done));
+    }
+    scanRange(row, pool.padas(), 0, int(qint64(pool.size()) / chunks), k, partial[0]);
+    done.acquire(chunks - 1);
+
+    QVector<Match> matches;
+    for (const QVector<Match>& part : partial) matches += part;
+    std::sort(matches.begin(), matches.end(), better);
+    if (matches.size() > k) matches.resize(k);
+    return matches;
+}
@@ -0,0 +1,89 @@
+#ifndef ASHTAKOOTAMATCHER_H
+#define ASHTAKOOTAMATCHER_H
+
+#include <QThreadPool>
+#include <QVector>
+#include "planetdata.h"
+
+// Columnar pool of matchmaking profiles: one byte per profile, the pada
+// (0-107) of its Moon. The Moon's pada fixes both its nakshatra and its
+// sign, which is everything the eight kootas look at.
+class AshtakootaPool {
+public:
+    AshtakootaPool();
+
+    void reserve(int count);
+    void append(double moonLongitude);
+    void appendPada(quint8 pada);     // NO_MOON for a profile that never matches
+    void clear();
+
+    int size() const { return m_padas.size(); }
+    const quint8* padas() const { return m_padas.constData(); }
+
+    static constexpr quint8 NO_MOON = 0xFF;
+
+private:
+    QVector<quint8> m_padas;
+};
+
+// Ashtakoota (guna milan) compatibility of one profile against a pool.
+//
+// All eight kootas depend on the two Moon padas alone, so every pairing is
+// precomputed into a 108 x 108 table of half-points (a match is out of 36
+// points, and graha maitri and vashya score halves). A query takes the
+// seeker's row of the table and scans the pool's pada column in blocks of
+// sixteen: scores are looked up with byte shuffles where SSSE3 is
+// available, and an SSE2 compare against the lowest score still in the
+// top K skips whole blocks. Large pools are split across the matcher's
+// threads and the partial top-K lists merged.
+class AshtakootaMatcher {
+public:
+    enum Koota {
+        Varna = 0,      // 1 point
+        Vashya,         // 2
+        Tara,           // 3
+        Yoni,           // 4
+        GrahaMaitri,    // 5
+        Gana,           // 6
+        Bhakoot,        // 7
+        Nadi,           // 8
+        KootaCount
+    };
+
+    // Role of the seeking profile; the pool holds the other side
+    enum Role {
+        Groom,
+        Bride
+    };
+
+    struct Match {
+        quint32 candidate;      // Index into the pool
+        quint8 halfPoints;      // 0-72
+
+        double points() const { return halfPoints / 2.0; }
+    };
+
+    struct Breakdown {
+        quint8 halfPoints[KootaCount];
+        int total() const;
+    };
+
+    explicit AshtakootaMatcher(int threads = 0);   // 0 for one per core
+
+    // Best k candidates by points, ties to the lower pool index
+    QVector<Match> topMatches(int seekerPada, Role role, const AshtakootaPool& pool, int k);
+
+    static int padaOf(double moonLongitude);
+    static quint8 halfPoints(int groomPada, int bridePada);
+    static Breakdown breakdown(int groomPada, int bridePada);
+    static const char* kootaName(int koota);
+
+    static const int PADA_COUNT = 108;
+    static const int MAX_HALF_POINTS = 72;
+    static const int MIN_CHUNK = 1 << 16;   // Candidates per thread, at least
+
+private:
+    QThreadPool m_pool;
+};
+
+#endif // ASHTAKOOTAMATCHER_H
@@ -0,0 +1,176 @@
+#include "aspectmatrix.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace Astro;
+
+namespace {
+
+// Aspect angles checked against the orb, and the flag each one sets
+constexpr float aspectAngles[5] = { 0.0f, 60.0f, 90.0f, 120.0f, 180.0f };
+constexpr quint8 aspectBits[5] = {
+    AspectMatrix::Conjunction, AspectMatrix::Sextile, AspectMatrix::Square,
+    AspectMatrix::Trine, AspectMatrix::Opposition
+};
+
+#if defined(__SSE2__)
+// Narrow four 32-bit lanes holding 0-255 to four consecutive bytes
+inline void storeBytes(quint8* dst, __m128i values) {
+    __m128i words = _mm_packs_epi32(values, values);
+    __m128i bytes = _mm_packus_epi16(words, words);
+    int packed = _mm_cvtsi128_si32(bytes);
+    std::memcpy(dst, &packed, sizeof(packed));
+}
+#endif
+
+} // namespace
+
+AspectMatrix::AspectMatrix()
+    : m_count(0), m_stride(0), m_orb(DEFAULT_ORB) {}
+
+void AspectMatrix::clear() {
+    m_count = 0;
+    m_stride = 0;
+    m_names.clear();
+    m_present.clear();
+    m_longitude.clear();
+    m_sign.clear();
+    m_house.clear();
+    m_arc.clear();
+    m_separation.clear();
+    m_signDistance.clear();
+    m_houseDistance.clear();
+    m_flags.clear();
+}
+
+int AspectMatrix::indexOf(const QString& body) const {
+    int planet = planetIndex(body);
+    return planet >= 0 ? planet : m_names.indexOf(body);
+}
+
+void AspectMatrix::build(const QMap<QString, double>& positions,
+                         const QVector<double>& housePositions,
+                         double orb) {
+    clear();
+    if (positions.isEmpty()) return;
+
+    // Grahas first in fixed order, then any additional bodies
+    for (int p = 0; p < PlanetCount; ++p) {
+        m_names.append(planetName(p));
+    }
+    for (auto it = positions.begin(); it != positions.end(); ++it) {
+        if (planetIndex(it.key()) < 0) m_names.append(it.key());
+    }
+
+    m_count = m_names.size();
+    m_stride = (m_count + 3) & ~3;
+    m_orb = orb;
+
+    m_present.fill(0, m_count);
+    m_longitude.fill(0.0f, m_stride);
+    m_sign.fill(0, m_stride);
+    m_house.fill(0, m_stride);
+
+    const bool hasHouses = housePositions.size() >= 12;
+    double cusps[12] = {};
+    for (int i = 0; hasHouses && i < 12; ++i) {
+        cusps[i] = normalizeDegrees(housePositions[i]);
+    }
+
+    for (int i = 0; i < m_count; ++i) {
+        auto it = positions.find(m_names[i]);
+        if (it == positions.end()) continue;
+
+        double lon = normalizeDegrees(it.value());
+        m_present[i] = 1;
+        m_longitude[i] = static_cast<float>(lon);
+        m_sign[i] = signOf(lon);
+        m_house[i] = hasHouses ? houseOf(lon, cusps) - 1 : m_sign[i];
+    }
+
+    const int cells = m_count * m_stride;
+    m_arc.resize(cells);
+    m_separation.resize(cells);
+    m_signDistance.resize(cells);
+    m_houseDistance.resize(cells);
+    m_flags.resize(cells);
+
+    computeRows();
+}
+
+void AspectMatrix::computeRows() {
+    const float orb = static_cast<float>(m_orb);
+    const float* lon = m_longitude.constData();
+    const qint32* signs = m_sign.constData();
+    const qint32* houses = m_house.constData();
+
+    for (int i = 0; i < m_count; ++i) {
+        const float li = lon[i];
+        const qint32 si = signs[i];
+        const qint32 hi = houses[i];
+        float* arcRow = m_arc.data() + i * m_stride;
+        float* sepRow = m_separation.data() + i * m_stride;
+        quint8* signRow = m_signDistance.data() + i * m_stride;
+        quint8* houseRow = m_houseDistance.data() + i * m_stride;
+        quint8* flagRow = m_flags.data() + i * m_stride;
+
+        int j = 0;
+#if defined(__SSE2__)
+        const __m128 vli = _mm_set1_ps(li);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 full = _mm_set1_ps(360.0f);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 vorb = _mm_set1_ps(orb);
+        const __m128i vsi = _mm_set1_epi32(si);
+        const __m128i vhi = _mm_set1_epi32(hi);
+        const __m128i twelve = _mm_set1_epi32(SignCount);
+        const __m128i izero = _mm_setzero_si128();
+
+        for (; j + 4 <= m_stride; j += 4) {
+            // Forward arc folded into 0-360, then the shortest arc
+            __m128 diff = _mm_sub_ps(_mm_loadu_ps(lon + j), vli);
+            __m128 arc = _mm_add_ps(diff, _mm_and_ps(_mm_cmplt_ps(diff, zero), full));
+            __m128 sep = _mm_min_ps(arc, _mm_sub_ps(full, arc));
+            _mm_storeu_ps(arcRow + j, arc);
+            _mm_storeu_ps(sepRow + j, sep);
+
+            __m128i flags = izero;
+            for (int k = 0; k < 5; ++k) {
+                __m128 deviation = _mm_and_ps(_mm_sub_ps(sep, _mm_set1_ps(aspectAngles[k])), absMask);
+                __m128i hit = _mm_castps_si128(_mm_cmple_ps(deviation, vorb));
+                flags = _mm_or_si128(flags, _mm_and_si128(hit, _mm_set1_epi32(aspectBits[k])));
+            }
+            storeBytes(flagRow + j, flags);
+
+            __m128i signDist = _mm_sub_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(signs + j)), vsi);
+            signDist = _mm_add_epi32(signDist, _mm_and_si128(_mm_cmplt_epi32(signDist, izero), twelve));
+            storeBytes(signRow + j, signDist);
+
+            __m128i houseDist = _mm_sub_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(houses + j)), vhi);
+            houseDist = _mm_add_epi32(houseDist, _mm_and_si128(_mm_cmplt_epi32(houseDist, izero), twelve));
+            storeBytes(houseRow + j, houseDist);
+        }
+#endif
+        for (; j < m_stride; ++j) {
+            float diff = lon[j] - li;
+            float arc = diff < 0.0f ? diff + 360.0f : diff;
+            float sep = std::min(arc, 360.0f - arc);
+            arcRow[j] = arc;
+            sepRow[j] = sep;
+
+            quint8 flags = 0;
+            for (int k = 0; k < 5; ++k) {
+                if (std::fabs(sep - aspectAngles[k]) <= orb) flags |= aspectBits[k];
+            }
+            flagRow[j] = flags;
+            signRow[j] = static_cast<quint8>((signs[j] - si + SignCount) % SignCount);
+            houseRow[j] = static_cast<quint8>((houses[j] - hi + SignCount) % SignCount);
+        }
+    }
+}
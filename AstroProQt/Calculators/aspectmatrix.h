@@ -0,0 +1,97 @@
+#ifndef ASPECTMATRIX_H
+#define ASPECTMATRIX_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QVector>
+#include "planetdata.h"
+#include <algorithm>
+
+// Pairwise angular relationships between every body of a chart, built once
+// per chart and shared by the strength, yoga and rendering code.
+//
+// Rows 0-8 are always the nine grahas in Astro::Planet order (absent ones
+// are flagged as such); any further bodies (asteroids, fixed points) follow
+// in name order. Rows are padded to a multiple of four so the kernel can
+// process four columns at a time.
+class AspectMatrix {
+public:
+    enum AspectFlag : quint8 {
+        Conjunction = 1 << 0,
+        Sextile     = 1 << 1,
+        Square      = 1 << 2,
+        Trine       = 1 << 3,
+        Opposition  = 1 << 4,
+        MajorAspects = Sextile | Square | Trine | Opposition
+    };
+
+    AspectMatrix();
+
+    // Build from named positions; houses may be empty (house distance is
+    // then counted in whole signs from Aries)
+    void build(const QMap<QString, double>& positions,
+               const QVector<double>& housePositions,
+               double orb = DEFAULT_ORB);
+
+    void clear();
+    bool isEmpty() const { return m_count == 0; }
+
+    int bodyCount() const { return m_count; }
+    int indexOf(const QString& body) const;
+    QString bodyName(int i) const { return m_names.value(i); }
+    bool contains(int i) const { return i >= 0 && i < m_count && m_present[i]; }
+    double longitude(int i) const { return m_longitude[i]; }
+    int sign(int i) const { return m_sign[i]; }
+    int house(int i) const { return m_house[i] + 1; }   // 1-12
+    double orb() const { return m_orb; }
+
+    // Shortest arc between two bodies (0-180)
+    float separation(int i, int j) const { return m_separation[i * m_stride + j]; }
+    // Forward arc from body i to body j (0-360)
+    float arc(int i, int j) const { return m_arc[i * m_stride + j]; }
+    // Sign / house of j counted from i, 0-based (0 = same, 6 = 7th)
+    int signDistance(int i, int j) const { return m_signDistance[i * m_stride + j]; }
+    int houseDistance(int i, int j) const { return m_houseDistance[i * m_stride + j]; }
+    // AspectFlag bits for aspects within the build orb
+    quint8 flags(int i, int j) const { return m_flags[i * m_stride + j]; }
+
+    bool isConjunct(int i, int j, double orb) const { return separation(i, j) <= orb; }
+    // Shortest arc from one longitude to another (0-360 each), rounded
+    // exactly as build() fills separation()
+    static float shortestArc(double from, double to) {
+        const float diff = static_cast<float>(to) - static_cast<float>(from);
+        const float arc = diff < 0.0f ? diff + 360.0f : diff;
+        return std::min(arc, 360.0f - arc);
+    }
+    bool isInAspect(int i, int j, double angle, double orb) const {
+        return std::fabs(separation(i, j) - angle) <= orb;
+    }
+    // Mutual kendras (1st, 4th, 7th, 10th) counted by sign
+    bool isInKendra(int i, int j) const { return signDistance(i, j) % 3 == 0; }
+
+    static constexpr double DEFAULT_ORB = 6.0;
+
+private:
+    void computeRows();
+
+    int m_count;
+    int m_stride;
+    double m_orb;
+    QStringList m_names;
+    QVector<quint8> m_present;
+
+    // Per-body columns, padded to m_stride
+    QVector<float> m_longitude;
+    QVector<qint32> m_sign;
+    QVector<qint32> m_house;   // 0-based
+
+    // m_count x m_stride matrices
+    QVector<float> m_arc;
+    QVector<float> m_separation;
+    QVector<quint8> m_signDistance;
+    QVector<quint8> m_houseDistance;
+    QVector<quint8> m_flags;
+};
+
+#endif // ASPECTMATRIX_H
@@ -0,0 +1,492 @@
+#include "chartsignature.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace Astro;
+
+namespace {
+
+constexpr int StackDepth = 64;
+
+inline quint16 bit(int n) {
+    return static_cast<quint16>(1u << n);
+}
+
+// Rotates a 12-bit place mask so that place 1 falls on the one-hot sign;
+// zero when the sign word is empty
+inline quint16 rotateToSign(quint16 mask, quint16 sign) {
+    const quint32 product = quint32(mask) * sign;
+    return static_cast<quint16>((product | (product >> 12)) & 0x0FFF);
+}
+
+// Rewrites YogaInstructions in terms of signature word tests. Only the
+// lordship of houses depends on the lagna, so rules over house lords are
+// expanded over the twelve lagna signs.
+class Lowering {
+public:
+    explicit Lowering(QVector<SignatureProgram::Op>& ops) : m_ops(ops), m_depth(0), m_maxDepth(0) {}
+
+    int maxDepth() const { return m_maxDepth; }
+
+    void instruction(const YogaInstruction& in) {
+        const int a = in.a;
+        const int b = in.b;
+
+        switch (in.op) {
+            case YogaInstruction::True:
+                push(SignatureProgram::Op::True);
+                break;
+            case YogaInstruction::InHouse:
+                test(ChartSignature::HouseColumn + a, in.mask);
+                break;
+            case YogaInstruction::InSign:
+                test(ChartSignature::SignColumn + a, in.mask);
+                break;
+            case YogaInstruction::HasDignity: {
+                bool first = true;
+                for (int d = 0; d < ChartFeatures::DignityCount; ++d) {
+                    if (!((in.mask >> d) & 1u)) continue;
+                    test(ChartSignature::dignityColumn(static_cast<quint8>(1u << d)), bit(a));
+                    if (!first) combine(SignatureProgram::Op::Or);
+                    first = false;
+                }
+                if (first) push(SignatureProgram::Op::False);
+                break;
+            }
+            case YogaInstruction::PlaceFrom:
+                placeFrom(a, b, in.mask);
+                break;
+            case YogaInstruction::LordInHouse:
+                test(ChartSignature::LordHouseColumn + a - 1, in.mask);
+                break;
+            case YogaInstruction::LordPlaceFrom:
+                bodyPlaceFrom(ChartSignature::LordColumn + a - 1, b, in.mask);
+                break;
+            case YogaInstruction::DispositorPlaceFrom:
+                bodyPlaceFrom(ChartSignature::DispositorColumn + a, b, in.mask);
+                break;
+            case YogaInstruction::ExaltationLordPlaceFrom:
+                test(ChartSignature::PresentColumn, bit(a));
+                placeFrom(b, signLord[signOf(exaltationLongitude[a])], in.mask);
+                combine(SignatureProgram::Op::And);
+                break;
+            case YogaInstruction::Conjunct:
+                test(ChartSignature::ConjunctColumn + a, bit(b));
+                break;
+            case YogaInstruction::Aspects:
+                place(ChartSignature::SignColumn + b, ChartFeatures::drishtiPlaces(a),
+                      ChartSignature::SignColumn + a);
+                break;
+            case YogaInstruction::OccupiedFrom: {
+                bool first = true;
+                for (int body = 0; body < PlanetCount; ++body) {
+                    if (!((in.mask >> body) & 1u)) continue;
+                    place(ChartSignature::SignColumn + body, bit(b - 1), ChartSignature::SignColumn + a);
+                    if (!first) combine(SignatureProgram::Op::Or);
+                    first = false;
+                }
+                if (first) push(SignatureProgram::Op::False);
+                break;
+            }
+            case YogaInstruction::LordsAssociated:
+                lordsAssociated(in.mask, in.mask2);
+                break;
+            case YogaInstruction::And:
+                combine(SignatureProgram::Op::And);
+                break;
+            case YogaInstruction::Or:
+                combine(SignatureProgram::Op::Or);
+                break;
+            case YogaInstruction::Not:
+                appendOp(SignatureProgram::Op::Not, 0, 0, 0);
+                break;
+        }
+    }
+
+private:
+    void appendOp(quint8 code, int column, int aux, quint16 mask) {
+        m_ops.append({ code, static_cast<quint8>(column), static_cast<quint8>(aux), mask });
+    }
+
+    void push(quint8 code, int column = 0, int aux = 0, quint16 mask = 0) {
+        appendOp(code, column, aux, mask);
+        m_maxDepth = std::max(m_maxDepth, ++m_depth);
+    }
+
+    void test(int column, quint16 mask) {
+        if (mask) {
+            push(SignatureProgram::Op::Test, column, 0, mask);
+        } else {
+            push(SignatureProgram::Op::False);
+        }
+    }
+
+    void place(int column, quint16 places, int signColumn) {
+        if (places) {
+            push(SignatureProgram::Op::Place, column, signColumn, places);
+        } else {
+            push(SignatureProgram::Op::False);
+        }
+    }
+
+    void combine(quint8 code) {
+        appendOp(code, 0, 0, 0);
+        --m_depth;
+    }
+
+    void placeFrom(int from, int body, quint16 places) {
+        if (places == YogaRules::Kendras) {
+            test(ChartSignature::KendraColumn + from, bit(body));
+        } else if (places == YogaRules::Trikonas) {
+            test(ChartSignature::TrikonaColumn + from, bit(body));
+        } else {
+            place(ChartSignature::SignColumn + body, places, ChartSignature::SignColumn + from);
+        }
+    }
+
+    // Placement of whichever planet a one-hot body column names
+    void bodyPlaceFrom(int bodyColumn, int from, quint16 places) {
+        if (places == YogaRules::Kendras) {
+            push(SignatureProgram::Op::Meet, ChartSignature::KendraColumn + from, bodyColumn);
+        } else if (places == YogaRules::Trikonas) {
+            push(SignatureProgram::Op::Meet, ChartSignature::TrikonaColumn + from, bodyColumn);
+        } else {
+            for (int lord = 0; lord < SevenPlanets; ++lord) {
+                test(bodyColumn, bit(lord));
+                placeFrom(from, lord, places);
+                combine(SignatureProgram::Op::And);
+                if (lord > 0) combine(SignatureProgram::Op::Or);
+            }
+        }
+    }
+
+    // OR over the lagna signs of any association between their lords
+    void lordsAssociated(quint16 housesA, quint16 housesB) {
+        for (int lagna = 0; lagna < SignCount; ++lagna) {
+            quint16 lordsA = 0, lordsB = 0;
+            for (int h = 0; h < 12; ++h) {
+                const int lord = signLord[(lagna + h) % SignCount];
+                if ((housesA >> h) & 1u) lordsA |= bit(lord);
+                if ((housesB >> h) & 1u) lordsB |= bit(lord);
+            }
+
+            test(ChartSignature::SignColumn + ChartFeatures::Lagna, bit(lagna));
+            bool first = true;
+            for (int p = 0; p < SevenPlanets; ++p) {
+                if (!((lordsA >> p) & 1u)) continue;
+                test(ChartSignature::AssociatedColumn + p, lordsB & ~bit(p));
+                if (!first) combine(SignatureProgram::Op::Or);
+                first = false;
+            }
+            if (first) push(SignatureProgram::Op::False);
+            combine(SignatureProgram::Op::And);
+            if (lagna > 0) combine(SignatureProgram::Op::Or);
+        }
+    }
+
+    QVector<SignatureProgram::Op>& m_ops;
+    int m_depth;
+    int m_maxDepth;
+};
+
+// Scalar interpreter; word(column) returns the chart's signature word
+template <typename WordFn>
+bool run(const SignatureProgram::Op* op, const SignatureProgram::Op* end, WordFn word) {
+    quint64 stack = 0;
+    for (; op != end; ++op) {
+        switch (op->code) {
+            case SignatureProgram::Op::Test:
+                stack = (stack << 1) | ((word(op->column) & op->mask) ? 1u : 0u);
+                break;
+            case SignatureProgram::Op::Meet:
+                stack = (stack << 1) | ((word(op->column) & word(op->aux)) ? 1u : 0u);
+                break;
+            case SignatureProgram::Op::Place:
+                stack = (stack << 1) |
+                        ((word(op->column) & rotateToSign(op->mask, word(op->aux))) ? 1u : 0u);
+                break;
+            case SignatureProgram::Op::False:
+                stack <<= 1;
+                break;
+            case SignatureProgram::Op::True:
+                stack = (stack << 1) | 1u;
+                break;
+            case SignatureProgram::Op::And: {
+                const quint64 top = stack & 1u;
+                stack >>= 1;
+                stack = (stack & ~quint64(1)) | (stack & top);
+                break;
+            }
+            case SignatureProgram::Op::Or: {
+                const quint64 top = stack & 1u;
+                stack >>= 1;
+                stack |= top;
+                break;
+            }
+            case SignatureProgram::Op::Not:
+                stack ^= 1u;
+                break;
+        }
+    }
+    return stack & 1u;
+}
+
+} // namespace
+
+ChartSignature ChartSignature::fromFeatures(const ChartFeatures& f) {
+    using namespace YogaRules;
+    ChartSignature s;
+
+    for (int body = 0; body < ChartFeatures::BodyCount; ++body) {
+        if (!f.contains(body)) continue;
+        s.word[SignColumn + body] = bit(f.sign[body]);
+        s.word[HouseColumn + body] = bit(f.house[body] - 1);
+
+        quint16 kendra = 0, trikona = 0;
+        for (int other = 0; other < ChartFeatures::BodyCount; ++other) {
+            if (!f.contains(other)) continue;
+            const quint16 place = bit(f.place(body, other) - 1);
+            if (place & Kendras) kendra |= bit(other);
+            if (place & Trikonas) trikona |= bit(other);
+        }
+        s.word[KendraColumn + body] = kendra;
+        s.word[TrikonaColumn + body] = trikona;
+    }
+
+    for (int h = 1; h <= 12; ++h) {
+        const int lord = f.houseLord[h];
+        if (!f.contains(lord)) continue;
+        s.word[LordHouseColumn + h - 1] = bit(f.house[lord] - 1);
+        s.word[LordColumn + h - 1] = bit(lord);
+    }
+
+    for (int p = 0; p < PlanetCount; ++p) {
+        if (!f.contains(p)) continue;
+        s.word[ConjunctColumn + p] = f.conjunct[p];
+        s.word[OccupantsColumn + f.sign[p]] |= bit(p);
+        if (f.contains(signLord[f.sign[p]])) s.word[DispositorColumn + p] = bit(signLord[f.sign[p]]);
+        for (int d = 0; d < ChartFeatures::DignityCount; ++d) {
+            if (f.dignity[p] & (1u << d)) s.word[OwnColumn + d] |= bit(p);
+        }
+    }
+
+    for (int p = 0; p < SevenPlanets; ++p) {
+        if (!f.contains(p)) continue;
+        for (int q = 0; q < SevenPlanets; ++q) {
+            if (q == p || !f.contains(q)) continue;
+            const bool exchange = signLord[f.sign[p]] == q && signLord[f.sign[q]] == p;
+            if ((f.conjunct[p] & bit(q)) || f.place(p, q) == 7 || exchange) {
+                s.word[AssociatedColumn + p] |= bit(q);
+            }
+        }
+    }
+
+    s.word[PresentColumn] = f.present;
+    return s;
+}
+
+int ChartSignature::dignityColumn(quint8 dignity) {
+    // Dignity bits are laid out in ChartFeatures::Dignity order from Own
+    int index = 0;
+    while (index < ChartFeatures::DignityCount && !(dignity & (1u << index))) ++index;
+    return OwnColumn + index;
+}
+
+SignatureBatch::SignatureBatch() : m_count(0), m_stride(0) {}
+
+void SignatureBatch::reserve(int count) {
+    if (count > m_stride) grow(count);
+}
+
+void SignatureBatch::grow(int capacity) {
+    const int stride = (capacity + 7) & ~7;
+    QVector<quint16> columns(stride * ChartSignature::ColumnCount, 0);
+    for (int c = 0; c < ChartSignature::ColumnCount; ++c) {
+        std::copy(m_columns.constData() + c * m_stride,
+                  m_columns.constData() + c * m_stride + m_count,
+                  columns.data() + c * stride);
+    }
+    m_columns.swap(columns);
+    m_stride = stride;
+}
+
+void SignatureBatch::append(const ChartSignature& signature) {
+    if (m_count == m_stride) grow(std::max(8, m_stride * 2));
+    quint16* data = m_columns.data();
+    for (int c = 0; c < ChartSignature::ColumnCount; ++c) {
+        data[c * m_stride + m_count] = signature.word[c];
+    }
+    ++m_count;
+}
+
+void SignatureBatch::clear() {
+    m_count = 0;
+    m_stride = 0;
+    m_columns.clear();
+}
+
+SignatureProgram::SignatureProgram() {}
+
+SignatureProgram::SignatureProgram(const YogaProgram& program) {
+    for (int rule = 0; rule < program.ruleCount(); ++rule) {
+        lower(program.rule(rule));
+    }
+}
+
+void SignatureProgram::lower(const QVector<YogaInstruction>& rule) {
+    Range range = { m_ops.size(), 0 };
+    Lowering lowering(m_ops);
+    for (const YogaInstruction& instruction : rule) {
+        lowering.instruction(instruction);
+    }
+    // Both evaluators hold StackDepth values; an empty range is never run
+    if (lowering.maxDepth() > StackDepth) {
+        m_ops.resize(range.start);
+        m_ranges.append(range);
+        return;
+    }
+    range.length = m_ops.size() - range.start;
+    m_ranges.append(range);
+}
+
+QVector<quint64> SignatureProgram::evaluate(const ChartSignature& signature) const {
+    QVector<quint64> active(wordsPerChart(), 0);
+    auto word = [&](int column) { return signature.word[column]; };
+    for (int rule = 0; rule < m_ranges.size(); ++rule) {
+        if (!isLowered(rule)) continue;
+        const Op* begin = m_ops.constData() + m_ranges[rule].start;
+        if (run(begin, begin + m_ranges[rule].length, word)) {
+            active[rule / 64] |= quint64(1) << (rule % 64);
+        }
+    }
+    return active;
+}
+
+QVector<quint64> SignatureProgram::evaluate(const SignatureBatch& batch) const {
+    const int words = wordsPerChart();
+    QVector<quint64> active(batch.size() * words, 0);
+    quint64* out = active.data();
+
+    int chart = 0;
+#if defined(__SSE2__)
+    // Tiles of 64 charts, eight 128-bit vectors of one 16-bit lane per
+    // chart, so that each interpreted op is amortised over the tile
+    constexpr int Vectors = 8;
+    constexpr int Tile = Vectors * 8;
+    __m128i stack[StackDepth][Vectors];
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(-1);
+    const __m128i signBits = _mm_set1_epi16(0x0FFF);
+    auto load = [](const quint16* words, int v) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(words) + v);
+    };
+    auto nonZero = [&](__m128i v) {
+        return _mm_xor_si128(_mm_cmpeq_epi16(v, zero), ones);
+    };
+
+    // Rule by rule, so that the interpreter branches repeat tile to tile
+    const int tiled = batch.size() - batch.size() % Tile;
+    for (int rule = 0; rule < m_ranges.size(); ++rule) {
+        if (!isLowered(rule)) continue;
+        for (chart = 0; chart < tiled; chart += Tile) {
+            const Op* op = m_ops.constData() + m_ranges[rule].start;
+            const Op* end = op + m_ranges[rule].length;
+            int top = -1;
+
+            for (; op != end; ++op) {
+                switch (op->code) {
+                    case Op::Test: {
+                        const quint16* values = batch.column(op->column) + chart;
+                        const __m128i mask = _mm_set1_epi16(static_cast<short>(op->mask));
+                        ++top;
+                        for (int v = 0; v < Vectors; ++v) {
+                            stack[top][v] = nonZero(_mm_and_si128(load(values, v), mask));
+                        }
+                        break;
+                    }
+                    case Op::Meet: {
+                        const quint16* left = batch.column(op->column) + chart;
+                        const quint16* right = batch.column(op->aux) + chart;
+                        ++top;
+                        for (int v = 0; v < Vectors; ++v) {
+                            stack[top][v] = nonZero(_mm_and_si128(load(left, v), load(right, v)));
+                        }
+                        break;
+                    }
+                    case Op::Place: {
+                        // One-hot sign times the mask is the mask shifted by the
+                        // sign; folding bits 12-23 back down completes the rotation
+                        const quint16* values = batch.column(op->column) + chart;
+                        const quint16* signs = batch.column(op->aux) + chart;
+                        const __m128i places = _mm_set1_epi16(static_cast<short>(op->mask));
+                        ++top;
+                        for (int v = 0; v < Vectors; ++v) {
+                            const __m128i sign = load(signs, v);
+                            const __m128i low = _mm_mullo_epi16(places, sign);
+                            const __m128i high = _mm_mulhi_epu16(places, sign);
+                            const __m128i rotated = _mm_and_si128(
+                                _mm_or_si128(low, _mm_or_si128(_mm_srli_epi16(low, 12), _mm_slli_epi16(high, 4))),
+                                signBits);
+                            stack[top][v] = nonZero(_mm_and_si128(load(values, v), rotated));
+                        }
+                        break;
+                    }
+                    case Op::False:
+                        ++top;
+                        for (int v = 0; v < Vectors; ++v) stack[top][v] = zero;
+                        break;
+                    case Op::True:
+                        ++top;
+                        for (int v = 0; v < Vectors; ++v) stack[top][v] = ones;
+                        break;
+                    case Op::And:
+                        --top;
+                        for (int v = 0; v < Vectors; ++v) {
+                            stack[top][v] = _mm_and_si128(stack[top][v], stack[top + 1][v]);
+                        }
+                        break;
+                    case Op::Or:
+                        --top;
+                        for (int v = 0; v < Vectors; ++v) {
+                            stack[top][v] = _mm_or_si128(stack[top][v], stack[top + 1][v]);
+                        }
+                        break;
+                    case Op::Not:
+                        for (int v = 0; v < Vectors; ++v) {
+                            stack[top][v] = _mm_xor_si128(stack[top][v], ones);
+                        }
+                        break;
+                }
+            }
+
+            // Two mask bits per 16-bit lane
+            const quint64 ruleBit = quint64(1) << (rule % 64);
+            for (int v = 0; v < Vectors; ++v) {
+                const int lanes = _mm_movemask_epi8(stack[0][v]);
+                for (int lane = 0; lane < 8; ++lane) {
+                    if ((lanes >> (2 * lane)) & 1) {
+                        out[(chart + v * 8 + lane) * words + rule / 64] |= ruleBit;
+                    }
+                }
+            }
+        }
+    }
+    chart = tiled;
+#endif
+
+    for (; chart < batch.size(); ++chart) {
+        auto word = [&](int column) { return batch.column(column)[chart]; };
+        for (int rule = 0; rule < m_ranges.size(); ++rule) {
+            if (!isLowered(rule)) continue;
+            const Op* begin = m_ops.constData() + m_ranges[rule].start;
+            if (run(begin, begin + m_ranges[rule].length, word)) {
+                out[chart * words + rule / 64] |= quint64(1) << (rule % 64);
+            }
+        }
+    }
+
+    return active;
+}
@@ -0,0 +1,119 @@
+#ifndef CHARTSIGNATURE_H
+#define CHARTSIGNATURE_H
+
+#include <QVector>
+#include "yogaprogram.h"
+
+// Compact, fixed-size bitmask form of a chart for bulk analytics. Every
+// word is a 12-bit sign/house mask or a 10-bit body mask, so any yoga rule
+// can be lowered to AND/OR/NOT over tests of the form (word & mask) != 0.
+struct ChartSignature {
+    enum Column {
+        SignColumn = 0,                                     // [body] sign occupied
+        HouseColumn = SignColumn + ChartFeatures::BodyCount, // [body] house occupied
+        LordHouseColumn = HouseColumn + ChartFeatures::BodyCount, // [house-1] house of its lord
+        LordColumn = LordHouseColumn + 12,                  // [house-1] its lord
+        KendraColumn = LordColumn + 12,                     // [body] bodies in kendra from it
+        TrikonaColumn = KendraColumn + ChartFeatures::BodyCount, // [body] bodies in trikona from it
+        ConjunctColumn = TrikonaColumn + ChartFeatures::BodyCount, // [planet] bodies within the orb
+        AssociatedColumn = ConjunctColumn + Astro::PlanetCount, // [planet] conjunct, opposed or exchanged
+        DispositorColumn = AssociatedColumn + Astro::SevenPlanets, // [planet] lord of its sign
+        OccupantsColumn = DispositorColumn + Astro::PlanetCount, // [sign] planets in the sign
+        OwnColumn = OccupantsColumn + 12,                   // Planets in own sign
+        ExaltedColumn,
+        DebilitatedColumn,
+        MoolatrikonaColumn,
+        VargottamaColumn,
+        NavamsaExaltedColumn,
+        NavamsaDebilitatedColumn,
+        PresentColumn,                                      // Bodies with a position
+        ColumnCount
+    };
+
+    static_assert(PresentColumn - OwnColumn == ChartFeatures::DignityCount,
+                  "one column per dignity bit");
+
+    quint16 word[ColumnCount];
+
+    ChartSignature() : word() {}
+
+    static ChartSignature fromFeatures(const ChartFeatures& features);
+
+    // Column holding one ChartFeatures::Dignity bit
+    static int dignityColumn(quint8 dignity);
+};
+
+// Column-major store of many signatures, padded to a multiple of eight so
+// that one 128-bit load reads the same word of eight charts
+class SignatureBatch {
+public:
+    SignatureBatch();
+
+    void reserve(int count);
+    void append(const ChartSignature& signature);
+    void clear();
+
+    int size() const { return m_count; }
+    int stride() const { return m_stride; }
+    const quint16* column(int index) const { return m_columns.constData() + index * m_stride; }
+
+private:
+    void grow(int capacity);
+
+    int m_count;
+    int m_stride;
+    QVector<quint16> m_columns;
+};
+
+// Yoga rules lowered to postfix programs of signature word tests
+class SignatureProgram {
+public:
+    struct Op {
+        enum Code : quint8 {
+            Test,       // word[column] & mask
+            Meet,       // word[column] & word[aux]
+            Place,      // word[column] & mask rotated to the sign in word[aux]
+            False,
+            True,
+            And,
+            Or,
+            Not
+        };
+        quint8 code;
+        quint8 column;
+        quint8 aux;
+        quint16 mask;
+    };
+
+    SignatureProgram();
+
+    // Lower every rule of a compiled yoga program. A rule whose lowering
+    // needs a deeper stack than the evaluators hold is left out: its bit
+    // is never set and isLowered() is false, so the caller evaluates it
+    // with the YogaProgram instead.
+    explicit SignatureProgram(const YogaProgram& program);
+
+    int ruleCount() const { return m_ranges.size(); }
+    bool isLowered(int rule) const { return m_ranges[rule].length > 0; }
+    int opCount() const { return m_ops.size(); }
+    int wordsPerChart() const { return (m_ranges.size() + 63) / 64; }
+
+    // Yoga bits of one chart; bit i of word i / 64 is rule i
+    QVector<quint64> evaluate(const ChartSignature& signature) const;
+
+    // Yoga bit column for a whole batch: wordsPerChart() words per chart
+    QVector<quint64> evaluate(const SignatureBatch& batch) const;
+
+private:
+    struct Range {
+        int start;
+        int length;
+    };
+
+    void lower(const QVector<YogaInstruction>& rule);
+
+    QVector<Op> m_ops;
+    QVector<Range> m_ranges;
+};
+
+#endif // CHARTSIGNATURE_H
@@ -0,0 +1,104 @@
+#include "chebyshevephemeris.h"
+#include <QtMath>
+#include <cmath>
+
+using namespace Astro;
+
+ChebyshevEphemeris::ChebyshevEphemeris(const Ephemeris& ephemeris)
+    : m_ephemeris(ephemeris)
+    , m_fitted(false)
+    , m_start(0)
+    , m_span(0)
+    , m_fitCount(0)
+    , m_available(0)
+    , m_coefficients() {
+}
+
+void ChebyshevEphemeris::fit(double startDay, double span) {
+    const int nodes = DEGREE + 1;
+    m_start = startDay;
+    m_span = span;
+    m_available = 0;
+
+    for (int body = 0; body < BodyCount; ++body) {
+        if (body == Ketu) continue;
+
+        // Sampled at the Chebyshev nodes in time order, unwrapped across
+        // 0/360 so that the series is continuous
+        double samples[nodes];
+        bool available = true;
+        for (int k = 0; k < nodes; ++k) {
+            const double x = -std::cos(M_PI * (k + 0.5) / nodes);
+            double value = m_ephemeris(body, startDay + (x + 1.0) * 0.5 * span);
+            if (std::isnan(value)) {
+                available = false;
+                break;
+            }
+            if (k > 0) {
+                value = samples[k - 1] + std::remainder(value - samples[k - 1], 360.0);
+            }
+            samples[k] = value;
+        }
+        if (!available) continue;
+
+        // c_j = 2/n * sum f(x_k) T_j(x_k); node k sits at angle pi - theta_k
+        for (int j = 0; j < nodes; ++j) {
+            double sum = 0.0;
+            for (int k = 0; k < nodes; ++k) {
+                sum += samples[k] * std::cos(j * (M_PI - M_PI * (k + 0.5) / nodes));
+            }
+            m_coefficients[body][j] = sum * 2.0 / nodes;
+        }
+        m_coefficients[body][0] *= 0.5;
+        m_available |= 1u << body;
+    }
+
+    m_fitted = true;
+    ++m_fitCount;
+}
+
+bool ChebyshevEphemeris::contains(int body) const {
+    return body >= 0 && body < BodyCount && ((m_available >> seriesOf(body)) & 1u);
+}
+
+double ChebyshevEphemeris::toUnit(double julianDay) const {
+    return qBound(-1.0, 2.0 * (julianDay - m_start) / m_span - 1.0, 1.0);
+}
+
+double ChebyshevEphemeris::longitude(int body, double julianDay) const {
+    // Clenshaw's recurrence
+    const double* c = m_coefficients[seriesOf(body)];
+    const double x = toUnit(julianDay);
+    double b1 = 0.0, b2 = 0.0;
+    for (int j = DEGREE; j >= 1; --j) {
+        const double b0 = 2.0 * x * b1 - b2 + c[j];
+        b2 = b1;
+        b1 = b0;
+    }
+    const double value = x * b1 - b2 + c[0];
+    return normalizeDegrees(body == Ketu ? value + 180.0 : value);
+}
+
+double ChebyshevEphemeris::speed(int body, double julianDay) const {
+    // Coefficients of the derivative series, then the same recurrence
+    const double* c = m_coefficients[seriesOf(body)];
+    double d[DEGREE + 2] = {};
+    for (int j = DEGREE; j >= 1; --j) {
+        d[j - 1] = d[j + 1] + 2.0 * j * c[j];
+    }
+    d[0] *= 0.5;
+
+    const double x = toUnit(julianDay);
+    double b1 = 0.0, b2 = 0.0;
+    for (int j = DEGREE - 1; j >= 1; --j) {
+        const double b0 = 2.0 * x * b1 - b2 + d[j];
+        b2 = b1;
+        b1 = b0;
+    }
+    return (x * b1 - b2 + d[0]) * 2.0 / m_span;
+}
+
+double ChebyshevEphemeris::errorBound(int body) const {
+    const double* c = m_coefficients[seriesOf(body)];
+    return std::fabs(c[DEGREE - 1]) + std::fabs(c[DEGREE]);
+}
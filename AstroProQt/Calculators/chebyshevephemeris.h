@@ -0,0 +1,57 @@
+#ifndef CHEBYSHEVEPHEMERIS_H
+#define CHEBYSHEVEPHEMERIS_H
+
+#include <QtGlobal>
+#include <functional>
+#include "planetdata.h"
+
+// Longitudes of every body over a short window as Chebyshev series, fitted
+// from a few ephemeris calls per body. A live chart evaluates the series
+// every tick and asks the ephemeris again only when time leaves the window.
+//
+// Over the default hour a degree-8 series holds the Moon and the ascendant
+// to well under an arcsecond; errorBound() estimates it from the last
+// coefficients.
+class ChebyshevEphemeris {
+public:
+    // Sidereal longitude in degrees at a Julian day (UT), or NaN when the
+    // body is unavailable. The body is an Astro::Planet or Ascendant; Ketu
+    // is taken opposite Rahu and never requested.
+    using Ephemeris = std::function<double(int body, double julianDay)>;
+
+    enum { Ascendant = Astro::PlanetCount, BodyCount = Astro::PlanetCount + 1 };
+
+    explicit ChebyshevEphemeris(const Ephemeris& ephemeris);
+
+    // Fit every body over [startDay, startDay + span]
+    void fit(double startDay, double span = DEFAULT_SPAN);
+    bool covers(double julianDay) const {
+        return m_fitted && julianDay >= m_start && julianDay <= m_start + m_span;
+    }
+    int fitCount() const { return m_fitCount; }
+
+    bool contains(int body) const;
+    // Longitude (0-360) and its rate in degrees per day, inside the window
+    double longitude(int body, double julianDay) const;
+    double speed(int body, double julianDay) const;
+    // Truncation error estimate in degrees
+    double errorBound(int body) const;
+
+    static const int DEGREE = 8;
+    static constexpr double DEFAULT_SPAN = 1.0 / 24.0;   // Days
+
+private:
+    // Ketu reads Rahu's series
+    static int seriesOf(int body) { return body == Astro::Ketu ? Astro::Rahu : body; }
+    double toUnit(double julianDay) const;
+
+    Ephemeris m_ephemeris;
+    bool m_fitted;
+    double m_start;
+    double m_span;
+    int m_fitCount;
+    quint16 m_available;                      // Bit per body with a series
+    double m_coefficients[BodyCount][DEGREE + 1];
+};
+
+#endif // CHEBYSHEVEPHEMERIS_H
@@ -1,10 +1,19 @@
 #include "dashacalculator.h"
 #include <QtMath>
+#include <algorithm>
+
+const int DashaCalculator::dashaPeriods[9] = {6, 10, 7, 18, 16, 19, 17, 7, 20};
+
+const QString DashaCalculator::planetNames[9] = {
+    "Sun", "Moon", "Mars", "Rahu", "Jupiter",
+    "Saturn", "Mercury", "Ketu", "Venus"
+};
 
 DashaCalculator::DashaCalculator() {}
 
 QVector<DashaPeriod> DashaCalculator::calculateVimshottariDasha(const QDateTime& birthTime, double moonLongitude) {
-    QVector<DashaPeriod> dashaPeriods;
+    QVector<DashaPeriod> mahadashas;
+    mahadashas.reserve(9);
     
     // Find starting planet based on Moon's longitude
     int startingPlanetIndex = findStartingPlanet(moonLongitude);
@@ -25,27 +34,42 @@ QVector<DashaPeriod> DashaCalculator::calculateVimshottariDasha(const QDateTime&
         // Calculate Antardasha for this period
         period.antarDashas = calculateAntarDasha(period);
         
-        dashaPeriods.append(period);
-        startTime = period.endTime;
+        startTime = period.endTime;   // Before period is moved from
+        mahadashas.append(std::move(period));
     }
     
-    return dashaPeriods;
+    return mahadashas;
 }
 
 QString DashaCalculator::getCurrentDasha(const QDateTime& birthTime, double moonLongitude) {
-    QVector<DashaPeriod> allPeriods = calculateVimshottariDasha(birthTime, moonLongitude);
     QDateTime currentTime = QDateTime::currentDateTime();
     
-    for (const DashaPeriod& period : allPeriods) {
-        if (currentTime >= period.startTime && currentTime < period.endTime) {
+    // Walk the same periods as calculateVimshottariDasha() without building
+    // the tables; only the running ones are needed
+    int startingPlanetIndex = findStartingPlanet(moonLongitude);
+    QDateTime startTime = calculateDashaStartTime(birthTime, moonLongitude);
+    
+    for (int i = 0; i < 9; ++i) {
+        int planetIndex = (startingPlanetIndex + i) % 9;
+        qint64 periodMs = dashaPeriods[planetIndex] * 365.25 * 24 * 60 * 60 * 1000;
+        QDateTime endTime = startTime.addMSecs(periodMs);
+        
+        if (currentTime >= startTime && currentTime < endTime) {
             // Find current Antardasha
-            for (const DashaPeriod& antardasha : period.antarDashas) {
-                if (currentTime >= antardasha.startTime && currentTime < antardasha.endTime) {
-                    return QString("%1-%2").arg(period.planet).arg(antardasha.planet);
+            qint64 totalPeriodMs = startTime.msecsTo(endTime);
+            QDateTime antarStart = startTime;
+            for (int j = 0; j < 9; ++j) {
+                int antarIndex = (planetIndex + j) % 9;
+                qint64 antarMs = totalPeriodMs * (dashaPeriods[antarIndex] / 120.0);
+                QDateTime antarEnd = antarStart.addMSecs(antarMs);
+                if (currentTime >= antarStart && currentTime < antarEnd) {
+                    return QString("%1-%2").arg(planetNames[planetIndex]).arg(planetNames[antarIndex]);
                 }
+                antarStart = antarEnd;
             }
-            return period.planet;
+            return planetNames[planetIndex];
         }
+        startTime = endTime;
     }
     
     return "Unknown";
@@ -53,9 +77,10 @@ QString DashaCalculator::getCurrentDasha(const QDateTime& birthTime, double moon
 
 QVector<DashaPeriod> DashaCalculator::calculateAntarDasha(const DashaPeriod& mahadasha) {
     QVector<DashaPeriod> antarDashas;
+    antarDashas.reserve(9);
     
     // Find starting planet index
-    int startIndex = planetNames.indexOf(mahadasha.planet);
+    int startIndex = int(std::find(planetNames, planetNames + 9, mahadasha.planet) - planetNames);
     QDateTime startTime = mahadasha.startTime;
     
     // Calculate total period in milliseconds
@@ -27,14 +27,11 @@ public:
     QVector<DashaPeriod> calculateAntarDasha(const DashaPeriod& mahadasha);
 
 private:
-    // Dasha periods in years for each planet
-    const QVector<int> dashaPeriods = {6, 10, 7, 18, 16, 19, 17, 7, 20}; // Sun to Ketu
+    // Dasha periods in years for each planet, shared by every calculator
+    static const int dashaPeriods[9];
     
     // Planet names in order
-    const QVector<QString> planetNames = {
-        "Sun", "Moon", "Mars", "Rahu", "Jupiter",
-        "Saturn", "Mercury", "Ketu", "Venus"
-    };
+    static const QString planetNames[9];
     
     // Helper methods
     int findStartingPlanet(double moonLongitude);
@@ -0,0 +1,461 @@
+#include "electionalsearch.h"
+#include "yogacalculator.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace Astro;
+
+namespace {
+
+// Scan step in days per body: short enough that no body can cross two
+// navamsa boundaries (3deg20') in one step, even at its fastest, and the
+// ascendant cannot pass through a whole sign
+constexpr double scanStep[ElectionalSearch::BodyCount] = {
+    1.5,        // Sun
+    0.1,        // Moon
+    2.0,        // Mars
+    1.0,        // Mercury
+    5.0,        // Jupiter
+    1.5,        // Venus
+    10.0,       // Saturn
+    5.0,        // Rahu
+    5.0,        // Ketu (follows Rahu)
+    1.0 / 72.0  // Ascendant
+};
+
+constexpr double NavamsaSpan = 30.0 / 9.0;
+constexpr double SpeedDelta = 0.5;   // Days either side for finite-difference speeds
+
+// Kala, Sthana and Cheshta Bala step when the hora, a house or a varga
+// changes, by up to about 0.2 of a planet's required rupas; a gap between
+// two profile samples that comes this close to the threshold can hide a
+// window or a dip, so it is resampled at the tolerance
+constexpr double NearMargin = 0.25;
+
+inline double wrap180(double degrees) {
+    degrees = std::fmod(degrees, 360.0);
+    if (degrees >= 180.0) degrees -= 360.0;
+    if (degrees < -180.0) degrees += 360.0;
+    return degrees;
+}
+
+// Illinois-modified regula falsi on a bracket over which g changes sign.
+// Returns the final bracket; g keeps its t0 sign on the first end.
+template <typename Fn>
+std::pair<double, double> solveBracket(double t0, double t1, double g0, double g1,
+                                       Fn g, double tolerance) {
+    int side = 0;
+    while (t1 - t0 > tolerance) {
+        double t = (t0 * g1 - t1 * g0) / (g1 - g0);
+        if (!(t > t0 && t < t1)) t = 0.5 * (t0 + t1);
+
+        const double gt = g(t);
+        if ((gt < 0) == (g0 < 0)) {
+            t0 = t;
+            g0 = gt;
+            if (side == -1) g1 *= 0.5;
+            side = -1;
+        } else {
+            t1 = t;
+            g1 = gt;
+            if (side == 1) g0 *= 0.5;
+            side = 1;
+        }
+    }
+    return std::make_pair(t0, t1);
+}
+
+} // namespace
+
+ElectionalSearch::ElectionalSearch(const Ephemeris& ephemeris)
+    : m_ephemeris(ephemeris), m_stats() {}
+
+double ElectionalSearch::julianDay(const QDateTime& time) {
+    return time.toMSecsSinceEpoch() / 86400000.0 + 2440587.5;
+}
+
+QDateTime ElectionalSearch::fromJulianDay(double julianDay) {
+    return QDateTime::fromMSecsSinceEpoch(
+        static_cast<qint64>(std::llround((julianDay - 2440587.5) * 86400000.0)), Qt::UTC);
+}
+
+quint64 ElectionalSearch::yogaMask(const QStringList& names) {
+    const QVector<YogaCalculator::Yoga> definitions = YogaCalculator::definitions();
+    quint64 mask = 0;
+    for (int i = 0; i < definitions.size() && i < 64; ++i) {
+        if (names.contains(definitions[i].name)) mask |= quint64(1) << i;
+    }
+    return mask;
+}
+
+double ElectionalSearch::longitude(int body, double julianDay) {
+    ++m_stats.ephemerisCalls;
+    // Rounded the way takeSnapshot() derives Ketu from Rahu
+    if (body == Ketu) return normalizeDegrees(normalizeDegrees(m_ephemeris(Rahu, julianDay)) + 180.0);
+    return normalizeDegrees(m_ephemeris(body, julianDay));
+}
+
+void ElectionalSearch::takeSnapshot(double julianDay, Snapshot& snapshot) {
+    QMap<QString, double> positions;
+    qint32 arcSeconds[VargaCalculator::BodyCount];
+
+    for (int body = 0; body < BodyCount; ++body) {
+        snapshot.longitude[body] = body == Ketu
+            ? normalizeDegrees(snapshot.longitude[Rahu] + 180.0)
+            : longitude(body, julianDay);
+        arcSeconds[body] = VargaCalculator::toArcSeconds(snapshot.longitude[body]);
+        if (body < PlanetCount) positions[planetName(body)] = snapshot.longitude[body];
+    }
+
+    // Whole-sign houses from the ascendant, as used for lordship
+    QVector<double> houses;
+    const int lagnaSign = signOf(snapshot.longitude[Ascendant]);
+    for (int h = 0; h < 12; ++h) {
+        houses.append(((lagnaSign + h) % SignCount) * 30.0);
+    }
+
+    snapshot.aspects.build(positions, houses);
+    snapshot.vargas = m_vargaCalculator.calculate(arcSeconds, 0x3FF);
+}
+
+bool ElectionalSearch::yogasHold(double julianDay, quint64 yogas) {
+    if (!yogas) return true;
+
+    Snapshot snapshot;
+    takeSnapshot(julianDay, snapshot);
+    ++m_stats.featureBuilds;
+
+    const ChartFeatures features = ChartFeatures::build(snapshot.aspects, snapshot.vargas);
+    const YogaProgram& program = YogaCalculator::program();
+    for (int rule = 0; rule < program.ruleCount() && rule < 64; ++rule) {
+        if (((yogas >> rule) & 1u) && !program.evaluate(rule, features)) return false;
+    }
+    return true;
+}
+
+ElectionalSearch::ProfilePoint ElectionalSearch::strengthAt(double julianDay, const Query& query) {
+    Snapshot snapshot;
+    takeSnapshot(julianDay, snapshot);
+    ++m_stats.strengthSamples;
+
+    StrengthCalculator::ShadbalaBatch batch;
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.longitude[p] = snapshot.longitude[p];
+        const double before = longitude(p, julianDay - SpeedDelta);
+        const double after = longitude(p, julianDay + SpeedDelta);
+        batch.speed[p] = wrap180(after - before) / (2.0 * SpeedDelta);
+    }
+
+    // Equal houses from the ascendant degree, as the chart and the service
+    // build them; Kala and Dig Bala read the time of day from the 1st cusp
+    StrengthCalculator::ChartContext context;
+    for (int h = 0; h < 12; ++h) {
+        context.cusps[h] = normalizeDegrees(snapshot.longitude[Ascendant] + h * 30.0);
+    }
+    const double local = julianDay + 0.5 + query.utcOffsetHours / 24.0;
+    context.dayNumber = static_cast<qint64>(std::floor(local));
+    context.localHours = (local - std::floor(local)) * 24.0;
+    context.hasTime = true;
+    context.ayanamsa = meanAyanamsa(julianDay);
+    context.aspects = &snapshot.aspects;
+    context.vargas = &snapshot.vargas;
+    m_strengthCalculator.computeShadbala(batch, context);
+
+    ProfilePoint point;
+    point.julianDay = julianDay;
+    for (int p = 0; p < SevenPlanets; ++p) {
+        point.ratio[p] = batch.total[p] / 60.0 / StrengthCalculator::requiredRupas(p);
+    }
+
+    double sum = 0.0;
+    for (const StrengthCondition& condition : query.strengths) {
+        sum += point.ratio[condition.planet];
+    }
+    if (query.strengths.isEmpty()) {
+        for (int p = 0; p < SevenPlanets; ++p) sum += point.ratio[p];
+        point.score = sum / SevenPlanets;
+    } else {
+        point.score = sum / query.strengths.size();
+    }
+    return point;
+}
+
+// Smallest surplus over the strength conditions; >= 0 when all hold
+double ElectionalSearch::margin(const ProfilePoint& point, const Query& query) {
+    double least = 1.0;
+    for (const StrengthCondition& condition : query.strengths) {
+        least = std::min(least, point.ratio[condition.planet] - condition.minimumRatio);
+    }
+    return least;
+}
+
+int ElectionalSearch::cellOf(int body, double longitude) const {
+    if (body == Ascendant) return signOf(longitude);
+
+    int cell = static_cast<int>(std::floor(longitude / NavamsaSpan)) * 2;
+    if (body < SevenPlanets && signOf(longitude) == moolatrikona[body].sign) {
+        const double degree = longitude - moolatrikona[body].sign * 30.0;
+        if (degree >= moolatrikona[body].from && degree < moolatrikona[body].to) ++cell;
+    }
+    return cell;
+}
+
+// First time after 'from' at which the body enters a new cell, or 'limit'
+double ElectionalSearch::nextBodyEvent(int body, double from, double limit, double tolerance) {
+    double t0 = from;
+    double lon0 = longitude(body, t0);
+    const int cell0 = cellOf(body, lon0);
+
+    while (t0 < limit) {
+        const double t1 = std::min(t0 + scanStep[body], limit);
+        const double lon1 = longitude(body, t1);
+        if (cellOf(body, lon1) == cell0) {
+            t0 = t1;
+            lon0 = lon1;
+            continue;
+        }
+
+        ++m_stats.events;
+
+        // The nearest boundary in the direction of motion; navamsa,
+        // moolatrikona start and end and, for the ascendant, sign
+        const double motion = wrap180(lon1 - lon0);
+        const double span = body == Ascendant ? 30.0 : NavamsaSpan;
+        double boundary = motion >= 0 ? (std::floor(lon0 / span) + 1) * span
+                                      : std::floor(lon0 / span) * span;
+        if (body < SevenPlanets) {
+            const MoolatrikonaRange& range = moolatrikona[body];
+            for (double edge : { range.sign * 30.0 + range.from, range.sign * 30.0 + range.to }) {
+                const double ahead = wrap180(edge - lon0);
+                if (ahead != 0.0 && (ahead > 0) == (motion >= 0) &&
+                    std::fabs(ahead) < std::fabs(wrap180(boundary - lon0))) {
+                    boundary = edge;
+                }
+            }
+        }
+
+        auto angle = [&](double t) { return wrap180(longitude(body, t) - boundary); };
+        const double g0 = wrap180(lon0 - boundary);
+        const double g1 = wrap180(lon1 - boundary);
+        if (g0 != 0.0 && (g0 < 0) != (g1 < 0)) {
+            return solveBracket(t0, t1, g0, g1, angle, tolerance).second;
+        }
+
+        // A station inside the step: fall back to the cell change itself
+        auto changed = [&](double t) { return cellOf(body, longitude(body, t)) == cell0 ? 1.0 : -1.0; };
+        return solveBracket(t0, t1, 1.0, -1.0, changed, tolerance).second;
+    }
+    return limit;
+}
+
+// First time after 'from' at which the pair enters or leaves the
+// conjunction orb, or 'limit'
+double ElectionalSearch::nextPairEvent(int p, int q, double from, double limit, double tolerance) {
+    const double step = std::min(scanStep[p], scanStep[q]);
+    // The orb test as ChartFeatures makes it, on AspectMatrix's float
+    // separations in both directions; either one changing is an event
+    auto state = [&](double t, double* distance) {
+        const double lp = longitude(p, t);
+        const double lq = longitude(q, t);
+        *distance = std::fabs(wrap180(lq - lp)) - ChartFeatures::CONJUNCTION_ORB;
+        return (AspectMatrix::shortestArc(lp, lq) <= ChartFeatures::CONJUNCTION_ORB ? 1 : 0) |
+               (AspectMatrix::shortestArc(lq, lp) <= ChartFeatures::CONJUNCTION_ORB ? 2 : 0);
+    };
+
+    double distance;
+    const int state0 = state(from, &distance);
+    double t0 = from;
+    double g0 = std::max(std::fabs(distance), 1e-9);
+    while (t0 < limit) {
+        const double t1 = std::min(t0 + step, limit);
+        if (state(t1, &distance) != state0) {
+            ++m_stats.events;
+            // Solve on the distance from the orb, signed by whether the
+            // test has changed, so the result lands on the new side
+            auto side = [&](double t) {
+                double d;
+                const int s = state(t, &d);
+                return s == state0 ? std::max(std::fabs(d), 1e-9) : -std::max(std::fabs(d), 1e-9);
+            };
+            return solveBracket(t0, t1, g0, -std::max(std::fabs(distance), 1e-9), side, tolerance).second;
+        }
+        t0 = t1;
+        g0 = std::max(std::fabs(distance), 1e-9);
+    }
+    return limit;
+}
+
+QVector<ElectionalSearch::Segment> ElectionalSearch::yogaSegments(const Query& query) {
+    QVector<Segment> segments;
+    if (!query.yogas) {
+        segments.append(Segment{ query.startDay, query.endDay });
+        return segments;
+    }
+
+    // Conjunction orbs only matter to rules that test them
+    quint16 pairBodies[PlanetCount] = {};
+    const YogaProgram& program = YogaCalculator::program();
+    for (int rule = 0; rule < program.ruleCount() && rule < 64; ++rule) {
+        if (!((query.yogas >> rule) & 1u)) continue;
+        for (const YogaInstruction& in : program.rule(rule)) {
+            if (in.op == YogaInstruction::Conjunct) {
+                pairBodies[std::min(in.a, in.b)] |= 1u << std::max(in.a, in.b);
+            } else if (in.op == YogaInstruction::LordsAssociated) {
+                for (int p = 0; p < SevenPlanets; ++p) {
+                    for (int q = p + 1; q < SevenPlanets; ++q) pairBodies[p] |= 1u << q;
+                }
+            }
+        }
+    }
+
+    struct PairEvent {
+        int p;
+        int q;
+        double next;
+    };
+    QVector<PairEvent> pairs;
+    for (int p = 0; p < PlanetCount; ++p) {
+        for (int q = p + 1; q < PlanetCount; ++q) {
+            if ((pairBodies[p] >> q) & 1u) pairs.append(PairEvent{ p, q, 0.0 });
+        }
+    }
+
+    // Event sweep: features are constant between consecutive events, and
+    // each body's next event is only recomputed once it has fired
+    double nextEvent[BodyCount];
+    for (int body = 0; body < BodyCount; ++body) {
+        nextEvent[body] = body == Ketu ? query.endDay
+            : nextBodyEvent(body, query.startDay, query.endDay, query.tolerance);
+    }
+    for (PairEvent& pair : pairs) {
+        pair.next = nextPairEvent(pair.p, pair.q, query.startDay, query.endDay, query.tolerance);
+    }
+
+    double t = query.startDay;
+    bool active = yogasHold(t, query.yogas);
+    while (t < query.endDay) {
+        double next = query.endDay;
+        for (double event : nextEvent) next = std::min(next, event);
+        for (const PairEvent& pair : pairs) next = std::min(next, pair.next);
+
+        if (active) {
+            if (!segments.isEmpty() && segments.last().end >= t) {
+                segments.last().end = next;
+            } else {
+                segments.append(Segment{ t, next });
+            }
+        }
+        if (next >= query.endDay) break;
+
+        for (int body = 0; body < BodyCount; ++body) {
+            if (nextEvent[body] <= next) {
+                nextEvent[body] = nextBodyEvent(body, next, query.endDay, query.tolerance);
+            }
+        }
+        for (PairEvent& pair : pairs) {
+            if (pair.next <= next) {
+                pair.next = nextPairEvent(pair.p, pair.q, next, query.endDay, query.tolerance);
+            }
+        }
+
+        t = next;
+        active = yogasHold(t, query.yogas);
+    }
+
+    return segments;
+}
+
+void ElectionalSearch::strengthWindows(const Segment& segment, const Query& query,
+                                       QVector<Window>& windows) {
+    // The last sample sits just inside the segment, before the yoga
+    // features change at its end
+    const double last = std::max(segment.start, segment.end - 0.5 * query.tolerance);
+    const int steps = std::max(1, static_cast<int>(std::ceil((last - segment.start) / query.profileStep)));
+
+    QVector<ProfilePoint> samples;
+    samples.append(strengthAt(segment.start, query));
+    for (int i = 1; i <= steps; ++i) {
+        const ProfilePoint point = strengthAt(segment.start + (last - segment.start) * i / steps, query);
+        const ProfilePoint& previous = samples.last();
+        const double m0 = margin(previous, query);
+        const double m1 = margin(point, query);
+        if ((m0 >= 0) != (m1 >= 0) || std::fabs(m0) < NearMargin || std::fabs(m1) < NearMargin) {
+            const double t0 = previous.julianDay;
+            const int fine = static_cast<int>(std::ceil((point.julianDay - t0) / query.tolerance));
+            for (int k = 1; k < fine; ++k) {
+                samples.append(strengthAt(t0 + (point.julianDay - t0) * k / fine, query));
+            }
+        }
+        samples.append(point);
+    }
+
+    auto marginAt = [&](double t) { return margin(strengthAt(t, query), query); };
+
+    Window window;
+    bool open = false;
+    auto close = [&](double end) {
+        window.endDay = end;
+        window.peakScore = -1.0;
+        for (const ProfilePoint& point : window.profile) {
+            if (point.score > window.peakScore) {
+                window.peakScore = point.score;
+                window.peakDay = point.julianDay;
+            }
+        }
+        windows.append(window);
+        open = false;
+    };
+
+    for (int i = 0; i < samples.size(); ++i) {
+        const double m = margin(samples[i], query);
+        if (i == 0) {
+            if (m >= 0) {
+                window = Window();
+                window.startDay = segment.start;
+                open = true;
+            }
+        } else {
+            const double previous = margin(samples[i - 1], query);
+            if ((previous >= 0) != (m >= 0)) {
+                // Bracketed on the sampled margin, refined by regula falsi
+                const auto bracket = solveBracket(
+                    samples[i - 1].julianDay, samples[i].julianDay,
+                    previous >= 0 ? std::max(previous, 1e-12) : previous,
+                    m >= 0 ? std::max(m, 1e-12) : m,
+                    [&](double t) {
+                        const double g = marginAt(t);
+                        return g >= 0 ? std::max(g, 1e-12) : g;
+                    },
+                    query.tolerance);
+                if (m >= 0) {
+                    window = Window();
+                    window.startDay = bracket.second;
+                    window.profile.append(strengthAt(bracket.second, query));
+                    open = true;
+                } else {
+                    window.profile.append(strengthAt(bracket.first, query));
+                    close(bracket.first);
+                }
+            }
+        }
+        if (open) window.profile.append(samples[i]);
+    }
+    if (open) close(segment.end);
+}
+
+bool ElectionalSearch::holds(double julianDay, const Query& query) {
+    if (!yogasHold(julianDay, query.yogas)) return false;
+    return query.strengths.isEmpty() || margin(strengthAt(julianDay, query), query) >= 0;
+}
+
+QVector<ElectionalSearch::Window> ElectionalSearch::search(const Query& query) {
+    m_stats = Stats();
+    QVector<Window> windows;
+    if (!m_ephemeris || query.endDay <= query.startDay) return windows;
+
+    for (const Segment& segment : yogaSegments(query)) {
+        strengthWindows(segment, query, windows);
+    }
+    return windows;
+}
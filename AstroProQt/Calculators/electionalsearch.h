@@ -0,0 +1,120 @@
+#ifndef ELECTIONALSEARCH_H
+#define ELECTIONALSEARCH_H
+
+#include <QDateTime>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include "planetdata.h"
+#include "aspectmatrix.h"
+#include "strengthcalculator.h"
+#include "vargacalculator.h"
+#include "yogaprogram.h"
+
+// Finds the intervals of time in which a set of yogas is active and chosen
+// planets are strong (electional / muhurta work).
+//
+// Yoga features only change when a body crosses a navamsa or moolatrikona
+// boundary, the ascendant changes sign, or two planets enter or leave the
+// conjunction orb. Each such event is bracketed by stepping the body on a
+// grid matched to its speed and then solved on the angle itself, so slow
+// bodies are sampled rarely. Strength is profiled inside the yoga intervals
+// and resampled at the tolerance only where it comes near the threshold,
+// since Kala, Sthana and Cheshta Bala step rather than vary smoothly.
+class ElectionalSearch {
+public:
+    // Sidereal longitude in degrees at a Julian day (UT). The body is an
+    // Astro::Planet or Ascendant, which must be for the search location.
+    // Ketu is taken opposite Rahu and never requested.
+    using Ephemeris = std::function<double(int body, double julianDay)>;
+
+    enum { Ascendant = Astro::PlanetCount, BodyCount = Astro::PlanetCount + 1 };
+
+    struct StrengthCondition {
+        int planet;
+        double minimumRatio;   // Shadbala over the required rupas
+    };
+
+    struct Query {
+        double startDay;       // Julian days, UT
+        double endDay;
+        quint64 yogas;         // Bits of YogaCalculator::definitions(), all required
+        QVector<StrengthCondition> strengths;
+        double utcOffsetHours; // Civil time at the location, for Kala Bala
+        double tolerance;      // Root-finding tolerance in days
+        double profileStep;    // Spacing of strength samples in days
+
+        Query() : startDay(0), endDay(0), yogas(0), utcOffsetHours(0),
+                  tolerance(1.0 / 1440.0), profileStep(1.0 / 24.0) {}
+    };
+
+    struct ProfilePoint {
+        double julianDay;
+        double ratio[Astro::SevenPlanets];  // Shadbala ratio of each planet
+        double score;                       // Mean ratio of the conditioned planets
+    };
+
+    struct Window {
+        double startDay;
+        double endDay;
+        double peakDay;
+        double peakScore;
+        QVector<ProfilePoint> profile;
+
+        double days() const { return endDay - startDay; }
+    };
+
+    struct Stats {
+        int ephemerisCalls;
+        int events;            // Boundary crossings solved
+        int featureBuilds;
+        int strengthSamples;
+    };
+
+    explicit ElectionalSearch(const Ephemeris& ephemeris);
+
+    QVector<Window> search(const Query& query);
+    // Whether every condition of the query holds at one instant; search()
+    // must agree with this sampled anywhere away from a window's edges
+    bool holds(double julianDay, const Query& query);
+    const Stats& stats() const { return m_stats; }
+
+    // Yoga bits for names from YogaCalculator::definitions()
+    static quint64 yogaMask(const QStringList& names);
+
+    static double julianDay(const QDateTime& time);
+    static QDateTime fromJulianDay(double julianDay);
+
+private:
+    struct Segment {
+        double start;
+        double end;
+    };
+
+    // Positions and derived matrices at one instant
+    struct Snapshot {
+        double longitude[BodyCount];
+        AspectMatrix aspects;
+        VargaCalculator::VargaMatrix vargas;
+    };
+
+    double longitude(int body, double julianDay);
+    void takeSnapshot(double julianDay, Snapshot& snapshot);
+    bool yogasHold(double julianDay, quint64 yogas);
+    ProfilePoint strengthAt(double julianDay, const Query& query);
+    static double margin(const ProfilePoint& point, const Query& query);
+
+    int cellOf(int body, double longitude) const;
+    double nextBodyEvent(int body, double from, double limit, double tolerance);
+    double nextPairEvent(int p, int q, double from, double limit, double tolerance);
+
+    QVector<Segment> yogaSegments(const Query& query);
+    void strengthWindows(const Segment& segment, const Query& query, QVector<Window>& windows);
+
+    Ephemeris m_ephemeris;
+    StrengthCalculator m_strengthCalculator;
+    VargaCalculator m_vargaCalculator;
+    Stats m_stats;
+};
+
+#endif // ELECTIONALSEARCH_H
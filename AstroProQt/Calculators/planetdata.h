@@ -0,0 +1,196 @@
+#ifndef PLANETDATA_H
+#define PLANETDATA_H
+
+#include <QString>
+#include <cmath>
+#include <cstdint>
+
+// Fixed planet indices and classical reference tables shared by the
+// calculators. Weekday order (Sun..Saturn) is used so that the index of a
+// planet is also the index of the weekday it rules.
+namespace Astro {
+
+enum Planet {
+    Sun = 0,
+    Moon,
+    Mars,
+    Mercury,
+    Jupiter,
+    Venus,
+    Saturn,
+    Rahu,
+    Ketu,
+    PlanetCount
+};
+
+constexpr int SevenPlanets = 7;
+constexpr int SignCount = 12;
+
+inline const char* planetName(int planet) {
+    static const char* const names[PlanetCount] = {
+        "Sun", "Moon", "Mars", "Mercury", "Jupiter",
+        "Venus", "Saturn", "Rahu", "Ketu"
+    };
+    return (planet >= 0 && planet < PlanetCount) ? names[planet] : "";
+}
+
+inline const char* signName(int sign) {
+    static const char* const names[SignCount] = {
+        "Aries", "Taurus", "Gemini", "Cancer", "Leo", "Virgo",
+        "Libra", "Scorpio", "Sagittarius", "Capricorn", "Aquarius", "Pisces"
+    };
+    return (sign >= 0 && sign < SignCount) ? names[sign] : "";
+}
+
+// Returns -1 for names that are not one of the nine grahas
+inline int planetIndex(const QString& name) {
+    for (int p = 0; p < PlanetCount; ++p) {
+        if (name == QLatin1String(planetName(p))) return p;
+    }
+    return -1;
+}
+
+inline double normalizeDegrees(double longitude) {
+    double result = std::fmod(longitude, 360.0);
+    return result < 0 ? result + 360.0 : result;
+}
+
+// Shortest arc between two longitudes (0-180)
+inline double angularDistance(double a, double b) {
+    double diff = std::fabs(normalizeDegrees(a) - normalizeDegrees(b));
+    return diff > 180.0 ? 360.0 - diff : diff;
+}
+
+// Lahiri ayanamsa from its J2000 value and the mean rate of precession;
+// within about 0.01 degree of the ephemeris's over 1900-2100
+inline double meanAyanamsa(double julianDay) {
+    return 23.853 + (julianDay - 2451545.0) / 365.25 * (50.29 / 3600.0);
+}
+
+inline int signOf(double longitude) {
+    return static_cast<int>(normalizeDegrees(longitude) / 30.0) % SignCount;
+}
+
+// Lord of each sign (0 = Aries, 11 = Pisces)
+constexpr int signLord[SignCount] = {
+    Mars, Venus, Mercury, Moon, Sun, Mercury,
+    Venus, Mars, Jupiter, Saturn, Saturn, Jupiter
+};
+
+// Signs owned by each planet as 12-bit masks (bit 0 = Aries)
+constexpr uint16_t ownSignMask[PlanetCount] = {
+    1u << 4,                // Sun: Leo
+    1u << 3,                // Moon: Cancer
+    (1u << 0) | (1u << 7),  // Mars: Aries, Scorpio
+    (1u << 2) | (1u << 5),  // Mercury: Gemini, Virgo
+    (1u << 8) | (1u << 11), // Jupiter: Sagittarius, Pisces
+    (1u << 1) | (1u << 6),  // Venus: Taurus, Libra
+    (1u << 9) | (1u << 10), // Saturn: Capricorn, Aquarius
+    0,                      // Rahu
+    0                       // Ketu
+};
+
+// Deep exaltation points in absolute longitude; debilitation is opposite
+constexpr double exaltationLongitude[PlanetCount] = {
+    10.0,   // Sun: Aries 10°
+    33.0,   // Moon: Taurus 3°
+    298.0,  // Mars: Capricorn 28°
+    165.0,  // Mercury: Virgo 15°
+    95.0,   // Jupiter: Cancer 5°
+    357.0,  // Venus: Pisces 27°
+    200.0,  // Saturn: Libra 20°
+    80.0,   // Rahu: Gemini 20°
+    260.0   // Ketu: Sagittarius 20°
+};
+
+// Chaldean order used for hora lords, and each planet's place in it
+constexpr int chaldeanOrder[SevenPlanets] = {
+    Saturn, Jupiter, Mars, Sun, Venus, Mercury, Moon
+};
+constexpr int chaldeanPosition[SevenPlanets] = { 3, 6, 2, 5, 1, 4, 0 };
+
+inline int weekdayLord(int64_t dayNumber) {
+    // JDN + 1 modulo 7 gives 0 = Sunday, which matches the Planet order
+    return static_cast<int>((dayNumber + 1) % 7);
+}
+
+// Lord of the hora running a number of hours after sunrise on a weekday
+inline int horaLord(int dayLord, int hoursSinceSunrise) {
+    return chaldeanOrder[(chaldeanPosition[dayLord] + hoursSinceSunrise) % SevenPlanets];
+}
+
+// Moolatrikona sign and degree range within it
+struct MoolatrikonaRange {
+    int sign;
+    double from;
+    double to;
+};
+
+constexpr MoolatrikonaRange moolatrikona[SevenPlanets] = {
+    {4, 0.0, 20.0},   // Sun: Leo 0-20
+    {1, 3.0, 30.0},   // Moon: Taurus 3-30
+    {0, 0.0, 12.0},   // Mars: Aries 0-12
+    {5, 15.0, 20.0},  // Mercury: Virgo 15-20
+    {8, 0.0, 10.0},   // Jupiter: Sagittarius 0-10
+    {6, 0.0, 15.0},   // Venus: Libra 0-15
+    {10, 0.0, 20.0}   // Saturn: Aquarius 0-20
+};
+
+// Natural (naisargika) relationship of row planet towards column planet:
+// +1 friend, 0 neutral, -1 enemy
+constexpr int8_t naturalRelation[SevenPlanets][SevenPlanets] = {
+    //  Su  Mo  Ma  Me  Ju  Ve  Sa
+    {   0,  1,  1,  0,  1, -1, -1 },  // Sun
+    {   1,  0,  0,  1,  0,  0,  0 },  // Moon
+    {   1,  1,  0, -1,  1,  0,  0 },  // Mars
+    {   1, -1,  0,  0,  0,  1,  0 },  // Mercury
+    {   1,  1,  1, -1,  0, -1,  0 },  // Jupiter
+    {  -1, -1,  0,  1,  0,  0,  1 },  // Venus
+    {  -1, -1, -1,  1,  0,  1,  0 }   // Saturn
+};
+
+// Temporary (tatkalika) friendship: planets in the 2nd, 3rd, 4th, 10th,
+// 11th and 12th from a planet are its temporary friends
+inline int temporaryRelation(int fromSign, int toSign) {
+    int distance = (toSign - fromSign + SignCount) % SignCount + 1;
+    switch (distance) {
+        case 2: case 3: case 4: case 10: case 11: case 12:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+// Compound (panchadha) relationship of a planet towards another, from
+// adhishatru (-2) to adhimitra (+2), given the signs both occupy
+inline int compoundRelation(int planet, int other, int planetSign, int otherSign) {
+    return naturalRelation[planet][other] + temporaryRelation(planetSign, otherSign);
+}
+
+// House (1-12) containing a longitude, given twelve cusp longitudes
+inline int houseOf(double longitude, const double* cusps) {
+    for (int i = 0; i < 12; ++i) {
+        double span = normalizeDegrees(cusps[(i + 1) % 12] - cusps[i]);
+        if (normalizeDegrees(longitude - cusps[i]) < span) {
+            return i + 1;
+        }
+    }
+    // Degenerate cusps: fall back to whole signs from the ascendant
+    return (signOf(longitude) - signOf(cusps[0]) + SignCount) % SignCount + 1;
+}
+
+inline bool isInOwnSign(int planet, int sign) {
+    return (ownSignMask[planet] >> sign) & 1u;
+}
+
+inline bool isExalted(int planet, int sign) {
+    return signOf(exaltationLongitude[planet]) == sign;
+}
+
+inline bool isDebilitated(int planet, int sign) {
+    return signOf(exaltationLongitude[planet] + 180.0) == sign;
+}
+
+} // namespace Astro
+
+#endif // PLANETDATA_H
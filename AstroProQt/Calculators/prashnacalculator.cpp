@@ -0,0 +1,64 @@
+#include "prashnacalculator.h"
+#include <cmath>
+
+using namespace Astro;
+
+namespace {
+
+// Vimshottari sequence from Ashwini; it repeats every nine nakshatras
+constexpr int vimshottariLord[9] = {
+    Ketu, Venus, Sun, Moon, Mars, Rahu, Jupiter, Saturn, Mercury
+};
+
+const char* const nakshatraNames[27] = {
+    "Ashwini", "Bharani", "Krittika", "Rohini", "Mrigashira", "Ardra",
+    "Punarvasu", "Pushya", "Ashlesha", "Magha", "Purva Phalguni",
+    "Uttara Phalguni", "Hasta", "Chitra", "Swati", "Vishakha", "Anuradha",
+    "Jyeshtha", "Mula", "Purva Ashadha", "Uttara Ashadha", "Shravana",
+    "Dhanishta", "Shatabhisha", "Purva Bhadrapada", "Uttara Bhadrapada",
+    "Revati"
+};
+
+} // namespace
+
+int PrashnaCalculator::nakshatraOf(double longitude) {
+    return qMin(26, static_cast<int>(normalizeDegrees(longitude) / NAKSHATRA_SPAN));
+}
+
+int PrashnaCalculator::starLord(double longitude) {
+    return vimshottariLord[nakshatraOf(longitude) % 9];
+}
+
+QString PrashnaCalculator::nakshatraName(int nakshatra) {
+    return (nakshatra >= 0 && nakshatra < 27) ? QString(nakshatraNames[nakshatra]) : QString();
+}
+
+PrashnaCalculator::Moment PrashnaCalculator::evaluate(double sun, double moon, double ascendant,
+                                                      double julianDay, double geoLongitude) {
+    Moment moment;
+    moment.ascendant = normalizeDegrees(ascendant);
+    moment.ascendantSign = signOf(ascendant);
+
+    const double moonLongitude = normalizeDegrees(moon);
+    moment.nakshatra = nakshatraOf(moonLongitude);
+    moment.pada = qMin(4, static_cast<int>(std::fmod(moonLongitude, NAKSHATRA_SPAN) /
+                                           (NAKSHATRA_SPAN / 4.0)) + 1);
+
+    // Same sunrise model as Kala Bala: the Sun's diurnal arc from the
+    // ascendant, one hour per 15 degrees. Local mean time decides which
+    // civil day the sunrise belongs to.
+    const double localDay = julianDay + 0.5 + geoLongitude / 360.0;
+    const qint64 dayNumber = static_cast<qint64>(std::floor(localDay));
+    const double localHours = (localDay - std::floor(localDay)) * 24.0;
+    const double hoursSinceSunrise = normalizeDegrees(ascendant - sun) / 15.0;
+    const qint64 day = dayNumber - (localHours < hoursSinceSunrise ? 1 : 0);
+    moment.dayLord = weekdayLord(day);
+    moment.horaLord = horaLord(moment.dayLord, static_cast<int>(hoursSinceSunrise));
+
+    moment.rulingPlanets[AscendantSignLord] = signLord[moment.ascendantSign];
+    moment.rulingPlanets[AscendantStarLord] = starLord(ascendant);
+    moment.rulingPlanets[MoonSignLord] = signLord[signOf(moonLongitude)];
+    moment.rulingPlanets[MoonStarLord] = starLord(moonLongitude);
+    moment.rulingPlanets[DayLord] = moment.dayLord;
+    return moment;
+}
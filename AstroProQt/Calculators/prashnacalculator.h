@@ -0,0 +1,46 @@
+#ifndef PRASHNACALCULATOR_H
+#define PRASHNACALCULATOR_H
+
+#include <QString>
+#include "planetdata.h"
+
+// Time-of-question (prashna) readings for a live chart: the rising sign,
+// the Moon's nakshatra and pada, the weekday and hora lords, and the
+// Krishnamurti (KP) ruling planets. Everything follows from the Sun, Moon
+// and ascendant longitudes and the moment, so it is cheap enough to run on
+// every tick.
+class PrashnaCalculator {
+public:
+    enum RulingPlanet {
+        AscendantSignLord = 0,
+        AscendantStarLord,
+        MoonSignLord,
+        MoonStarLord,
+        DayLord,
+        RulingPlanetCount
+    };
+
+    struct Moment {
+        double ascendant;
+        int ascendantSign;
+        int nakshatra;      // Moon's nakshatra, 0 = Ashwini
+        int pada;           // 1-4
+        int dayLord;        // Astro::Planet; the Vedic day starts at sunrise
+        int horaLord;
+        int rulingPlanets[RulingPlanetCount];
+    };
+
+    // Longitudes are sidereal degrees; the Julian day is UT and the
+    // geographic longitude (east positive) places local mean time
+    static Moment evaluate(double sun, double moon, double ascendant,
+                           double julianDay, double geoLongitude);
+
+    // Vimshottari lord of the nakshatra containing a longitude
+    static int starLord(double longitude);
+    static int nakshatraOf(double longitude);
+    static QString nakshatraName(int nakshatra);
+
+    static constexpr double NAKSHATRA_SPAN = 360.0 / 27.0;
+};
+
+#endif // PRASHNACALCULATOR_H
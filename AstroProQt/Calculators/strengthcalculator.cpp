@@ -1,231 +1,457 @@
 #include "strengthcalculator.h"
 #include <QtMath>
+#include <cmath>
+#include <limits>
 
-StrengthCalculator::StrengthCalculator() {
-    initializeRulershipTable();
-    initializeExaltationTable();
-    initializeAspectTable();
-}
+using namespace Astro;
 
-void StrengthCalculator::initializeRulershipTable() {
-    // Planet rulership in signs (0 = Aries, 11 = Pisces)
-    rulershipTable = {
-        {"Sun", {4}},          // Leo
-        {"Moon", {3}},         // Cancer
-        {"Mars", {0, 7}},      // Aries, Scorpio
-        {"Mercury", {2, 5}},   // Gemini, Virgo
-        {"Jupiter", {8, 11}},  // Sagittarius, Pisces
-        {"Venus", {1, 6}},     // Taurus, Libra
-        {"Saturn", {9, 10}},   // Capricorn, Aquarius
-        {"Rahu", {}},          // No rulership
-        {"Ketu", {}}           // No rulership
-    };
-}
+namespace {
 
-void StrengthCalculator::initializeExaltationTable() {
-    // Exaltation points for planets (degree, sign)
-    exaltationTable = {
-        {"Sun", {10, 0}},      // 10° Aries
-        {"Moon", {3, 1}},      // 3° Taurus
-        {"Mars", {28, 9}},     // 28° Capricorn
-        {"Mercury", {15, 5}},  // 15° Virgo
-        {"Jupiter", {5, 3}},   // 5° Cancer
-        {"Venus", {27, 11}},   // 27° Pisces
-        {"Saturn", {20, 6}},   // 20° Libra
-        {"Rahu", {20, 2}},     // 20° Gemini
-        {"Ketu", {20, 8}}      // 20° Sagittarius
-    };
+// Naisargika (natural) strength in virupas
+constexpr double naisargikaTable[SevenPlanets] = {
+    60.0, 51.43, 17.14, 25.70, 34.28, 42.85, 8.57
+};
+
+// Minimum Shadbala in rupas for a planet to be considered strong
+constexpr double requiredRupasTable[SevenPlanets] = {
+    6.5, 6.0, 5.0, 7.0, 6.5, 5.5, 5.0
+};
+
+// Mean daily motion in degrees, used as the Cheshta reference
+constexpr double meanSpeed[SevenPlanets] = {
+    0.9856, 13.1764, 0.5240, 0.9856, 0.0831, 0.9856, 0.0335
+};
+
+// Cusp at which each planet has no directional strength:
+// Sun/Mars 4th, Moon/Venus 10th, Mercury/Jupiter 7th, Saturn 1st
+constexpr int powerlessCusp[SevenPlanets] = { 3, 9, 3, 6, 6, 9, 0 };
+
+// Kendradi Bala for kendra, panaphara and apoklima houses
+constexpr double kendradiValue[3] = { 60.0, 30.0, 15.0 };
+
+// Decanate (0-2) that gives Drekkana Bala: male, female, neutral planets
+constexpr int drekkanaPart[SevenPlanets] = { 0, 2, 0, 1, 0, 2, 1 };
+
+// Moon and Venus gain Ojhayugma Bala in even signs, the rest in odd signs
+constexpr int prefersEvenSign[SevenPlanets] = { 0, 1, 0, 0, 0, 1, 0 };
+
+// Nathonnata: value = dayWeight * divaBala + base
+constexpr double nathonnataWeight[SevenPlanets] = { 1, -1, -1, 0, 1, 1, -1 };
+constexpr double nathonnataBase[SevenPlanets] = { 0, 60, 60, 60, 0, 0, 60 };
+
+// Paksha: benefics take the waxing strength, malefics its complement;
+// the Moon's Paksha Bala is doubled
+constexpr double pakshaWeight[SevenPlanets] = { -1, 2, -1, 1, 1, 1, -1 };
+constexpr double pakshaBase[SevenPlanets] = { 60, 0, 60, 0, 0, 0, 60 };
+
+// Ayana: +1 gains with north declination, -1 with south, 0 with either;
+// the Sun's Ayana Bala is doubled
+constexpr double ayanaDirection[SevenPlanets] = { 1, -1, 1, 0, 1, 1, -1 };
+constexpr double ayanaMultiplier[SevenPlanets] = { 2, 1, 1, 1, 1, 1, 1 };
+
+// Lords of the three parts of the day and of the night
+constexpr int dayTribhagaLord[3] = { Mercury, Sun, Saturn };
+constexpr int nightTribhagaLord[3] = { Moon, Venus, Mars };
+
+// Divisions used for Saptavargaja Bala
+constexpr int saptavarga[7] = {
+    VargaCalculator::D1, VargaCalculator::D2, VargaCalculator::D3,
+    VargaCalculator::D7, VargaCalculator::D9, VargaCalculator::D12,
+    VargaCalculator::D30
+};
+
+constexpr double OBLIQUITY = 23.44;
+constexpr qint64 KALI_EPOCH_DAY = 588466; // Julian day number, a Friday
+
+} // namespace
+
+StrengthCalculator::StrengthCalculator() {}
+
+double StrengthCalculator::requiredRupas(int planet) {
+    return (planet >= 0 && planet < SevenPlanets) ? requiredRupasTable[planet] : 0.0;
 }
 
-void StrengthCalculator::initializeAspectTable() {
-    // Special aspects for planets (degrees and strength)
-    aspectTable = {
-        {"Mars", {{90, 0.5}, {120, 0.75}, {180, 1.0}}},
-        {"Jupiter", {{60, 0.5}, {120, 0.75}, {180, 1.0}}},
-        {"Saturn", {{60, 0.5}, {90, 0.75}, {180, 1.0}}}
-    };
+StrengthCalculator::ChartContext StrengthCalculator::makeContext(
+    const QVector<double>& housePositions, const QDateTime& birthTime) {
+
+    ChartContext context;
+    for (int i = 0; i < 12 && i < housePositions.size(); ++i) {
+        context.cusps[i] = normalizeDegrees(housePositions[i]);
+    }
+
+    if (birthTime.isValid()) {
+        context.dayNumber = birthTime.date().toJulianDay();
+        context.localHours = birthTime.time().msecsSinceStartOfDay() / 3600000.0;
+        context.hasTime = true;
+    }
+    // Declination needs the tropical longitude; a chart without a date
+    // takes the J2000 ayanamsa
+    context.ayanamsa = meanAyanamsa(context.hasTime ? context.dayNumber : 2451545.0);
+    return context;
 }
 
-QMap<QString, PlanetaryStrength> StrengthCalculator::calculateStrengths(
-    const QMap<QString, double>& planetPositions,
-    const QVector<double>& housePositions) {
-    
+QMap<QString, StrengthCalculator::PlanetaryStrength>
+StrengthCalculator::calculateAllStrengths(
+    const QMap<QString, double>& planetaryPositions,
+    const QVector<double>& housePositions,
+    const QDateTime& birthTime,
+    const QMap<QString, double>& planetarySpeeds,
+    const AspectMatrix* aspects,
+    const VargaCalculator::VargaMatrix* vargas) {
+
     QMap<QString, PlanetaryStrength> strengths;
-    
-    // Calculate strength for each planet
-    for (auto it = planetPositions.begin(); it != planetPositions.end(); ++it) {
-        QString planet = it.key();
-        double position = it.value();
-        
+
+    // Shadbala is only defined for a complete chart
+    if (housePositions.size() < 12) return strengths;
+    for (int p = 0; p < SevenPlanets; ++p) {
+        if (!planetaryPositions.contains(planetName(p))) return strengths;
+    }
+
+    ShadbalaBatch batch;
+    for (int p = 0; p < SevenPlanets; ++p) {
+        const QString name = planetName(p);
+        batch.longitude[p] = normalizeDegrees(planetaryPositions.value(name));
+        batch.speed[p] = planetarySpeeds.value(name, std::numeric_limits<double>::quiet_NaN());
+    }
+
+    ChartContext context = makeContext(housePositions, birthTime);
+    context.aspects = aspects;
+    context.vargas = vargas;
+    computeShadbala(batch, context);
+
+    for (int p = 0; p < SevenPlanets; ++p) {
         PlanetaryStrength strength;
-        
-        // Calculate Shadbala (six-fold strength)
-        strength.positional = calculatePositionalStrength(planet, position, housePositions);
-        strength.directional = calculateDirectionalStrength(planet, position);
-        strength.temporal = calculateTemporalStrength(planet, position);
-        strength.motional = calculateMotionalStrength(planet, position);
-        strength.aspectual = calculateAspectualStrength(planet, position, planetPositions);
-        strength.natural = calculateNaturalStrength(planet);
-        
-        // Calculate total strength
-        strength.total = strength.positional + strength.directional + 
-                        strength.temporal + strength.motional + 
-                        strength.aspectual + strength.natural;
-                        
-        strengths[planet] = strength;
-    }
-    
+        strength.uchchaBala = batch.uchcha[p];
+        strength.saptavargajaBala = batch.saptavargaja[p];
+        strength.ojhayugmaBala = batch.ojhayugma[p];
+        strength.kendradiBala = batch.kendradi[p];
+        strength.drekkanaBala = batch.drekkana[p];
+        strength.nathonnataBala = batch.nathonnata[p];
+        strength.pakshaBala = batch.paksha[p];
+        strength.tribhagaBala = batch.tribhaga[p];
+        strength.abdaBala = batch.abda[p];
+        strength.masaBala = batch.masa[p];
+        strength.varaBala = batch.vara[p];
+        strength.horaBala = batch.hora[p];
+        strength.ayanaBala = batch.ayana[p];
+
+        strength.sthanaBala = batch.sthana[p];
+        strength.digBala = batch.dig[p];
+        strength.kalaBala = batch.kala[p];
+        strength.cheshtaBala = batch.cheshta[p];
+        // The luminaries' Cheshta Bala does not depend on their speed
+        strength.motionKnown = p == Sun || p == Moon || !std::isnan(batch.speed[p]);
+        strength.naisargikaBala = batch.naisargika[p];
+        strength.drishtisBala = batch.drik[p];
+        strength.vimsopakaBala = batch.vimsopaka[p];
+
+        strength.shadbala = batch.total[p];
+        strength.rupas = batch.total[p] / 60.0;
+        strength.requiredRupas = requiredRupasTable[p];
+
+        strengths[planetName(p)] = strength;
+    }
+
     return strengths;
 }
 
-double StrengthCalculator::calculatePositionalStrength(
-    const QString& planet, double position, const QVector<double>& houses) {
-    
-    double strength = 0.0;
-    int sign = static_cast<int>(position / 30);
-    
-    // Check ownership
-    if (rulershipTable[planet].contains(sign)) {
-        strength += 5.0;
-    }
-    
-    // Check exaltation
-    if (exaltationTable.contains(planet)) {
-        QPair<int, int> exaltPoint = exaltationTable[planet];
-        double distance = qAbs(position - (exaltPoint.second * 30 + exaltPoint.first));
-        if (distance < 30) {
-            strength += (30 - distance) / 6.0; // Maximum 5 points for exact exaltation
+void StrengthCalculator::computeShadbala(ShadbalaBatch& batch,
+                                         const ChartContext& context) const {
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.sign[p] = signOf(batch.longitude[p]);
+        batch.house[p] = houseOf(batch.longitude[p], context.cusps);
+    }
+
+    // Divisional signs come from the chart's varga matrix when shared
+    VargaCalculator::VargaMatrix localVargas;
+    const VargaCalculator::VargaMatrix* vargas = context.vargas;
+    if (!vargas) {
+        qint32 arcSeconds[VargaCalculator::BodyCount] = {};
+        for (int p = 0; p < SevenPlanets; ++p) {
+            arcSeconds[p] = VargaCalculator::toArcSeconds(batch.longitude[p]);
+        }
+        arcSeconds[VargaCalculator::Ascendant] = VargaCalculator::toArcSeconds(context.cusps[0]);
+        const quint16 present = ((1u << SevenPlanets) - 1) | (1u << VargaCalculator::Ascendant);
+        localVargas = VargaCalculator().calculate(arcSeconds, present);
+        vargas = &localVargas;
+    }
+
+    computeSthanaBala(batch, context, *vargas);
+    computeDigBala(batch, context);
+    computeKalaBala(batch, context);
+    computeCheshtaBala(batch);   // Sun and Moon reuse Ayana/Paksha
+    computeDrikBala(batch, context);
+
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.naisargika[p] = naisargikaTable[p];
+        batch.total[p] = batch.sthana[p] + batch.dig[p] + batch.kala[p] +
+                         batch.cheshta[p] + batch.naisargika[p] + batch.drik[p];
+        batch.vimsopaka[p] = vargas->vimsopaka[VargaCalculator::Shodasavarga][p];
+    }
+}
+
+void StrengthCalculator::computeSthanaBala(ShadbalaBatch& batch,
+                                           const ChartContext& context,
+                                           const VargaCalculator::VargaMatrix& vargas) const {
+    // Uchcha: one third of the arc from the debilitation point
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.uchcha[p] = angularDistance(batch.longitude[p],
+                                          exaltationLongitude[p] + 180.0) / 3.0;
+    }
+
+    // Compound (panchadha) relationship from natural and temporary friendship
+    int compound[SevenPlanets][SevenPlanets];
+    for (int p = 0; p < SevenPlanets; ++p) {
+        for (int q = 0; q < SevenPlanets; ++q) {
+            int temporary = context.aspects
+                ? temporaryRelation(0, context.aspects->signDistance(p, q))
+                : temporaryRelation(batch.sign[p], batch.sign[q]);
+            compound[p][q] = (p == q) ? 0 : naturalRelation[p][q] + temporary;
         }
     }
-    
-    // Check house placement
-    int house = 1;
-    for (int i = 0; i < houses.size(); ++i) {
-        if (position >= houses[i] && position < houses[(i + 1) % 12]) {
-            house = i + 1;
-            break;
+
+    // Saptavargaja: dignity in the seven divisional charts
+    for (int p = 0; p < SevenPlanets; ++p) {
+        const double degree = batch.longitude[p] - batch.sign[p] * 30.0;
+        const bool inMoolatrikona = batch.sign[p] == moolatrikona[p].sign &&
+                                    degree >= moolatrikona[p].from &&
+                                    degree < moolatrikona[p].to;
+        double total = 0.0;
+        for (int varga : saptavarga) {
+            int sign = vargas.signOf(varga, p);
+            total += vargaDignity(p, sign, varga == VargaCalculator::D1 && inMoolatrikona,
+                                  compound);
         }
+        batch.saptavargaja[p] = total;
+    }
+
+    // Ojhayugma: odd/even sign in Rasi and Navamsa, 15 each
+    for (int p = 0; p < SevenPlanets; ++p) {
+        int navamsa = vargas.signOf(VargaCalculator::D9, p);
+        int rasiEven = batch.sign[p] & 1;   // Aries (0) is an odd sign
+        int navamsaEven = navamsa & 1;
+        batch.ojhayugma[p] = 15.0 * (rasiEven == prefersEvenSign[p]) +
+                             15.0 * (navamsaEven == prefersEvenSign[p]);
+    }
+
+    // Kendradi: 60 in kendras, 30 in panapharas, 15 in apoklimas
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.kendradi[p] = kendradiValue[(batch.house[p] - 1) % 3];
+    }
+
+    // Drekkana: 15 when the decanate matches the planet's gender
+    for (int p = 0; p < SevenPlanets; ++p) {
+        int part = qMin(2, static_cast<int>((batch.longitude[p] - batch.sign[p] * 30.0) / 10.0));
+        batch.drekkana[p] = (part == drekkanaPart[p]) ? 15.0 : 0.0;
+    }
+
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.sthana[p] = batch.uchcha[p] + batch.saptavargaja[p] +
+                          batch.ojhayugma[p] + batch.kendradi[p] +
+                          batch.drekkana[p];
     }
-    
-    // Add house-based strength
-    switch (house) {
-        case 1: case 4: case 7: case 10: // Angular houses
-            strength += 3.0;
-            break;
-        case 2: case 5: case 8: case 11: // Succedent houses
-            strength += 2.0;
-            break;
-        default: // Cadent houses
-            strength += 1.0;
-            break;
-    }
-    
-    return strength;
 }
 
-double StrengthCalculator::calculateDirectionalStrength(const QString& planet, double position) {
-    // Calculate strength based on planetary dignities in different directions
-    double strength = 0.0;
-    int sign = static_cast<int>(position / 30);
-    
-    // Cardinal directions strength
-    switch (sign) {
-        case 0: case 1: case 2: // East (Aries to Gemini)
-            if (planet == "Jupiter" || planet == "Mercury") strength += 2.0;
-            break;
-        case 3: case 4: case 5: // North (Cancer to Virgo)
-            if (planet == "Moon" || planet == "Venus") strength += 2.0;
-            break;
-        case 6: case 7: case 8: // West (Libra to Sagittarius)
-            if (planet == "Saturn" || planet == "Sun") strength += 2.0;
-            break;
-        case 9: case 10: case 11: // South (Capricorn to Pisces)
-            if (planet == "Mars") strength += 2.0;
-            break;
-    }
-    
-    return strength;
+void StrengthCalculator::computeDigBala(ShadbalaBatch& batch,
+                                        const ChartContext& context) const {
+    // One third of the arc from the point of no directional strength
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.dig[p] = angularDistance(batch.longitude[p],
+                                       context.cusps[powerlessCusp[p]]) / 3.0;
+    }
 }
 
-double StrengthCalculator::calculateTemporalStrength(const QString& planet, double position) {
-    // Calculate strength based on time of day/night
-    double strength = 0.0;
-    int sign = static_cast<int>(position / 30);
-    bool isDiurnal = (sign >= 0 && sign <= 5); // Above horizon
-    
-    // Diurnal planets
-    if (isDiurnal && (planet == "Sun" || planet == "Jupiter" || planet == "Saturn")) {
-        strength += 2.0;
-    }
-    // Nocturnal planets
-    else if (!isDiurnal && (planet == "Moon" || planet == "Venus" || planet == "Mars")) {
-        strength += 2.0;
-    }
-    // Mercury is strong in both
-    else if (planet == "Mercury") {
-        strength += 1.0;
-    }
-    
-    return strength;
+void StrengthCalculator::computeKalaBala(ShadbalaBatch& batch,
+                                         const ChartContext& context) const {
+    // Sun's diurnal arc from the ascendant: 0 at sunrise, 90 at noon,
+    // 180 at sunset. One degree corresponds to four minutes of time.
+    const double sinceSunrise = normalizeDegrees(context.cusps[0] - batch.longitude[Sun]);
+    const bool isDay = sinceSunrise < 180.0;
+
+    // Nathonnata: diva bala peaks at noon, ratri bala at midnight
+    const double divaBala = 60.0 * (1.0 - angularDistance(sinceSunrise, 90.0) / 180.0);
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.nathonnata[p] = nathonnataWeight[p] * divaBala + nathonnataBase[p];
+    }
+
+    // Paksha: Moon-Sun elongation, 60 at full Moon
+    const double shukla = angularDistance(batch.longitude[Moon], batch.longitude[Sun]) / 3.0;
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.paksha[p] = pakshaWeight[p] * shukla + pakshaBase[p];
+    }
+
+    // Tribhaga: lord of the current third of day or night, Jupiter always
+    const int part = qMin(2, static_cast<int>((isDay ? sinceSunrise : sinceSunrise - 180.0) / 60.0));
+    const int tribhagaLord = isDay ? dayTribhagaLord[part] : nightTribhagaLord[part];
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.tribhaga[p] = (p == tribhagaLord || p == Jupiter) ? 60.0 : 0.0;
+    }
+
+    // Abda, Masa, Vara and Hora lords. The Vedic day starts at sunrise, so
+    // a birth before sunrise belongs to the previous weekday.
+    int abdaLord = -1, masaLord = -1, varaLord = -1, horaLord = -1;
+    if (context.hasTime) {
+        const double hoursSinceSunrise = sinceSunrise / 15.0;
+        const qint64 day = context.dayNumber -
+                           (context.localHours < hoursSinceSunrise ? 1 : 0);
+        const qint64 ahargana = day - KALI_EPOCH_DAY;
+
+        varaLord = weekdayLord(day);
+        abdaLord = weekdayLord(KALI_EPOCH_DAY + (ahargana / 360) * 360);
+        masaLord = weekdayLord(KALI_EPOCH_DAY + (ahargana / 30) * 30);
+
+        const int horaCount = static_cast<int>(hoursSinceSunrise);
+        horaLord = Astro::horaLord(varaLord, horaCount);
+    }
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.abda[p] = (p == abdaLord) ? 15.0 : 0.0;
+        batch.masa[p] = (p == masaLord) ? 30.0 : 0.0;
+        batch.vara[p] = (p == varaLord) ? 45.0 : 0.0;
+        batch.hora[p] = (p == horaLord) ? 60.0 : 0.0;
+    }
+
+    // Ayana: declination from the tropical ecliptic longitude, 24° of
+    // kranti = 30
+    const double sinObliquity = std::sin(qDegreesToRadians(OBLIQUITY));
+    for (int p = 0; p < SevenPlanets; ++p) {
+        const double tropical = batch.longitude[p] + context.ayanamsa;
+        double declination = qRadiansToDegrees(
+            std::asin(sinObliquity * std::sin(qDegreesToRadians(tropical))));
+        double kranti = ayanaDirection[p] != 0 ? ayanaDirection[p] * declination
+                                               : std::fabs(declination);
+        batch.ayana[p] = ayanaMultiplier[p] * (24.0 + kranti) / 48.0 * 60.0;
+    }
+
+    for (int p = 0; p < SevenPlanets; ++p) {
+        batch.kala[p] = batch.nathonnata[p] + batch.paksha[p] +
+                        batch.tribhaga[p] + batch.abda[p] + batch.masa[p] +
+                        batch.vara[p] + batch.hora[p] + batch.ayana[p];
+    }
 }
 
-double StrengthCalculator::calculateMotionalStrength(const QString& planet, double position) {
-    // Base implementation - would need actual planetary motion data
-    // Returns a default value for now
-    return 1.0;
+void StrengthCalculator::computeCheshtaBala(ShadbalaBatch& batch) const {
+    for (int p = Mars; p < SevenPlanets; ++p) {
+        double ratio = batch.speed[p] / meanSpeed[p];
+        double value;
+        if (std::isnan(ratio)) value = 0.0;   // Motion unknown
+        else if (ratio < 0.0) value = 60.0;   // Vakra (retrograde)
+        else if (ratio < 0.5) value = 15.0;   // Vikala / Mandatara
+        else if (ratio < 0.9) value = 30.0;   // Manda
+        else if (ratio <= 1.1) value = 7.5;   // Sama
+        else if (ratio <= 1.5) value = 45.0;  // Chara
+        else value = 30.0;                    // Atichara
+        batch.cheshta[p] = value;
+    }
+
+    // The luminaries take their Ayana and Paksha Bala (undoubled)
+    batch.cheshta[Sun] = batch.ayana[Sun] / ayanaMultiplier[Sun];
+    batch.cheshta[Moon] = batch.paksha[Moon] / pakshaWeight[Moon];
 }
 
-double StrengthCalculator::calculateAspectualStrength(
-    const QString& planet, double position,
-    const QMap<QString, double>& planetPositions) {
-    
-    double strength = 0.0;
-    
-    // Check aspects from other planets
-    for (auto it = planetPositions.begin(); it != planetPositions.end(); ++it) {
-        if (it.key() == planet) continue;
-        
-        double aspect = calculateAspect(position, it.value());
-        
-        // Check if this aspect is special for the aspecting planet
-        if (aspectTable.contains(it.key())) {
-            const QVector<QPair<double, double>>& specialAspects = aspectTable[it.key()];
-            for (const auto& specialAspect : specialAspects) {
-                if (qAbs(aspect - specialAspect.first) < 1.0) {
-                    strength += specialAspect.second;
-                    break;
-                }
-            }
+void StrengthCalculator::computeDrikBala(ShadbalaBatch& batch,
+                                         const ChartContext& context) const {
+    // The Moon is benefic while waxing; Mercury is taken as benefic
+    const bool moonWaxing = normalizeDegrees(batch.longitude[Moon] - batch.longitude[Sun]) < 180.0;
+    const double aspectSign[SevenPlanets] = {
+        -1.0, moonWaxing ? 1.0 : -1.0, -1.0, 1.0, 1.0, 1.0, -1.0
+    };
+
+    for (int target = 0; target < SevenPlanets; ++target) {
+        double sum = 0.0;
+        for (int aspector = 0; aspector < SevenPlanets; ++aspector) {
+            if (aspector == target) continue;
+            double angle = context.aspects
+                ? context.aspects->arc(aspector, target)
+                : normalizeDegrees(batch.longitude[target] - batch.longitude[aspector]);
+            sum += aspectSign[aspector] * drishtiValue(aspector, angle);
         }
-        
-        // Standard aspects
-        if (qAbs(aspect - 120) < 1.0) strength += 0.5; // Trine
-        else if (qAbs(aspect - 60) < 1.0) strength += 0.3; // Sextile
-        else if (qAbs(aspect - 0) < 1.0) strength += 0.2; // Conjunction
-    }
-    
-    return strength;
+        batch.drik[target] = sum / 4.0;
+    }
 }
 
-double StrengthCalculator::calculateNaturalStrength(const QString& planet) {
-    // Base natural strengths for planets
-    static const QMap<QString, double> naturalStrengths = {
-        {"Sun", 5.0},
-        {"Moon", 4.0},
-        {"Jupiter", 4.0},
-        {"Venus", 3.0},
-        {"Mercury", 3.0},
-        {"Mars", 2.0},
-        {"Saturn", 2.0},
-        {"Rahu", 1.0},
-        {"Ketu", 1.0}
-    };
-    
-    return naturalStrengths.value(planet, 0.0);
+double StrengthCalculator::calculateShadbala(
+    const QString& planet,
+    const QMap<QString, double>& planetaryPositions,
+    const QVector<double>& housePositions,
+    const QDateTime& birthTime) {
+
+    return calculateAllStrengths(planetaryPositions, housePositions, birthTime)
+        .value(planet).shadbala;
+}
+
+double StrengthCalculator::calculateDigBala(const QString& planet, double longitude,
+                                            const QVector<double>& housePositions) const {
+    int p = planetIndex(planet);
+    if (p < 0 || p >= SevenPlanets || housePositions.size() < 12) return 0.0;
+    return angularDistance(longitude, housePositions[powerlessCusp[p]]) / 3.0;
+}
+
+double StrengthCalculator::calculateDrishtiBala(
+    const QString& planet,
+    const QMap<QString, double>& planetaryPositions) const {
+
+    int target = planetIndex(planet);
+    if (target < 0 || !planetaryPositions.contains(planet)) return 0.0;
+
+    bool moonWaxing = true;
+    if (planetaryPositions.contains("Moon") && planetaryPositions.contains("Sun")) {
+        moonWaxing = normalizeDegrees(planetaryPositions["Moon"] -
+                                      planetaryPositions["Sun"]) < 180.0;
+    }
+
+    double sum = 0.0;
+    for (int aspector = 0; aspector < SevenPlanets; ++aspector) {
+        if (aspector == target || !planetaryPositions.contains(planetName(aspector))) continue;
+
+        bool benefic = aspector == Jupiter || aspector == Venus ||
+                       aspector == Mercury || (aspector == Moon && moonWaxing);
+        double angle = normalizeDegrees(planetaryPositions[planet] -
+                                        planetaryPositions[planetName(aspector)]);
+        double value = drishtiValue(aspector, angle);
+        sum += benefic ? value : -value;
+    }
+    return sum / 4.0;
+}
+
+double StrengthCalculator::vargaDignity(
+    int planet, int vargaSign, bool inMoolatrikona,
+    const int (&compound)[SevenPlanets][SevenPlanets]) {
+
+    if (inMoolatrikona) return 45.0;
+    if (isInOwnSign(planet, vargaSign)) return 30.0;
+
+    switch (compound[planet][signLord[vargaSign]]) {
+        case 2:  return 22.5;   // Adhimitra
+        case 1:  return 15.0;   // Mitra
+        case 0:  return 7.5;    // Sama
+        case -1: return 3.75;   // Shatru
+        default: return 1.875;  // Adhishatru
+    }
 }
 
-double StrengthCalculator::calculateAspect(double pos1, double pos2) {
-    double diff = qAbs(pos1 - pos2);
-    if (diff > 180) diff = 360 - diff;
-    return diff;
+double StrengthCalculator::drishtiValue(int aspector, double angle) {
+    // Graded aspect value in virupas for an aspect angle of 0-360
+    double value;
+    if (angle < 30.0) value = 0.0;
+    else if (angle < 60.0) value = (angle - 30.0) / 2.0;
+    else if (angle < 90.0) value = angle - 45.0;
+    else if (angle < 120.0) value = (120.0 - angle) / 2.0 + 30.0;
+    else if (angle < 150.0) value = 150.0 - angle;
+    else if (angle < 180.0) value = (angle - 150.0) * 2.0;
+    else if (angle < 300.0) value = (300.0 - angle) / 2.0;
+    else value = 0.0;
+
+    // Special aspects of Mars (4th/8th), Jupiter (5th/9th), Saturn (3rd/10th)
+    if (aspector == Mars && ((angle >= 90.0 && angle < 120.0) ||
+                             (angle >= 210.0 && angle < 240.0))) {
+        value += 15.0;
+    } else if (aspector == Jupiter && ((angle >= 120.0 && angle < 150.0) ||
+                                       (angle >= 240.0 && angle < 270.0))) {
+        value += 30.0;
+    } else if (aspector == Saturn && ((angle >= 60.0 && angle < 90.0) ||
+                                      (angle >= 270.0 && angle < 300.0))) {
+        value += 45.0;
+    }
+
+    return qMin(60.0, value);
 }
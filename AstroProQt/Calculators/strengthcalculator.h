@@ -4,72 +4,158 @@
 #include <QString>
 #include <QMap>
 #include <QVector>
+#include <QDateTime>
+#include "planetdata.h"
+#include "aspectmatrix.h"
+#include "vargacalculator.h"
 
 class StrengthCalculator {
 public:
-    // Structure to hold various strength parameters
+    // Structure to hold various strength parameters (all values in virupas,
+    // 60 virupas = 1 rupa)
     struct PlanetaryStrength {
         double shadbala;      // Total Shadbala strength
         double sthanaBala;    // Positional strength
         double digBala;       // Directional strength
         double drishtisBala;  // Aspectual strength
         double kalaBala;      // Temporal strength
+        double cheshtaBala;   // Motional strength
+        bool motionKnown;     // False when no speed was given; cheshtaBala is then 0
         double naisargikaBala; // Natural strength
-        
+
+        // Sthana Bala components
+        double uchchaBala;
+        double saptavargajaBala;
+        double ojhayugmaBala;
+        double kendradiBala;
+        double drekkanaBala;
+
+        // Kala Bala components
+        double nathonnataBala;
+        double pakshaBala;
+        double tribhagaBala;
+        double abdaBala;
+        double masaBala;
+        double varaBala;
+        double horaBala;
+        double ayanaBala;
+
+        double vimsopakaBala;  // Shodasavarga Vimsopaka, 0-20 (not in the total)
+
+        double rupas;          // shadbala / 60
+        double requiredRupas;  // Classical minimum for the planet
+
         // Initialize with default values
-        PlanetaryStrength() 
-            : shadbala(0), sthanaBala(0), digBala(0),
-              drishtisBala(0), kalaBala(0), naisargikaBala(0) {}
+        PlanetaryStrength()
+            : shadbala(0), sthanaBala(0), digBala(0), drishtisBala(0),
+              kalaBala(0), cheshtaBala(0), motionKnown(true), naisargikaBala(0),
+              uchchaBala(0), saptavargajaBala(0), ojhayugmaBala(0),
+              kendradiBala(0), drekkanaBala(0), nathonnataBala(0),
+              pakshaBala(0), tribhagaBala(0), abdaBala(0), masaBala(0),
+              varaBala(0), horaBala(0), ayanaBala(0), vimsopakaBala(0),
+              rupas(0), requiredRupas(0) {}
+
+        // Shadbala relative to the classical requirement (>= 1.0 is strong)
+        double ratio() const {
+            return requiredRupas > 0 ? rupas / requiredRupas : 0.0;
+        }
+    };
+
+    // Chart-wide inputs shared by every planet
+    struct ChartContext {
+        double cusps[12];     // House cusps, 1st to 12th
+        qint64 dayNumber;     // Julian day number of the local civil date
+        double localHours;    // Local clock time of birth in hours
+        bool hasTime;
+        double ayanamsa;      // Added to the sidereal longitudes for tropical ones
+        const AspectMatrix* aspects;  // Optional shared pairwise angles
+        const VargaCalculator::VargaMatrix* vargas;  // Optional shared vargas
+
+        ChartContext() : cusps(), dayNumber(0), localHours(0), hasTime(false),
+                         ayanamsa(0), aspects(nullptr), vargas(nullptr) {}
+    };
+
+    // Structure-of-arrays over the seven classical planets. Every component
+    // is computed by a flat loop over these arrays so the arithmetic can be
+    // vectorised; Rahu and Ketu have no Shadbala.
+    struct ShadbalaBatch {
+        alignas(32) double longitude[Astro::SevenPlanets];
+        alignas(32) double speed[Astro::SevenPlanets];    // degrees/day, NaN if unknown
+        int sign[Astro::SevenPlanets];
+        int house[Astro::SevenPlanets];
+
+        alignas(32) double uchcha[Astro::SevenPlanets];
+        alignas(32) double saptavargaja[Astro::SevenPlanets];
+        alignas(32) double ojhayugma[Astro::SevenPlanets];
+        alignas(32) double kendradi[Astro::SevenPlanets];
+        alignas(32) double drekkana[Astro::SevenPlanets];
+        alignas(32) double dig[Astro::SevenPlanets];
+        alignas(32) double nathonnata[Astro::SevenPlanets];
+        alignas(32) double paksha[Astro::SevenPlanets];
+        alignas(32) double tribhaga[Astro::SevenPlanets];
+        alignas(32) double abda[Astro::SevenPlanets];
+        alignas(32) double masa[Astro::SevenPlanets];
+        alignas(32) double vara[Astro::SevenPlanets];
+        alignas(32) double hora[Astro::SevenPlanets];
+        alignas(32) double ayana[Astro::SevenPlanets];
+        alignas(32) double cheshta[Astro::SevenPlanets];
+        alignas(32) double naisargika[Astro::SevenPlanets];
+        alignas(32) double drik[Astro::SevenPlanets];
+        alignas(32) double vimsopaka[Astro::SevenPlanets];
+
+        alignas(32) double sthana[Astro::SevenPlanets];
+        alignas(32) double kala[Astro::SevenPlanets];
+        alignas(32) double total[Astro::SevenPlanets];
     };
 
     StrengthCalculator();
 
-    // Calculate complete strength for all planets
+    // Calculate complete strength for all planets. Speeds are in degrees
+    // per day; Mars to Saturn take no Cheshta Bala without one.
     QMap<QString, PlanetaryStrength> calculateAllStrengths(
         const QMap<QString, double>& planetaryPositions,
         const QVector<double>& housePositions,
-        const QDateTime& birthTime
+        const QDateTime& birthTime,
+        const QMap<QString, double>& planetarySpeeds = QMap<QString, double>(),
+        const AspectMatrix* aspects = nullptr,
+        const VargaCalculator::VargaMatrix* vargas = nullptr
     );
 
+    // Run every Shadbala component over a prepared batch. Longitudes,
+    // speeds and the chart context must be filled in by the caller; the
+    // varga matrix is built from the batch if the context has none.
+    void computeShadbala(ShadbalaBatch& batch, const ChartContext& context) const;
+
     // Individual strength calculations
-    double calculateShadbala(const QString& planet, 
-                           double longitude, 
+    double calculateShadbala(const QString& planet,
+                           const QMap<QString, double>& planetaryPositions,
                            const QVector<double>& housePositions,
                            const QDateTime& birthTime);
-    
-    double calculateDigBala(const QString& planet, double longitude);
-    double calculateDrishtiBala(const QString& planet, 
-                               const QMap<QString, double>& planetaryPositions);
 
-private:
-    // Constants for calculations
-    const QVector<QString> planets = {
-        "Sun", "Moon", "Mars", "Mercury", 
-        "Jupiter", "Venus", "Saturn", "Rahu", "Ketu"
-    };
+    double calculateDigBala(const QString& planet, double longitude,
+                            const QVector<double>& housePositions) const;
+    double calculateDrishtiBala(const QString& planet,
+                               const QMap<QString, double>& planetaryPositions) const;
 
-    // Exaltation degrees for planets
-    const QMap<QString, double> exaltationDegrees = {
-        {"Sun", 10},     // Aries 10°
-        {"Moon", 33},    // Taurus 3°
-        {"Mars", 298},   // Capricorn 28°
-        {"Mercury", 165},// Virgo 15°
-        {"Jupiter", 95}, // Cancer 5°
-        {"Venus", 357},  // Pisces 27°
-        {"Saturn", 200}  // Libra 20°
-    };
+    static ChartContext makeContext(const QVector<double>& housePositions,
+                                    const QDateTime& birthTime);
+
+    // Classical minimum Shadbala of a planet in rupas
+    static double requiredRupas(int planet);
+
+private:
+    // Component passes, each over all seven planets
+    void computeSthanaBala(ShadbalaBatch& batch, const ChartContext& context,
+                           const VargaCalculator::VargaMatrix& vargas) const;
+    void computeDigBala(ShadbalaBatch& batch, const ChartContext& context) const;
+    void computeKalaBala(ShadbalaBatch& batch, const ChartContext& context) const;
+    void computeCheshtaBala(ShadbalaBatch& batch) const;
+    void computeDrikBala(ShadbalaBatch& batch, const ChartContext& context) const;
 
-    // Helper methods
-    double calculateSthanaBala(const QString& planet, double longitude);
-    double calculateKalaBala(const QString& planet, 
-                           double longitude, 
-                           const QDateTime& birthTime);
-    double calculateNaisargikaBala(const QString& planet);
-    
     // Utility functions
-    double getExaltationStrength(const QString& planet, double longitude);
-    double getMoulaTrikonaStrength(const QString& planet, double longitude);
-    bool isInOwnSign(const QString& planet, double longitude);
+    static double drishtiValue(int aspector, double angle);
+    static double vargaDignity(int planet, int vargaSign, bool inMoolatrikona,
+                               const int (&compound)[Astro::SevenPlanets][Astro::SevenPlanets]);
 };
 
 #endif // STRENGTHCALCULATOR_H
@@ -0,0 +1,221 @@
+#include "vargacalculator.h"
+#include <QtGlobal>
+
+using namespace Astro;
+
+namespace {
+
+constexpr qint32 ARCSEC_PER_SIGN = 30 * 3600;
+constexpr qint32 ARCSEC_PER_CIRCLE = 360 * 3600;
+
+constexpr int divisionTable[VargaCalculator::VargaCount] = {
+    1, 2, 3, 4, 7, 9, 10, 12, 16, 20, 24, 27, 30, 40, 45, 60
+};
+
+// Every regular varga maps part n of a sign to (start + step * n) mod 12,
+// where start and step depend only on the rasi sign
+struct VargaRule {
+    quint8 start;
+    quint8 step;
+};
+
+struct RuleTable {
+    VargaRule rule[VargaCalculator::VargaCount][SignCount];
+};
+
+constexpr RuleTable makeRules() {
+    RuleTable table{};
+    for (int sign = 0; sign < SignCount; ++sign) {
+        const bool odd = (sign % 2) == 0;    // Aries (0) is an odd sign
+        const int modality = sign % 3;       // Movable, fixed, dual
+        const int element = sign % 4;        // Fire, earth, air, water
+        auto set = [&](int varga, int start, int step) {
+            table.rule[varga][sign] = { static_cast<quint8>(start % SignCount),
+                                        static_cast<quint8>(step % SignCount) };
+        };
+
+        set(VargaCalculator::D1, sign, 0);
+        // Hora: Leo then Cancer in odd signs, Cancer then Leo in even signs
+        set(VargaCalculator::D2, odd ? 4 : 3, odd ? 11 : 1);
+        // Drekkana: the sign, its 5th and its 9th
+        set(VargaCalculator::D3, sign, 4);
+        // Chaturthamsa: the sign and its kendras
+        set(VargaCalculator::D4, sign, 3);
+        // Saptamsa: from the sign if odd, from its 7th if even
+        set(VargaCalculator::D7, odd ? sign : sign + 6, 1);
+        // Navamsa: from Aries, Capricorn, Libra, Cancer by element
+        set(VargaCalculator::D9, element * 9, 1);
+        // Dasamsa: from the sign if odd, from its 9th if even
+        set(VargaCalculator::D10, odd ? sign : sign + 8, 1);
+        set(VargaCalculator::D12, sign, 1);
+        // Shodasamsa: from Aries, Leo, Sagittarius by modality
+        set(VargaCalculator::D16, modality * 4, 1);
+        // Vimsamsa: from Aries, Sagittarius, Leo by modality
+        set(VargaCalculator::D20, modality * 8, 1);
+        // Chaturvimsamsa: from Leo if odd, Cancer if even
+        set(VargaCalculator::D24, odd ? 4 : 3, 1);
+        // Bhamsa: from Aries, Cancer, Libra, Capricorn by element
+        set(VargaCalculator::D27, element * 3, 1);
+        // Trimsamsa is unequal and has its own table below
+        set(VargaCalculator::D30, sign, 0);
+        // Khavedamsa: from Aries if odd, Libra if even
+        set(VargaCalculator::D40, odd ? 0 : 6, 1);
+        // Akshavedamsa: from Aries, Leo, Sagittarius by modality
+        set(VargaCalculator::D45, modality * 4, 1);
+        // Shashtiamsa: from the sign itself
+        set(VargaCalculator::D60, sign, 1);
+    }
+    return table;
+}
+
+constexpr RuleTable rules = makeRules();
+
+// Trimsamsa sign for each whole degree of odd [0] and even [1] signs
+struct TrimsamsaTable {
+    quint8 sign[2][30];
+};
+
+constexpr TrimsamsaTable makeTrimsamsa() {
+    TrimsamsaTable table{};
+    for (int degree = 0; degree < 30; ++degree) {
+        // Odd: Mars 5, Saturn 5, Jupiter 8, Mercury 7, Venus 5
+        table.sign[0][degree] = degree < 5 ? 0 : degree < 10 ? 10 :
+                                degree < 18 ? 8 : degree < 25 ? 2 : 6;
+        // Even: Venus 5, Mercury 7, Jupiter 8, Saturn 5, Mars 5
+        table.sign[1][degree] = degree < 5 ? 1 : degree < 12 ? 5 :
+                                degree < 20 ? 11 : degree < 25 ? 9 : 7;
+    }
+    return table;
+}
+
+constexpr TrimsamsaTable trimsamsa = makeTrimsamsa();
+
+// Vimsopaka weight of each varga in each scheme
+constexpr double vimsopakaWeight[VargaCalculator::SchemeCount][VargaCalculator::VargaCount] = {
+    //  D1   D2   D3   D4   D7   D9  D10  D12  D16  D20  D24  D27  D30  D40  D45  D60
+    {  6.0, 2.0, 4.0, 0.0, 0.0, 5.0, 0.0, 2.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0 },
+    {  5.0, 2.0, 3.0, 0.0, 2.5, 4.5, 0.0, 2.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0 },
+    {  3.0, 1.5, 1.5, 0.0, 1.5, 1.5, 1.5, 1.5, 1.5, 0.0, 0.0, 0.0, 1.5, 0.0, 0.0, 5.0 },
+    {  3.5, 1.0, 1.0, 0.5, 0.5, 3.0, 0.5, 0.5, 2.0, 0.5, 0.5, 0.5, 1.0, 0.5, 0.5, 4.0 }
+};
+
+constexpr bool weightsTotalTwenty() {
+    for (const auto& scheme : vimsopakaWeight) {
+        double total = 0.0;
+        for (double weight : scheme) total += weight;
+        if (total != 20.0) return false;
+    }
+    return true;
+}
+
+static_assert(weightsTotalTwenty(), "Each Vimsopaka scheme must total 20");
+
+// Vimsopaka points by compound relationship with the sign lord,
+// from adhishatru (-2) to adhimitra (+2); own or exaltation sign gives 20
+constexpr double relationPoints[5] = { 5.0, 7.0, 10.0, 15.0, 18.0 };
+
+inline int signInVarga(int varga, int sign, qint32 withinSign) {
+    if (varga == VargaCalculator::D30) {
+        return trimsamsa.sign[sign & 1][withinSign / 3600];
+    }
+    const int part = withinSign * divisionTable[varga] / ARCSEC_PER_SIGN;
+    const VargaRule rule = rules.rule[varga][sign];
+    return (rule.start + rule.step * part) % SignCount;
+}
+
+} // namespace
+
+VargaCalculator::VargaCalculator() {}
+
+VargaCalculator::VargaMatrix VargaCalculator::calculate(
+    const QMap<QString, double>& planetPositions, double ascendant) const {
+
+    qint32 arcSeconds[BodyCount] = {};
+    quint16 presentMask = 1u << Ascendant;
+    for (int p = 0; p < PlanetCount; ++p) {
+        auto it = planetPositions.find(planetName(p));
+        if (it == planetPositions.end()) continue;
+        arcSeconds[p] = toArcSeconds(it.value());
+        presentMask |= 1u << p;
+    }
+    arcSeconds[Ascendant] = toArcSeconds(ascendant);
+
+    return calculate(arcSeconds, presentMask);
+}
+
+VargaCalculator::VargaMatrix VargaCalculator::calculate(
+    const qint32 (&arcSeconds)[BodyCount], quint16 presentMask) const {
+
+    VargaMatrix matrix;
+    matrix.present = presentMask;
+
+    for (int body = 0; body < BodyCount; ++body) {
+        if (!matrix.contains(body)) continue;
+
+        const qint32 arc = arcSeconds[body];
+        const int sign = arc / ARCSEC_PER_SIGN;
+        const qint32 within = arc - sign * ARCSEC_PER_SIGN;
+        for (int varga = 0; varga < VargaCount; ++varga) {
+            matrix.sign[varga][body] = static_cast<quint8>(signInVarga(varga, sign, within));
+        }
+    }
+
+    matrix.valid = presentMask != 0;
+    computeVimsopaka(matrix);
+    return matrix;
+}
+
+void VargaCalculator::computeVimsopaka(VargaMatrix& matrix) {
+    if (!matrix.hasVimsopaka()) return;
+
+    // Compound relationships are fixed by the rasi chart
+    int compound[SevenPlanets][SevenPlanets];
+    for (int p = 0; p < SevenPlanets; ++p) {
+        for (int q = 0; q < SevenPlanets; ++q) {
+            compound[p][q] = (p == q) ? 2 : compoundRelation(p, q, matrix.sign[D1][p],
+                                                                   matrix.sign[D1][q]);
+        }
+    }
+
+    for (int p = 0; p < SevenPlanets; ++p) {
+        double points[VargaCount];
+        for (int varga = 0; varga < VargaCount; ++varga) {
+            const int sign = matrix.sign[varga][p];
+            points[varga] = (isInOwnSign(p, sign) || isExalted(p, sign))
+                ? 20.0 : relationPoints[compound[p][signLord[sign]] + 2];
+        }
+
+        for (int scheme = 0; scheme < SchemeCount; ++scheme) {
+            double total = 0.0;
+            for (int varga = 0; varga < VargaCount; ++varga) {
+                total += vimsopakaWeight[scheme][varga] * points[varga];
+            }
+            matrix.vimsopaka[scheme][p] = total / 20.0;
+        }
+    }
+}
+
+int VargaCalculator::vargaSign(int varga, double longitude) {
+    const qint32 arc = toArcSeconds(longitude);
+    const int sign = arc / ARCSEC_PER_SIGN;
+    return signInVarga(varga, sign, arc - sign * ARCSEC_PER_SIGN);
+}
+
+qint32 VargaCalculator::toArcSeconds(double longitude) {
+    return qBound(0, static_cast<qint32>(normalizeDegrees(longitude) * 3600.0),
+                  ARCSEC_PER_CIRCLE - 1);
+}
+
+int VargaCalculator::division(int varga) {
+    return (varga >= 0 && varga < VargaCount) ? divisionTable[varga] : 1;
+}
+
+QString VargaCalculator::vargaName(int varga) {
+    static const char* const names[VargaCount] = {
+        "Rasi", "Hora", "Drekkana", "Chaturthamsa", "Saptamsa", "Navamsa",
+        "Dasamsa", "Dwadasamsa", "Shodasamsa", "Vimsamsa", "Chaturvimsamsa",
+        "Bhamsa", "Trimsamsa", "Khavedamsa", "Akshavedamsa", "Shashtiamsa"
+    };
+    if (varga < 0 || varga >= VargaCount) return QString();
+    return QString("D%1 %2").arg(divisionTable[varga]).arg(names[varga]);
+}
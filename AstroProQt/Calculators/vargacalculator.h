@@ -0,0 +1,73 @@
+#ifndef VARGACALCULATOR_H
+#define VARGACALCULATOR_H
+
+#include <QString>
+#include <QMap>
+#include "planetdata.h"
+
+// Divisional (varga) charts D1-D60 for every body of a chart, computed in
+// one integer pass over arc-second longitudes. The resulting matrix is
+// built once per chart and read by the strength, yoga and rendering code.
+class VargaCalculator {
+public:
+    // The sixteen Parashari vargas, in order of division
+    enum Varga {
+        D1 = 0, D2, D3, D4, D7, D9, D10, D12,
+        D16, D20, D24, D27, D30, D40, D45, D60,
+        VargaCount
+    };
+
+    // Bodies are the nine grahas in Astro::Planet order, then the ascendant
+    enum { Ascendant = Astro::PlanetCount, BodyCount = Astro::PlanetCount + 1 };
+
+    // Vimsopaka weighting schemes (each totals 20)
+    enum VimsopakaScheme {
+        Shadvarga = 0,
+        Saptavarga,
+        Dasavarga,
+        Shodasavarga,
+        SchemeCount
+    };
+
+    struct VargaMatrix {
+        quint8 sign[VargaCount][BodyCount];   // 0 = Aries
+        quint16 present;                      // Bit per body with a position
+        // Vimsopaka bala (0-20) of the seven planets in each scheme
+        double vimsopaka[SchemeCount][Astro::SevenPlanets];
+        bool valid;
+
+        VargaMatrix() : sign(), present(0), vimsopaka(), valid(false) {}
+
+        bool contains(int body) const { return (present >> body) & 1u; }
+        // Vimsopaka needs all seven planets
+        bool hasVimsopaka() const { return (present & 0x7Fu) == 0x7Fu; }
+        int signOf(int varga, int body) const { return sign[varga][body]; }
+        // Same sign in the rasi and the navamsa
+        bool isVargottama(int body) const { return sign[D1][body] == sign[D9][body]; }
+    };
+
+    VargaCalculator();
+
+    // Calculate from named positions and the ascendant longitude
+    VargaMatrix calculate(const QMap<QString, double>& planetPositions,
+                          double ascendant) const;
+
+    // Calculate from arc-second longitudes (0 to 1295999); bodies whose bit
+    // is clear in presentMask are skipped
+    VargaMatrix calculate(const qint32 (&arcSeconds)[BodyCount],
+                          quint16 presentMask) const;
+
+    // Sign (0-11) of a single longitude in one varga
+    static int vargaSign(int varga, double longitude);
+
+    // Longitude in whole arc-seconds, 0 to 1295999
+    static qint32 toArcSeconds(double longitude);
+
+    static int division(int varga);
+    static QString vargaName(int varga);
+
+private:
+    static void computeVimsopaka(VargaMatrix& matrix);
+};
+
+#endif // VARGACALCULATOR_H
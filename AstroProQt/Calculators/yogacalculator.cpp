@@ -1,425 +1,268 @@
 #include "yogacalculator.h"
 #include <cmath>
 #include <QDebug>
+#include <QtAlgorithms>
+#include <QVarLengthArray>
 
-YogaCalculator::YogaCalculator() {}
+using namespace Astro;
+using namespace YogaRules;
 
-// Strength calculation methods
-double YogaCalculator::calculateRajaYogaStrength(
-    const QMap<QString, double>& positions,
-    const QMap<QString, double>& strengths) {
-    
-    double baseStrength = 75.0; // Base strength for Raja Yoga
-    double totalStrength = 0.0;
-    int count = 0;
-    
-    // Consider strengths of involved planets
-    for (auto it = positions.begin(); it != positions.end(); ++it) {
-        if (strengths.contains(it.key())) {
-            totalStrength += strengths[it.key()];
-            count++;
-        }
-    }
-    
-    if (count > 0) {
-        return baseStrength * (1.0 + (totalStrength / (count * 100.0)));
-    }
-    return baseStrength;
-}
+namespace {
 
-double YogaCalculator::calculateDhanaYogaStrength(
-    const QMap<QString, double>& positions,
-    const QMap<QString, double>& strengths) {
-    
-    double baseStrength = 65.0; // Base strength for Dhana Yoga
-    double totalStrength = 0.0;
-    int count = 0;
-    
-    // Consider strengths of involved planets
-    for (auto it = positions.begin(); it != positions.end(); ++it) {
-        if (strengths.contains(it.key())) {
-            totalStrength += strengths[it.key()];
-            count++;
-        }
-    }
-    
-    if (count > 0) {
-        return baseStrength * (1.0 + (totalStrength / (count * 100.0)));
-    }
-    return baseStrength;
-}
+// How an active yoga's strength is derived
+enum StrengthModel {
+    FixedStrength,        // The base strength as is
+    ParticipantStrength,  // Base scaled by the planets that formed the yoga
+    VimsopakaStrength     // Vimsopaka of one planet
+};
 
-double YogaCalculator::calculateGajaKesariStrength(
-    const QMap<QString, double>& positions,
-    const QMap<QString, double>& strengths) {
-    
-    double baseStrength = 70.0; // Base strength for Gaja Kesari Yoga
-    
-    if (strengths.contains("Jupiter") && strengths.contains("Moon")) {
-        double jupiterStrength = strengths["Jupiter"];
-        double moonStrength = strengths["Moon"];
-        return baseStrength * (1.0 + ((jupiterStrength + moonStrength) / 200.0));
-    }
-    return baseStrength;
-}
+struct YogaDefinition {
+    YogaCalculator::Yoga yoga;
+    StrengthModel model;
+    double baseStrength;
+    int planet;
+};
 
-double YogaCalculator::calculateBudhAdityaStrength(
-    const QMap<QString, double>& positions,
-    const QMap<QString, double>& strengths) {
-    
-    double baseStrength = 70.0; // Base strength for Budh-Aditya Yoga
-    
-    if (strengths.contains("Mercury") && strengths.contains("Sun")) {
-        double mercuryStrength = strengths["Mercury"];
-        double sunStrength = strengths["Sun"];
-        return baseStrength * (1.0 + ((mercuryStrength + sunStrength) / 200.0));
-    }
-    return baseStrength;
-}
+struct CompiledYogas {
+    QVector<YogaDefinition> definitions;
+    YogaProgram program;
 
-QVector<YogaCalculator::Yoga> YogaCalculator::detectActiveYogas(
-    const QMap<QString, double>& planetPositions,
-    const QVector<double>& housePositions,
-    const QMap<QString, double>& planetaryStrengths) {
-    
-    QVector<Yoga> activeYogas;
-    
-    try {
-        // Check each predefined yoga
-        for (Yoga yoga : yogaDefinitions) {
-            bool isActive = false;
-            double strength = 0.0;
-            
-            if (yoga.name == "Raja Yoga") {
-                isActive = checkRajaYoga(planetPositions, housePositions);
-                if (isActive) {
-                    strength = calculateRajaYogaStrength(planetPositions, planetaryStrengths);
-                }
-            }
-            else if (yoga.name == "Dhana Yoga") {
-                isActive = checkDhanaYoga(planetPositions, housePositions);
-                if (isActive) {
-                    strength = calculateDhanaYogaStrength(planetPositions, planetaryStrengths);
-                }
-            }
-            else if (yoga.name == "Gaja Kesari") {
-                isActive = checkGajaKesariYoga(planetPositions);
-                if (isActive) {
-                    strength = calculateGajaKesariStrength(planetPositions, planetaryStrengths);
-                }
-            }
-            else if (yoga.name == "Budh-Aditya") {
-                isActive = checkBudhAditya(planetPositions);
-                if (isActive) {
-                    strength = calculateBudhAdityaStrength(planetPositions, planetaryStrengths);
-                }
-            }
-            else if (yoga.name == "Pancha Mahapurusha") {
-                isActive = checkPanchaMahapurusha(planetPositions, housePositions);
-                if (isActive) {
-                    strength = 75.0; // Base strength for Mahapurusha Yoga
-                }
-            }
-            else if (yoga.name == "Viparita Raja") {
-                isActive = checkViparitaRaja(planetPositions, housePositions);
-                if (isActive) {
-                    strength = 80.0; // Strong yoga that turns negative into positive
-                }
-            }
-            else if (yoga.name == "Hamsa") {
-                isActive = checkHamsaYoga(planetPositions, housePositions);
-                if (isActive) {
-                    strength = 70.0;
-                }
-            }
-            else if (yoga.name == "Malavya") {
-                isActive = checkMalavyaYoga(planetPositions, housePositions);
-                if (isActive) {
-                    strength = 70.0;
-                }
-            }
-            else if (yoga.name == "Shasha") {
-                isActive = checkShashaYoga(planetPositions, housePositions);
-                if (isActive) {
-                    strength = 70.0;
-                }
-            }
-            else if (yoga.name == "Ruchaka") {
-                isActive = checkRuchakaYoga(planetPositions, housePositions);
-                if (isActive) {
-                    strength = 70.0;
-                }
-            }
-            else if (yoga.name == "Bhadra") {
-                isActive = checkBhadraYoga(planetPositions, housePositions);
-                if (isActive) {
-                    strength = 70.0;
-                }
-            }
-            
-            if (isActive) {
-                yoga.isActive = true;
-                yoga.strength = strength;
-                activeYogas.append(yoga);
-            }
+    // Definitions stay index-aligned with the program's rules, so a rule
+    // the program rejects is left out of both
+    void add(const char* name, const char* description, const YogaExpr& rule,
+             StrengthModel model, double baseStrength, int planet = -1) {
+        if (program.add(rule) < 0) {
+            qWarning() << "Yoga rule rejected as malformed or too deep:" << name;
+            return;
         }
-    } catch (const std::exception& e) {
-        qDebug() << "Error detecting yogas:" << e.what();
+        definitions.append({ YogaCalculator::Yoga(name, description),
+                             model, baseStrength, planet });
     }
-    
-    return activeYogas;
-}
+};
 
-// Utility Methods
-bool YogaCalculator::arePlanetsConjunct(double pos1, double pos2, double orb) {
-    double diff = std::abs(pos1 - pos2);
-    if (diff > 180) diff = 360 - diff;
-    return diff <= orb;
-}
+constexpr int Lagna = ChartFeatures::Lagna;
 
-bool YogaCalculator::isPlanetInHouse(double planetPos, double houseStart, double houseEnd) {
-    // Normalize positions to 0-360 range
-    planetPos = std::fmod(planetPos + 360.0, 360.0);
-    houseStart = std::fmod(houseStart + 360.0, 360.0);
-    houseEnd = std::fmod(houseEnd + 360.0, 360.0);
-    
-    if (houseStart < houseEnd) {
-        return planetPos >= houseStart && planetPos < houseEnd;
-    } else {
-        // House spans 0° Aries
-        return planetPos >= houseStart || planetPos < houseEnd;
-    }
+// Planet in its own or exaltation sign in a kendra from the ascendant
+YogaExpr mahapurusha(int planet) {
+    return hasDignity(planet, ChartFeatures::Own | ChartFeatures::Exalted) &&
+           inHouse(planet, Kendras);
 }
 
-int YogaCalculator::getHousePlacement(double longitude, const QVector<double>& houses) {
-    for (int i = 0; i < 12; i++) {
-        double houseStart = houses[i];
-        double houseEnd = houses[(i + 1) % 12];
-        
-        if (isPlanetInHouse(longitude, houseStart, houseEnd)) {
-            return i + 1; // Houses are 1-based
-        }
-    }
-    return 1; // Default to 1st house if not found (shouldn't happen)
+// A debilitated planet whose fall is cancelled: the lord of its sign or of
+// its exaltation sign is in a kendra from the ascendant or the Moon, or the
+// planet is exalted in the navamsa
+YogaExpr neechaBhanga(int planet) {
+    return hasDignity(planet, ChartFeatures::Debilitated) &&
+           (dispositorPlaceFrom(planet, Lagna, Kendras) ||
+            dispositorPlaceFrom(planet, Moon, Kendras) ||
+            exaltationLordPlaceFrom(planet, Lagna, Kendras) ||
+            exaltationLordPlaceFrom(planet, Moon, Kendras) ||
+            hasDignity(planet, ChartFeatures::NavamsaExalted));
 }
 
-bool YogaCalculator::areInAspect(double pos1, double pos2, int aspect) {
-    double diff = std::abs(pos1 - pos2);
-    if (diff > 180) diff = 360 - diff;
-    
-    double orb = 10.0; // Default orb of 10 degrees
-    return std::abs(diff - aspect) <= orb;
-}
+CompiledYogas compile() {
+    CompiledYogas c;
+
+    const quint16 dhanaHouses = places({2, 5, 9, 11});
+    const YogaExpr secondFromMoon = occupiedFrom(Moon, 2, TaraGrahas);
+    const YogaExpr twelfthFromMoon = occupiedFrom(Moon, 12, TaraGrahas);
 
-bool YogaCalculator::isPlanetInOwnSign(const QString& planet, double longitude) {
-    int sign = static_cast<int>(longitude / 30);
-    if (!planetRulerships.contains(planet)) return false;
-    
-    QVector<int> ruledSigns;
-    for (int house : planetRulerships[planet]) {
-        ruledSigns.append((house - 1) % 12); // Convert house number to sign index
+    YogaExpr anyNeechaBhanga = neechaBhanga(Sun);
+    for (int p = Moon; p < SevenPlanets; ++p) {
+        anyNeechaBhanga = anyNeechaBhanga || neechaBhanga(p);
     }
-    
-    return ruledSigns.contains(sign);
-}
 
-bool YogaCalculator::isPlanetExalted(const QString& planet, double longitude) {
-    if (!exaltDebil.contains(planet)) return false;
-    
-    double exaltDegree = exaltDebil[planet].first;
-    double orb = 10.0; // Consider within 10 degrees of exact exaltation
-    
-    double diff = std::abs(longitude - exaltDegree);
-    if (diff > 180) diff = 360 - diff;
-    
-    return diff <= orb;
-}
+    c.add("Raja Yoga", "Combination of lords of trine and quadrant houses",
+          lordsAssociated(Kendras, Trikonas),
+          ParticipantStrength, 75.0);
+    c.add("Dhana Yoga", "Combination indicating wealth and prosperity",
+          inHouse(Jupiter, dhanaHouses) || inHouse(Venus, dhanaHouses) ||
+          inHouse(Mercury, dhanaHouses) || inHouse(Moon, dhanaHouses),
+          ParticipantStrength, 65.0);
+    c.add("Gaja Kesari", "Jupiter and Moon combination in quadrant houses",
+          placeFrom(Moon, Jupiter, Kendras),
+          ParticipantStrength, 70.0);
+    c.add("Budh-Aditya", "Mercury and Sun combination indicating intelligence",
+          conjunct(Mercury, Sun),
+          ParticipantStrength, 70.0);
+    c.add("Chandra-Mangal", "Moon and Mars combination indicating courage",
+          placeFrom(Moon, Mars, places({1, 7})),
+          ParticipantStrength, 65.0);
+    c.add("Neecha Bhanga", "Cancellation of debilitation",
+          anyNeechaBhanga,
+          FixedStrength, 60.0);
+    c.add("Pancha Mahapurusha", "Planets in own/exaltation sign in angles",
+          mahapurusha(Mars) || mahapurusha(Mercury) || mahapurusha(Jupiter) ||
+          mahapurusha(Venus) || mahapurusha(Saturn),
+          FixedStrength, 75.0);
+    c.add("Viparita Raja", "Lords of 6th, 8th or 12th placed in a dusthana",
+          lordInHouse(6, Dusthanas) || lordInHouse(8, Dusthanas) ||
+          lordInHouse(12, Dusthanas),
+          FixedStrength, 80.0);
+    c.add("Hamsa", "Jupiter in own/exaltation sign in angle from Moon",
+          hasDignity(Jupiter, ChartFeatures::Own | ChartFeatures::Exalted) &&
+          placeFrom(Moon, Jupiter, Kendras),
+          VimsopakaStrength, 70.0, Jupiter);
+    c.add("Malavya", "Venus in own/exaltation sign in angle from Ascendant",
+          mahapurusha(Venus), VimsopakaStrength, 70.0, Venus);
+    c.add("Shasha", "Saturn in own/exaltation sign in angle from Ascendant",
+          mahapurusha(Saturn), VimsopakaStrength, 70.0, Saturn);
+    c.add("Ruchaka", "Mars in own/exaltation sign in angle from Ascendant",
+          mahapurusha(Mars), VimsopakaStrength, 70.0, Mars);
+    c.add("Bhadra", "Mercury in own/exaltation sign in angle from Ascendant",
+          mahapurusha(Mercury), VimsopakaStrength, 70.0, Mercury);
+    c.add("Sunapha", "Planets other than the Sun in the 2nd from the Moon",
+          secondFromMoon && !twelfthFromMoon,
+          FixedStrength, 60.0);
+    c.add("Anapha", "Planets other than the Sun in the 12th from the Moon",
+          twelfthFromMoon && !secondFromMoon,
+          FixedStrength, 60.0);
+    c.add("Durudhara", "Planets on both sides of the Moon",
+          secondFromMoon && twelfthFromMoon,
+          FixedStrength, 65.0);
+    c.add("Kemadruma", "No planets on either side of the Moon",
+          !secondFromMoon && !twelfthFromMoon,
+          FixedStrength, 50.0);
 
-bool YogaCalculator::isPlanetInAngle(double longitude, const QVector<double>& houses) {
-    int house = getHousePlacement(longitude, houses);
-    return (house == 1 || house == 4 || house == 7 || house == 10);
+    return c;
 }
 
-bool YogaCalculator::isPlanetInKendra(double pos1, double pos2) {
-    int houseDiff = std::abs(static_cast<int>(pos1 / 30) - 
-                            static_cast<int>(pos2 / 30));
-    return (houseDiff == 0 || houseDiff == 3 || houseDiff == 6 || houseDiff == 9);
+// Rules are compiled once and shared by every calculator
+const CompiledYogas& compiledYogas() {
+    static const CompiledYogas compiled = compile();
+    return compiled;
 }
 
-// Basic Yoga Detection Methods
-bool YogaCalculator::checkRajaYoga(
-    const QMap<QString, double>& positions, 
-    const QVector<double>& houses) {
-    
-    // Raja Yoga occurs when lords of trine houses (1,5,9) combine with
-    // lords of quadrant houses (1,4,7,10)
-    QVector<QString> trineLords, quadrantLords;
-    
-    // Get lords of trine and quadrant houses
-    for (const QString& planet : planetRulerships.keys()) {
-        for (int house : planetRulerships[planet]) {
-            if (house == 1 || house == 5 || house == 9) {
-                trineLords.append(planet);
-            }
-            if (house == 1 || house == 4 || house == 7 || house == 10) {
-                quadrantLords.append(planet);
-            }
-        }
-    }
-    
-    // Check if any trine lord is conjunct with any quadrant lord
-    for (const QString& trineLord : trineLords) {
-        if (!positions.contains(trineLord)) continue;
-        
-        for (const QString& quadrantLord : quadrantLords) {
-            if (!positions.contains(quadrantLord)) continue;
-            if (trineLord == quadrantLord) continue; // Same planet
-            
-            if (arePlanetsConjunct(positions[trineLord], positions[quadrantLord])) {
-                return true;
-            }
-        }
+} // namespace
+
+YogaCalculator::YogaCalculator() {}
+
+QStringList YogaCalculator::Yoga::planets() const {
+    QStringList names;
+    for (int body = 0; body < ChartFeatures::BodyCount; ++body) {
+        if (!((participants >> body) & 1u)) continue;
+        names << (body == ChartFeatures::Lagna ? QString("Lagna") : QString(planetName(body)));
     }
-    
-    return false;
+    return names;
 }
 
-bool YogaCalculator::checkDhanaYoga(
-    const QMap<QString, double>& positions, 
-    const QVector<double>& houses) {
-    
-    // Dhana Yoga occurs when benefics occupy 2nd, 5th, 9th or 11th houses
-    QVector<QString> benefics = {"Jupiter", "Venus", "Mercury", "Moon"};
-    QVector<int> dhanaHouses = {2, 5, 9, 11};
-    
-    for (const QString& benefic : benefics) {
-        if (!positions.contains(benefic)) continue;
-        
-        int house = getHousePlacement(positions[benefic], houses);
-        if (dhanaHouses.contains(house)) {
-            return true;
+// Strength calculation methods
+double YogaCalculator::calculateParticipantStrength(
+    const double (&ratios)[SevenPlanets], quint16 known,
+    quint16 participants, double baseStrength) {
+
+    // Only the planets that formed the yoga, and only those with Shadbala
+    const quint16 rated = participants & known;
+    if (!rated) return baseStrength;
+
+    double total = 0.0;
+    int count = 0;
+    for (int p = 0; p < SevenPlanets; ++p) {
+        if ((rated >> p) & 1u) {
+            total += ratios[p];
+            ++count;
         }
     }
-    
-    return false;
+    return baseStrength * (1.0 + total / count);
 }
 
-bool YogaCalculator::checkGajaKesariYoga(const QMap<QString, double>& positions) {
-    if (!positions.contains("Jupiter") || !positions.contains("Moon")) {
-        return false;
-    }
-    
-    return isPlanetInKendra(positions["Jupiter"], positions["Moon"]);
+double YogaCalculator::calculateMahapurushaStrength(
+    const VargaCalculator::VargaMatrix& vargas, int planet) {
+
+    // The yoga gives its results in proportion to the planet's dignity
+    // across the sixteen vargas
+    if (!vargas.hasVimsopaka()) return 70.0;
+    return vargas.vimsopaka[VargaCalculator::Shodasavarga][planet] * 5.0;
 }
 
-bool YogaCalculator::checkBudhAditya(const QMap<QString, double>& positions) {
-    if (!positions.contains("Mercury") || !positions.contains("Sun")) {
-        return false;
+QVector<YogaCalculator::Yoga> YogaCalculator::detectActiveYogas(
+    const QMap<QString, double>& planetPositions,
+    const QVector<double>& housePositions,
+    const QMap<QString, StrengthCalculator::PlanetaryStrength>& planetaryStrengths,
+    const AspectMatrix* aspects,
+    const VargaCalculator::VargaMatrix* vargas) {
+
+    QVector<Yoga> activeYogas;
+
+    AspectMatrix localAspects;
+    if (!aspects) {
+        localAspects.build(planetPositions, housePositions);
+        aspects = &localAspects;
     }
-    
-    return arePlanetsConjunct(positions["Mercury"], positions["Sun"]);
-}
 
-bool YogaCalculator::checkPanchaMahapurusha(
-    const QMap<QString, double>& positions,
-    const QVector<double>& houses) {
-    
-    QVector<QString> planets = {"Mars", "Mercury", "Jupiter", "Venus", "Saturn"};
-    
-    for (const QString& planet : planets) {
-        if (!positions.contains(planet)) continue;
-        
-        double pos = positions[planet];
-        if ((isPlanetInOwnSign(planet, pos) || isPlanetExalted(planet, pos)) &&
-            isPlanetInAngle(pos, houses)) {
-            return true;
-        }
+    VargaCalculator::VargaMatrix localVargas;
+    if (!vargas) {
+        localVargas = VargaCalculator().calculate(
+            planetPositions, housePositions.isEmpty() ? 0.0 : housePositions[0]);
+        vargas = &localVargas;
     }
-    return false;
-}
 
-bool YogaCalculator::checkViparitaRaja(
-    const QMap<QString, double>& positions,
-    const QVector<double>& houses) {
-    
-    // Get lords of 6th, 8th, and 12th houses
-    QString lord6th, lord8th, lord12th;
-    
-    for (const QString& planet : planetRulerships.keys()) {
-        QVector<int> houses = planetRulerships[planet];
-        if (houses.contains(6)) lord6th = planet;
-        if (houses.contains(8)) lord8th = planet;
-        if (houses.contains(12)) lord12th = planet;
+    // One lookup per planet, shared by every yoga
+    double ratios[SevenPlanets] = {};
+    quint16 known = 0;
+    for (int p = 0; p < SevenPlanets; ++p) {
+        auto it = planetaryStrengths.constFind(planetName(p));
+        if (it == planetaryStrengths.constEnd()) continue;
+        ratios[p] = it.value().ratio();
+        known |= 1u << p;
     }
-    
-    // Check if these lords are in mutual kendras (angles)
-    if (!positions.contains(lord6th) || !positions.contains(lord8th) || 
-        !positions.contains(lord12th)) return false;
-    
-    return isPlanetInKendra(positions[lord6th], positions[lord8th]) &&
-           isPlanetInKendra(positions[lord8th], positions[lord12th]) &&
-           isPlanetInKendra(positions[lord6th], positions[lord12th]);
-}
 
-bool YogaCalculator::checkHamsaYoga(
-    const QMap<QString, double>& positions,
-    const QVector<double>& houses) {
-    
-    if (!positions.contains("Jupiter") || !positions.contains("Moon")) 
-        return false;
-    
-    double jupiterPos = positions["Jupiter"];
-    double moonPos = positions["Moon"];
-    
-    return (isPlanetInOwnSign("Jupiter", jupiterPos) || 
-            isPlanetExalted("Jupiter", jupiterPos)) &&
-           isPlanetInKendra(jupiterPos, moonPos);
-}
+    const CompiledYogas& compiled = compiledYogas();
+    const ChartFeatures features = ChartFeatures::build(*aspects, *vargas);
+
+    // Rule results are scratch for this chart; a few words fit on the stack
+    QVarLengthArray<quint64, 4> active(compiled.program.wordCount());
+    compiled.program.evaluateAll(features, active.data());
+    int activeCount = 0;
+    for (quint64 word : active) activeCount += qPopulationCount(word);
+    activeYogas.reserve(activeCount);
+
+    YogaTrace trace;
+    for (int i = 0; i < compiled.definitions.size(); ++i) {
+        if (!((active[i / 64] >> (i % 64)) & 1u)) continue;
+
+        compiled.program.trace(i, features, trace);
 
-bool YogaCalculator::checkMalavyaYoga(
-    const QMap<QString, double>& positions,
-    const QVector<double>& houses) {
-    
-    if (!positions.contains("Venus")) return false;
-    
-    double venusPos = positions["Venus"];
-    return (isPlanetInOwnSign("Venus", venusPos) || 
-            isPlanetExalted("Venus", venusPos)) &&
-           isPlanetInAngle(venusPos, houses);
+        const YogaDefinition& definition = compiled.definitions[i];
+        double strength = definition.baseStrength;
+        switch (definition.model) {
+            case ParticipantStrength:
+                strength = calculateParticipantStrength(ratios, known, trace.participants,
+                                                        definition.baseStrength);
+                break;
+            case VimsopakaStrength:
+                strength = calculateMahapurushaStrength(*vargas, definition.planet);
+                break;
+            case FixedStrength:
+                break;
+        }
+
+        Yoga yoga = definition.yoga;
+        yoga.isActive = true;
+        yoga.strength = strength;
+        yoga.participants = trace.participants;
+        yoga.conditions.reserve(int(trace.conditions.size()));
+        for (quint16 offset : trace.conditions) {
+            yoga.conditions << compiled.program.describe(i, offset);
+        }
+        activeYogas.append(std::move(yoga));
+    }
+
+    return activeYogas;
 }
 
-bool YogaCalculator::checkShashaYoga(
-    const QMap<QString, double>& positions,
-    const QVector<double>& houses) {
-    
-    if (!positions.contains("Saturn")) return false;
-    
-    double saturnPos = positions["Saturn"];
-    return (isPlanetInOwnSign("Saturn", saturnPos) || 
-            isPlanetExalted("Saturn", saturnPos)) &&
-           isPlanetInAngle(saturnPos, houses);
+QVector<quint64> YogaCalculator::evaluate(const ChartFeatures& features) {
+    return compiledYogas().program.evaluateAll(features);
 }
 
-bool YogaCalculator::checkRuchakaYoga(
-    const QMap<QString, double>& positions,
-    const QVector<double>& houses) {
-    
-    if (!positions.contains("Mars")) return false;
-    
-    double marsPos = positions["Mars"];
-    return (isPlanetInOwnSign("Mars", marsPos) || 
-            isPlanetExalted("Mars", marsPos)) &&
-           isPlanetInAngle(marsPos, houses);
+const YogaProgram& YogaCalculator::program() {
+    return compiledYogas().program;
 }
 
-bool YogaCalculator::checkBhadraYoga(
-    const QMap<QString, double>& positions,
-    const QVector<double>& houses) {
-    
-    if (!positions.contains("Mercury")) return false;
-    
-    double mercuryPos = positions["Mercury"];
-    return (isPlanetInOwnSign("Mercury", mercuryPos) || 
-            isPlanetExalted("Mercury", mercuryPos)) &&
-           isPlanetInAngle(mercuryPos, houses);
+QVector<YogaCalculator::Yoga> YogaCalculator::definitions() {
+    QVector<Yoga> yogas;
+    for (const YogaDefinition& definition : compiledYogas().definitions) {
+        yogas.append(definition.yoga);
+    }
+    return yogas;
 }
@@ -0,0 +1,537 @@
+#include "yogaprogram.h"
+#include <QStringList>
+#include <algorithm>
+
+using namespace Astro;
+
+namespace {
+
+// Places (bit n-1 = nth) receiving each graha's full sight: every graha
+// aspects the 7th; Mars also the 4th and 8th, Jupiter the 5th and 9th,
+// Saturn the 3rd and 10th
+constexpr quint16 grahaDrishti[PlanetCount] = {
+    YogaRules::places({7}),             // Sun
+    YogaRules::places({7}),             // Moon
+    YogaRules::places({4, 7, 8}),       // Mars
+    YogaRules::places({7}),             // Mercury
+    YogaRules::places({5, 7, 9}),       // Jupiter
+    YogaRules::places({7}),             // Venus
+    YogaRules::places({3, 7, 10}),      // Saturn
+    YogaRules::places({7}),             // Rahu
+    YogaRules::places({7})              // Ketu
+};
+
+inline quint16 rotateSigns(quint16 mask, int sign) {
+    return static_cast<quint16>(((mask << sign) | (mask >> ((SignCount - sign) % SignCount))) & 0x0FFF);
+}
+
+inline bool inMask(quint16 mask, int bit) {
+    return (mask >> bit) & 1u;
+}
+
+YogaExpr leaf(quint8 op, int a, int b, quint16 mask, quint16 mask2 = 0) {
+    YogaInstruction instruction;
+    instruction.op = op;
+    instruction.a = static_cast<quint8>(a);
+    instruction.b = static_cast<quint8>(b);
+    instruction.mask = mask;
+    instruction.mask2 = mask2;
+    return YogaExpr(instruction);
+}
+
+// Lords of the houses in a mask, as a body set
+inline quint16 lordsOf(const ChartFeatures& f, quint16 houses) {
+    quint16 lords = 0;
+    for (int h = 1; h <= 12; ++h) {
+        if (inMask(houses, h - 1)) lords |= 1u << f.houseLord[h];
+    }
+    return lords;
+}
+
+// Conjunction, mutual 7th or exchange of signs (parivartana)
+inline bool associated(const ChartFeatures& f, int p, int q) {
+    return inMask(f.conjunct[p], q) || f.place(p, q) == 7 ||
+           (signLord[f.sign[p]] == q && signLord[f.sign[q]] == p);
+}
+
+
+// Value of a leaf predicate. When traced, 'bodies' receives the bodies
+// the leaf is about: those that made it true, or its anchors.
+template <bool Traced>
+inline bool leafValue(const YogaInstruction& in, const ChartFeatures& f, quint16& bodies) {
+    const int a = in.a;
+    const int b = in.b;
+    bool value = false;
+    quint16 formed = 0;
+
+    switch (in.op) {
+        case YogaInstruction::True:
+            value = true;
+            break;
+        case YogaInstruction::InHouse:
+            value = f.contains(a) && inMask(in.mask, f.house[a] - 1);
+            formed = 1u << a;
+            break;
+        case YogaInstruction::InSign:
+            value = f.contains(a) && inMask(in.mask, f.sign[a]);
+            formed = 1u << a;
+            break;
+        case YogaInstruction::HasDignity:
+            value = f.contains(a) && (f.dignity[a] & in.mask);
+            formed = 1u << a;
+            break;
+        case YogaInstruction::PlaceFrom:
+            value = f.contains(a) && f.contains(b) &&
+                    inMask(in.mask, f.place(a, b) - 1);
+            formed = (1u << a) | (1u << b);
+            break;
+        case YogaInstruction::LordInHouse: {
+            const int lord = f.houseLord[a];
+            value = f.contains(lord) && inMask(in.mask, f.house[lord] - 1);
+            formed = 1u << lord;
+            break;
+        }
+        case YogaInstruction::LordPlaceFrom: {
+            const int lord = f.houseLord[a];
+            value = f.contains(lord) && f.contains(b) &&
+                    inMask(in.mask, f.place(b, lord) - 1);
+            formed = (1u << lord) | (1u << b);
+            break;
+        }
+        case YogaInstruction::DispositorPlaceFrom:
+        case YogaInstruction::ExaltationLordPlaceFrom: {
+            formed = (1u << a) | (1u << b);
+            if (!f.contains(a) || !f.contains(b)) break;
+            const int sign = in.op == YogaInstruction::DispositorPlaceFrom
+                ? f.sign[a] : signOf(exaltationLongitude[a]);
+            const int lord = signLord[sign];
+            value = f.contains(lord) && inMask(in.mask, f.place(b, lord) - 1);
+            formed |= 1u << lord;
+            break;
+        }
+        case YogaInstruction::Conjunct:
+            value = f.contains(a) && inMask(f.conjunct[a], b);
+            formed = (1u << a) | (1u << b);
+            break;
+        case YogaInstruction::Aspects:
+            value = f.contains(a) && f.contains(b) &&
+                    inMask(f.aspectedSigns[a], f.sign[b]);
+            formed = (1u << a) | (1u << b);
+            break;
+        case YogaInstruction::OccupiedFrom: {
+            formed = 1u << a;
+            if (!f.contains(a)) break;
+            const int target = (f.sign[a] + b - 1) % SignCount;
+            for (int body = 0; body < PlanetCount && (Traced || !value); ++body) {
+                if (inMask(in.mask, body) && f.contains(body) && f.sign[body] == target) {
+                    value = true;
+                    formed |= 1u << body;
+                }
+            }
+            break;
+        }
+        case YogaInstruction::LordsAssociated: {
+            const quint16 lordsA = lordsOf(f, in.mask);
+            const quint16 lordsB = lordsOf(f, in.mask2);
+            for (int p = 0; p < SevenPlanets && (Traced || !value); ++p) {
+                if (!inMask(lordsA, p) || !f.contains(p)) continue;
+                for (int q = 0; q < SevenPlanets && (Traced || !value); ++q) {
+                    if (q != p && inMask(lordsB, q) && f.contains(q) && associated(f, p, q)) {
+                        value = true;
+                        formed |= (1u << p) | (1u << q);
+                    }
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (Traced) bodies = formed;
+    return value;
+}
+
+inline QString bodyName(int body) {
+    return body == ChartFeatures::Lagna ? QStringLiteral("Lagna") : QString(planetName(body));
+}
+
+inline QString bodyNames(quint16 bodies) {
+    QStringList names;
+    for (int body = 0; body < ChartFeatures::BodyCount; ++body) {
+        if (inMask(bodies, body)) names << bodyName(body);
+    }
+    return names.join('/');
+}
+
+// House or place numbers of a mask, e.g. "1/4/7/10"
+inline QString numbers(quint16 mask) {
+    QStringList list;
+    for (int n = 1; n <= 12; ++n) {
+        if (inMask(mask, n - 1)) list << QString::number(n);
+    }
+    return list.join('/');
+}
+
+inline QString signNames(quint16 mask) {
+    static const char* const names[SignCount] = {
+        "Aries", "Taurus", "Gemini", "Cancer", "Leo", "Virgo",
+        "Libra", "Scorpio", "Sagittarius", "Capricorn", "Aquarius", "Pisces"
+    };
+    QStringList list;
+    for (int s = 0; s < SignCount; ++s) {
+        if (inMask(mask, s)) list << names[s];
+    }
+    return list.join('/');
+}
+
+inline QString dignityNames(quint16 mask) {
+    static const char* const names[] = {
+        "in own sign", "exalted", "debilitated", "in moolatrikona",
+        "vargottama", "exalted in navamsa", "debilitated in navamsa"
+    };
+    QStringList list;
+    for (int d = 0; d < ChartFeatures::DignityCount; ++d) {
+        if (inMask(mask, d)) list << names[d];
+    }
+    return list.join(" or ");
+}
+
+} // namespace
+
+ChartFeatures::ChartFeatures()
+    : present(0), sign(), house(), dignity(), houseLord(), conjunct(), aspectedSigns() {}
+
+ChartFeatures ChartFeatures::build(const AspectMatrix& aspects,
+                                   const VargaCalculator::VargaMatrix& vargas) {
+    ChartFeatures f;
+
+    for (int p = 0; p < PlanetCount; ++p) {
+        if (!aspects.contains(p)) continue;
+        f.present |= 1u << p;
+        f.sign[p] = static_cast<quint8>(aspects.sign(p));
+        f.house[p] = static_cast<quint8>(aspects.house(p));
+    }
+
+    const int lagnaSign = vargas.contains(VargaCalculator::Ascendant)
+        ? vargas.signOf(VargaCalculator::D1, VargaCalculator::Ascendant) : 0;
+    f.present |= 1u << Lagna;
+    f.sign[Lagna] = static_cast<quint8>(lagnaSign);
+    f.house[Lagna] = 1;
+
+    for (int h = 1; h <= 12; ++h) {
+        f.houseLord[h] = static_cast<quint8>(signLord[(lagnaSign + h - 1) % SignCount]);
+    }
+
+    for (int p = 0; p < PlanetCount; ++p) {
+        if (!f.contains(p)) continue;
+        const int sign = f.sign[p];
+
+        quint8 dignity = 0;
+        if (isInOwnSign(p, sign)) dignity |= Own;
+        if (isExalted(p, sign)) dignity |= Exalted;
+        if (isDebilitated(p, sign)) dignity |= Debilitated;
+        if (p < SevenPlanets && sign == moolatrikona[p].sign) {
+            const double degree = aspects.longitude(p) - sign * 30.0;
+            if (degree >= moolatrikona[p].from && degree < moolatrikona[p].to) {
+                dignity |= Moolatrikona;
+            }
+        }
+        if (vargas.contains(p)) {
+            const int navamsa = vargas.signOf(VargaCalculator::D9, p);
+            if (navamsa == sign) dignity |= Vargottama;
+            if (isExalted(p, navamsa)) dignity |= NavamsaExalted;
+            if (isDebilitated(p, navamsa)) dignity |= NavamsaDebilitated;
+        }
+        f.dignity[p] = dignity;
+
+        quint16 close = 0;
+        for (int q = 0; q < PlanetCount; ++q) {
+            if (q != p && f.contains(q) && aspects.isConjunct(p, q, CONJUNCTION_ORB)) {
+                close |= 1u << q;
+            }
+        }
+        f.conjunct[p] = close;
+
+        // Place n from the planet is sign (sign + n - 1)
+        f.aspectedSigns[p] = rotateSigns(drishtiPlaces(p), sign);
+    }
+
+    return f;
+}
+
+quint16 ChartFeatures::drishtiPlaces(int planet) {
+    return (planet >= 0 && planet < PlanetCount) ? grahaDrishti[planet] : 0;
+}
+
+YogaExpr YogaExpr::combine(const YogaExpr& lhs, const YogaExpr& rhs, quint8 op) {
+    YogaExpr result = lhs;
+    result.m_code += rhs.m_code;
+    YogaInstruction instruction = {};
+    instruction.op = op;
+    result.m_code.append(instruction);
+    return result;
+}
+
+YogaExpr operator&&(const YogaExpr& lhs, const YogaExpr& rhs) {
+    return YogaExpr::combine(lhs, rhs, YogaInstruction::And);
+}
+
+YogaExpr operator||(const YogaExpr& lhs, const YogaExpr& rhs) {
+    return YogaExpr::combine(lhs, rhs, YogaInstruction::Or);
+}
+
+YogaExpr operator!(const YogaExpr& expr) {
+    YogaExpr result = expr;
+    YogaInstruction instruction = {};
+    instruction.op = YogaInstruction::Not;
+    result.m_code.append(instruction);
+    return result;
+}
+
+namespace YogaRules {
+
+YogaExpr always() { return leaf(YogaInstruction::True, 0, 0, 0); }
+
+YogaExpr inHouse(int body, quint16 houses) {
+    return leaf(YogaInstruction::InHouse, body, 0, houses);
+}
+
+YogaExpr inSign(int body, quint16 signs) {
+    return leaf(YogaInstruction::InSign, body, 0, signs);
+}
+
+YogaExpr hasDignity(int planet, quint8 dignity) {
+    return leaf(YogaInstruction::HasDignity, planet, 0, dignity);
+}
+
+YogaExpr placeFrom(int from, int body, quint16 places) {
+    return leaf(YogaInstruction::PlaceFrom, from, body, places);
+}
+
+YogaExpr lordInHouse(int house, quint16 houses) {
+    return leaf(YogaInstruction::LordInHouse, house, 0, houses);
+}
+
+YogaExpr lordPlaceFrom(int house, int from, quint16 places) {
+    return leaf(YogaInstruction::LordPlaceFrom, house, from, places);
+}
+
+YogaExpr dispositorPlaceFrom(int planet, int from, quint16 places) {
+    return leaf(YogaInstruction::DispositorPlaceFrom, planet, from, places);
+}
+
+YogaExpr exaltationLordPlaceFrom(int planet, int from, quint16 places) {
+    return leaf(YogaInstruction::ExaltationLordPlaceFrom, planet, from, places);
+}
+
+YogaExpr conjunct(int planet1, int planet2) {
+    return leaf(YogaInstruction::Conjunct, planet1, planet2, 0);
+}
+
+YogaExpr aspects(int planet, int target) {
+    return leaf(YogaInstruction::Aspects, planet, target, 0);
+}
+
+YogaExpr occupiedFrom(int from, int place, quint16 bodies) {
+    return leaf(YogaInstruction::OccupiedFrom, from, place, bodies);
+}
+
+YogaExpr lordsAssociated(quint16 housesA, quint16 housesB) {
+    return leaf(YogaInstruction::LordsAssociated, 0, 0, housesA, housesB);
+}
+
+} // namespace YogaRules
+
+YogaProgram::YogaProgram() {}
+
+int YogaProgram::add(const YogaExpr& rule) {
+    // A well-formed rule leaves exactly one value and fits the stack
+    int depth = 0;
+    for (const YogaInstruction& instruction : rule.code()) {
+        if (instruction.op == YogaInstruction::And || instruction.op == YogaInstruction::Or) {
+            --depth;
+        } else if (instruction.op != YogaInstruction::Not) {
+            ++depth;
+        }
+        if (depth < 1 || depth > STACK_DEPTH) return -1;
+    }
+    if (depth != 1) return -1;
+
+    Range range = { m_code.size(), rule.code().size() };
+    m_code += rule.code();
+    m_ranges.append(range);
+    return m_ranges.size() - 1;
+}
+
+QVector<YogaInstruction> YogaProgram::rule(int index) const {
+    const Range range = m_ranges[index];
+    return m_code.mid(range.start, range.length);
+}
+
+bool YogaProgram::evaluate(int rule, const ChartFeatures& f) const {
+    const Range range = m_ranges[rule];
+    const YogaInstruction* ip = m_code.constData() + range.start;
+    const YogaInstruction* end = ip + range.length;
+
+    // Boolean stack held in the bits of one word
+    quint64 stack = 0;
+    quint16 unused = 0;
+
+    for (; ip != end; ++ip) {
+        switch (ip->op) {
+            case YogaInstruction::And: {
+                const quint64 top = stack & 1u;
+                stack >>= 1;
+                stack = (stack & ~quint64(1)) | (stack & top);
+                break;
+            }
+            case YogaInstruction::Or: {
+                const quint64 top = stack & 1u;
+                stack >>= 1;
+                stack |= top;
+                break;
+            }
+            case YogaInstruction::Not:
+                stack ^= 1u;
+                break;
+            default:
+                stack = (stack << 1) | (leafValue<false>(*ip, f, unused) ? 1u : 0u);
+                break;
+        }
+    }
+
+    return stack & 1u;
+}
+
+bool YogaProgram::trace(int rule, const ChartFeatures& f, YogaTrace& trace) const {
+    const Range range = m_ranges[rule];
+    const YogaInstruction* code = m_code.constData() + range.start;
+
+    // Each stack entry carries the bodies behind its value. A false leaf
+    // keeps the bodies it was about, so that a negation of it still names
+    // them; false compounds carry nothing. The leaves behind each true
+    // entry are kept in stack order in trace.conditions, from the entry's
+    // 'first' up to the next entry's; false entries have none, so And and
+    // Or never move them.
+    struct Entry {
+        bool value;
+        quint16 bodies;
+        int first;
+    };
+    Entry stack[STACK_DEPTH];   // add() keeps rules within this depth
+    int depth = 0;
+    std::vector<quint16>& conditions = trace.conditions;
+    conditions.clear();
+    conditions.reserve(range.length);
+
+    for (int offset = 0; offset < range.length; ++offset) {
+        const YogaInstruction& in = code[offset];
+        switch (in.op) {
+            case YogaInstruction::And:
+            case YogaInstruction::Or: {
+                const Entry rhs = stack[--depth];
+                Entry& lhs = stack[depth - 1];
+                const bool value = in.op == YogaInstruction::And
+                    ? lhs.value && rhs.value : lhs.value || rhs.value;
+                if (!value) {
+                    lhs.value = false;
+                    lhs.bodies = 0;
+                    conditions.resize(lhs.first);
+                } else if (!lhs.value) {
+                    lhs.value = true;
+                    lhs.bodies = rhs.bodies;
+                } else if (rhs.value) {
+                    lhs.bodies |= rhs.bodies;
+                }
+                break;
+            }
+            case YogaInstruction::Not: {
+                // A negation that holds is its own condition
+                Entry& top = stack[depth - 1];
+                top.value = !top.value;
+                conditions.resize(top.first);
+                if (top.value) {
+                    conditions.push_back(static_cast<quint16>(offset));
+                } else {
+                    top.bodies = 0;
+                }
+                break;
+            }
+            default: {
+                Entry& entry = stack[depth++];
+                entry.bodies = 0;
+                entry.first = int(conditions.size());
+                entry.value = leafValue<true>(in, f, entry.bodies);
+                if (entry.value) conditions.push_back(static_cast<quint16>(offset));
+                break;
+            }
+        }
+    }
+
+    trace.participants = stack[0].bodies;
+    return stack[0].value;
+}
+
+QString YogaProgram::describe(int rule, int offset) const {
+    const Range range = m_ranges[rule];
+    const YogaInstruction* code = m_code.constData() + range.start;
+    const YogaInstruction& in = code[offset];
+
+    switch (in.op) {
+        case YogaInstruction::True:
+            return QStringLiteral("always");
+        case YogaInstruction::InHouse:
+            return QString("%1 in house %2").arg(bodyName(in.a), numbers(in.mask));
+        case YogaInstruction::InSign:
+            return QString("%1 in %2").arg(bodyName(in.a), signNames(in.mask));
+        case YogaInstruction::HasDignity:
+            return QString("%1 %2").arg(bodyName(in.a), dignityNames(in.mask));
+        case YogaInstruction::PlaceFrom:
+            return QString("%1 in place %2 from %3")
+                .arg(bodyName(in.b), numbers(in.mask), bodyName(in.a));
+        case YogaInstruction::LordInHouse:
+            return QString("lord of house %1 in house %2").arg(int(in.a)).arg(numbers(in.mask));
+        case YogaInstruction::LordPlaceFrom:
+            return QString("lord of house %1 in place %2 from %3")
+                .arg(int(in.a)).arg(numbers(in.mask), bodyName(in.b));
+        case YogaInstruction::DispositorPlaceFrom:
+            return QString("dispositor of %1 in place %2 from %3")
+                .arg(bodyName(in.a), numbers(in.mask), bodyName(in.b));
+        case YogaInstruction::ExaltationLordPlaceFrom:
+            return QString("exaltation lord of %1 in place %2 from %3")
+                .arg(bodyName(in.a), numbers(in.mask), bodyName(in.b));
+        case YogaInstruction::Conjunct:
+            return QString("%1 conjunct %2").arg(bodyName(in.a), bodyName(in.b));
+        case YogaInstruction::Aspects:
+            return QString("%1 aspects %2").arg(bodyName(in.a), bodyName(in.b));
+        case YogaInstruction::OccupiedFrom:
+            return QString("%1 in place %2 from %3")
+                .arg(bodyNames(in.mask)).arg(int(in.b)).arg(bodyName(in.a));
+        case YogaInstruction::LordsAssociated:
+            return QString("lords of houses %1 and %2 associated")
+                .arg(numbers(in.mask), numbers(in.mask2));
+        case YogaInstruction::Not:
+            if (offset > 0 && code[offset - 1].op < YogaInstruction::And) {
+                return "not " + describe(rule, offset - 1);
+            }
+            return QStringLiteral("not all of the alternatives");
+        default:
+            return QString();
+    }
+}
+
+QVector<quint64> YogaProgram::evaluateAll(const ChartFeatures& features) const {
+    QVector<quint64> active(wordCount(), 0);
+    evaluateAll(features, active.data());
+    return active;
+}
+
+void YogaProgram::evaluateAll(const ChartFeatures& features, quint64* active) const {
+    std::fill(active, active + wordCount(), 0);
+    for (int rule = 0; rule < m_ranges.size(); ++rule) {
+        if (evaluate(rule, features)) {
+            active[rule / 64] |= quint64(1) << (rule % 64);
+        }
+    }
+}
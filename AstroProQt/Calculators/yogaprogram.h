@@ -0,0 +1,196 @@
+#ifndef YOGAPROGRAM_H
+#define YOGAPROGRAM_H
+
+#include <QString>
+#include <QVector>
+#include <initializer_list>
+#include <vector>
+#include "planetdata.h"
+#include "aspectmatrix.h"
+#include "vargacalculator.h"
+
+// Everything a yoga rule can ask about a chart, precomputed once per chart
+// so that rules reduce to table lookups and mask tests.
+struct ChartFeatures {
+    // Bodies are the nine grahas in Astro::Planet order, then the ascendant
+    enum { Lagna = Astro::PlanetCount, BodyCount = Astro::PlanetCount + 1 };
+
+    enum Dignity : quint8 {
+        Own                = 1 << 0,
+        Exalted            = 1 << 1,
+        Debilitated        = 1 << 2,
+        Moolatrikona       = 1 << 3,
+        Vargottama         = 1 << 4,
+        NavamsaExalted     = 1 << 5,
+        NavamsaDebilitated = 1 << 6
+    };
+    enum { DignityCount = 7 };                // Bits of Dignity
+
+    quint16 present;                          // Bit per body
+    quint8 sign[BodyCount];                   // 0 = Aries
+    quint8 house[BodyCount];                  // 1-12 from the cusps
+    quint8 dignity[Astro::PlanetCount];       // Dignity bits
+    quint8 houseLord[13];                     // [1..12] lord of each house
+    quint16 conjunct[Astro::PlanetCount];     // Bodies within the orb
+    quint16 aspectedSigns[Astro::PlanetCount]; // Signs under graha drishti
+
+    ChartFeatures();
+
+    // Lordship is counted in whole signs from the ascendant sign held in
+    // the varga matrix; placement uses the aspect matrix houses
+    static ChartFeatures build(const AspectMatrix& aspects,
+                               const VargaCalculator::VargaMatrix& vargas);
+
+    bool contains(int body) const { return (present >> body) & 1u; }
+    // Place (1-12) of body 'to' counted from body 'from' by sign
+    int place(int from, int to) const { return (sign[to] - sign[from] + 12) % 12 + 1; }
+
+    // Places (bit n-1 = nth) receiving a graha's full sight
+    static quint16 drishtiPlaces(int planet);
+
+    static constexpr double CONJUNCTION_ORB = 10.0;
+};
+
+// One step of a compiled rule. Rules are stored in postfix order: leaf
+// predicates push a result and And/Or/Not combine the top of the stack.
+// Masks of houses, signs or places use bit n-1 for house n / place n and
+// bit s for sign s; masks of bodies use bit b for body b.
+struct YogaInstruction {
+    enum Opcode : quint8 {
+        True,
+        InHouse,            // body a in houses[mask]
+        InSign,             // body a in signs[mask]
+        HasDignity,         // dignity[a] & mask
+        PlaceFrom,          // body b sits in places[mask] counted from body a
+        LordInHouse,        // lord of house a sits in houses[mask]
+        LordPlaceFrom,      // lord of house a in places[mask] from body b
+        DispositorPlaceFrom,    // lord of a's sign in places[mask] from body b
+        ExaltationLordPlaceFrom, // lord of a's exaltation sign, likewise
+        Conjunct,           // a and b within the conjunction orb
+        Aspects,            // a casts graha drishti on b
+        OccupiedFrom,       // some body of set[mask] in place b from body a
+        LordsAssociated,    // a lord of houses[mask] and another lord of
+                            // houses[mask2] conjunct, in mutual 7th or exchange
+        And,
+        Or,
+        Not
+    };
+
+    quint8 op;
+    quint8 a;
+    quint8 b;
+    quint16 mask;
+    quint16 mask2;
+};
+
+// A rule under construction; combined with &&, || and ! and then compiled
+// into a YogaProgram
+class YogaExpr {
+public:
+    YogaExpr() {}
+    explicit YogaExpr(const YogaInstruction& leaf) { m_code.append(leaf); }
+
+    const QVector<YogaInstruction>& code() const { return m_code; }
+
+    friend YogaExpr operator&&(const YogaExpr& lhs, const YogaExpr& rhs);
+    friend YogaExpr operator||(const YogaExpr& lhs, const YogaExpr& rhs);
+    friend YogaExpr operator!(const YogaExpr& expr);
+
+private:
+    static YogaExpr combine(const YogaExpr& lhs, const YogaExpr& rhs, quint8 op);
+
+    QVector<YogaInstruction> m_code;
+};
+
+// Vocabulary for writing rules
+namespace YogaRules {
+
+constexpr quint16 places(std::initializer_list<int> numbers) {
+    quint16 mask = 0;
+    for (int n : numbers) mask |= static_cast<quint16>(1u << (n - 1));
+    return mask;
+}
+
+constexpr quint16 Kendras = places({1, 4, 7, 10});
+constexpr quint16 Trikonas = places({1, 5, 9});
+constexpr quint16 Dusthanas = places({6, 8, 12});
+
+// Body sets: the five tara grahas, and the natural benefics
+constexpr quint16 TaraGrahas = (1u << Astro::Mars) | (1u << Astro::Mercury) |
+                               (1u << Astro::Jupiter) | (1u << Astro::Venus) |
+                               (1u << Astro::Saturn);
+constexpr quint16 NaturalBenefics = (1u << Astro::Moon) | (1u << Astro::Mercury) |
+                                    (1u << Astro::Jupiter) | (1u << Astro::Venus);
+
+YogaExpr always();
+YogaExpr inHouse(int body, quint16 houses);
+YogaExpr inSign(int body, quint16 signs);
+YogaExpr hasDignity(int planet, quint8 dignity);
+YogaExpr placeFrom(int from, int body, quint16 places);
+YogaExpr lordInHouse(int house, quint16 houses);
+YogaExpr lordPlaceFrom(int house, int from, quint16 places);
+YogaExpr dispositorPlaceFrom(int planet, int from, quint16 places);
+YogaExpr exaltationLordPlaceFrom(int planet, int from, quint16 places);
+YogaExpr conjunct(int planet1, int planet2);
+YogaExpr aspects(int planet, int target);
+YogaExpr occupiedFrom(int from, int place, quint16 bodies);
+YogaExpr lordsAssociated(quint16 housesA, quint16 housesB);
+
+} // namespace YogaRules
+
+// Why a rule held: the bodies that formed it and the leaves that carried
+// the result, as offsets into the rule's instructions. A trace reused
+// across rules keeps the capacity of its conditions.
+struct YogaTrace {
+    quint16 participants;           // Bit per ChartFeatures body
+    std::vector<quint16> conditions;
+
+    YogaTrace() : participants(0) {}
+};
+
+// All yoga rules flattened into one instruction array, compiled once and
+// evaluated against a ChartFeatures vector per chart
+class YogaProgram {
+public:
+    YogaProgram();
+
+    // Append a rule; returns its index, or -1 and adds nothing when the
+    // rule does not leave exactly one value or needs more than STACK_DEPTH
+    int add(const YogaExpr& rule);
+
+    int ruleCount() const { return m_ranges.size(); }
+    int instructionCount() const { return m_code.size(); }
+    // Words of an evaluateAll() result
+    int wordCount() const { return (m_ranges.size() + 63) / 64; }
+
+    // Postfix instructions of one rule
+    QVector<YogaInstruction> rule(int index) const;
+
+    bool evaluate(int rule, const ChartFeatures& features) const;
+
+    // As evaluate(), also recording why the rule held
+    bool trace(int rule, const ChartFeatures& features, YogaTrace& trace) const;
+
+    // Plain-text reading of one instruction of a rule, for reports
+    QString describe(int rule, int offset) const;
+
+    // Evaluate every rule; bit i of the result word i / 64 is rule i
+    QVector<quint64> evaluateAll(const ChartFeatures& features) const;
+    // As above, into wordCount() words
+    void evaluateAll(const ChartFeatures& features, quint64* active) const;
+
+    // Values evaluate() and trace() can hold; evaluate() keeps them in the
+    // bits of one word
+    static constexpr int STACK_DEPTH = 64;
+
+private:
+    struct Range {
+        int start;
+        int length;
+    };
+
+    QVector<YogaInstruction> m_code;
+    QVector<Range> m_ranges;
+};
+
+#endif // YOGAPROGRAM_H
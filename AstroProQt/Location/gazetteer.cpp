@@ -0,0 +1,515 @@
+#include "gazetteer.h"
+#include <QIODevice>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+// File layout: a header, then sections aligned to four bytes. All integers
+// are little-endian and the sections are read in place from the mapping.
+struct Gazetteer::Header {
+    quint32 magic;
+    quint32 version;
+    quint32 placeCount;
+    quint32 nodeCount;
+    quint32 topCount;
+    quint32 labelBytes;
+    quint32 zoneCount;
+    quint32 stringBytes;
+    quint32 resultsPerPrefix;
+    quint32 placesOffset;   // PlaceRecord[placeCount]
+    quint32 nodesOffset;    // TrieNode[nodeCount], root first, children contiguous
+    quint32 topsOffset;     // quint32 place indexes, most populous first
+    quint32 labelsOffset;   // Trie edge labels, UTF-8
+    quint32 zonesOffset;    // quint32 string offset and length per zone
+    quint32 stringsOffset;  // Names, divisions and zone ids, UTF-8
+    quint32 fileSize;
+};
+
+struct Gazetteer::PlaceRecord {
+    qint32 latitude;        // Microdegrees
+    qint32 longitude;
+    quint32 population;
+    quint32 text;           // Name then division in the string section
+    quint16 nameLength;
+    quint16 adminLength;
+    quint16 zone;           // NoZone if unknown
+    char country[2];
+};
+
+struct Gazetteer::TrieNode {
+    quint32 label;          // Edge label into the label section
+    quint32 firstChild;
+    quint32 top;            // Into the top-places section
+    quint16 labelLength;
+    quint16 childCount;
+    quint16 topCount;
+    quint16 reserved;
+};
+
+namespace {
+
+const quint32 GazetteerMagic = 0x5A475041;   // "APGZ"
+const quint32 GazetteerVersion = 1;
+const quint16 NoZone = 0xFFFF;
+const int MaxKeyLength = 64;                 // Longer names are not indexed
+
+quint32 align4(quint32 offset) {
+    return (offset + 3) & ~3u;
+}
+
+} // namespace
+
+QString Gazetteer::Place::displayName() const {
+    QStringList parts;
+    parts << name;
+    if (!admin.isEmpty() && admin != name) parts << admin;
+    if (!country.isEmpty()) parts << country;
+    return parts.join(", ");
+}
+
+Gazetteer::Gazetteer()
+    : m_base(nullptr)
+    , m_header(nullptr)
+{
+}
+
+Gazetteer::~Gazetteer() {
+    close();
+}
+
+void Gazetteer::close() {
+    if (m_base) {
+        m_file.unmap(const_cast<uchar*>(m_base));
+    }
+    m_file.close();
+    m_base = nullptr;
+    m_header = nullptr;
+}
+
+bool Gazetteer::open(const QString& filePath) {
+    close();
+    m_error.clear();
+    
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    m_error = "Gazetteer files are only read on little-endian hosts";
+    return false;
+#endif
+    
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    
+    const qint64 size = m_file.size();
+    const uchar* base = size >= qint64(sizeof(Header)) ? m_file.map(0, size) : nullptr;
+    const Header* header = reinterpret_cast<const Header*>(base);
+    if (!header || header->magic != GazetteerMagic || header->version != GazetteerVersion ||
+        header->fileSize != size) {
+        m_error = "Not a gazetteer file";
+        if (base) m_file.unmap(const_cast<uchar*>(base));
+        m_file.close();
+        return false;
+    }
+    
+    // Check every section and every cross reference once, so that queries
+    // can follow them without bounds checks
+    auto fits = [size](quint64 offset, quint64 bytes) {
+        return offset % 4 == 0 && offset + bytes <= quint64(size);
+    };
+    bool valid = header->nodeCount > 0 &&
+        fits(header->placesOffset, quint64(header->placeCount) * sizeof(PlaceRecord)) &&
+        fits(header->nodesOffset, quint64(header->nodeCount) * sizeof(TrieNode)) &&
+        fits(header->topsOffset, quint64(header->topCount) * sizeof(quint32)) &&
+        fits(header->labelsOffset, header->labelBytes) &&
+        fits(header->zonesOffset, quint64(header->zoneCount) * 2 * sizeof(quint32)) &&
+        fits(header->stringsOffset, header->stringBytes);
+    
+    if (valid) {
+        const TrieNode* nodes = reinterpret_cast<const TrieNode*>(base + header->nodesOffset);
+        const quint32* tops = reinterpret_cast<const quint32*>(base + header->topsOffset);
+        for (quint32 i = 0; valid && i < header->nodeCount; ++i) {
+            const TrieNode& node = nodes[i];
+            valid = quint64(node.label) + node.labelLength <= header->labelBytes &&
+                    (i == 0 || node.labelLength > 0) &&
+                    quint64(node.firstChild) + node.childCount <= header->nodeCount &&
+                    quint64(node.top) + node.topCount <= header->topCount;
+        }
+        for (quint32 i = 0; valid && i < header->topCount; ++i) {
+            valid = tops[i] < header->placeCount;
+        }
+        const PlaceRecord* places = reinterpret_cast<const PlaceRecord*>(base + header->placesOffset);
+        for (quint32 i = 0; valid && i < header->placeCount; ++i) {
+            const PlaceRecord& place = places[i];
+            valid = quint64(place.text) + place.nameLength + place.adminLength <= header->stringBytes &&
+                    (place.zone == NoZone || place.zone < header->zoneCount);
+        }
+        const quint32* zones = reinterpret_cast<const quint32*>(base + header->zonesOffset);
+        for (quint32 i = 0; valid && i < header->zoneCount; ++i) {
+            valid = quint64(zones[2 * i]) + zones[2 * i + 1] <= header->stringBytes;
+        }
+    }
+    
+    if (!valid) {
+        m_error = "Gazetteer file is corrupt";
+        m_file.unmap(const_cast<uchar*>(base));
+        m_file.close();
+        return false;
+    }
+    
+    m_base = base;
+    m_header = header;
+    return true;
+}
+
+int Gazetteer::placeCount() const {
+    return m_header ? int(m_header->placeCount) : 0;
+}
+
+QByteArray Gazetteer::normalize(const QString& text) {
+    // Compatibility decomposition splits accented letters into a base
+    // letter and combining marks, which are then dropped
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD);
+    QString folded;
+    folded.reserve(decomposed.size());
+    bool gap = false;
+    for (int i = 0; i < decomposed.size(); ++i) {
+        const QChar c = decomposed.at(i);
+        if (c.category() == QChar::Mark_NonSpacing) continue;
+        // "St. John's" and "St Johns" share a key
+        if (c == QChar('\'') || c.unicode() == 0x2019) continue;
+        if (!c.isLetterOrNumber()) {
+            gap = true;
+            continue;
+        }
+        if (gap && !folded.isEmpty()) folded += QChar(' ');
+        gap = false;
+        folded += c.toLower();
+    }
+    return folded.toUtf8();
+}
+
+QString Gazetteer::stringAt(quint32 offset, int length) const {
+    return QString::fromUtf8(reinterpret_cast<const char*>(m_base + m_header->stringsOffset + offset),
+                             length);
+}
+
+Gazetteer::Place Gazetteer::placeAt(quint32 index) const {
+    const PlaceRecord& record =
+        reinterpret_cast<const PlaceRecord*>(m_base + m_header->placesOffset)[index];
+    
+    Place place;
+    place.name = stringAt(record.text, record.nameLength);
+    place.admin = stringAt(record.text + record.nameLength, record.adminLength);
+    place.country = QString::fromLatin1(record.country, record.country[1] ? 2 : 0);
+    if (record.zone != NoZone) {
+        const quint32* zone =
+            reinterpret_cast<const quint32*>(m_base + m_header->zonesOffset) + 2 * record.zone;
+        place.timezone = stringAt(zone[0], zone[1]);
+    }
+    place.latitude = record.latitude / 1e6;
+    place.longitude = record.longitude / 1e6;
+    place.population = record.population;
+    return place;
+}
+
+QVector<Gazetteer::Place> Gazetteer::complete(const QString& prefix, int limit) const {
+    QVector<Place> places;
+    const QByteArray key = normalize(prefix);
+    if (!isOpen() || key.isEmpty() || limit <= 0) return places;
+    
+    const TrieNode* nodes = reinterpret_cast<const TrieNode*>(m_base + m_header->nodesOffset);
+    const char* labels = reinterpret_cast<const char*>(m_base + m_header->labelsOffset);
+    const TrieNode* node = nodes;
+    int position = 0;
+    for (;;) {
+        // Match the edge label; the prefix may end part way along it
+        const char* label = labels + node->label;
+        for (int i = 0; i < node->labelLength && position < key.size(); ++i, ++position) {
+            if (label[i] != key[position]) return places;
+        }
+        if (position == key.size()) break;
+        
+        const TrieNode* next = nullptr;
+        const TrieNode* child = nodes + node->firstChild;
+        for (int i = 0; i < node->childCount; ++i, ++child) {
+            if (labels[child->label] == key[position]) {
+                next = child;
+                break;
+            }
+        }
+        if (!next) return places;
+        node = next;
+    }
+    
+    // The node holds the most populous places of its whole subtree
+    const quint32* top = reinterpret_cast<const quint32*>(m_base + m_header->topsOffset) + node->top;
+    const int count = qMin(limit, int(node->topCount));
+    places.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        places.append(placeAt(top[i]));
+    }
+    return places;
+}
+
+// GazetteerBuilder
+
+GazetteerBuilder::GazetteerBuilder()
+    : m_resultsPerPrefix(10)
+    , m_alternateLimit(16)
+{
+}
+
+bool GazetteerBuilder::readAdminNames(QIODevice& device) {
+    if (!device.isOpen() && !device.open(QIODevice::ReadOnly)) return false;
+    // code, name, ASCII name, geonameid
+    while (!device.atEnd()) {
+        const QList<QByteArray> fields = device.readLine().split('\t');
+        if (fields.size() < 2) continue;
+        m_adminNames.insert(QString::fromUtf8(fields[0]), QString::fromUtf8(fields[1]).trimmed());
+    }
+    return true;
+}
+
+int GazetteerBuilder::readGeoNames(QIODevice& device, quint32 minimumPopulation) {
+    if (!device.isOpen() && !device.open(QIODevice::ReadOnly)) return 0;
+    
+    // geonameid, name, asciiname, alternatenames, latitude, longitude,
+    // feature class, feature code, country code, cc2, admin1 ... admin4,
+    // population, elevation, dem, timezone, modification date
+    enum { Name = 1, AsciiName = 2, AlternateNames = 3, Latitude = 4, Longitude = 5,
+           CountryCode = 8, Admin1 = 10, Population = 14, Timezone = 17, FieldCount = 18 };
+    
+    int count = 0;
+    while (!device.atEnd()) {
+        QByteArray line = device.readLine();
+        if (line.endsWith('\n')) line.chop(1);
+        const QList<QByteArray> fields = line.split('\t');
+        if (fields.size() < FieldCount) continue;
+        
+        const quint32 population = fields[Population].toUInt();
+        if (population < minimumPopulation) continue;
+        
+        Gazetteer::Place place;
+        place.name = QString::fromUtf8(fields[Name]);
+        place.country = QString::fromLatin1(fields[CountryCode]);
+        const QString adminCode = QString::fromUtf8(fields[Admin1]);
+        place.admin = m_adminNames.value(place.country + "." + adminCode, adminCode);
+        place.timezone = QString::fromLatin1(fields[Timezone]);
+        place.latitude = fields[Latitude].toDouble();
+        place.longitude = fields[Longitude].toDouble();
+        place.population = population;
+        
+        QStringList alternates;
+        alternates << QString::fromUtf8(fields[AsciiName]);
+        if (!fields[AlternateNames].isEmpty()) {
+            alternates += QString::fromUtf8(fields[AlternateNames]).split(',');
+        }
+        addPlace(place, alternates);
+        ++count;
+    }
+    return count;
+}
+
+void GazetteerBuilder::addPlace(const Gazetteer::Place& place, const QStringList& alternateNames) {
+    const quint32 index = m_places.size();
+    m_places.append(place);
+    
+    // Only distinct alternates after the ASCII name count toward the limit
+    QVector<QByteArray> keys;
+    keys.append(Gazetteer::normalize(place.name));
+    int counted = 0;
+    for (int i = 0; i < alternateNames.size(); ++i) {
+        if (i > 0 && counted == m_alternateLimit) break;
+        const QByteArray key = Gazetteer::normalize(alternateNames[i]);
+        if (keys.contains(key)) continue;
+        keys.append(key);
+        if (i > 0) ++counted;
+    }
+    
+    for (const QByteArray& key : keys) {
+        if (key.isEmpty() || key.size() > MaxKeyLength) continue;
+        m_entries.append(Entry{key, index});
+    }
+}
+
+void GazetteerBuilder::mergeTop(QVector<quint32>& top, const QVector<quint32>& candidates) const {
+    top += candidates;
+    // Most populous first, then in input order
+    std::sort(top.begin(), top.end(), [this](quint32 a, quint32 b) {
+        const quint32 populationA = m_places[a].population;
+        const quint32 populationB = m_places[b].population;
+        return populationA != populationB ? populationA > populationB : a < b;
+    });
+    top.erase(std::unique(top.begin(), top.end()), top.end());
+    if (top.size() > m_resultsPerPrefix) {
+        top.resize(m_resultsPerPrefix);
+    }
+}
+
+int GazetteerBuilder::buildNode(const QVector<Entry>& entries, int begin, int end, int depth,
+                                bool root, QVector<BuildNode>& nodes) const {
+    // Entries are sorted, so the first and last share the range's prefix.
+    // Below the root an edge takes all of it (path compression).
+    int split = depth;
+    if (!root && begin < end) {
+        const QByteArray& first = entries[begin].key;
+        const QByteArray& last = entries[end - 1].key;
+        const int limit = qMin(first.size(), last.size());
+        while (split < limit && first[split] == last[split]) ++split;
+    }
+    
+    const int index = nodes.size();
+    nodes.append(BuildNode());
+    if (begin < end) {
+        nodes[index].label = entries[begin].key.mid(depth, split - depth);
+    }
+    
+    // Names ending here sort before the longer ones
+    QVector<quint32> terminal;
+    int i = begin;
+    while (i < end && entries[i].key.size() == split) {
+        terminal.append(entries[i].place);
+        ++i;
+    }
+    
+    // One child per distinct next byte
+    while (i < end) {
+        const char next = entries[i].key[split];
+        int j = i + 1;
+        while (j < end && entries[j].key[split] == next) ++j;
+        
+        const int child = buildNode(entries, i, j, split, false, nodes);
+        nodes[index].children.append(child);
+        const QVector<quint32> childTop = nodes[child].top;
+        mergeTop(nodes[index].top, childTop);
+        i = j;
+    }
+    mergeTop(nodes[index].top, terminal);
+    return index;
+}
+
+bool GazetteerBuilder::write(const QString& filePath, QString* error) const {
+    if (m_places.size() > 0x7FFFFFFF || m_resultsPerPrefix > 0xFFFF) {
+        if (error) *error = "Too many places";
+        return false;
+    }
+    
+    // Place records and their strings
+    QByteArray strings;
+    QHash<QString, int> zoneIndex;
+    QVector<quint32> zones;
+    QVector<Gazetteer::PlaceRecord> records;
+    records.reserve(m_places.size());
+    for (const Gazetteer::Place& place : m_places) {
+        const QByteArray name = place.name.toUtf8().left(0xFFFF);
+        const QByteArray admin = place.admin.toUtf8().left(0xFFFF);
+        const QByteArray country = place.country.toLatin1();
+        
+        Gazetteer::PlaceRecord record;
+        record.latitude = qRound(place.latitude * 1e6);
+        record.longitude = qRound(place.longitude * 1e6);
+        record.population = place.population;
+        record.text = strings.size();
+        record.nameLength = name.size();
+        record.adminLength = admin.size();
+        record.country[0] = country.size() == 2 ? country[0] : 0;
+        record.country[1] = country.size() == 2 ? country[1] : 0;
+        strings += name;
+        strings += admin;
+        
+        record.zone = NoZone;
+        if (!place.timezone.isEmpty()) {
+            auto it = zoneIndex.find(place.timezone);
+            if (it == zoneIndex.end()) {
+                const QByteArray zone = place.timezone.toUtf8();
+                it = zoneIndex.insert(place.timezone, zones.size() / 2);
+                zones << quint32(strings.size()) << quint32(zone.size());
+                strings += zone;
+            }
+            if (it.value() < NoZone) record.zone = it.value();
+        }
+        records.append(record);
+    }
+    
+    // Radix trie over the sorted keys, laid out breadth first so that the
+    // children of a node are contiguous
+    QVector<Entry> entries = m_entries;
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.key != b.key ? a.key < b.key : a.place < b.place;
+    });
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.key == b.key && a.place == b.place;
+    }), entries.end());
+    
+    QVector<BuildNode> built;
+    buildNode(entries, 0, entries.size(), 0, true, built);
+    
+    QVector<Gazetteer::TrieNode> nodes(built.size());
+    QVector<quint32> tops;
+    QByteArray labels;
+    QVector<int> queue;
+    queue.reserve(built.size());
+    queue.append(0);
+    int nextPosition = 1;
+    for (int head = 0; head < queue.size(); ++head) {
+        const BuildNode& source = built[queue[head]];
+        if (source.label.size() > 0xFFFF || source.children.size() > 0xFFFF) {
+            if (error) *error = "Name too long to index";
+            return false;
+        }
+        Gazetteer::TrieNode& node = nodes[head];
+        node.label = labels.size();
+        node.labelLength = source.label.size();
+        node.firstChild = nextPosition;
+        node.childCount = source.children.size();
+        node.top = tops.size();
+        node.topCount = source.top.size();
+        node.reserved = 0;
+        labels += source.label;
+        tops += source.top;
+        for (int child : source.children) {
+            queue.append(child);
+            ++nextPosition;
+        }
+    }
+    
+    Gazetteer::Header header;
+    header.magic = GazetteerMagic;
+    header.version = GazetteerVersion;
+    header.placeCount = records.size();
+    header.nodeCount = nodes.size();
+    header.topCount = tops.size();
+    header.labelBytes = labels.size();
+    header.zoneCount = zones.size() / 2;
+    header.stringBytes = strings.size();
+    header.resultsPerPrefix = m_resultsPerPrefix;
+    header.placesOffset = align4(sizeof(Gazetteer::Header));
+    header.nodesOffset = align4(header.placesOffset + records.size() * sizeof(Gazetteer::PlaceRecord));
+    header.topsOffset = align4(header.nodesOffset + nodes.size() * sizeof(Gazetteer::TrieNode));
+    header.labelsOffset = align4(header.topsOffset + tops.size() * sizeof(quint32));
+    header.zonesOffset = align4(header.labelsOffset + labels.size());
+    header.stringsOffset = align4(header.zonesOffset + zones.size() * sizeof(quint32));
+    header.fileSize = header.stringsOffset + strings.size();
+    
+    QByteArray image(header.fileSize, '\0');
+    auto put = [&image](quint32 offset, const void* data, int bytes) {
+        if (bytes > 0) memcpy(image.data() + offset, data, bytes);
+    };
+    put(0, &header, sizeof(Gazetteer::Header));
+    put(header.placesOffset, records.constData(), records.size() * sizeof(Gazetteer::PlaceRecord));
+    put(header.nodesOffset, nodes.constData(), nodes.size() * sizeof(Gazetteer::TrieNode));
+    put(header.topsOffset, tops.constData(), tops.size() * sizeof(quint32));
+    put(header.labelsOffset, labels.constData(), labels.size());
+    put(header.zonesOffset, zones.constData(), zones.size() * sizeof(quint32));
+    put(header.stringsOffset, strings.constData(), strings.size());
+    
+    // Written whole and renamed into place, so readers never map a partial file
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(image) != image.size() || !file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
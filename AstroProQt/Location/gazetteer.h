@@ -0,0 +1,109 @@
+#ifndef GAZETTEER_H
+#define GAZETTEER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QIODevice;
+
+// Offline place lookup for type-ahead. The gazetteer file holds fixed-size
+// place records and a radix trie over normalized names in which every node
+// stores its most populous places, so a prefix query walks at most one node
+// per character and never enumerates the subtree. The file is memory-mapped
+// and used in place.
+class Gazetteer {
+public:
+    struct Place {
+        QString name;
+        QString admin;       // First-level division, e.g. a state
+        QString country;     // ISO 3166 alpha-2
+        QString timezone;    // IANA zone id, empty if unknown
+        double latitude;
+        double longitude;
+        quint32 population;
+
+        Place() : latitude(0), longitude(0), population(0) {}
+        QString displayName() const;
+    };
+
+    Gazetteer();
+    ~Gazetteer();
+
+    bool open(const QString& filePath);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+    QString errorString() const { return m_error; }
+
+    int placeCount() const;
+
+    // Most populous places with a name starting with the prefix
+    QVector<Place> complete(const QString& prefix, int limit = 10) const;
+
+    // Lower case, diacritics dropped, punctuation folded to single spaces
+    static QByteArray normalize(const QString& text);
+
+private:
+    struct Header;
+    struct PlaceRecord;
+    struct TrieNode;
+
+    Place placeAt(quint32 index) const;
+    QString stringAt(quint32 offset, int length) const;
+
+    QFile m_file;
+    const uchar* m_base;
+    const Header* m_header;
+    QString m_error;
+
+    friend class GazetteerBuilder;
+};
+
+// Builds a gazetteer file from a GeoNames dump
+// (https://download.geonames.org/export/dump/, e.g. cities500.txt)
+class GazetteerBuilder {
+public:
+    GazetteerBuilder();
+
+    // Places kept at each trie node, and so the most a query can return
+    void setResultsPerPrefix(int count) { m_resultsPerPrefix = count; }
+    // Alternate names indexed per place, beyond the name and ASCII name
+    void setAlternateNameLimit(int count) { m_alternateLimit = count; }
+
+    // admin1CodesASCII.txt, for division names instead of codes
+    bool readAdminNames(QIODevice& device);
+    // Tab-separated GeoNames records; returns the places read
+    int readGeoNames(QIODevice& device, quint32 minimumPopulation = 0);
+
+    // The first alternate name is the ASCII name
+    void addPlace(const Gazetteer::Place& place, const QStringList& alternateNames = QStringList());
+
+    int placeCount() const { return m_places.size(); }
+    bool write(const QString& filePath, QString* error = nullptr) const;
+
+private:
+    struct Entry {
+        QByteArray key;
+        quint32 place;
+    };
+    struct BuildNode {
+        QByteArray label;
+        QVector<int> children;
+        QVector<quint32> top;
+    };
+
+    int buildNode(const QVector<Entry>& entries, int begin, int end, int depth, bool root,
+                  QVector<BuildNode>& nodes) const;
+    void mergeTop(QVector<quint32>& top, const QVector<quint32>& candidates) const;
+
+    QVector<Gazetteer::Place> m_places;
+    QVector<Entry> m_entries;
+    QHash<QString, QString> m_adminNames;
+    int m_resultsPerPrefix;
+    int m_alternateLimit;
+};
+
+#endif // GAZETTEER_H
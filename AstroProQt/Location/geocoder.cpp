@@ -0,0 +1,434 @@
+#include "geocoder.h"
+#include "gazetteer.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QTimer>
+#include <QUrlQuery>
+#include <algorithm>
+
+namespace {
+
+// Cache file record: key, fetch time, found flag, latitude, longitude and
+// the formatted name, tab-separated on one line
+const int RECORD_FIELDS = 6;
+
+QByteArray sanitized(const QString& text) {
+    QByteArray bytes = text.toUtf8();
+    bytes.replace('\t', ' ');
+    bytes.replace('\n', ' ');
+    bytes.replace('\r', ' ');
+    return bytes;
+}
+
+} // namespace
+
+Geocoder::Geocoder(QObject* parent)
+    : QObject(parent)
+    , m_network(new QNetworkAccessManager(this))
+    , m_endpoint("https://api.opencagedata.com/geocode/v1/json")
+    , m_running(0)
+    , m_diskLines(0)
+    , m_nextId(0)
+    , m_interactive(0) {
+    m_ttl = DEFAULT_TTL;
+    m_maxConcurrent = DEFAULT_MAX_CONCURRENT;
+    m_memory.setMaxCost(DEFAULT_MEMORY_CAPACITY);
+}
+
+Geocoder::~Geocoder() {
+    // The replies outlive this object until the manager is deleted
+    for (auto it = m_replies.constBegin(); it != m_replies.constEnd(); ++it) {
+        disconnect(it.key(), nullptr, this, nullptr);
+        it.key()->abort();
+    }
+}
+
+void Geocoder::setMaxConcurrent(int requests) {
+    m_maxConcurrent = qMax(1, requests);
+    startQueued();
+}
+
+bool Geocoder::setCacheFile(const QString& filePath) {
+    m_diskFile.close();
+    m_diskIndex.clear();
+    m_diskLines = 0;
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    m_diskFile.setFileName(filePath);
+    if (!m_diskFile.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    loadCache();
+    return true;
+}
+
+quint64 Geocoder::lookup(const QString& place) {
+    if (m_interactive != 0) {
+        cancel(m_interactive);
+    }
+    const quint64 id = ++m_nextId;
+    m_interactive = id;
+
+    const Waiter waiter = {id, -1};
+    const QByteArray key = Gazetteer::normalize(place);
+    Result result;
+    result.query = place;
+    if (key.isEmpty()) {
+        result.error = "Empty place name";
+        deliverLater(waiter, result);
+    } else if (cachedResult(key, result)) {
+        deliverLater(waiter, result);
+    } else {
+        wait(key, place, waiter, true);
+        startQueued();
+    }
+    return id;
+}
+
+quint64 Geocoder::lookupBatch(const QStringList& places) {
+    const quint64 id = ++m_nextId;
+    Batch& batch = m_batches[id];
+    batch.results.resize(places.size());
+    batch.remaining = places.size();
+
+    // Cached places are filled in here; the rest queue behind any
+    // interactive lookup and share requests with identical places
+    for (int i = 0; i < places.size(); ++i) {
+        Result& result = batch.results[i];
+        result.query = places[i];
+        const QByteArray key = Gazetteer::normalize(places[i]);
+        if (key.isEmpty()) {
+            result.error = "Empty place name";
+            --batch.remaining;
+        } else if (cachedResult(key, result)) {
+            --batch.remaining;
+        } else {
+            wait(key, places[i], Waiter{id, i}, false);
+        }
+    }
+
+    if (batch.remaining == 0) {
+        QTimer::singleShot(0, this, [this, id]() { finishBatch(id); });
+    } else {
+        startQueued();
+    }
+    return id;
+}
+
+void Geocoder::cancel(quint64 id) {
+    if (id == m_interactive) {
+        m_interactive = 0;
+    }
+    m_batches.remove(id);
+
+    // Requests nobody waits for any more are dropped or aborted
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        QVector<Waiter>& waiters = it->waiters;
+        waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                     [id](const Waiter& waiter) { return waiter.id == id; }),
+                      waiters.end());
+        if (!waiters.isEmpty()) {
+            ++it;
+            continue;
+        }
+        if (it->reply) {
+            QNetworkReply* reply = it->reply;
+            m_replies.remove(reply);
+            disconnect(reply, nullptr, this, nullptr);
+            reply->abort();
+            reply->deleteLater();
+            --m_running;
+        } else {
+            m_queue.removeOne(it.key());
+        }
+        it = m_pending.erase(it);
+    }
+    startQueued();
+}
+
+bool Geocoder::cachedResult(const QByteArray& key, Result& result) {
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    CacheEntry entry;
+    const CacheEntry* cached = m_memory.object(key);
+    if (cached && now - cached->fetched < m_ttl) {
+        entry = *cached;
+    } else {
+        if (cached) {
+            m_memory.remove(key);
+        }
+        auto it = m_diskIndex.constFind(key);
+        if (it == m_diskIndex.constEnd()) {
+            return false;
+        }
+        QByteArray recordKey;
+        if (!readRecord(it.value(), recordKey, entry) || recordKey != key ||
+            now - entry.fetched >= m_ttl) {
+            m_diskIndex.remove(key);
+            return false;
+        }
+        m_memory.insert(key, new CacheEntry(entry));
+    }
+
+    result.formatted = entry.formatted;
+    result.latitude = entry.latitude;
+    result.longitude = entry.longitude;
+    result.found = entry.found;
+    result.cached = true;
+    return true;
+}
+
+void Geocoder::store(const QByteArray& key, const CacheEntry& entry) {
+    m_memory.insert(key, new CacheEntry(entry));
+    if (!m_diskFile.isOpen()) {
+        return;
+    }
+
+    QByteArray line = key;
+    line += '\t' + QByteArray::number(entry.fetched);
+    line += '\t' + QByteArray(entry.found ? "1" : "0");
+    line += '\t' + QByteArray::number(entry.latitude, 'f', 7);
+    line += '\t' + QByteArray::number(entry.longitude, 'f', 7);
+    line += '\t' + sanitized(entry.formatted);
+    line += '\n';
+
+    const qint64 offset = m_diskFile.size();
+    if (m_diskFile.seek(offset) && m_diskFile.write(line) == line.size()) {
+        m_diskFile.flush();
+        m_diskIndex[key] = offset;
+        ++m_diskLines;
+    }
+}
+
+bool Geocoder::readRecord(qint64 offset, QByteArray& key, CacheEntry& entry) {
+    if (!m_diskFile.seek(offset)) {
+        return false;
+    }
+    QByteArray line = m_diskFile.readLine();
+    if (!line.endsWith('\n')) {
+        return false;   // Torn write at the end of the file
+    }
+    line.chop(1);
+
+    const QList<QByteArray> fields = line.split('\t');
+    if (fields.size() != RECORD_FIELDS) {
+        return false;
+    }
+    bool ok = true;
+    key = fields[0];
+    entry.fetched = fields[1].toLongLong(&ok);
+    entry.found = fields[2] == "1";
+    entry.latitude = fields[3].toDouble();
+    entry.longitude = fields[4].toDouble();
+    entry.formatted = QString::fromUtf8(fields[5]);
+    return ok && !key.isEmpty();
+}
+
+void Geocoder::loadCache() {
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    m_diskFile.seek(0);
+    qint64 offset = 0;
+    while (!m_diskFile.atEnd()) {
+        const QByteArray line = m_diskFile.readLine();
+        if (!line.endsWith('\n')) {
+            // Torn write; drop it so the next record starts on its own line
+            m_diskFile.resize(offset);
+            break;
+        }
+        ++m_diskLines;
+
+        // Only the key and the fetch time are needed for the index
+        const int keyEnd = line.indexOf('\t');
+        const int timeEnd = keyEnd < 0 ? -1 : line.indexOf('\t', keyEnd + 1);
+        if (timeEnd > 0) {
+            const QByteArray key = line.left(keyEnd);
+            const qint64 fetched = line.mid(keyEnd + 1, timeEnd - keyEnd - 1).toLongLong();
+            if (now - fetched < m_ttl) {
+                m_diskIndex[key] = offset;
+            } else {
+                m_diskIndex.remove(key);
+            }
+        }
+        offset += line.size();
+    }
+
+    if (m_diskLines > 2 * m_diskIndex.size() + 64) {
+        compactCache();
+    }
+}
+
+void Geocoder::compactCache() {
+    const QString filePath = m_diskFile.fileName();
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QHash<QByteArray, qint64> index;
+    qint64 offset = 0;
+    for (auto it = m_diskIndex.constBegin(); it != m_diskIndex.constEnd(); ++it) {
+        if (!m_diskFile.seek(it.value())) {
+            continue;
+        }
+        const QByteArray line = m_diskFile.readLine();
+        if (!line.endsWith('\n') || file.write(line) != line.size()) {
+            continue;
+        }
+        index[it.key()] = offset;
+        offset += line.size();
+    }
+
+    m_diskFile.close();
+    if (file.commit()) {
+        m_diskIndex = index;
+        m_diskLines = index.size();
+    }
+    m_diskFile.open(QIODevice::ReadWrite);
+}
+
+void Geocoder::wait(const QByteArray& key, const QString& query, const Waiter& waiter, bool urgent) {
+    auto it = m_pending.find(key);
+    if (it == m_pending.end()) {
+        Pending pending;
+        pending.query = query;
+        pending.reply = nullptr;
+        it = m_pending.insert(key, pending);
+        if (urgent) {
+            m_queue.prepend(key);
+        } else {
+            m_queue.enqueue(key);
+        }
+    } else if (urgent && !it->reply) {
+        // Already queued by a batch; move it ahead
+        m_queue.removeOne(key);
+        m_queue.prepend(key);
+    }
+    it->waiters.append(waiter);
+}
+
+void Geocoder::startQueued() {
+    while (m_running < m_maxConcurrent && !m_queue.isEmpty()) {
+        const QByteArray key = m_queue.dequeue();
+        auto it = m_pending.find(key);
+        if (it == m_pending.end() || it->reply) {
+            continue;
+        }
+
+        QUrlQuery query;
+        query.addQueryItem("q", it->query);
+        query.addQueryItem("key", m_apiKey);
+        query.addQueryItem("limit", "1");
+        query.addQueryItem("no_annotations", "1");
+        QUrl url(m_endpoint);
+        url.setQuery(query);
+
+        QNetworkReply* reply = m_network->get(QNetworkRequest(url));
+        it->reply = reply;
+        m_replies.insert(reply, key);
+        ++m_running;
+        connect(reply, &QNetworkReply::finished, this, [this, reply]() { handleReply(reply); });
+    }
+}
+
+void Geocoder::handleReply(QNetworkReply* reply) {
+    reply->deleteLater();
+    --m_running;
+    const QByteArray key = m_replies.take(reply);
+    const Pending pending = m_pending.take(key);
+
+    CacheEntry entry;
+    Result result = parseReply(reply, entry);
+    result.query = pending.query;
+    if (result.ok()) {
+        store(key, entry);
+    }
+
+    // Start the next requests first; the receivers may queue more lookups
+    startQueued();
+    for (const Waiter& waiter : pending.waiters) {
+        deliver(waiter, result);
+    }
+}
+
+Geocoder::Result Geocoder::parseReply(QNetworkReply* reply, CacheEntry& entry) const {
+    Result result;
+    if (reply->error() != QNetworkReply::NoError) {
+        result.error = "Network error: " + reply->errorString();
+        return result;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(reply->readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        result.error = "Invalid response from the geocoding service";
+        return result;
+    }
+
+    const QJsonArray results = doc.object()["results"].toArray();
+    entry.fetched = QDateTime::currentSecsSinceEpoch();
+    entry.found = !results.isEmpty();
+    entry.latitude = 0;
+    entry.longitude = 0;
+    if (entry.found) {
+        const QJsonObject first = results.first().toObject();
+        const QJsonObject geometry = first["geometry"].toObject();
+        entry.formatted = first["formatted"].toString();
+        entry.latitude = geometry["lat"].toDouble();
+        entry.longitude = geometry["lng"].toDouble();
+    }
+
+    result.formatted = entry.formatted;
+    result.latitude = entry.latitude;
+    result.longitude = entry.longitude;
+    result.found = entry.found;
+    return result;
+}
+
+void Geocoder::deliver(const Waiter& waiter, const Result& result) {
+    if (waiter.index < 0) {
+        // Superseded or cancelled lookups stay silent
+        if (waiter.id != m_interactive) {
+            return;
+        }
+        m_interactive = 0;
+        emit finished(waiter.id, result);
+        return;
+    }
+
+    auto it = m_batches.find(waiter.id);
+    if (it == m_batches.end()) {
+        return;
+    }
+    Result& slot = it->results[waiter.index];
+    const QString query = slot.query;
+    slot = result;
+    slot.query = query;
+
+    const int remaining = --it->remaining;
+    const int total = it->results.size();
+    emit batchProgress(waiter.id, total - remaining, total);
+    if (remaining == 0) {
+        finishBatch(waiter.id);
+    }
+}
+
+void Geocoder::deliverLater(const Waiter& waiter, const Result& result) {
+    QTimer::singleShot(0, this, [this, waiter, result]() { deliver(waiter, result); });
+}
+
+void Geocoder::finishBatch(quint64 id) {
+    auto it = m_batches.find(id);
+    if (it == m_batches.end()) {
+        return;
+    }
+    const QVector<Result> results = it->results;
+    m_batches.erase(it);
+    emit batchFinished(id, results);
+}
@@ -0,0 +1,134 @@
+#ifndef GEOCODER_H
+#define GEOCODER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QCache>
+#include <QFile>
+#include <QHash>
+#include <QQueue>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+// Client for the OpenCage forward geocoding API. Queries are keyed by their
+// normalized text; answers are kept in an in-memory LRU and in an append-only
+// disk cache with a time to live. Identical lookups in flight share one
+// request, and at most maxConcurrent requests are on the network at a time.
+//
+// lookup() is for interactive use: each call supersedes the previous one,
+// whose request is aborted unless another lookup still waits on it.
+// lookupBatch() resolves a list of places, e.g. for an import, and reports
+// all answers at once. Results are always delivered from the event loop,
+// never from inside lookup() or lookupBatch().
+class Geocoder : public QObject {
+    Q_OBJECT
+
+public:
+    struct Result {
+        QString query;
+        QString formatted;   // Place name as returned by the service
+        double latitude;
+        double longitude;
+        bool found;
+        bool cached;         // Answered from memory or disk
+        QString error;       // Network or service failure; not cached
+
+        Result() : latitude(0), longitude(0), found(false), cached(false) {}
+        bool ok() const { return error.isEmpty(); }
+    };
+
+    explicit Geocoder(QObject* parent = nullptr);
+    ~Geocoder();
+
+    // Service endpoint and key; the endpoint can point at a local stub server
+    void setEndpoint(const QUrl& url) { m_endpoint = url; }
+    void setApiKey(const QString& key) { m_apiKey = key; }
+
+    // Append-only cache file, loaded here and compacted when mostly stale
+    bool setCacheFile(const QString& filePath);
+    void setTimeToLive(int seconds) { m_ttl = seconds; }
+    void setMemoryCapacity(int entries) { m_memory.setMaxCost(entries); }
+    void setMaxConcurrent(int requests);
+
+    quint64 lookup(const QString& place);
+    quint64 lookupBatch(const QStringList& places);
+    void cancel(quint64 id);
+
+    int pendingRequests() const { return m_pending.size(); }
+
+signals:
+    void finished(quint64 id, const Geocoder::Result& result);
+    void batchProgress(quint64 id, int done, int total);
+    void batchFinished(quint64 id, const QVector<Geocoder::Result>& results);
+
+private:
+    struct CacheEntry {
+        QString formatted;
+        double latitude;
+        double longitude;
+        bool found;
+        qint64 fetched;   // Seconds since the epoch
+    };
+
+    // A lookup waiting for a key; index is the position in a batch
+    struct Waiter {
+        quint64 id;
+        int index;
+    };
+
+    // One network request per key, shared by all its waiters
+    struct Pending {
+        QString query;
+        QNetworkReply* reply;   // Null while queued
+        QVector<Waiter> waiters;
+    };
+
+    struct Batch {
+        QVector<Result> results;
+        int remaining;
+    };
+
+    bool cachedResult(const QByteArray& key, Result& result);
+    void store(const QByteArray& key, const CacheEntry& entry);
+    bool readRecord(qint64 offset, QByteArray& key, CacheEntry& entry);
+    void loadCache();
+    void compactCache();
+
+    void wait(const QByteArray& key, const QString& query, const Waiter& waiter, bool urgent);
+    void startQueued();
+    void handleReply(QNetworkReply* reply);
+    Result parseReply(QNetworkReply* reply, CacheEntry& entry) const;
+    void deliver(const Waiter& waiter, const Result& result);
+    void deliverLater(const Waiter& waiter, const Result& result);
+    void finishBatch(quint64 id);
+
+    QNetworkAccessManager* m_network;
+    QUrl m_endpoint;
+    QString m_apiKey;
+    int m_ttl;
+    int m_maxConcurrent;
+    int m_running;
+
+    QCache<QByteArray, CacheEntry> m_memory;
+    QFile m_diskFile;
+    QHash<QByteArray, qint64> m_diskIndex;   // Offset of the latest record per key
+    int m_diskLines;   // Records in the file, live or superseded
+
+    QHash<QByteArray, Pending> m_pending;
+    QHash<QNetworkReply*, QByteArray> m_replies;
+    QQueue<QByteArray> m_queue;
+    QHash<quint64, Batch> m_batches;
+    quint64 m_nextId;
+    quint64 m_interactive;   // Current lookup(), superseded by the next
+
+    const int DEFAULT_TTL = 30 * 24 * 3600;
+    const int DEFAULT_MEMORY_CAPACITY = 512;
+    const int DEFAULT_MAX_CONCURRENT = 4;
+};
+
+#endif // GEOCODER_H
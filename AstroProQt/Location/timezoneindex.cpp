@@ -0,0 +1,678 @@
+#include "timezoneindex.h"
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTimeZone>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// File layout: a header, then sections aligned to eight bytes. All integers
+// are little-endian and the sections are read in place from the mapping.
+struct TimeZoneIndex::Header {
+    quint32 magic;
+    quint32 version;
+    quint32 cellsPerDegree;
+    quint32 zoneCount;
+    quint32 transitionCount;
+    quint32 polygonCount;
+    quint32 rowRefCount;
+    quint32 edgeCount;
+    quint32 candidateCount;
+    quint32 stringBytes;
+    quint32 zonesOffset;        // ZoneRecord[zoneCount]
+    quint32 transitionsOffset;  // Transition[transitionCount], by zone, then by time
+    quint32 polygonsOffset;     // PolygonRecord[polygonCount]
+    quint32 rowRefsOffset;      // quint32 edge indexes, rowCount + 1 per polygon
+    quint32 edgesOffset;        // Edge[edgeCount], by polygon, then by row
+    quint32 cellsOffset;        // quint32 per cell, rows from the south pole
+    quint32 candidatesOffset;   // Per boundary cell, a count then polygon indexes
+    quint32 stringsOffset;      // Zone ids, UTF-8
+    quint32 fileSize;
+    quint32 reserved;
+};
+
+struct TimeZoneIndex::ZoneRecord {
+    quint32 name;
+    quint32 nameLength;
+    quint32 firstTransition;
+    quint32 transitionCount;
+    qint32 initialOffset;       // Before the first transition
+    qint32 initialDst;
+};
+
+struct TimeZoneIndex::Transition {
+    qint64 at;                  // UTC seconds since the epoch
+    qint32 offset;              // Seconds east of UTC from then on
+    qint32 dst;
+};
+
+struct TimeZoneIndex::PolygonRecord {
+    quint32 zone;
+    quint32 firstRow;
+    quint32 rowCount;
+    quint32 rowRefs;            // Into the row reference section
+};
+
+// An edge is listed in every row its latitude range touches
+struct TimeZoneIndex::Edge {
+    float x1;
+    float y1;
+    float x2;
+    float y2;
+};
+
+namespace {
+
+const quint32 TimeZoneMagic = 0x5A545041;     // "APTZ"
+const quint32 TimeZoneVersion = 1;
+const quint32 SeaCell = 0xFFFFFFFF;
+const quint32 DirectCell = 0x80000000;        // Low bits are the zone
+const double SnapDistance = 0.05;             // Degrees; covers slivers between simplified borders
+const qint64 TransitionSpan = 86400;          // Wider than any UTC offset
+
+quint32 align8(quint32 offset) {
+    return (offset + 7) & ~7u;
+}
+
+int rowOf(double latitude, int cellsPerDegree) {
+    const int rows = 180 * cellsPerDegree;
+    return qBound(0, int(std::floor((latitude + 90.0) * cellsPerDegree)), rows - 1);
+}
+
+int columnOf(double longitude, int cellsPerDegree) {
+    const int columns = 360 * cellsPerDegree;
+    return qBound(0, int(std::floor((longitude + 180.0) * cellsPerDegree)), columns - 1);
+}
+
+// Even-odd test with a ray towards the east, over the edges of one row.
+// Optionally also the distance to the nearest of those edges.
+template <typename Edge>
+bool crossesOdd(const Edge* begin, const Edge* end, double latitude, double longitude,
+                double* edgeDistance) {
+    bool inside = false;
+    double nearest = edgeDistance ? *edgeDistance : 0;
+    for (const Edge* edge = begin; edge != end; ++edge) {
+        const double x1 = edge->x1, y1 = edge->y1, x2 = edge->x2, y2 = edge->y2;
+        if ((y1 > latitude) != (y2 > latitude)) {
+            const double x = x1 + (latitude - y1) * (x2 - x1) / (y2 - y1);
+            if (x > longitude) inside = !inside;
+        }
+        if (edgeDistance) {
+            const double dx = x2 - x1, dy = y2 - y1;
+            const double lengthSquared = dx * dx + dy * dy;
+            double t = lengthSquared > 0 ? ((longitude - x1) * dx + (latitude - y1) * dy) / lengthSquared : 0;
+            t = qBound(0.0, t, 1.0);
+            nearest = qMin(nearest, std::hypot(x1 + t * dx - longitude, y1 + t * dy - latitude));
+        }
+    }
+    if (edgeDistance) *edgeDistance = nearest;
+    return inside;
+}
+
+// Nautical zone by longitude; note the inverted sign of the Etc ids
+int seaOffsetHours(double longitude) {
+    return qBound(-12, int(std::lround(longitude / 15.0)), 12);
+}
+
+QString seaZoneName(double longitude) {
+    const int hours = seaOffsetHours(longitude);
+    if (hours == 0) return "Etc/GMT";
+    return QString("Etc/GMT") + (hours > 0 ? "-" : "+") + QString::number(qAbs(hours));
+}
+
+} // namespace
+
+TimeZoneIndex::TimeZoneIndex()
+    : m_base(nullptr)
+    , m_header(nullptr)
+{
+}
+
+TimeZoneIndex::~TimeZoneIndex() {
+    close();
+}
+
+void TimeZoneIndex::close() {
+    if (m_base) {
+        m_file.unmap(const_cast<uchar*>(m_base));
+    }
+    m_file.close();
+    m_base = nullptr;
+    m_header = nullptr;
+}
+
+bool TimeZoneIndex::open(const QString& filePath) {
+    close();
+    m_error.clear();
+
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    m_error = "Time zone index files are only read on little-endian hosts";
+    return false;
+#endif
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    const uchar* base = size >= qint64(sizeof(Header)) ? m_file.map(0, size) : nullptr;
+    const Header* header = reinterpret_cast<const Header*>(base);
+    if (!header || header->magic != TimeZoneMagic || header->version != TimeZoneVersion ||
+        header->fileSize != size || header->cellsPerDegree < 1 || header->cellsPerDegree > 8) {
+        m_error = "Not a time zone index file";
+        if (base) m_file.unmap(const_cast<uchar*>(base));
+        m_file.close();
+        return false;
+    }
+
+    // Check every section and every cross reference once, so that queries
+    // can follow them without bounds checks
+    const quint32 rows = 180 * header->cellsPerDegree;
+    const quint32 cellCount = rows * 360 * header->cellsPerDegree;
+    auto fits = [size](quint64 offset, quint64 bytes) {
+        return offset % 8 == 0 && offset + bytes <= quint64(size);
+    };
+    bool valid =
+        fits(header->zonesOffset, quint64(header->zoneCount) * sizeof(ZoneRecord)) &&
+        fits(header->transitionsOffset, quint64(header->transitionCount) * sizeof(Transition)) &&
+        fits(header->polygonsOffset, quint64(header->polygonCount) * sizeof(PolygonRecord)) &&
+        fits(header->rowRefsOffset, quint64(header->rowRefCount) * sizeof(quint32)) &&
+        fits(header->edgesOffset, quint64(header->edgeCount) * sizeof(Edge)) &&
+        fits(header->cellsOffset, quint64(cellCount) * sizeof(quint32)) &&
+        fits(header->candidatesOffset, quint64(header->candidateCount) * sizeof(quint32)) &&
+        fits(header->stringsOffset, header->stringBytes);
+
+    if (valid) {
+        const ZoneRecord* zones = reinterpret_cast<const ZoneRecord*>(base + header->zonesOffset);
+        for (quint32 i = 0; valid && i < header->zoneCount; ++i) {
+            valid = quint64(zones[i].name) + zones[i].nameLength <= header->stringBytes &&
+                    quint64(zones[i].firstTransition) + zones[i].transitionCount <= header->transitionCount;
+        }
+        const PolygonRecord* polygons = reinterpret_cast<const PolygonRecord*>(base + header->polygonsOffset);
+        const quint32* rowRefs = reinterpret_cast<const quint32*>(base + header->rowRefsOffset);
+        for (quint32 i = 0; valid && i < header->polygonCount; ++i) {
+            const PolygonRecord& polygon = polygons[i];
+            valid = polygon.zone < header->zoneCount &&
+                    quint64(polygon.firstRow) + polygon.rowCount <= rows &&
+                    quint64(polygon.rowRefs) + polygon.rowCount + 1 <= header->rowRefCount;
+            for (quint32 r = 0; valid && r < polygon.rowCount; ++r) {
+                valid = rowRefs[polygon.rowRefs + r] <= rowRefs[polygon.rowRefs + r + 1] &&
+                        rowRefs[polygon.rowRefs + r + 1] <= header->edgeCount;
+            }
+        }
+        const quint32* cells = reinterpret_cast<const quint32*>(base + header->cellsOffset);
+        const quint32* candidates = reinterpret_cast<const quint32*>(base + header->candidatesOffset);
+        for (quint32 i = 0; valid && i < cellCount; ++i) {
+            const quint32 cell = cells[i];
+            if (cell == SeaCell) continue;
+            if (cell & DirectCell) {
+                valid = (cell & ~DirectCell) < header->zoneCount;
+                continue;
+            }
+            valid = cell < header->candidateCount &&
+                    quint64(cell) + 1 + candidates[cell] <= header->candidateCount;
+            for (quint32 c = 1; valid && c <= candidates[cell]; ++c) {
+                valid = candidates[cell + c] < header->polygonCount;
+            }
+        }
+    }
+
+    if (!valid) {
+        m_error = "Time zone index file is corrupt";
+        m_file.unmap(const_cast<uchar*>(base));
+        m_file.close();
+        return false;
+    }
+
+    m_base = base;
+    m_header = header;
+    return true;
+}
+
+int TimeZoneIndex::zoneCount() const {
+    return m_header ? int(m_header->zoneCount) : 0;
+}
+
+QString TimeZoneIndex::zoneName(int zone) const {
+    if (!m_header || zone < 0 || quint32(zone) >= m_header->zoneCount) {
+        return QString();
+    }
+    const ZoneRecord& record = reinterpret_cast<const ZoneRecord*>(m_base + m_header->zonesOffset)[zone];
+    return QString::fromUtf8(reinterpret_cast<const char*>(m_base + m_header->stringsOffset + record.name),
+                             record.nameLength);
+}
+
+bool TimeZoneIndex::insidePolygon(quint32 polygon, int row, double latitude, double longitude,
+                                  double* edgeDistance) const {
+    const PolygonRecord& record =
+        reinterpret_cast<const PolygonRecord*>(m_base + m_header->polygonsOffset)[polygon];
+    if (quint32(row) < record.firstRow || quint32(row) >= record.firstRow + record.rowCount) {
+        return false;
+    }
+    const quint32* rowRefs = reinterpret_cast<const quint32*>(m_base + m_header->rowRefsOffset) +
+                             record.rowRefs + (row - record.firstRow);
+    const Edge* edges = reinterpret_cast<const Edge*>(m_base + m_header->edgesOffset);
+    return crossesOdd(edges + rowRefs[0], edges + rowRefs[1], latitude, longitude, edgeDistance);
+}
+
+int TimeZoneIndex::zoneAt(double latitude, double longitude) const {
+    if (!m_header) {
+        return -1;
+    }
+    const int cellsPerDegree = m_header->cellsPerDegree;
+    const int row = rowOf(latitude, cellsPerDegree);
+    const int column = columnOf(longitude, cellsPerDegree);
+    const quint32 cell = reinterpret_cast<const quint32*>(m_base + m_header->cellsOffset)
+        [row * 360 * cellsPerDegree + column];
+    if (cell == SeaCell) return -1;
+    if (cell & DirectCell) return int(cell & ~DirectCell);
+
+    // Boundary cell: the polygon containing the point, or failing that the
+    // one with the nearest edge, so points in the slivers that simplifying
+    // neighbouring borders leaves between them still get a zone
+    const quint32* candidates = reinterpret_cast<const quint32*>(m_base + m_header->candidatesOffset) + cell;
+    const PolygonRecord* polygons = reinterpret_cast<const PolygonRecord*>(m_base + m_header->polygonsOffset);
+    int nearestZone = -1;
+    double nearestDistance = SnapDistance;
+    for (quint32 c = 1; c <= candidates[0]; ++c) {
+        double distance = nearestDistance;
+        if (insidePolygon(candidates[c], row, latitude, longitude, &distance)) {
+            return int(polygons[candidates[c]].zone);
+        }
+        if (distance < nearestDistance) {
+            nearestDistance = distance;
+            nearestZone = int(polygons[candidates[c]].zone);
+        }
+    }
+    return nearestZone;
+}
+
+int TimeZoneIndex::offsetAt(int zone, qint64 utcSeconds, bool* dst) const {
+    if (!m_header || zone < 0 || quint32(zone) >= m_header->zoneCount) {
+        if (dst) *dst = false;
+        return 0;
+    }
+    const ZoneRecord& record = reinterpret_cast<const ZoneRecord*>(m_base + m_header->zonesOffset)[zone];
+    const Transition* begin = reinterpret_cast<const Transition*>(m_base + m_header->transitionsOffset) +
+                              record.firstTransition;
+    const Transition* end = begin + record.transitionCount;
+    const Transition* next = std::upper_bound(begin, end, utcSeconds,
+        [](qint64 seconds, const Transition& transition) { return seconds < transition.at; });
+    if (next == begin) {
+        if (dst) *dst = record.initialDst != 0;
+        return record.initialOffset;
+    }
+    if (dst) *dst = next[-1].dst != 0;
+    return next[-1].offset;
+}
+
+TimeZoneIndex::Resolution TimeZoneIndex::resolveIn(int zone, double longitude, qint64 localSeconds) const {
+    Resolution resolution;
+    if (zone < 0) {
+        resolution.utcOffset = seaOffsetHours(longitude) * 3600;
+    } else {
+        // The offsets a day either side bracket any transition near the
+        // time; an offset is consistent if it is in effect at the instant
+        // it gives
+        const int before = offsetAt(zone, localSeconds - TransitionSpan);
+        const int after = offsetAt(zone, localSeconds + TransitionSpan);
+        const bool beforeHolds = offsetAt(zone, localSeconds - before) == before;
+        const bool afterHolds = offsetAt(zone, localSeconds - after) == after;
+        if (beforeHolds && afterHolds) {
+            resolution.utcOffset = qMax(before, after);   // Repeated hour, first pass
+        } else if (afterHolds) {
+            resolution.utcOffset = after;
+        } else {
+            resolution.utcOffset = before;                // Skipped hour, moved forward
+        }
+        offsetAt(zone, localSeconds - resolution.utcOffset, &resolution.dst);
+    }
+    resolution.utc = QDateTime::fromSecsSinceEpoch(localSeconds - resolution.utcOffset, Qt::UTC);
+    return resolution;
+}
+
+TimeZoneIndex::Resolution TimeZoneIndex::resolve(double latitude, double longitude,
+                                                 const QDate& date, const QTime& time) const {
+    if (!date.isValid() || !time.isValid()) {
+        return Resolution();
+    }
+    const int zone = zoneAt(latitude, longitude);
+    const qint64 local = QDateTime(date, time, Qt::UTC).toSecsSinceEpoch();
+    Resolution resolution = resolveIn(zone, longitude, local);
+    resolution.zone = zone >= 0 ? zoneName(zone) : seaZoneName(longitude);
+    return resolution;
+}
+
+QVector<TimeZoneIndex::Resolution> TimeZoneIndex::resolve(const QVector<Query>& queries) const {
+    QVector<Resolution> resolutions(queries.size());
+    QVector<QString> names(zoneCount());
+    for (int i = 0; i < queries.size(); ++i) {
+        const Query& query = queries[i];
+        if (!query.date.isValid() || !query.time.isValid()) {
+            continue;
+        }
+        const int zone = zoneAt(query.latitude, query.longitude);
+        const qint64 local = QDateTime(query.date, query.time, Qt::UTC).toSecsSinceEpoch();
+        resolutions[i] = resolveIn(zone, query.longitude, local);
+        if (zone < 0) {
+            resolutions[i].zone = seaZoneName(query.longitude);
+        } else {
+            if (names[zone].isNull()) names[zone] = zoneName(zone);
+            resolutions[i].zone = names[zone];
+        }
+    }
+    return resolutions;
+}
+
+TimeZoneIndexBuilder::TimeZoneIndexBuilder()
+    : m_cellsPerDegree(2)
+    , m_tolerance(0.005)
+    , m_firstYear(1850)
+    , m_lastYear(2100)
+{
+}
+
+int TimeZoneIndexBuilder::zoneIndex(const QString& zone) {
+    int index = m_zones.indexOf(zone);
+    if (index < 0) {
+        index = m_zones.size();
+        m_zones.append(zone);
+    }
+    return index;
+}
+
+QStringList TimeZoneIndexBuilder::unknownZones() const {
+    QStringList unknown;
+    for (const QString& zone : m_zones) {
+        if (!QTimeZone::isTimeZoneIdAvailable(zone.toLatin1())) unknown << zone;
+    }
+    return unknown;
+}
+
+QVector<QPointF> TimeZoneIndexBuilder::simplify(const QVector<QPointF>& ring) const {
+    // Douglas-Peucker, iterative, anchored at the first point and the
+    // point farthest from it so that closed rings keep their extent
+    const int count = ring.size();
+    if (count < 4 || m_tolerance <= 0) return ring;
+
+    int far = 0;
+    double farDistance = -1;
+    for (int i = 1; i < count; ++i) {
+        const double d = std::hypot(ring[i].x() - ring[0].x(), ring[i].y() - ring[0].y());
+        if (d > farDistance) {
+            farDistance = d;
+            far = i;
+        }
+    }
+
+    QVector<bool> keep(count + 1, false);
+    keep[0] = keep[far] = keep[count] = true;
+    QVector<QPair<int, int>> spans = {{0, far}, {far, count}};
+    auto point = [&ring, count](int i) { return ring[i % count]; };
+    while (!spans.isEmpty()) {
+        const QPair<int, int> span = spans.takeLast();
+        const QPointF a = point(span.first), b = point(span.second);
+        const double dx = b.x() - a.x(), dy = b.y() - a.y();
+        const double length = std::hypot(dx, dy);
+        int worst = -1;
+        double worstDistance = m_tolerance;
+        for (int i = span.first + 1; i < span.second; ++i) {
+            const QPointF p = point(i);
+            const double d = length > 0
+                ? std::fabs(dy * (p.x() - a.x()) - dx * (p.y() - a.y())) / length
+                : std::hypot(p.x() - a.x(), p.y() - a.y());
+            if (d > worstDistance) {
+                worstDistance = d;
+                worst = i;
+            }
+        }
+        if (worst >= 0) {
+            keep[worst] = true;
+            spans.append(qMakePair(span.first, worst));
+            spans.append(qMakePair(worst, span.second));
+        }
+    }
+
+    QVector<QPointF> simplified;
+    for (int i = 0; i < count; ++i) {
+        if (keep[i]) simplified.append(ring[i]);
+    }
+    return simplified.size() >= 3 ? simplified : QVector<QPointF>();
+}
+
+void TimeZoneIndexBuilder::addPolygon(const QString& zone, const QVector<QVector<QPointF>>& rings) {
+    Polygon polygon;
+    double minX = 180, minY = 90, maxX = -180, maxY = -90;
+    for (const QVector<QPointF>& ring : rings) {
+        QVector<QPointF> open = ring;
+        if (open.size() > 1 && open.first() == open.last()) open.removeLast();
+        const QVector<QPointF> simplified = simplify(open);
+        if (simplified.isEmpty()) continue;
+        polygon.rings.append(simplified);
+        for (const QPointF& p : simplified) {
+            minX = qMin(minX, p.x());
+            minY = qMin(minY, p.y());
+            maxX = qMax(maxX, p.x());
+            maxY = qMax(maxY, p.y());
+        }
+    }
+    if (!polygon.rings.isEmpty()) {
+        polygon.zone = zoneIndex(zone);
+        polygon.bounds = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+        m_polygons.append(polygon);
+    }
+}
+
+bool TimeZoneIndexBuilder::readGeoJson(QIODevice& device, QString* error) {
+    if (!device.isOpen() && !device.open(QIODevice::ReadOnly)) {
+        if (error) *error = device.errorString();
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(device.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        if (error) *error = parseError.errorString();
+        return false;
+    }
+
+    auto toRings = [](const QJsonArray& coordinates) {
+        QVector<QVector<QPointF>> rings;
+        for (const QJsonValue& ringValue : coordinates) {
+            QVector<QPointF> ring;
+            for (const QJsonValue& pointValue : ringValue.toArray()) {
+                const QJsonArray point = pointValue.toArray();
+                ring.append(QPointF(point.at(0).toDouble(), point.at(1).toDouble()));
+            }
+            rings.append(ring);
+        }
+        return rings;
+    };
+
+    for (const QJsonValue& featureValue : doc.object()["features"].toArray()) {
+        const QJsonObject feature = featureValue.toObject();
+        const QString zone = feature["properties"].toObject()["tzid"].toString();
+        const QJsonObject geometry = feature["geometry"].toObject();
+        const QString type = geometry["type"].toString();
+        const QJsonArray coordinates = geometry["coordinates"].toArray();
+        if (zone.isEmpty()) continue;
+        if (type == "Polygon") {
+            addPolygon(zone, toRings(coordinates));
+        } else if (type == "MultiPolygon") {
+            for (const QJsonValue& polygon : coordinates) {
+                addPolygon(zone, toRings(polygon.toArray()));
+            }
+        }
+    }
+    return true;
+}
+
+bool TimeZoneIndexBuilder::write(const QString& filePath, QString* error) const {
+    using Edge = TimeZoneIndex::Edge;
+    const int cellsPerDegree = m_cellsPerDegree;
+    const int rows = 180 * cellsPerDegree;
+    const int columns = 360 * cellsPerDegree;
+
+    // Edges bucketed by row per polygon, and the polygons crossing each cell
+    QVector<TimeZoneIndex::PolygonRecord> polygons;
+    QVector<quint32> rowRefs;
+    QVector<Edge> edges;
+    QVector<QVector<quint32>> cellPolygons(rows * columns);
+    for (int p = 0; p < m_polygons.size(); ++p) {
+        const Polygon& polygon = m_polygons[p];
+        const int firstRow = rowOf(polygon.bounds.top(), cellsPerDegree);
+        const int lastRow = rowOf(polygon.bounds.bottom(), cellsPerDegree);
+        QVector<QVector<Edge>> rowEdges(lastRow - firstRow + 1);
+        for (const QVector<QPointF>& ring : polygon.rings) {
+            for (int i = 0; i < ring.size(); ++i) {
+                const QPointF& a = ring[i];
+                const QPointF& b = ring[(i + 1) % ring.size()];
+                const Edge edge = {float(a.x()), float(a.y()), float(b.x()), float(b.y())};
+                const int r0 = rowOf(qMin(edge.y1, edge.y2), cellsPerDegree);
+                const int r1 = rowOf(qMax(edge.y1, edge.y2), cellsPerDegree);
+                const int c0 = columnOf(qMin(edge.x1, edge.x2), cellsPerDegree);
+                const int c1 = columnOf(qMax(edge.x1, edge.x2), cellsPerDegree);
+                for (int r = r0; r <= r1; ++r) {
+                    rowEdges[r - firstRow].append(edge);
+                    for (int c = c0; c <= c1; ++c) {
+                        QVector<quint32>& list = cellPolygons[r * columns + c];
+                        if (list.isEmpty() || list.last() != quint32(p)) list.append(p);
+                    }
+                }
+            }
+        }
+
+        TimeZoneIndex::PolygonRecord record;
+        record.zone = polygon.zone;
+        record.firstRow = firstRow;
+        record.rowCount = rowEdges.size();
+        record.rowRefs = rowRefs.size();
+        for (const QVector<Edge>& row : rowEdges) {
+            rowRefs.append(edges.size());
+            edges += row;
+        }
+        rowRefs.append(edges.size());
+        polygons.append(record);
+    }
+
+    // Cells no border crosses lie wholly in one zone or at sea; their
+    // centre decides which
+    QVector<int> cellZones(rows * columns, -1);
+    for (int p = 0; p < polygons.size(); ++p) {
+        const TimeZoneIndex::PolygonRecord& record = polygons[p];
+        const QRectF& bounds = m_polygons[p].bounds;
+        const int c0 = columnOf(bounds.left(), cellsPerDegree);
+        const int c1 = columnOf(bounds.right(), cellsPerDegree);
+        for (quint32 r = record.firstRow; r < record.firstRow + record.rowCount; ++r) {
+            const double latitude = (r + 0.5) / cellsPerDegree - 90.0;
+            const Edge* begin = edges.constData() + rowRefs[record.rowRefs + r - record.firstRow];
+            const Edge* end = edges.constData() + rowRefs[record.rowRefs + r - record.firstRow + 1];
+            for (int c = c0; c <= c1; ++c) {
+                const int cell = r * columns + c;
+                if (!cellPolygons[cell].isEmpty() || cellZones[cell] >= 0) continue;
+                const double longitude = (c + 0.5) / cellsPerDegree - 180.0;
+                if (crossesOdd(begin, end, latitude, longitude, nullptr)) {
+                    cellZones[cell] = record.zone;
+                }
+            }
+        }
+    }
+
+    QVector<quint32> cells(rows * columns);
+    QVector<quint32> candidates;
+    for (int cell = 0; cell < cells.size(); ++cell) {
+        const QVector<quint32>& list = cellPolygons[cell];
+        if (!list.isEmpty()) {
+            cells[cell] = candidates.size();
+            candidates.append(list.size());
+            candidates += list;
+        } else {
+            cells[cell] = cellZones[cell] >= 0 ? (DirectCell | quint32(cellZones[cell])) : SeaCell;
+        }
+    }
+    if (quint32(candidates.size()) >= DirectCell) {
+        if (error) *error = "Too many boundary cells";
+        return false;
+    }
+
+    // Offset transitions from the tz database
+    QByteArray strings;
+    QVector<TimeZoneIndex::ZoneRecord> zones;
+    QVector<TimeZoneIndex::Transition> transitions;
+    const QDateTime from(QDate(m_firstYear, 1, 1), QTime(0, 0), Qt::UTC);
+    const QDateTime to(QDate(m_lastYear + 1, 1, 1), QTime(0, 0), Qt::UTC);
+    for (const QString& zone : m_zones) {
+        const QByteArray name = zone.toUtf8();
+        TimeZoneIndex::ZoneRecord record;
+        record.name = strings.size();
+        record.nameLength = name.size();
+        record.firstTransition = transitions.size();
+        record.initialOffset = 0;
+        record.initialDst = 0;
+        strings += name;
+
+        const QTimeZone timeZone(zone.toLatin1());
+        if (timeZone.isValid()) {
+            record.initialOffset = timeZone.offsetFromUtc(from);
+            record.initialDst = timeZone.isDaylightTime(from) ? 1 : 0;
+            for (const QTimeZone::OffsetData& data : timeZone.transitions(from, to)) {
+                TimeZoneIndex::Transition transition;
+                transition.at = data.atUtc.toSecsSinceEpoch();
+                transition.offset = data.offsetFromUtc;
+                transition.dst = data.daylightTimeOffset != 0 ? 1 : 0;
+                transitions.append(transition);
+            }
+        }
+        record.transitionCount = transitions.size() - record.firstTransition;
+        zones.append(record);
+    }
+
+    TimeZoneIndex::Header header;
+    header.magic = TimeZoneMagic;
+    header.version = TimeZoneVersion;
+    header.cellsPerDegree = cellsPerDegree;
+    header.zoneCount = zones.size();
+    header.transitionCount = transitions.size();
+    header.polygonCount = polygons.size();
+    header.rowRefCount = rowRefs.size();
+    header.edgeCount = edges.size();
+    header.candidateCount = candidates.size();
+    header.stringBytes = strings.size();
+    header.zonesOffset = align8(sizeof(TimeZoneIndex::Header));
+    header.transitionsOffset = align8(header.zonesOffset + zones.size() * sizeof(TimeZoneIndex::ZoneRecord));
+    header.polygonsOffset = align8(header.transitionsOffset + transitions.size() * sizeof(TimeZoneIndex::Transition));
+    header.rowRefsOffset = align8(header.polygonsOffset + polygons.size() * sizeof(TimeZoneIndex::PolygonRecord));
+    header.edgesOffset = align8(header.rowRefsOffset + rowRefs.size() * sizeof(quint32));
+    header.cellsOffset = align8(header.edgesOffset + edges.size() * sizeof(Edge));
+    header.candidatesOffset = align8(header.cellsOffset + cells.size() * sizeof(quint32));
+    header.stringsOffset = align8(header.candidatesOffset + candidates.size() * sizeof(quint32));
+    header.fileSize = header.stringsOffset + strings.size();
+    header.reserved = 0;
+
+    QByteArray image(header.fileSize, '\0');
+    auto put = [&image](quint32 offset, const void* data, int bytes) {
+        if (bytes > 0) memcpy(image.data() + offset, data, bytes);
+    };
+    put(0, &header, sizeof(TimeZoneIndex::Header));
+    put(header.zonesOffset, zones.constData(), zones.size() * sizeof(TimeZoneIndex::ZoneRecord));
+    put(header.transitionsOffset, transitions.constData(), transitions.size() * sizeof(TimeZoneIndex::Transition));
+    put(header.polygonsOffset, polygons.constData(), polygons.size() * sizeof(TimeZoneIndex::PolygonRecord));
+    put(header.rowRefsOffset, rowRefs.constData(), rowRefs.size() * sizeof(quint32));
+    put(header.edgesOffset, edges.constData(), edges.size() * sizeof(Edge));
+    put(header.cellsOffset, cells.constData(), cells.size() * sizeof(quint32));
+    put(header.candidatesOffset, candidates.constData(), candidates.size() * sizeof(quint32));
+    put(header.stringsOffset, strings.constData(), strings.size());
+
+    // Written whole and renamed into place, so readers never map a partial file
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(image) != image.size() || !file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,126 @@
+#ifndef TIMEZONEINDEX_H
+#define TIMEZONEINDEX_H
+
+#include <QByteArray>
+#include <QDate>
+#include <QDateTime>
+#include <QFile>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QStringList>
+#include <QTime>
+#include <QVector>
+
+class QIODevice;
+
+// Offline time zone lookup. The index file holds simplified zone boundary
+// polygons behind a uniform grid: a cell inside a single zone maps straight
+// to it, and a boundary cell lists the few polygons crossing it, whose
+// edges are bucketed by grid row so a point-in-polygon test only looks at
+// edges in the point's latitude band. Each zone carries its UTC offset
+// transitions, compiled from the tz database when the file was built. The
+// file is memory-mapped, and all queries are const and thread-safe.
+class TimeZoneIndex {
+public:
+    struct Resolution {
+        QString zone;        // IANA zone id; Etc/GMT+N at sea
+        int utcOffset;       // Seconds east of UTC
+        bool dst;
+        QDateTime utc;
+
+        Resolution() : utcOffset(0), dst(false) {}
+        bool isValid() const { return utc.isValid(); }
+    };
+
+    // A wall clock time at a place, as entered for a birth
+    struct Query {
+        double latitude;
+        double longitude;
+        QDate date;
+        QTime time;
+    };
+
+    TimeZoneIndex();
+    ~TimeZoneIndex();
+
+    bool open(const QString& filePath);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+    QString errorString() const { return m_error; }
+
+    int zoneCount() const;
+    QString zoneName(int zone) const;
+
+    // Zone containing the point, or -1 at sea
+    int zoneAt(double latitude, double longitude) const;
+    // Offset in effect at a UTC instant, in seconds since the epoch
+    int offsetAt(int zone, qint64 utcSeconds, bool* dst = nullptr) const;
+
+    // Wall clock time at the point to UTC. A time skipped by a forward
+    // transition is moved forward by the gap; a repeated time resolves to
+    // its first occurrence.
+    Resolution resolve(double latitude, double longitude, const QDate& date, const QTime& time) const;
+    // Same for many places, e.g. an import; zone names are decoded once
+    QVector<Resolution> resolve(const QVector<Query>& queries) const;
+
+private:
+    struct Header;
+    struct ZoneRecord;
+    struct Transition;
+    struct PolygonRecord;
+    struct Edge;
+
+    bool insidePolygon(quint32 polygon, int row, double latitude, double longitude,
+                       double* edgeDistance) const;
+    Resolution resolveIn(int zone, double longitude, qint64 localSeconds) const;
+
+    QFile m_file;
+    const uchar* m_base;
+    const Header* m_header;
+    QString m_error;
+
+    friend class TimeZoneIndexBuilder;
+};
+
+// Builds a time zone index from zone boundaries in GeoJSON, as published by
+// timezone-boundary-builder (https://github.com/evansiroky/timezone-boundary-builder),
+// and from the tz database the Qt installation is using
+class TimeZoneIndexBuilder {
+public:
+    TimeZoneIndexBuilder();
+
+    void setCellsPerDegree(int cells) { m_cellsPerDegree = qBound(1, cells, 8); }
+    // Douglas-Peucker tolerance for the boundaries, in degrees
+    void setSimplifyTolerance(double degrees) { m_tolerance = degrees; }
+    // Years whose transitions are compiled
+    void setTransitionYears(int first, int last) { m_firstYear = first; m_lastYear = last; }
+
+    // FeatureCollection of Polygon and MultiPolygon features with a tzid property
+    bool readGeoJson(QIODevice& device, QString* error = nullptr);
+    void addPolygon(const QString& zone, const QVector<QVector<QPointF>>& rings);
+
+    int polygonCount() const { return m_polygons.size(); }
+    // Zones the tz database did not know; they are written with offset 0
+    QStringList unknownZones() const;
+    bool write(const QString& filePath, QString* error = nullptr) const;
+
+private:
+    struct Polygon {
+        int zone;
+        QVector<QVector<QPointF>> rings;
+        QRectF bounds;
+    };
+
+    QVector<QPointF> simplify(const QVector<QPointF>& ring) const;
+    int zoneIndex(const QString& zone);
+
+    QVector<Polygon> m_polygons;
+    QStringList m_zones;
+    int m_cellsPerDegree;
+    double m_tolerance;
+    int m_firstYear;
+    int m_lastYear;
+};
+
+#endif // TIMEZONEINDEX_H
@@ -0,0 +1,383 @@
+#include "chartcomputer.h"
+#include "siderealephemeris.h"
+#include <QJsonArray>
+#include <QtMath>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+QDateTime parseTime(const QJsonValue& value) {
+    QDateTime time = QDateTime::fromString(value.toString(), Qt::ISODateWithMs);
+    if (time.isValid() && time.timeSpec() == Qt::LocalTime) {
+        time.setTimeSpec(Qt::UTC);
+    }
+    return time;
+}
+
+QJsonObject periodJson(const DashaPeriod& period) {
+    QJsonObject json;
+    json["planet"] = period.planet;
+    json["start"] = period.startTime.toUTC().toString(Qt::ISODate);
+    json["end"] = period.endTime.toUTC().toString(Qt::ISODate);
+    return json;
+}
+
+ChartComputer::Reply failure(int status, const QString& message) {
+    QJsonObject body;
+    body["error"] = message;
+    return {status, body};
+}
+
+} // namespace
+
+ChartQuery::ChartQuery()
+    : kind(Chart)
+    , latitude(0)
+    , longitude(0)
+    , ascendant(std::numeric_limits<double>::quiet_NaN())
+    , days(365)
+    , yogas(0)
+    , utcOffsetHours(0) {
+}
+
+bool ChartQuery::needsEphemeris() const {
+    if (kind == Dasha) return !positions.contains("Moon");
+    return positions.size() < Astro::PlanetCount;
+}
+
+bool ChartQuery::fromJson(Kind kind, const QJsonObject& json, ChartQuery* query,
+                          QString* error) {
+    ChartQuery result;
+    result.kind = kind;
+    result.time = parseTime(json["time"]);
+    if (!result.time.isValid()) {
+        *error = "\"time\" must be an ISO 8601 date and time";
+        return false;
+    }
+    result.latitude = json["latitude"].toDouble();
+    result.longitude = json["longitude"].toDouble();
+    if (qAbs(result.latitude) > 90.0 || qAbs(result.longitude) > 180.0) {
+        *error = "\"latitude\" or \"longitude\" is out of range";
+        return false;
+    }
+
+    const QJsonObject positions = json["positions"].toObject();
+    for (auto it = positions.constBegin(); it != positions.constEnd(); ++it) {
+        if (Astro::planetIndex(it.key()) < 0 || !it.value().isDouble()) {
+            *error = QString("\"positions\" has an unknown planet or a non-numeric longitude: %1")
+                         .arg(it.key());
+            return false;
+        }
+        result.positions[it.key()] = Astro::normalizeDegrees(it.value().toDouble());
+    }
+    if (json["ascendant"].isDouble()) {
+        result.ascendant = Astro::normalizeDegrees(json["ascendant"].toDouble());
+    }
+
+    if (kind == Dasha || kind == Transits) {
+        result.at = json.contains("at") ? parseTime(json["at"]) : QDateTime::currentDateTimeUtc();
+        if (!result.at.isValid()) {
+            *error = "\"at\" must be an ISO 8601 date and time";
+            return false;
+        }
+    }
+
+    if (kind == Transits) {
+        result.days = json["days"].toInt(365);
+        if (result.days < 1 || result.days > MAX_TRANSIT_DAYS) {
+            *error = QString("\"days\" must be from 1 to %1").arg(MAX_TRANSIT_DAYS);
+            return false;
+        }
+    }
+
+    if (kind == Electional) {
+        result.end = parseTime(json["end"]);
+        if (!result.end.isValid() || result.end <= result.time) {
+            *error = "\"end\" must be an ISO 8601 date and time after \"time\"";
+            return false;
+        }
+        if (result.time.secsTo(result.end) > MAX_ELECTIONAL_DAYS * 86400LL) {
+            *error = QString("The range may span at most %1 days").arg(MAX_ELECTIONAL_DAYS);
+            return false;
+        }
+
+        QStringList names;
+        for (const QJsonValue& name : json["yogas"].toArray()) {
+            names.append(name.toString());
+        }
+        names.removeDuplicates();
+        result.yogas = ElectionalSearch::yogaMask(names);
+        if (qPopulationCount(result.yogas) != names.size()) {
+            *error = "\"yogas\" has an unknown yoga name";
+            return false;
+        }
+
+        const QJsonObject strengths = json["strengths"].toObject();
+        for (auto it = strengths.constBegin(); it != strengths.constEnd(); ++it) {
+            const int planet = Astro::planetIndex(it.key());
+            if (planet < 0 || planet >= Astro::SevenPlanets || !it.value().isDouble()) {
+                *error = QString("\"strengths\" needs one of the seven planets and a minimum ratio: %1")
+                             .arg(it.key());
+                return false;
+            }
+            result.strengths.append({planet, it.value().toDouble()});
+        }
+        result.utcOffsetHours = json["utcOffset"].isDouble()
+            ? json["utcOffset"].toDouble() : result.time.offsetFromUtc() / 3600.0;
+    }
+    *query = result;
+    return true;
+}
+
+ChartComputer::ChartComputer()
+    : m_cachedInstant(0)
+    , m_cachedPlanets(0)
+    , m_cachedSpeeds(0)
+    , m_ephemerisCalls(0) {
+}
+
+void ChartComputer::useInstant(const QDateTime& time) {
+    const qint64 instant = time.toMSecsSinceEpoch();
+    if (instant != m_cachedInstant) {
+        m_cachedInstant = instant;
+        m_cachedPlanets = 0;
+        m_cachedSpeeds = 0;
+    }
+}
+
+bool ChartComputer::longitudeAt(const QDateTime& time, int planet, double* longitude,
+                                QString* error) {
+    useInstant(time);
+    const int body = planet == Astro::Ketu ? Astro::Rahu : planet;
+    if (!(m_cachedPlanets & (1u << body))) {
+        ++m_ephemerisCalls;
+        if (!SiderealEphemeris::longitude(SiderealEphemeris::julianDay(time), body,
+                                          &m_cached[body], error)) {
+            return false;
+        }
+        m_cachedPlanets |= 1u << body;
+    }
+    *longitude = planet == Astro::Ketu
+        ? Astro::normalizeDegrees(m_cached[Astro::Rahu] + 180.0) : m_cached[body];
+    return true;
+}
+
+bool ChartComputer::speedAt(const QDateTime& time, int planet, double* speed, QString* error) {
+    useInstant(time);
+    const int body = planet == Astro::Ketu ? Astro::Rahu : planet;
+    if (!(m_cachedSpeeds & (1u << body))) {
+        m_ephemerisCalls += 2;
+        if (!SiderealEphemeris::speed(SiderealEphemeris::julianDay(time), body,
+                                      &m_cachedSpeed[body], error)) {
+            return false;
+        }
+        m_cachedSpeeds |= 1u << body;
+    }
+    *speed = m_cachedSpeed[body];
+    return true;
+}
+
+QMap<QString, double> ChartComputer::chartPositions(const ChartQuery& query,
+                                                    QMap<QString, double>* speeds,
+                                                    QString* error) {
+    QMap<QString, double> positions = query.positions;
+    for (int p = 0; p < Astro::PlanetCount && query.needsEphemeris(); ++p) {
+        const QString name = Astro::planetName(p);
+        if (positions.contains(name)) continue;
+        double longitude;
+        if (!longitudeAt(query.time, p, &longitude, error)) {
+            return QMap<QString, double>();
+        }
+        positions[name] = longitude;
+        // Only the seven planets have Cheshta Bala
+        if (p < Astro::SevenPlanets) {
+            double speed;
+            if (!speedAt(query.time, p, &speed, error)) {
+                return QMap<QString, double>();
+            }
+            (*speeds)[name] = speed;
+        }
+    }
+    return positions;
+}
+
+ChartComputer::Reply ChartComputer::electional(const ChartQuery& query) {
+    // The search asks for each instant once, so it reads the ephemeris
+    // directly rather than through the instant cache
+    QString error;
+    ElectionalSearch search([&](int body, double julianDay) {
+        if (body == ElectionalSearch::Ascendant) {
+            return SiderealEphemeris::ascendant(julianDay, query.latitude, query.longitude);
+        }
+        double longitude = 0.0;
+        if (error.isEmpty()) {
+            SiderealEphemeris::longitude(julianDay, body, &longitude, &error);
+        }
+        return longitude;
+    });
+
+    ElectionalSearch::Query range;
+    range.startDay = SiderealEphemeris::julianDay(query.time);
+    range.endDay = SiderealEphemeris::julianDay(query.end);
+    range.yogas = query.yogas;
+    range.strengths = query.strengths;
+    range.utcOffsetHours = query.utcOffsetHours;
+    const QVector<ElectionalSearch::Window> windows = search.search(range);
+    m_ephemerisCalls += search.stats().ephemerisCalls;
+    if (!error.isEmpty()) {
+        return failure(422, error);
+    }
+
+    QJsonArray found;
+    for (const ElectionalSearch::Window& window : windows) {
+        QJsonObject json;
+        json["start"] = ElectionalSearch::fromJulianDay(window.startDay).toString(Qt::ISODate);
+        json["end"] = ElectionalSearch::fromJulianDay(window.endDay).toString(Qt::ISODate);
+        json["peak"] = ElectionalSearch::fromJulianDay(window.peakDay).toString(Qt::ISODate);
+        json["peakScore"] = window.peakScore;
+        found.append(json);
+    }
+    QJsonObject body;
+    body["windows"] = found;
+    return {200, body};
+}
+
+ChartComputer::Reply ChartComputer::compute(const ChartQuery& query) {
+    if (query.kind == ChartQuery::Electional) {
+        return electional(query);
+    }
+    if (query.kind == ChartQuery::Dasha) {
+        double moon = query.positions.value("Moon");
+        QString error;
+        if (!query.positions.contains("Moon") && !longitudeAt(query.time, Astro::Moon, &moon, &error)) {
+            return failure(422, error);
+        }
+        QJsonObject body;
+        body["moon"] = moon;
+        body["at"] = query.at.toUTC().toString(Qt::ISODate);
+        const QVector<DashaPeriod> periods =
+            m_dashaCalculator.calculateVimshottariDasha(query.time, moon);
+        for (const DashaPeriod& period : periods) {
+            if (query.at < period.startTime || query.at >= period.endTime) continue;
+            body["mahadasha"] = periodJson(period);
+            for (const DashaPeriod& antardasha : period.antarDashas) {
+                if (query.at >= antardasha.startTime && query.at < antardasha.endTime) {
+                    body["antardasha"] = periodJson(antardasha);
+                    break;
+                }
+            }
+            break;
+        }
+        if (!body.contains("mahadasha")) {
+            return failure(422, "\"at\" is outside the 120 years of the Vimshottari cycle");
+        }
+        return {200, body};
+    }
+
+    QString error;
+    QMap<QString, double> speeds;
+    const QMap<QString, double> positions = chartPositions(query, &speeds, &error);
+    if (positions.isEmpty()) {
+        return failure(422, error);
+    }
+    const double day = SiderealEphemeris::julianDay(query.time);
+    const double ascendant = std::isnan(query.ascendant)
+        ? SiderealEphemeris::ascendant(day, query.latitude, query.longitude) : query.ascendant;
+    QVector<double> houses;
+    for (int h = 0; h < 12; ++h) {
+        houses.append(Astro::normalizeDegrees(ascendant + h * 30.0));
+    }
+
+    if (query.kind == ChartQuery::Transits) {
+        // One instant a day, at the hour of 'at'
+        const AshtakavargaCalculator::Ashtakavarga natal =
+            m_ashtakavargaCalculator.calculate(positions, ascendant);
+        const QVector<AshtakavargaCalculator::TransitDay> days =
+            AshtakavargaCalculator::transitDays([&](int planet, double julianDay) {
+                double longitude = 0.0;
+                ++m_ephemerisCalls;
+                if (error.isEmpty()) {
+                    SiderealEphemeris::longitude(julianDay, planet, &longitude, &error);
+                }
+                return longitude;
+            }, SiderealEphemeris::julianDay(query.at), query.days);
+        if (!error.isEmpty()) {
+            return failure(422, error);
+        }
+        const QVector<AshtakavargaCalculator::TransitScore> scores =
+            m_ashtakavargaCalculator.scoreTransits(natal, days);
+
+        QJsonArray transits;
+        for (int d = 0; d < scores.size(); ++d) {
+            QJsonArray bindus;
+            QJsonArray favourable;
+            for (int p = 0; p < Astro::SevenPlanets; ++p) {
+                bindus.append(scores[d].bindus[p]);
+                if ((scores[d].favourable >> p) & 1u) favourable.append(Astro::planetName(p));
+            }
+            QJsonObject json;
+            json["date"] = query.at.addDays(d).toUTC().toString(Qt::ISODate);
+            json["bindus"] = bindus;
+            json["total"] = scores[d].total;
+            json["favourable"] = favourable;
+            transits.append(json);
+        }
+        QJsonObject body;
+        body["days"] = transits;
+        return {200, body};
+    }
+
+    AspectMatrix aspects;
+    aspects.build(positions, houses);
+    const VargaCalculator::VargaMatrix vargas = m_vargaCalculator.calculate(positions, ascendant);
+    const QMap<QString, StrengthCalculator::PlanetaryStrength> strengths =
+        m_strengthCalculator.calculateAllStrengths(positions, houses, query.time,
+                                                   speeds, &aspects, &vargas);
+    const QVector<YogaCalculator::Yoga> yogas =
+        m_yogaCalculator.detectActiveYogas(positions, houses, strengths, &aspects, &vargas);
+
+    QJsonObject body;
+    if (query.kind == ChartQuery::Yogas) {
+        QJsonArray active;
+        for (const YogaCalculator::Yoga& yoga : yogas) {
+            QJsonObject json;
+            json["name"] = yoga.name;
+            json["strength"] = yoga.strength;
+            json["planets"] = QJsonArray::fromStringList(yoga.planets());
+            json["conditions"] = QJsonArray::fromStringList(yoga.conditions);
+            active.append(json);
+        }
+        body["yogas"] = active;
+        return {200, body};
+    }
+
+    QJsonObject longitudes;
+    for (auto it = positions.constBegin(); it != positions.constEnd(); ++it) {
+        longitudes[it.key()] = it.value();
+    }
+    QJsonArray cusps;
+    for (double cusp : houses) {
+        cusps.append(cusp);
+    }
+    QJsonObject shadbala;
+    for (auto it = strengths.constBegin(); it != strengths.constEnd(); ++it) {
+        QJsonObject json;
+        json["shadbala"] = it.value().shadbala;
+        json["rupas"] = it.value().rupas;
+        json["ratio"] = it.value().ratio();
+        json["motionKnown"] = it.value().motionKnown;
+        shadbala[it.key()] = json;
+    }
+    QJsonArray yogaNames;
+    for (const YogaCalculator::Yoga& yoga : yogas) {
+        yogaNames.append(yoga.name);
+    }
+    body["julianDay"] = day;
+    body["ascendant"] = ascendant;
+    body["positions"] = longitudes;
+    body["houses"] = cusps;
+    body["strengths"] = shadbala;
+    body["yogas"] = yogaNames;
+    return {200, body};
+}
@@ -0,0 +1,97 @@
+#ifndef CHARTCOMPUTER_H
+#define CHARTCOMPUTER_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include "Calculators/ashtakavargacalculator.h"
+#include "Calculators/dashacalculator.h"
+#include "Calculators/electionalsearch.h"
+#include "Calculators/planetdata.h"
+#include "Calculators/strengthcalculator.h"
+#include "Calculators/vargacalculator.h"
+#include "Calculators/yogacalculator.h"
+
+// One request to the chart service, parsed on the network thread and
+// computed on a worker. Times without a UTC offset are taken as UTC.
+struct ChartQuery {
+    enum Kind {
+        Chart,      // Positions, houses, strengths and active yoga names
+        Dasha,      // Mahadasha and antardasha running at an instant
+        Yogas,      // Active yogas with strength and participants
+        Electional, // Windows in which yogas hold and planets are strong
+        Transits    // Natal Ashtakavarga bindus met by each day's transits
+    };
+
+    Kind kind;
+    QDateTime time;                     // Birth instant
+    double latitude;
+    double longitude;
+    QMap<QString, double> positions;    // Sidereal; replace the ephemeris's
+    double ascendant;                   // Sidereal; NaN to compute it
+    QDateTime at;                       // Dasha instant or first transit day; defaults to now
+    int days;                           // Transits only; one per day from 'at'
+    QDateTime end;                      // Electional only; 'time' starts the range
+    quint64 yogas;                      // Electional only; all required
+    QVector<ElectionalSearch::StrengthCondition> strengths;    // Electional only
+    double utcOffsetHours;              // Electional only; civil time at the place
+
+    ChartQuery();
+
+    // Queries for one instant share their ephemeris positions
+    qint64 instantKey() const { return time.toMSecsSinceEpoch(); }
+    bool needsEphemeris() const;
+
+    static bool fromJson(Kind kind, const QJsonObject& json, ChartQuery* query,
+                         QString* error);
+
+    // Longest electional range a worker searches in one query
+    static constexpr int MAX_ELECTIONAL_DAYS = 31;
+    static constexpr int MAX_TRANSIT_DAYS = 3660;
+};
+
+// The calculators and position cache of one service worker; each worker
+// thread owns one. The Swiss Ephemeris underneath is process-global, and
+// SiderealEphemeris serializes the workers' calls into it.
+class ChartComputer {
+public:
+    struct Reply {
+        int status;             // HTTP status
+        QJsonObject body;
+    };
+
+    ChartComputer();
+
+    Reply compute(const ChartQuery& query);
+
+    // Sidereal longitude of an Astro::Planet. Bodies are kept for the last
+    // instant, so a batch of queries for one instant asks the ephemeris
+    // once per body.
+    bool longitudeAt(const QDateTime& time, int planet, double* longitude, QString* error);
+    // Daily motion of an Astro::Planet, kept for the last instant the same way
+    bool speedAt(const QDateTime& time, int planet, double* speed, QString* error);
+    int ephemerisCalls() const { return m_ephemerisCalls; }
+
+private:
+    // Speeds are filled for the bodies taken from the ephemeris only
+    QMap<QString, double> chartPositions(const ChartQuery& query, QMap<QString, double>* speeds,
+                                         QString* error);
+    void useInstant(const QDateTime& time);
+    Reply electional(const ChartQuery& query);
+
+    qint64 m_cachedInstant;     // Milliseconds since the epoch
+    quint32 m_cachedPlanets;    // Bit per planet of m_cached
+    quint32 m_cachedSpeeds;     // Bit per planet of m_cachedSpeed
+    double m_cached[Astro::PlanetCount];
+    double m_cachedSpeed[Astro::PlanetCount];
+    int m_ephemerisCalls;
+
+    DashaCalculator m_dashaCalculator;
+    StrengthCalculator m_strengthCalculator;
+    YogaCalculator m_yogaCalculator;
+    AshtakavargaCalculator m_ashtakavargaCalculator;
+    VargaCalculator m_vargaCalculator;
+};
+
+#endif // CHARTCOMPUTER_H
@@ -0,0 +1,58 @@
+#include "chartjobqueue.h"
+#include <QMutexLocker>
+
+ChartJobQueue::ChartJobQueue(int capacity)
+    : m_size(0)
+    , m_capacity(qMax(1, capacity))
+    , m_stopped(false) {
+}
+
+bool ChartJobQueue::push(const ChartJob& job) {
+    QMutexLocker locker(&m_mutex);
+    if (m_stopped || m_size >= m_capacity) {
+        return false;
+    }
+
+    const qint64 instant = job.query.instantKey();
+    auto open = m_open.find(instant);
+    if (open != m_open.end() && open.value()->jobs.size() < MAX_BATCH) {
+        open.value()->jobs.append(job);
+    } else {
+        m_batches.push_back({instant, {job}});
+        m_open[instant] = std::prev(m_batches.end());
+        m_ready.wakeOne();
+    }
+    ++m_size;
+    return true;
+}
+
+bool ChartJobQueue::pop(QVector<ChartJob>* batch) {
+    QMutexLocker locker(&m_mutex);
+    while (m_batches.empty() && !m_stopped) {
+        m_ready.wait(&m_mutex);
+    }
+    if (m_stopped) {
+        return false;
+    }
+
+    Batch& front = m_batches.front();
+    auto open = m_open.find(front.instant);
+    if (open != m_open.end() && open.value() == m_batches.begin()) {
+        m_open.erase(open);
+    }
+    *batch = std::move(front.jobs);
+    m_batches.pop_front();
+    m_size -= batch->size();
+    return true;
+}
+
+void ChartJobQueue::stop() {
+    QMutexLocker locker(&m_mutex);
+    m_stopped = true;
+    m_ready.wakeAll();
+}
+
+int ChartJobQueue::size() const {
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
@@ -0,0 +1,50 @@
+#ifndef CHARTJOBQUEUE_H
+#define CHARTJOBQUEUE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+#include <list>
+#include "chartcomputer.h"
+
+struct ChartJob {
+    quint64 id;
+    ChartQuery query;
+};
+
+// Bounded queue between the network thread and the workers. Jobs for an
+// instant that is already waiting join its batch, so a worker takes all the
+// queries for one instant together and computes their positions once.
+// push() fails instead of blocking when the queue is full; the service
+// turns that into a 503.
+class ChartJobQueue {
+public:
+    explicit ChartJobQueue(int capacity);
+
+    bool push(const ChartJob& job);
+    // Blocks for the oldest batch; false once stop() was called
+    bool pop(QVector<ChartJob>* batch);
+    void stop();
+
+    int size() const;
+    int capacity() const { return m_capacity; }
+
+    static const int MAX_BATCH = 64;
+
+private:
+    struct Batch {
+        qint64 instant;
+        QVector<ChartJob> jobs;
+    };
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_ready;
+    std::list<Batch> m_batches;                             // Oldest first
+    QHash<qint64, std::list<Batch>::iterator> m_open;       // Batches still taking jobs
+    int m_size;
+    int m_capacity;
+    bool m_stopped;
+};
+
+#endif // CHARTJOBQUEUE_H
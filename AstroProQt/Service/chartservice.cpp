@@ -0,0 +1,395 @@
+#include "chartservice.h"
+#include "siderealephemeris.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QRunnable>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <exception>
+
+struct ChartService::Connection {
+    quint64 id;
+    QTcpSocket* socket;
+    QTimer* idleTimer;
+    QByteArray buffer;      // Received, not yet parsed
+    bool busy;              // A request is being computed
+    bool keepAlive;
+    int route;              // ServiceMetrics::Route of the current request
+    qint64 started;         // Service clock when the request was complete
+};
+
+// Takes batches off the queue until it stops, with calculators and a
+// position cache of its own for its whole life
+class ServiceWorker : public QRunnable {
+public:
+    explicit ServiceWorker(ChartService* service) : m_service(service) {}
+
+    void run() override {
+        ChartComputer computer;
+        QVector<ChartJob> batch;
+        while (m_service->m_queue.pop(&batch)) {
+            QVector<ChartService::Completed> completed;
+            completed.reserve(batch.size());
+            for (const ChartJob& job : batch) {
+                ChartComputer::Reply reply;
+                try {
+                    reply = computer.compute(job.query);
+                } catch (const std::exception& e) {
+                    reply.status = 500;
+                    reply.body = QJsonObject();
+                    reply.body["error"] = QString::fromLocal8Bit(e.what());
+                }
+                completed.append({job.id, reply.status,
+                                  QJsonDocument(reply.body).toJson(QJsonDocument::Compact)});
+            }
+
+            ChartService* service = m_service;
+            const int size = batch.size();
+            QMetaObject::invokeMethod(service, [service, completed, size]() {
+                service->deliver(completed, size);
+            }, Qt::QueuedConnection);
+        }
+    }
+
+private:
+    ChartService* m_service;
+};
+
+namespace {
+
+QByteArray reasonPhrase(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 422: return "Unprocessable Entity";
+    case 431: return "Request Header Fields Too Large";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    case 505: return "HTTP Version Not Supported";
+    default:  return "Internal Server Error";
+    }
+}
+
+QByteArray errorBody(const QString& message) {
+    QJsonObject body;
+    body["error"] = message;
+    return QJsonDocument(body).toJson(QJsonDocument::Compact);
+}
+
+} // namespace
+
+ChartService::Options::Options()
+    : address(QHostAddress::LocalHost)
+    , port(8547)
+    , workers(0)
+    , queueCapacity(1024)
+    , maxConnections(256)
+    , idleTimeoutMs(30000) {
+}
+
+ChartService::ChartService(const Options& options, QObject* parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_queue(options.queueCapacity)
+    , m_workers(options.workers > 0 ? options.workers : QThread::idealThreadCount())
+    , m_nextConnection(0)
+    , m_nextJob(0) {
+    m_clock.start();
+    // Workers run for the life of the service, so the pool must not retire them
+    m_pool.setMaxThreadCount(m_workers);
+    m_pool.setExpiryTimeout(-1);
+    // Set once, before any worker asks the ephemeris
+    SiderealEphemeris::setUp();
+
+    connect(&m_server, &QTcpServer::newConnection,
+            this, &ChartService::acceptConnections);
+}
+
+ChartService::~ChartService() {
+    stop();
+}
+
+bool ChartService::start(QString* error) {
+    if (!m_server.listen(m_options.address, m_options.port)) {
+        if (error) *error = m_server.errorString();
+        return false;
+    }
+    for (int i = 0; i < m_workers; ++i) {
+        m_pool.start(new ServiceWorker(this));
+    }
+    updateGauges();
+    return true;
+}
+
+void ChartService::stop() {
+    m_server.close();
+    const QList<Connection*> connections = m_connections.values();
+    for (Connection* connection : connections) {
+        closeConnection(connection);
+    }
+    m_queue.stop();
+    m_pool.waitForDone();
+}
+
+void ChartService::acceptConnections() {
+    while (m_server.hasPendingConnections()) {
+        Connection* connection = new Connection;
+        connection->id = ++m_nextConnection;
+        connection->socket = m_server.nextPendingConnection();
+        connection->idleTimer = new QTimer(connection->socket);
+        connection->busy = false;
+        connection->keepAlive = true;
+        connection->route = ServiceMetrics::OtherRoute;
+        connection->started = 0;
+        m_connections.insert(connection->id, connection);
+
+        // Unread requests stay in the kernel once this fills, which stops
+        // the client through TCP flow control
+        QTcpSocket* socket = connection->socket;
+        socket->setReadBufferSize(MAX_HEADER_BYTES + MAX_BODY_BYTES);
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connection->idleTimer->setSingleShot(true);
+        connection->idleTimer->setInterval(m_options.idleTimeoutMs);
+        connection->idleTimer->start();
+
+        connect(connection->idleTimer, &QTimer::timeout, this, [this, connection]() {
+            if (connection->busy) {
+                connection->idleTimer->start();
+            } else {
+                closeConnection(connection);
+            }
+        });
+        connect(socket, &QTcpSocket::readyRead, this, [this, connection]() {
+            readRequests(connection);
+        });
+        connect(socket, &QTcpSocket::bytesWritten, this, [this, connection]() {
+            readRequests(connection);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, connection]() {
+            closeConnection(connection);
+        });
+    }
+
+    // The rest wait in the listen backlog
+    if (m_connections.size() >= m_options.maxConnections) {
+        m_server.pauseAccepting();
+    }
+    updateGauges();
+}
+
+int ChartService::parseRequest(QByteArray& buffer, Request* request) {
+    const int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        return buffer.size() > MAX_HEADER_BYTES ? 431 : 0;
+    }
+
+    const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() != 3) {
+        return 400;
+    }
+    const QByteArray version = requestLine[2];
+    if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+        return 505;
+    }
+    request->method = requestLine[0];
+    request->path = requestLine[1].left(requestLine[1].indexOf('?'));
+    request->keepAlive = version == "HTTP/1.1";
+
+    qint64 contentLength = 0;
+    for (int i = 1; i < lines.size(); ++i) {
+        const int colon = lines[i].indexOf(':');
+        if (colon <= 0) return 400;
+        const QByteArray name = lines[i].left(colon).trimmed().toLower();
+        const QByteArray value = lines[i].mid(colon + 1).trimmed().toLower();
+        if (name == "content-length") {
+            bool ok = false;
+            contentLength = value.toLongLong(&ok);
+            if (!ok || contentLength < 0) return 400;
+            if (contentLength > MAX_BODY_BYTES) return 413;
+        } else if (name == "transfer-encoding" && value != "identity") {
+            return 501;
+        } else if (name == "connection") {
+            if (value.contains("close")) request->keepAlive = false;
+            else if (value.contains("keep-alive")) request->keepAlive = true;
+        }
+    }
+
+    const qint64 total = headerEnd + 4 + contentLength;
+    if (buffer.size() < total) {
+        return 0;
+    }
+    request->body = buffer.mid(headerEnd + 4, int(contentLength));
+    buffer.remove(0, int(total));
+    return 200;
+}
+
+void ChartService::readRequests(Connection* connection) {
+    // One request at a time, and none while the client is behind on reading
+    if (connection->busy || !connection->keepAlive
+        || connection->socket->bytesToWrite() >= WRITE_HIGH_WATER) {
+        return;
+    }
+
+    const int limit = MAX_HEADER_BYTES + MAX_BODY_BYTES;
+    if (connection->buffer.size() < limit) {
+        connection->buffer += connection->socket->read(limit - connection->buffer.size());
+    }
+    if (connection->buffer.isEmpty()) {
+        return;
+    }
+    connection->idleTimer->start();
+
+    Request request;
+    const int status = parseRequest(connection->buffer, &request);
+    if (status == 0) {
+        return;
+    }
+    connection->started = m_clock.nsecsElapsed();
+    if (status != 200) {
+        connection->route = ServiceMetrics::OtherRoute;
+        connection->keepAlive = false;
+        connection->buffer.clear();
+        respond(connection, status, errorBody(QString::fromLatin1(reasonPhrase(status))));
+        return;
+    }
+    handleRequest(connection, request);
+}
+
+void ChartService::handleRequest(Connection* connection, const Request& request) {
+    connection->keepAlive = request.keepAlive;
+
+    if (request.path == "/metrics" || request.path == "/health") {
+        connection->route = request.path == "/metrics"
+            ? ServiceMetrics::MetricsRoute : ServiceMetrics::OtherRoute;
+        if (request.method != "GET") {
+            respond(connection, 405, errorBody("Use GET"));
+        } else if (connection->route == ServiceMetrics::MetricsRoute) {
+            updateGauges();
+            respond(connection, 200, m_metrics.prometheusText(), "text/plain; version=0.0.4");
+        } else {
+            QJsonObject body;
+            body["status"] = "ok";
+            body["workers"] = m_workers;
+            body["queued"] = m_queue.size();
+            respond(connection, 200, QJsonDocument(body).toJson(QJsonDocument::Compact));
+        }
+        return;
+    }
+
+    ChartQuery::Kind kind;
+    if (request.path == "/chart") {
+        kind = ChartQuery::Chart;
+        connection->route = ServiceMetrics::ChartRoute;
+    } else if (request.path == "/dasha") {
+        kind = ChartQuery::Dasha;
+        connection->route = ServiceMetrics::DashaRoute;
+    } else if (request.path == "/yogas") {
+        kind = ChartQuery::Yogas;
+        connection->route = ServiceMetrics::YogasRoute;
+    } else if (request.path == "/electional") {
+        kind = ChartQuery::Electional;
+        connection->route = ServiceMetrics::ElectionalRoute;
+    } else if (request.path == "/transits") {
+        kind = ChartQuery::Transits;
+        connection->route = ServiceMetrics::TransitsRoute;
+    } else {
+        connection->route = ServiceMetrics::OtherRoute;
+        respond(connection, 404, errorBody("Unknown path"));
+        return;
+    }
+    if (request.method != "POST") {
+        respond(connection, 405, errorBody("Use POST"));
+        return;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(request.body, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        respond(connection, 400, errorBody("The body must be a JSON object"));
+        return;
+    }
+    ChartJob job;
+    QString error;
+    if (!ChartQuery::fromJson(kind, document.object(), &job.query, &error)) {
+        respond(connection, 400, errorBody(error));
+        return;
+    }
+
+    job.id = ++m_nextJob;
+    if (!m_queue.push(job)) {
+        m_metrics.recordRejected();
+        respond(connection, 503, errorBody("The service is at capacity; retry shortly"));
+        return;
+    }
+    connection->busy = true;
+    m_pendingJobs.insert(job.id, connection->id);
+}
+
+void ChartService::respond(Connection* connection, int status, const QByteArray& body,
+                           const QByteArray& contentType) {
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status) + "\r\n";
+    head += "Content-Type: " + contentType + "\r\n";
+    head += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    if (status == 503) {
+        head += "Retry-After: 1\r\n";
+    }
+    head += connection->keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    connection->socket->write(head + body);
+
+    m_metrics.recordRequest(connection->route, status, m_clock.nsecsElapsed() - connection->started);
+    connection->busy = false;
+    if (!connection->keepAlive) {
+        // Closed once the response is flushed
+        connection->socket->disconnectFromHost();
+        return;
+    }
+
+    // A pipelined request may already be buffered; read it from the event
+    // loop rather than recursing
+    connection->idleTimer->start();
+    const quint64 id = connection->id;
+    QMetaObject::invokeMethod(this, [this, id]() {
+        if (Connection* connection = m_connections.value(id)) {
+            readRequests(connection);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void ChartService::closeConnection(Connection* connection) {
+    if (!m_connections.remove(connection->id)) {
+        return;
+    }
+    // A query still being computed is dropped when it completes
+    connection->idleTimer->stop();
+    connection->socket->disconnect(this);
+    connection->idleTimer->disconnect(this);
+    connection->socket->close();
+    connection->socket->deleteLater();
+    delete connection;
+
+    if (m_connections.size() < m_options.maxConnections) {
+        m_server.resumeAccepting();
+    }
+    updateGauges();
+}
+
+void ChartService::deliver(const QVector<Completed>& completed, int batchSize) {
+    m_metrics.recordBatch(batchSize);
+    for (const Completed& done : completed) {
+        Connection* connection = m_connections.value(m_pendingJobs.take(done.job));
+        if (connection) {
+            respond(connection, done.status, done.body);
+        }
+    }
+    updateGauges();
+}
+
+void ChartService::updateGauges() {
+    m_metrics.setGauges(m_queue.size(), m_connections.size(), m_workers);
+}
@@ -0,0 +1,106 @@
+#ifndef CHARTSERVICE_H
+#define CHARTSERVICE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QThreadPool>
+#include "chartjobqueue.h"
+#include "servicemetrics.h"
+
+class QTcpSocket;
+class QTimer;
+
+// Local HTTP/1.1 service answering chart, dasha and yoga queries as JSON:
+//
+//   POST /chart   positions, houses, Shadbala and active yoga names
+//   POST /dasha   mahadasha and antardasha running at "at"
+//   POST /yogas   active yogas with strength, planets and conditions
+//   GET  /metrics Prometheus counters, latency histograms and QPS
+//   GET  /health
+//
+// Sockets are served on the thread that owns the service; queries are
+// computed by a fixed pool of workers, each with its own calculators and
+// position cache; their ephemeris calls take turns on the process-wide Swiss
+// Ephemeris. Connections are kept alive and answer one request at a
+// time: the next request is not read until the response is written and
+// the client has taken most of it, so a slow client holds back only
+// itself. A full queue answers 503 with Retry-After, and new connections
+// wait in the listen backlog while the connection limit is reached.
+class ChartService : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        QHostAddress address;
+        quint16 port;
+        int workers;            // 0 = one per core
+        int queueCapacity;      // Queries waiting for a worker
+        int maxConnections;
+        int idleTimeoutMs;      // Idle keep-alive connections are closed
+
+        Options();
+    };
+
+    explicit ChartService(const Options& options, QObject* parent = nullptr);
+    ~ChartService();
+
+    bool start(QString* error = nullptr);
+    void stop();
+    quint16 port() const { return m_server.serverPort(); }
+    int workerCount() const { return m_workers; }
+
+    static const int MAX_HEADER_BYTES = 16 * 1024;
+    static const int MAX_BODY_BYTES = 1024 * 1024;
+    static const int WRITE_HIGH_WATER = 256 * 1024;   // Unsent bytes that pause reading
+
+private slots:
+    void acceptConnections();
+
+private:
+    struct Connection;
+
+    // A computed query on its way back from a worker
+    struct Completed {
+        quint64 job;
+        int status;
+        QByteArray body;
+    };
+
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QByteArray body;
+        bool keepAlive;
+    };
+
+    // Status 0 while the request is incomplete, 200 when it was taken from
+    // the buffer, or the error status to close the connection with
+    static int parseRequest(QByteArray& buffer, Request* request);
+    void readRequests(Connection* connection);
+    void handleRequest(Connection* connection, const Request& request);
+    void respond(Connection* connection, int status, const QByteArray& body,
+                 const QByteArray& contentType = "application/json");
+    void closeConnection(Connection* connection);
+    void deliver(const QVector<Completed>& completed, int batchSize);
+    void updateGauges();
+
+    friend class ServiceWorker;
+
+    Options m_options;
+    QTcpServer m_server;
+    ChartJobQueue m_queue;
+    QThreadPool m_pool;
+    int m_workers;
+    ServiceMetrics m_metrics;
+    QElapsedTimer m_clock;
+
+    QHash<quint64, Connection*> m_connections;
+    QHash<quint64, quint64> m_pendingJobs;     // Job id to connection id
+    quint64 m_nextConnection;
+    quint64 m_nextJob;
+};
+
+#endif // CHARTSERVICE_H
@@ -0,0 +1,80 @@
+#include "chartservice.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <csignal>
+
+namespace {
+
+void quitOnSignal(int)
+{
+    QCoreApplication::quit();
+}
+
+int intValue(const QCommandLineParser& parser, const QCommandLineOption& option, int fallback)
+{
+    bool ok = false;
+    const int value = parser.value(option).toInt(&ok);
+    return ok && value >= 0 ? value : fallback;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("astro_service");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    ChartService::Options options;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local JSON service for charts, dashas and yogas");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption hostOption("host",
+        "Address to listen on (default 127.0.0.1).", "address", "127.0.0.1");
+    QCommandLineOption portOption("port",
+        "Port to listen on (default 8547).", "port", QString::number(options.port));
+    QCommandLineOption workersOption("workers",
+        "Worker threads computing queries (default one per core).", "n", "0");
+    QCommandLineOption queueOption("queue",
+        "Queries that may wait for a worker before 503 is answered.", "n",
+        QString::number(options.queueCapacity));
+    QCommandLineOption connectionsOption("max-connections",
+        "Open connections before new ones wait in the backlog.", "n",
+        QString::number(options.maxConnections));
+    parser.addOption(hostOption);
+    parser.addOption(portOption);
+    parser.addOption(workersOption);
+    parser.addOption(queueOption);
+    parser.addOption(connectionsOption);
+    parser.process(app);
+
+    if (!options.address.setAddress(parser.value(hostOption))) {
+        qCritical() << "Invalid address" << parser.value(hostOption);
+        return 1;
+    }
+    options.port = quint16(intValue(parser, portOption, options.port));
+    options.workers = intValue(parser, workersOption, 0);
+    options.queueCapacity = qMax(1, intValue(parser, queueOption, options.queueCapacity));
+    options.maxConnections = qMax(1, intValue(parser, connectionsOption, options.maxConnections));
+
+    ChartService service(options);
+    QString error;
+    if (!service.start(&error)) {
+        qCritical() << "Cannot listen:" << error;
+        return 1;
+    }
+    qInfo().noquote() << QString("Listening on %1:%2 with %3 workers")
+                             .arg(options.address.toString())
+                             .arg(service.port())
+                             .arg(service.workerCount());
+
+    // Stop cleanly so the workers are joined before exit
+    std::signal(SIGINT, quitOnSignal);
+    std::signal(SIGTERM, quitOnSignal);
+    const int status = app.exec();
+    service.stop();
+    return status;
+}
@@ -0,0 +1,151 @@
+#include "servicemetrics.h"
+#include <QString>
+#include <cstring>
+
+namespace {
+
+// Upper bounds in seconds; the last bucket is +Inf
+const double LatencyBounds[ServiceMetrics::LATENCY_BUCKETS - 1] = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25
+};
+const int BatchBounds[ServiceMetrics::BATCH_BUCKETS - 1] = {1, 2, 4, 8, 16, 32};
+
+} // namespace
+
+ServiceMetrics::ServiceMetrics()
+    : m_batches(0)
+    , m_batchedJobs(0)
+    , m_rejected(0)
+    , m_queueDepth(0)
+    , m_connections(0)
+    , m_workers(0)
+    , m_currentSecond(0) {
+    std::memset(m_routes, 0, sizeof(m_routes));
+    std::memset(m_batchBuckets, 0, sizeof(m_batchBuckets));
+    std::memset(m_perSecond, 0, sizeof(m_perSecond));
+    m_clock.start();
+}
+
+const char* ServiceMetrics::routeName(int route) {
+    static const char* const names[RouteCount] = {"chart", "dasha", "yogas", "electional",
+                                                         "transits", "metrics", "other"};
+    return route >= 0 && route < RouteCount ? names[route] : "other";
+}
+
+void ServiceMetrics::advanceClock() const {
+    // Seconds skipped since the last request had none
+    const qint64 now = m_clock.elapsed() / 1000;
+    for (qint64 second = qMax(m_currentSecond + 1, now - QPS_WINDOW + 1); second <= now; ++second) {
+        m_perSecond[second % QPS_WINDOW] = 0;
+    }
+    m_currentSecond = qMax(m_currentSecond, now);
+}
+
+void ServiceMetrics::recordRequest(int route, int status, qint64 latencyNs) {
+    RouteStats& stats = m_routes[qBound(0, route, RouteCount - 1)];
+    ++stats.requests;
+    if (status >= 400) ++stats.errors;
+
+    const double seconds = latencyNs / 1e9;
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && seconds > LatencyBounds[bucket]) ++bucket;
+    ++stats.buckets[bucket];
+    stats.latencySum += seconds;
+
+    advanceClock();
+    ++m_perSecond[m_currentSecond % QPS_WINDOW];
+}
+
+void ServiceMetrics::recordBatch(int size) {
+    int bucket = 0;
+    while (bucket < BATCH_BUCKETS - 1 && size > BatchBounds[bucket]) ++bucket;
+    ++m_batchBuckets[bucket];
+    ++m_batches;
+    m_batchedJobs += size;
+}
+
+void ServiceMetrics::setGauges(int queueDepth, int connections, int workers) {
+    m_queueDepth = queueDepth;
+    m_connections = connections;
+    m_workers = workers;
+}
+
+double ServiceMetrics::qps(int seconds) const {
+    advanceClock();
+    seconds = qBound(1, seconds, QPS_WINDOW);
+    // The current second is still filling, so the window ends before it
+    quint64 total = 0;
+    for (int i = 1; i <= seconds; ++i) {
+        const qint64 second = m_currentSecond - i;
+        if (second < 0) break;
+        total += m_perSecond[second % QPS_WINDOW];
+    }
+    return double(total) / seconds;
+}
+
+QByteArray ServiceMetrics::prometheusText() const {
+    QString text;
+
+    text += "# HELP astro_requests_total Requests answered, by route.\n"
+            "# TYPE astro_requests_total counter\n";
+    for (int route = 0; route < RouteCount; ++route) {
+        text += QString("astro_requests_total{route=\"%1\"} %2\n")
+                    .arg(routeName(route)).arg(m_routes[route].requests);
+    }
+    text += "# HELP astro_request_errors_total Requests answered with status 400 or above.\n"
+            "# TYPE astro_request_errors_total counter\n";
+    for (int route = 0; route < RouteCount; ++route) {
+        text += QString("astro_request_errors_total{route=\"%1\"} %2\n")
+                    .arg(routeName(route)).arg(m_routes[route].errors);
+    }
+
+    text += "# HELP astro_request_duration_seconds Time from a complete request to its response.\n"
+            "# TYPE astro_request_duration_seconds histogram\n";
+    for (int route = 0; route < RouteCount; ++route) {
+        const RouteStats& stats = m_routes[route];
+        quint64 cumulative = 0;
+        for (int bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+            cumulative += stats.buckets[bucket];
+            const QString bound = bucket < LATENCY_BUCKETS - 1
+                ? QString::number(LatencyBounds[bucket]) : QString("+Inf");
+            text += QString("astro_request_duration_seconds_bucket{route=\"%1\",le=\"%2\"} %3\n")
+                        .arg(routeName(route), bound).arg(cumulative);
+        }
+        text += QString("astro_request_duration_seconds_sum{route=\"%1\"} %2\n")
+                    .arg(routeName(route)).arg(stats.latencySum, 0, 'f', 6);
+        text += QString("astro_request_duration_seconds_count{route=\"%1\"} %2\n")
+                    .arg(routeName(route)).arg(stats.requests);
+    }
+
+    text += "# HELP astro_qps Requests answered per second.\n"
+            "# TYPE astro_qps gauge\n";
+    text += QString("astro_qps{window=\"10s\"} %1\n").arg(qps(10), 0, 'f', 2);
+    text += QString("astro_qps{window=\"60s\"} %1\n").arg(qps(60), 0, 'f', 2);
+
+    text += "# HELP astro_batch_size Queries computed together for one instant.\n"
+            "# TYPE astro_batch_size histogram\n";
+    quint64 cumulative = 0;
+    for (int bucket = 0; bucket < BATCH_BUCKETS; ++bucket) {
+        cumulative += m_batchBuckets[bucket];
+        const QString bound = bucket < BATCH_BUCKETS - 1
+            ? QString::number(BatchBounds[bucket]) : QString("+Inf");
+        text += QString("astro_batch_size_bucket{le=\"%1\"} %2\n").arg(bound).arg(cumulative);
+    }
+    text += QString("astro_batch_size_sum %1\n").arg(m_batchedJobs);
+    text += QString("astro_batch_size_count %1\n").arg(m_batches);
+
+    text += "# HELP astro_rejected_total Requests refused with 503 because the queue was full.\n"
+            "# TYPE astro_rejected_total counter\n";
+    text += QString("astro_rejected_total %1\n").arg(m_rejected);
+    text += "# HELP astro_queue_depth Queries waiting for a worker.\n"
+            "# TYPE astro_queue_depth gauge\n";
+    text += QString("astro_queue_depth %1\n").arg(m_queueDepth);
+    text += "# HELP astro_connections Open client connections.\n"
+            "# TYPE astro_connections gauge\n";
+    text += QString("astro_connections %1\n").arg(m_connections);
+    text += "# HELP astro_workers Worker threads.\n"
+            "# TYPE astro_workers gauge\n";
+    text += QString("astro_workers %1\n").arg(m_workers);
+
+    return text.toUtf8();
+}
@@ -0,0 +1,65 @@
+#ifndef SERVICEMETRICS_H
+#define SERVICEMETRICS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+
+// Request counters, latency histograms and throughput of the chart
+// service, served at /metrics in the Prometheus text format. Updated and
+// read on the network thread only.
+class ServiceMetrics {
+public:
+    enum Route {
+        ChartRoute,
+        DashaRoute,
+        YogasRoute,
+        ElectionalRoute,
+        TransitsRoute,
+        MetricsRoute,
+        OtherRoute,         // Health checks, unknown paths, malformed requests
+        RouteCount
+    };
+
+    ServiceMetrics();
+
+    void recordRequest(int route, int status, qint64 latencyNs);
+    void recordBatch(int size);
+    void recordRejected() { ++m_rejected; }
+    void setGauges(int queueDepth, int connections, int workers);
+
+    // Requests per second over the last seconds, at most QPS_WINDOW
+    double qps(int seconds) const;
+    QByteArray prometheusText() const;
+
+    static const char* routeName(int route);
+
+    static const int LATENCY_BUCKETS = 12;
+    static const int BATCH_BUCKETS = 7;
+    static const int QPS_WINDOW = 60;
+
+private:
+    struct RouteStats {
+        quint64 requests;
+        quint64 errors;                     // Status 400 and above
+        quint64 buckets[LATENCY_BUCKETS];   // Not cumulative; the last is +Inf
+        double latencySum;                  // Seconds
+    };
+
+    void advanceClock() const;
+
+    RouteStats m_routes[RouteCount];
+    quint64 m_batchBuckets[BATCH_BUCKETS];
+    quint64 m_batches;
+    quint64 m_batchedJobs;
+    quint64 m_rejected;
+    int m_queueDepth;
+    int m_connections;
+    int m_workers;
+
+    // Completed requests per second, in a ring indexed by second
+    QElapsedTimer m_clock;
+    mutable qint64 m_currentSecond;
+    mutable quint64 m_perSecond[QPS_WINDOW];
+};
+
+#endif // SERVICEMETRICS_H
@@ -0,0 +1,33 @@
+#include "batchexporter.h"
+#include "batchrunner.h"
+#include "perfcounters.h"
+#include <memory>
+
+BatchExporter::BatchExporter()
+    : m_size(800, 800)
+    , m_scale(1.0)
+    , m_threads(0)
+{
+}
+
+BatchExporter::Result BatchExporter::run(const QVector<Job>& jobs) const {
+    // Every worker keeps one renderer for all of its charts
+    const BatchRunner::Result batch = BatchRunner::run(jobs.size(), m_threads, [this, &jobs]() {
+        auto renderer = std::make_shared<ChartRenderer>();
+        renderer->setOptions(m_options);
+        return BatchRunner::Task([this, &jobs, renderer](int index) {
+            const Job& job = jobs[index];
+            PERF_REGION("Batch export");
+            return renderer->exportFile(job.filePath, m_size, job.chart, m_scale);
+        });
+    });
+
+    Result result;
+    result.written = batch.succeeded;
+    for (int index : batch.failed) {
+        result.failedPaths.append(jobs[index].filePath);
+    }
+    result.failed = result.failedPaths.size();
+    result.seconds = batch.seconds;
+    return result;
+}
@@ -0,0 +1,45 @@
+#ifndef BATCHEXPORTER_H
+#define BATCHEXPORTER_H
+
+#include <QSize>
+#include <QStringList>
+#include <QVector>
+#include "chartrenderer.h"
+
+// Renders many charts to image files on a pool of worker threads, without
+// a window. Every worker keeps one ChartRenderer for all of its charts.
+class BatchExporter {
+public:
+    struct Job {
+        QString filePath;       // .png, .jpg or .svg
+        ChartRenderer::Chart chart;
+    };
+
+    struct Result {
+        int written;
+        int failed;
+        double seconds;
+        QStringList failedPaths;
+
+        Result() : written(0), failed(0), seconds(0) {}
+        double chartsPerSecond() const { return seconds > 0 ? written / seconds : 0.0; }
+    };
+
+    BatchExporter();
+
+    void setOptions(const ChartRenderer::Options& options) { m_options = options; }
+    void setSize(const QSize& size) { m_size = size; }
+    void setScale(qreal scale) { m_scale = scale; }
+    void setThreadCount(int threads) { m_threads = threads; }   // 0 = all cores
+
+    // Blocks until every job is written
+    Result run(const QVector<Job>& jobs) const;
+
+private:
+    ChartRenderer::Options m_options;
+    QSize m_size;
+    qreal m_scale;
+    int m_threads;
+};
+
+#endif // BATCHEXPORTER_H
@@ -0,0 +1,73 @@
+#include "batchrunner.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+
+namespace {
+
+// Shared state of one run; workers claim jobs one at a time
+struct RunState {
+    int count;
+    const std::function<BatchRunner::Task()>* makeTask;
+    QAtomicInt next;
+    QAtomicInt succeeded;
+    QMutex failedMutex;
+    QVector<int> failed;
+};
+
+class Worker : public QRunnable {
+public:
+    explicit Worker(RunState& state) : m_state(state) {}
+
+    void run() override {
+        const BatchRunner::Task task = (*m_state.makeTask)();
+        for (;;) {
+            const int index = m_state.next.fetchAndAddRelaxed(1);
+            if (index >= m_state.count) break;
+
+            if (task(index)) {
+                m_state.succeeded.fetchAndAddRelaxed(1);
+            } else {
+                QMutexLocker locker(&m_state.failedMutex);
+                m_state.failed.append(index);
+            }
+        }
+    }
+
+private:
+    RunState& m_state;
+};
+
+} // namespace
+
+BatchRunner::Result BatchRunner::run(int count, int threads,
+                                     const std::function<Task()>& makeTask) {
+    QElapsedTimer timer;
+    timer.start();
+
+    RunState state;
+    state.count = count;
+    state.makeTask = &makeTask;
+
+    const int workers = std::max(1, std::min(
+        threads > 0 ? threads : QThread::idealThreadCount(), count));
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    for (int i = 0; i < workers; ++i) {
+        pool.start(new Worker(state));
+    }
+    pool.waitForDone();
+
+    Result result;
+    result.succeeded = state.succeeded.loadAcquire();
+    result.failed = state.failed;
+    std::sort(result.failed.begin(), result.failed.end());
+    result.seconds = timer.nsecsElapsed() / 1e9;
+    return result;
+}
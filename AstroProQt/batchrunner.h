@@ -0,0 +1,29 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QVector>
+#include <functional>
+
+// Runs a batch of jobs on a private thread pool, so a nightly batch does
+// not starve the global one. Every worker calls makeTask() once, on its own
+// thread, for a task holding its per-thread state (a renderer, say), then
+// claims job indexes one at a time until none are left.
+class BatchRunner {
+public:
+    // Does job index; false if it failed
+    using Task = std::function<bool(int index)>;
+
+    struct Result {
+        int succeeded;
+        QVector<int> failed;   // Job indexes, ascending
+        double seconds;
+
+        Result() : succeeded(0), seconds(0) {}
+    };
+
+    // Blocks until every job is done; threads 0 = all cores, never more
+    // than there are jobs
+    static Result run(int count, int threads, const std::function<Task()>& makeTask);
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,415 @@
+// Micro-benchmark suite for the calculators and ephemeris entry points.
+//
+// Runs every benchmark over the same reproducible corpus of synthetic
+// birth data and reports latency per operation, heap allocations per
+// operation and throughput. Results can be written as JSON and compared
+// against a saved baseline, failing when a benchmark slowed down by more
+// than the threshold:
+//
+//   astro_bench --json baseline.json
+//   astro_bench --baseline baseline.json --threshold 10
+//
+// With --perf, each benchmark's timed loop is also a hardware counter
+// region, and IPC, cache and branch miss rates are reported.
+//
+// Chart/pipeline runs one chart through every calculator the way the report
+// and service workers do, so its allocations/op is the per-chart total.
+//
+// Chart rendering draws into an offscreen QImage; the offscreen platform
+// plugin is used unless QT_QPA_PLATFORM says otherwise.
+
+#include "chartrenderer.h"
+#include "perfcounters.h"
+#include "Calculators/aspectmatrix.h"
+#include "Calculators/dashacalculator.h"
+#include "Calculators/strengthcalculator.h"
+#include "Calculators/yogacalculator.h"
+#include "swephexp.h"
+#include <QDateTime>
+#include <QFile>
+#include <QGuiApplication>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <random>
+#include <vector>
+
+// Every allocation in the process goes through these, so the count taken
+// around a benchmark loop is its allocations
+namespace {
+std::atomic<unsigned long long> allocationCount(0);
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const unsigned CorpusSeed = 20240415u;
+const double MinSampleNs = 2000.0;     // Cheap operations are repeated up to this
+const double DefaultThreshold = 10.0;  // Percent
+
+// Mean daily motion of the seven planets, scaled for the synthetic speeds
+const double MeanSpeed[Astro::SevenPlanets] = {
+    0.9856, 13.1764, 0.5240, 0.9856, 0.0831, 0.9856, 0.0335
+};
+
+struct SyntheticChart {
+    QMap<QString, double> positions;
+    QMap<QString, double> speeds;   // Degrees/day, some retrograde
+    QVector<double> houses;
+    QDateTime birthTime;
+    double julianDay;
+
+    // Inputs of the benchmarks that consume other calculators' output
+    AspectMatrix aspects;
+    QMap<QString, StrengthCalculator::PlanetaryStrength> strengths;
+    ChartRenderer::Chart chart;
+};
+
+std::vector<SyntheticChart> makeCorpus(int count) {
+    std::mt19937 rng(CorpusSeed);
+    std::uniform_real_distribution<double> degree(0.0, 360.0);
+    std::uniform_int_distribution<qint64> seconds(0, 100LL * 365 * 86400);
+    std::uniform_real_distribution<double> motion(-0.5, 1.8);   // Multiple of the mean
+    StrengthCalculator strengthCalculator;
+
+    std::vector<SyntheticChart> corpus(count);
+    for (SyntheticChart& chart : corpus) {
+        for (int p = 0; p < Astro::PlanetCount; ++p) {
+            chart.positions[Astro::planetName(p)] = degree(rng);
+        }
+        for (int p = 0; p < Astro::SevenPlanets; ++p) {
+            chart.speeds[Astro::planetName(p)] = motion(rng) * MeanSpeed[p];
+        }
+        double ascendant = degree(rng);
+        for (int h = 0; h < 12; ++h) {
+            chart.houses.append(Astro::normalizeDegrees(ascendant + h * 30.0));
+        }
+        chart.birthTime = QDateTime::fromSecsSinceEpoch(
+            seconds(rng) - 50LL * 365 * 86400, Qt::UTC);
+        chart.julianDay = chart.birthTime.toMSecsSinceEpoch() / 86400000.0 + 2440587.5;
+
+        chart.aspects.build(chart.positions, chart.houses);
+        chart.strengths = strengthCalculator.calculateAllStrengths(
+            chart.positions, chart.houses, chart.birthTime, chart.speeds);
+        chart.chart = ChartRenderer::Chart::build(chart.positions, chart.houses);
+    }
+    return corpus;
+}
+
+struct Benchmark {
+    QString name;
+    // One operation on a chart; the result feeds the checksum
+    std::function<double(const SyntheticChart&)> run;
+};
+
+struct Result {
+    QString name;
+    double meanNs;
+    double p50Ns;
+    double p99Ns;
+    double allocationsPerOp;
+    double opsPerSecond;
+    PerfCounters::Totals counters;   // Empty without --perf
+};
+
+Result measure(const Benchmark& benchmark, const std::vector<SyntheticChart>& corpus,
+               double& checksum) {
+    // Warm the caches and find how many repeats make a sample long enough
+    // to time reliably
+    auto start = Clock::now();
+    for (const SyntheticChart& chart : corpus) {
+        checksum += benchmark.run(chart);
+    }
+    const double warmNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    const int repeats = std::max(1, int(MinSampleNs / std::max(1.0, warmNs / corpus.size())));
+
+    std::vector<double> samples;
+    samples.reserve(corpus.size());
+    const QByteArray region = benchmark.name.toUtf8();
+    unsigned long long allocations = 0;
+    double totalNs = 0.0;
+    {
+        PerfCounters::Region counters(region.constData());
+        const unsigned long long allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        for (const SyntheticChart& chart : corpus) {
+            start = Clock::now();
+            for (int r = 0; r < repeats; ++r) {
+                checksum += benchmark.run(chart);
+            }
+            const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            totalNs += ns;
+            samples.push_back(ns / repeats);
+        }
+        // Counted inside the region, which allocates as it opens and records
+        allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double q) {
+        return samples[static_cast<size_t>(q * (samples.size() - 1))];
+    };
+    const double ops = double(corpus.size()) * repeats;
+    return {benchmark.name, totalNs / ops, percentile(0.5), percentile(0.99),
+            allocations / ops, ops * 1e9 / totalNs,
+            PerfCounters::instance().totals(benchmark.name)};
+}
+
+QVector<Benchmark> makeBenchmarks(DashaCalculator& dasha, StrengthCalculator& strength,
+                                  YogaCalculator& yoga, ChartRenderer& renderer,
+                                  QImage& canvas) {
+    QVector<Benchmark> benchmarks;
+
+    // The bodies the charts use; the bundled ephemeris may not implement
+    // them all, which the first call reports
+    const struct {
+        const char* name;
+        int body;
+    } bodies[] = {
+        {"Sun", SE_SUN}, {"Moon", SE_MOON}, {"Mars", SE_MARS}, {"Mercury", SE_MERCURY},
+        {"Jupiter", SE_JUPITER}, {"Venus", SE_VENUS}, {"Saturn", SE_SATURN},
+        {"Rahu", SE_MEAN_NODE}
+    };
+    for (const auto& body : bodies) {
+        double xx[6] = {0};
+        char error[256] = {0};
+        if (swe_calc_ut(2451545.0, body.body, 0, xx, error) < 0) {
+            std::printf("%-44s skipped: %s\n",
+                        QString("swe_calc_ut/%1").arg(body.name).toLocal8Bit().constData(), error);
+            continue;
+        }
+        const int ipl = body.body;
+        benchmarks.append({QString("swe_calc_ut/%1").arg(body.name), [ipl](const SyntheticChart& chart) {
+            double xx[6];
+            char error[256];
+            swe_calc_ut(chart.julianDay, ipl, 0, xx, error);
+            return xx[0];
+        }});
+    }
+
+    benchmarks.append({"DashaCalculator/calculateVimshottariDasha", [&dasha](const SyntheticChart& chart) {
+        return double(dasha.calculateVimshottariDasha(chart.birthTime, chart.positions.value("Moon")).size());
+    }});
+    benchmarks.append({"DashaCalculator/getCurrentDasha", [&dasha](const SyntheticChart& chart) {
+        return double(dasha.getCurrentDasha(chart.birthTime, chart.positions.value("Moon")).size());
+    }});
+    benchmarks.append({"StrengthCalculator/calculateAllStrengths", [&strength](const SyntheticChart& chart) {
+        return strength.calculateAllStrengths(chart.positions, chart.houses, chart.birthTime,
+                                              chart.speeds).value("Sun").shadbala;
+    }});
+    benchmarks.append({"YogaCalculator/detectActiveYogas", [&yoga](const SyntheticChart& chart) {
+        return double(yoga.detectActiveYogas(chart.positions, chart.houses, chart.strengths,
+                                             &chart.aspects).size());
+    }});
+    benchmarks.append({"AspectMatrix/build", [](const SyntheticChart& chart) {
+        AspectMatrix aspects;
+        aspects.build(chart.positions, chart.houses);
+        return double(aspects.flags(0, 1));
+    }});
+
+    const auto pipeline = [&dasha, &strength, &yoga](const SyntheticChart& chart) {
+        AspectMatrix aspects;
+        aspects.build(chart.positions, chart.houses);
+        const VargaCalculator::VargaMatrix vargas =
+            VargaCalculator().calculate(chart.positions, chart.houses[0]);
+        const QMap<QString, StrengthCalculator::PlanetaryStrength> strengths =
+            strength.calculateAllStrengths(chart.positions, chart.houses, chart.birthTime,
+                                           chart.speeds, &aspects, &vargas);
+        const QVector<YogaCalculator::Yoga> yogas =
+            yoga.detectActiveYogas(chart.positions, chart.houses, strengths, &aspects, &vargas);
+        const QVector<DashaPeriod> dashas =
+            dasha.calculateVimshottariDasha(chart.birthTime, chart.positions.value("Moon"));
+        return strengths.value("Sun").shadbala + yogas.size() + dashas.size();
+    };
+    benchmarks.append({"Chart/pipeline", pipeline});
+    benchmarks.append({"ChartRenderer/render", [&renderer, &canvas](const SyntheticChart& chart) {
+        canvas.fill(Qt::white);
+        QPainter painter(&canvas);
+        renderer.render(painter, canvas.size(), chart.chart);
+        return double(canvas.constBits()[0]);
+    }});
+    return benchmarks;
+}
+
+QJsonObject toJson(const QVector<Result>& results, int charts) {
+    QJsonArray benchmarks;
+    for (const Result& result : results) {
+        QJsonObject entry;
+        entry["name"] = result.name;
+        entry["ns_per_op"] = result.meanNs;
+        entry["p50_ns"] = result.p50Ns;
+        entry["p99_ns"] = result.p99Ns;
+        entry["allocs_per_op"] = result.allocationsPerOp;
+        entry["ops_per_sec"] = result.opsPerSecond;
+        const PerfCounters::Totals& counters = result.counters;
+        if (counters.ipc() >= 0) entry["ipc"] = counters.ipc();
+        if (counters.l1dMissRate() >= 0) entry["l1d_miss_rate"] = counters.l1dMissRate();
+        if (counters.llcMissesPerKilo() >= 0) entry["llc_mpki"] = counters.llcMissesPerKilo();
+        if (counters.branchMissRate() >= 0) entry["branch_miss_rate"] = counters.branchMissRate();
+        benchmarks.append(entry);
+    }
+    QJsonObject root;
+    root["charts"] = charts;
+    root["seed"] = double(CorpusSeed);
+    root["benchmarks"] = benchmarks;
+    return root;
+}
+
+// Compares median latency and allocations with a saved run; returns the
+// number of regressions beyond the threshold
+int compare(const QVector<Result>& results, const QJsonObject& baseline, double threshold) {
+    QMap<QString, QJsonObject> saved;
+    for (const QJsonValue& value : baseline["benchmarks"].toArray()) {
+        saved[value.toObject()["name"].toString()] = value.toObject();
+    }
+
+    std::printf("\n%-44s %12s %12s %8s %10s\n", "Benchmark", "base p50", "p50", "change", "allocs");
+    int regressions = 0;
+    for (const Result& result : results) {
+        if (!saved.contains(result.name)) {
+            std::printf("%-44s %12s\n", result.name.toLocal8Bit().constData(), "new");
+            continue;
+        }
+        const QJsonObject& base = saved[result.name];
+        const double baseNs = base["p50_ns"].toDouble();
+        const double change = baseNs > 0 ? (result.p50Ns - baseNs) * 100.0 / baseNs : 0.0;
+        const double baseAllocations = base["allocs_per_op"].toDouble();
+        const bool slower = change > threshold;
+        const bool allocates = result.allocationsPerOp > baseAllocations + 0.5;
+        if (slower || allocates) ++regressions;
+        std::printf("%-44s %12.0f %12.0f %+7.1f%% %10.1f%s\n",
+                    result.name.toLocal8Bit().constData(), baseNs, result.p50Ns, change,
+                    result.allocationsPerOp, slower || allocates ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+void usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [--charts N] [--filter TEXT] [--json FILE]\n"
+                 "          [--baseline FILE] [--threshold PERCENT] [--perf]\n", program);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int charts = 2000;
+    QString filter;
+    QString jsonPath;
+    QString baselinePath;
+    double threshold = DefaultThreshold;
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--charts") && hasValue) {
+            charts = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--filter") && hasValue) {
+            filter = QString::fromLocal8Bit(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--json") && hasValue) {
+            jsonPath = QString::fromLocal8Bit(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--baseline") && hasValue) {
+            baselinePath = QString::fromLocal8Bit(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--threshold") && hasValue) {
+            threshold = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--perf")) {
+            PerfCounters::instance().setEnabled(true);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    const std::vector<SyntheticChart> corpus = makeCorpus(charts);
+    DashaCalculator dasha;
+    StrengthCalculator strength;
+    YogaCalculator yoga;
+    ChartRenderer renderer;
+    QImage canvas(600, 600, QImage::Format_ARGB32_Premultiplied);
+
+    std::printf("%-44s %10s %10s %10s %10s %12s\n",
+                "Benchmark", "ns/op", "p50 ns", "p99 ns", "allocs/op", "ops/s");
+    QVector<Result> results;
+    double checksum = 0.0;
+    for (const Benchmark& benchmark : makeBenchmarks(dasha, strength, yoga, renderer, canvas)) {
+        if (!filter.isEmpty() && !benchmark.name.contains(filter, Qt::CaseInsensitive)) {
+            continue;
+        }
+        const Result result = measure(benchmark, corpus, checksum);
+        std::printf("%-44s %10.0f %10.0f %10.0f %10.1f %12.0f\n",
+                    result.name.toLocal8Bit().constData(), result.meanNs, result.p50Ns,
+                    result.p99Ns, result.allocationsPerOp, result.opsPerSecond);
+        results.append(result);
+    }
+    std::printf("checksum %.3f (%d charts)\n", checksum, charts);
+    if (PerfCounters::instance().isEnabled()) {
+        std::printf("\n%s", PerfCounters::instance().report().toLocal8Bit().constData());
+    }
+
+    if (!jsonPath.isEmpty()) {
+        QFile file(jsonPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::fprintf(stderr, "Cannot write %s\n", jsonPath.toLocal8Bit().constData());
+            return 2;
+        }
+        file.write(QJsonDocument(toJson(results, charts)).toJson());
+    }
+
+    if (!baselinePath.isEmpty()) {
+        QFile file(baselinePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "Cannot read %s\n", baselinePath.toLocal8Bit().constData());
+            return 2;
+        }
+        const QJsonObject baseline = QJsonDocument::fromJson(file.readAll()).object();
+        if (baseline["charts"].toInt() != charts) {
+            std::printf("note: baseline was run with %d charts\n", baseline["charts"].toInt());
+        }
+        const int regressions = compare(results, baseline, threshold);
+        if (regressions > 0) {
+            std::printf("%d benchmark(s) regressed by more than %.1f%%\n", regressions, threshold);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+// Electional search benchmark and cross-check.
+//
+// Runs ElectionalSearch for a few yoga and strength queries on a
+// reproducible analytic ephemeris (mean motions with an epicycle term, so
+// the planets station and go retrograde), then samples the same range
+// minute by minute with holds() and checks that every minute further than
+// the search's tolerance from an edge agrees with the windows it returned.
+// Exits nonzero on any disagreement.
+
+#include "Calculators/electionalsearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+constexpr double J2000 = 2451545.0;
+constexpr double AYANAMSA = 23.85;
+constexpr double LATITUDE = 28.61;
+constexpr double LONGITUDE = 77.21;
+
+struct Orbit {
+    double epoch;       // Mean longitude at J2000, degrees
+    double motion;      // Mean daily motion, degrees
+    double amplitude;   // Epicycle term, degrees
+    double period;      // Of the epicycle term, days
+};
+
+// Sun, Moon, Mars, Mercury, Jupiter, Venus, Saturn, Rahu; the speeds stay
+// inside the ranges the search's scan steps are sized for
+constexpr Orbit orbits[Astro::Ketu] = {
+    {280.46, 0.985647, 1.9, 365.26},
+    {218.32, 13.176396, 6.3, 27.5546},
+    {355.43, 0.524033, 60.0, 779.94},
+    {252.25, 0.985647, 22.0, 115.88},
+    {34.35, 0.083091, 10.0, 398.88},
+    {181.98, 0.985647, 100.0, 583.92},
+    {50.08, 0.033460, 6.0, 378.09},
+    {125.04, -0.052954, 0.0, 1.0}
+};
+
+double analyticLongitude(int body, double julianDay) {
+    const double t = julianDay - J2000;
+    if (body == ElectionalSearch::Ascendant) {
+        const double sidereal = Astro::normalizeDegrees(280.46061837 + 360.98564736629 * t + LONGITUDE);
+        const double ramc = sidereal * M_PI / 180.0;
+        const double obliquity = 23.4392911 * M_PI / 180.0;
+        const double phi = LATITUDE * M_PI / 180.0;
+        const double tropical = std::atan2(std::cos(ramc),
+            -(std::sin(ramc) * std::cos(obliquity) + std::tan(phi) * std::sin(obliquity)));
+        return Astro::normalizeDegrees(tropical * 180.0 / M_PI - AYANAMSA);
+    }
+    const Orbit& orbit = orbits[body];
+    return Astro::normalizeDegrees(orbit.epoch + orbit.motion * t - AYANAMSA +
+                                   orbit.amplitude * std::sin(2.0 * M_PI * t / orbit.period));
+}
+
+double seconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+struct Case {
+    const char* label;
+    QStringList yogas;
+    QVector<ElectionalSearch::StrengthCondition> strengths;
+};
+
+// Minutes that disagree with the search's windows
+int check(ElectionalSearch& search, const ElectionalSearch::Query& query, int days,
+          const char* label) {
+    using Clock = std::chrono::steady_clock;
+
+    auto start = Clock::now();
+    const QVector<ElectionalSearch::Window> windows = search.search(query);
+    const double searchSeconds = seconds(Clock::now() - start);
+    const ElectionalSearch::Stats stats = search.stats();
+
+    // Minute-by-minute reference. The search places edges to its
+    // tolerance, so minutes within two tolerances of a window edge, or of
+    // a change in the reference itself, are not compared
+    const int minutes = days * 1440;
+    start = Clock::now();
+    std::vector<char> reference(minutes);
+    for (int m = 0; m < minutes; ++m) {
+        reference[m] = search.holds(query.startDay + m / 1440.0, query);
+    }
+    const double scanSeconds = seconds(Clock::now() - start);
+
+    const double guard = 2.0 * query.tolerance;
+    const int reach = static_cast<int>(std::ceil(guard * 1440.0));
+    int mismatches = 0;
+    for (int m = 0; m < minutes; ++m) {
+        const double t = query.startDay + m / 1440.0;
+        bool inside = false;
+        bool settled = true;
+        for (const ElectionalSearch::Window& window : windows) {
+            if (std::fabs(t - window.startDay) <= guard || std::fabs(t - window.endDay) <= guard) {
+                settled = false;
+            }
+            if (t >= window.startDay && t < window.endDay) inside = true;
+        }
+        for (int k = std::max(0, m - reach); k <= std::min(minutes - 1, m + reach); ++k) {
+            if (reference[k] != reference[m]) settled = false;
+        }
+        if (settled && bool(reference[m]) != inside && ++mismatches <= 5) {
+            std::printf("  mismatch at %s: search says %s\n",
+                        qPrintable(ElectionalSearch::fromJulianDay(t).toString(Qt::ISODate)),
+                        inside ? "inside" : "outside");
+        }
+    }
+
+    double covered = 0.0;
+    for (const ElectionalSearch::Window& window : windows) covered += window.days();
+    std::printf("%-28s %4d windows %7.2f days  search %7.3f s (%8d ephemeris calls)"
+                "  minute scan %7.3f s  %d mismatches\n",
+                label, windows.size(), covered, searchSeconds, stats.ephemerisCalls,
+                scanSeconds, mismatches);
+    return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int days = argc > 1 ? std::max(1, std::atoi(argv[1])) : 30;
+
+    const QVector<Case> cases = {
+        {"Gaja Kesari, Moon+Jupiter", {"Gaja Kesari"}, {{Astro::Moon, 1.0}, {Astro::Jupiter, 1.0}}},
+        {"Sun+Venus", {}, {{Astro::Sun, 1.1}, {Astro::Venus, 0.9}}},
+        {"Budh-Aditya, Mars", {"Budh-Aditya"}, {{Astro::Mars, 1.05}}},
+        {"Raja Yoga+Sunapha", {"Raja Yoga", "Sunapha"}, {}},
+        {"Chandra-Mangal+Dhana, Mercury", {"Chandra-Mangal", "Dhana Yoga"}, {{Astro::Mercury, 1.0}}}
+    };
+
+    ElectionalSearch search(analyticLongitude);
+    int mismatches = 0;
+    for (const Case& c : cases) {
+        ElectionalSearch::Query query;
+        query.startDay = 2460310.5;     // 2024-01-01 00:00 UT
+        query.endDay = query.startDay + days;
+        query.yogas = ElectionalSearch::yogaMask(c.yogas);
+        query.strengths = c.strengths;
+        query.utcOffsetHours = 5.5;
+        mismatches += check(search, query, days, c.label);
+    }
+    return mismatches ? 1 : 0;
+}
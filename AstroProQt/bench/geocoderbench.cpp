@@ -0,0 +1,280 @@
+// Geocoder benchmark and check against a local stub of the OpenCage API.
+//
+// A QTcpServer answers each geocoding request after a fixed delay, with
+// coordinates derived from the normalized place, and counts the requests
+// and the most it had open at once. The geocoder is pointed at it and
+// checked for: one request per distinct place, shared by a batch and an
+// interactive lookup; no more requests on the network than
+// setMaxConcurrent(); answers from the cache until the time to live
+// passes; and silence from superseded and cancelled lookups, whose
+// requests are aborted unless someone else still waits on them. Prints
+// the batch times and exits 1 if any check fails.
+//
+//   geocoder_bench [places, default 200]
+
+#include "Location/gazetteer.h"
+#include "Location/geocoder.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHash>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrlQuery>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+const int DELAY_MS = 20;
+const int TIMEOUT_MS = 10000;
+
+// Coordinates the stub answers for a place; spellings with the same key agree
+double latitudeOf(const QString& place) {
+    return (qHash(Gazetteer::normalize(place)) % 18000) / 100.0 - 90.0;
+}
+
+double longitudeOf(const QString& place) {
+    return (qHash(Gazetteer::normalize(place)) / 18000 % 36000) / 100.0 - 180.0;
+}
+
+// GET <path>?q=<place> over keep-alive connections; "Nowhere" has no results
+class StubServer {
+public:
+    int requests = 0;
+    int open = 0;    // Received and not yet answered
+    int peak = 0;
+
+    StubServer() {
+        QObject::connect(&m_server, &QTcpServer::newConnection, [this]() {
+            while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+                accept(socket);
+            }
+        });
+    }
+
+    bool listen() { return m_server.listen(QHostAddress::LocalHost); }
+    QUrl url() const {
+        return QUrl(QString("http://127.0.0.1:%1/geocode/v1/json").arg(m_server.serverPort()));
+    }
+
+private:
+    void accept(QTcpSocket* socket) {
+        auto buffer = QSharedPointer<QByteArray>::create();
+        auto waiting = QSharedPointer<int>::create(0);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, buffer, waiting]() {
+            buffer->append(socket->readAll());
+            int end;
+            while ((end = buffer->indexOf("\r\n\r\n")) >= 0) {
+                const QByteArray head = buffer->left(end);
+                buffer->remove(0, end + 4);
+                request(socket, head, waiting);
+            }
+        });
+        // An aborted request closes its connection unanswered
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, [this, socket, waiting]() {
+            open -= *waiting;
+            *waiting = 0;
+            socket->deleteLater();
+        });
+    }
+
+    void request(QTcpSocket* socket, const QByteArray& head, QSharedPointer<int> waiting) {
+        // "GET /geocode/v1/json?q=...&key=... HTTP/1.1"
+        const QUrl target = QUrl::fromEncoded(head.split(' ').value(1));
+        const QString place = QUrlQuery(target).queryItemValue("q", QUrl::FullyDecoded);
+        ++requests;
+        ++*waiting;
+        peak = std::max(peak, ++open);
+
+        QPointer<QTcpSocket> guard(socket);
+        QTimer::singleShot(DELAY_MS, [this, guard, waiting, place]() {
+            if (!guard || guard->state() != QAbstractSocket::ConnectedState) return;
+            --*waiting;
+            --open;
+            guard->write(response(place));
+        });
+    }
+
+    static QByteArray response(const QString& place) {
+        const QByteArray body = place == "Nowhere"
+            ? QByteArray("{\"results\":[]}")
+            : QString("{\"results\":[{\"formatted\":\"%1\",\"geometry\":{\"lat\":%2,\"lng\":%3}}]}")
+                  .arg(place).arg(latitudeOf(place), 0, 'f', 2).arg(longitudeOf(place), 0, 'f', 2)
+                  .toUtf8();
+        return "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+               QByteArray::number(body.size()) + "\r\n\r\n" + body;
+    }
+
+    QTcpServer m_server;
+};
+
+// Answers the geocoder delivered, by id
+struct Answers {
+    QHash<quint64, Geocoder::Result> lookups;
+    QHash<quint64, QVector<Geocoder::Result>> batches;
+
+    explicit Answers(Geocoder& geocoder) {
+        QObject::connect(&geocoder, &Geocoder::finished,
+                         [this](quint64 id, const Geocoder::Result& result) { lookups[id] = result; });
+        QObject::connect(&geocoder, &Geocoder::batchFinished,
+                         [this](quint64 id, const QVector<Geocoder::Result>& results) {
+            batches[id] = results;
+        });
+    }
+};
+
+// Runs the event loop until done() or the timeout
+bool runUntil(const std::function<bool()>& done, int timeoutMs) {
+    QElapsedTimer timer;
+    timer.start();
+    while (!done() && timer.elapsed() < timeoutMs) {
+        QEventLoop loop;
+        QTimer::singleShot(5, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    return done();
+}
+
+void settle(int ms) {
+    runUntil([]() { return false; }, ms);
+}
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    std::printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) ++failures;
+}
+
+bool located(const Geocoder::Result& result) {
+    return result.ok() && result.found &&
+           qAbs(result.latitude - latitudeOf(result.query)) < 1e-6 &&
+           qAbs(result.longitude - longitudeOf(result.query)) < 1e-6;
+}
+
+bool allLocated(const QVector<Geocoder::Result>& results, int count) {
+    return results.size() == count &&
+           std::all_of(results.begin(), results.end(), located);
+}
+
+bool allCached(const QVector<Geocoder::Result>& results) {
+    return std::all_of(results.begin(), results.end(),
+                       [](const Geocoder::Result& result) { return result.cached; });
+}
+
+Geocoder::Result lookupOne(Geocoder& geocoder, Answers& answers, const QString& place) {
+    const quint64 id = geocoder.lookup(place);
+    runUntil([&]() { return answers.lookups.contains(id); }, TIMEOUT_MS);
+    return answers.lookups.value(id);
+}
+
+// A batch of distinct places under a concurrency limit, timed
+void timedBatch(Geocoder& geocoder, Answers& answers, StubServer& server,
+                const QString& prefix, int count, int limit) {
+    QStringList places;
+    for (int i = 0; i < count; ++i) {
+        places << QString("%1 %2").arg(prefix).arg(i + 1);
+    }
+    geocoder.setMaxConcurrent(limit);
+    const int before = server.requests;
+    server.peak = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    const quint64 id = geocoder.lookupBatch(places);
+    runUntil([&]() { return answers.batches.contains(id); }, TIMEOUT_MS + count * DELAY_MS);
+    const double ms = timer.nsecsElapsed() / 1e6;
+
+    std::printf("%d places, %d at a time: %8.1f ms, %d requests, at most %d open\n",
+                count, limit, ms, server.requests - before, server.peak);
+    check(allLocated(answers.batches.value(id), count), "every place of the batch located");
+    check(server.requests - before == count, "one request per place");
+    check(server.peak <= limit, "no more requests open than the limit");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+
+    StubServer server;
+    if (!server.listen()) {
+        std::printf("skipped: cannot listen on localhost\n");
+        return 0;
+    }
+    Geocoder geocoder;
+    geocoder.setEndpoint(server.url());
+    geocoder.setApiKey("stub");
+    Answers answers(geocoder);
+
+    // Spellings of one place, and an interactive lookup of a place the
+    // batch is already fetching, share requests
+    const quint64 batch = geocoder.lookupBatch({"Delhi", "delhi ", "Mumbai", "DELHI", "Pune", "Nowhere"});
+    const quint64 single = geocoder.lookup("Mumbai");
+    runUntil([&]() { return answers.batches.contains(batch) && answers.lookups.contains(single); },
+             TIMEOUT_MS);
+    const QVector<Geocoder::Result> shared = answers.batches.value(batch);
+    check(server.requests == 4, "identical places share one request");
+    check(shared.size() == 6 && located(shared[0]) && located(shared[1]) && located(shared[3]) &&
+          located(shared[2]) && located(shared[4]) && shared[5].ok() && !shared[5].found,
+          "batch answers in order, unknown place not found");
+    check(located(answers.lookups.value(single)), "lookup answered by the batch's request");
+
+    timedBatch(geocoder, answers, server, "Town", count, 2);
+    timedBatch(geocoder, answers, server, "Village", count, 6);
+
+    int before = server.requests;
+    QStringList towns;
+    for (int i = 0; i < count; ++i) {
+        towns << QString("Town %1").arg(i + 1);
+    }
+    const quint64 again = geocoder.lookupBatch(towns);
+    runUntil([&]() { return answers.batches.contains(again); }, TIMEOUT_MS);
+    check(server.requests == before && allCached(answers.batches.value(again)) &&
+          allLocated(answers.batches.value(again), count), "repeated batch answered from the cache");
+
+    // A lookup superseded by the next one stays silent and its request is
+    // aborted, so it is fetched again when asked for
+    geocoder.setMaxConcurrent(4);
+    const quint64 first = geocoder.lookup("Chennai");
+    const quint64 second = geocoder.lookup("Kolkata");
+    runUntil([&]() { return answers.lookups.contains(second); }, TIMEOUT_MS);
+    settle(5 * DELAY_MS);
+    check(!answers.lookups.contains(first) && located(answers.lookups.value(second)),
+          "superseded lookup stays silent");
+    before = server.requests;
+    const Geocoder::Result chennai = lookupOne(geocoder, answers, "Chennai");
+    check(located(chennai) && !chennai.cached && server.requests == before + 1,
+          "superseded request aborted before it was cached");
+
+    // A cancelled batch stays silent; a request another lookup waits on
+    // is kept for it
+    const quint64 cancelled = geocoder.lookupBatch({"Agra", "Jaipur", "Surat"});
+    const quint64 surat = geocoder.lookup("Surat");
+    geocoder.cancel(cancelled);
+    check(geocoder.pendingRequests() == 1, "cancel drops the requests nobody waits for");
+    runUntil([&]() { return answers.lookups.contains(surat); }, TIMEOUT_MS);
+    settle(5 * DELAY_MS);
+    check(!answers.batches.contains(cancelled) && located(answers.lookups.value(surat)),
+          "cancelled batch stays silent, shared request kept");
+
+    // Answers are cached until the time to live passes
+    before = server.requests;
+    const Geocoder::Result fresh = lookupOne(geocoder, answers, "Delhi");
+    check(located(fresh) && fresh.cached && server.requests == before, "cached answer within its time to live");
+    geocoder.setTimeToLive(1);
+    settle(1100);
+    const Geocoder::Result expired = lookupOne(geocoder, answers, "Delhi");
+    check(located(expired) && !expired.cached && server.requests == before + 1,
+          "expired answer fetched again");
+
+    std::printf("%d requests, %d failures\n", server.requests, failures);
+    return failures ? 1 : 0;
+}
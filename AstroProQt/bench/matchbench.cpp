@@ -0,0 +1,99 @@
+// Ashtakoota matching throughput benchmark.
+//
+// Fills a pool with reproducible Moon longitudes, checks the top matches of
+// a few seekers against an exhaustive ranking, then times top-K queries on
+// one thread and on all of them.
+//
+//   match_bench [pool size, default 1000000] [k, default 100]
+
+#include "Calculators/ashtakootamatcher.h"
+#include <QThread>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+AshtakootaPool makePool(int count) {
+    std::mt19937 rng(20240601u);
+    std::uniform_real_distribution<double> degree(0.0, 360.0);
+    AshtakootaPool pool;
+    pool.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        pool.append(degree(rng));
+    }
+    return pool;
+}
+
+// Exhaustive ranking: most points first, then pool order
+bool matchesExhaustive(const QVector<AshtakootaMatcher::Match>& matches, int seeker,
+                       AshtakootaMatcher::Role role, const AshtakootaPool& pool, int k) {
+    std::vector<std::pair<int, int>> ranked;
+    ranked.reserve(pool.size());
+    for (int i = 0; i < pool.size(); ++i) {
+        const int pada = pool.padas()[i];
+        const int points = role == AshtakootaMatcher::Groom
+            ? AshtakootaMatcher::halfPoints(seeker, pada)
+            : AshtakootaMatcher::halfPoints(pada, seeker);
+        ranked.emplace_back(-points, i);
+    }
+    const int expected = std::min<int>(k, int(ranked.size()));
+    std::partial_sort(ranked.begin(), ranked.begin() + expected, ranked.end());
+    if (matches.size() != expected) return false;
+    for (int i = 0; i < expected; ++i) {
+        if (int(matches[i].candidate) != ranked[i].second ||
+            -int(matches[i].halfPoints) != ranked[i].first) return false;
+    }
+    return true;
+}
+
+double timeQueries(AshtakootaMatcher& matcher, const AshtakootaPool& pool, int k, int queries) {
+    using Clock = std::chrono::steady_clock;
+    int checksum = 0;
+    const auto start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        const auto role = q % 2 ? AshtakootaMatcher::Groom : AshtakootaMatcher::Bride;
+        checksum += matcher.topMatches(q % AshtakootaMatcher::PADA_COUNT, role, pool, k).size();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (checksum == 0) std::printf("no matches\n");
+    return seconds;
+}
+
+void report(const char* label, double seconds, int pool, int queries) {
+    const double pairs = double(pool) * queries;
+    std::printf("%-12s %8.1f M pairs/s  %8.3f ms/query\n",
+                label, pairs / seconds / 1e6, seconds * 1e3 / queries);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000000;
+    const int k = argc > 2 ? std::max(1, std::atoi(argv[2])) : 100;
+    const int queries = 200;
+
+    const AshtakootaPool pool = makePool(count);
+    AshtakootaMatcher single(1);
+    AshtakootaMatcher parallel;
+
+    int mismatches = 0;
+    for (int seeker = 0; seeker < AshtakootaMatcher::PADA_COUNT; seeker += 13) {
+        for (auto role : {AshtakootaMatcher::Groom, AshtakootaMatcher::Bride}) {
+            if (!matchesExhaustive(parallel.topMatches(seeker, role, pool, k), seeker, role, pool, k)) {
+                ++mismatches;
+            }
+        }
+    }
+
+    report("1 thread", timeQueries(single, pool, k, queries), count, queries);
+    char label[32];
+    std::snprintf(label, sizeof(label), "%d threads", QThread::idealThreadCount());
+    report(label, timeQueries(parallel, pool, k, queries), count, queries);
+    std::printf("%d candidates, top %d, %d mismatches\n", count, k, mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+// Per-chart Shadbala latency benchmark.
+//
+// Generates a reproducible set of synthetic charts and times both the
+// QMap-based calculateAllStrengths() entry point and the raw
+// structure-of-arrays kernel, reporting per-chart latency percentiles.
+// First checks Cheshta Bala for every class of motion; exits 1 if any
+// differs from BPHS.
+
+#include "Calculators/strengthcalculator.h"
+#include <QDateTime>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct SyntheticChart {
+    QMap<QString, double> positions;
+    QVector<double> houses;
+    QDateTime birthTime;
+};
+
+std::vector<SyntheticChart> makeCorpus(int count) {
+    std::mt19937 rng(20240415u);
+    std::uniform_real_distribution<double> degree(0.0, 360.0);
+    std::uniform_int_distribution<qint64> seconds(0, 100LL * 365 * 86400);
+
+    std::vector<SyntheticChart> corpus(count);
+    for (SyntheticChart& chart : corpus) {
+        for (int p = 0; p < Astro::PlanetCount; ++p) {
+            chart.positions[Astro::planetName(p)] = degree(rng);
+        }
+        double ascendant = degree(rng);
+        for (int h = 0; h < 12; ++h) {
+            chart.houses.append(Astro::normalizeDegrees(ascendant + h * 30.0));
+        }
+        chart.birthTime = QDateTime::fromSecsSinceEpoch(
+            seconds(rng) - 50LL * 365 * 86400, Qt::UTC);
+    }
+    return corpus;
+}
+
+void report(const char* label, std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    auto percentile = [&](double q) {
+        return samples[static_cast<size_t>(q * (samples.size() - 1))];
+    };
+    std::printf("%-24s mean %8.0f ns  p50 %8.0f ns  p99 %8.0f ns  (%zu charts)\n",
+                label, sum / samples.size(), percentile(0.5), percentile(0.99),
+                samples.size());
+}
+
+// Cheshta Bala of Mars to Saturn at speeds of each motion class, as
+// multiples of the mean daily motion; returns the number of mismatches
+int checkCheshta(const StrengthCalculator& calculator) {
+    struct MotionClass {
+        const char* name;
+        double ratio;
+        double virupas;
+    };
+    const MotionClass classes[] = {
+        {"Vakra", -0.5, 60.0},
+        {"Vikala", 0.2, 15.0},
+        {"Manda", 0.7, 30.0},
+        {"Sama", 1.0, 7.5},
+        {"Chara", 1.3, 45.0},
+        {"Atichara", 2.0, 30.0},
+        {"unknown", std::numeric_limits<double>::quiet_NaN(), 0.0}
+    };
+    const double meanSpeed[Astro::SevenPlanets] = {
+        0.9856, 13.1764, 0.5240, 0.9856, 0.0831, 0.9856, 0.0335
+    };
+
+    QVector<double> houses;
+    for (int h = 0; h < 12; ++h) houses.append(h * 30.0);
+    const StrengthCalculator::ChartContext context =
+        StrengthCalculator::makeContext(houses, QDateTime());
+
+    int mismatches = 0;
+    for (const MotionClass& motion : classes) {
+        StrengthCalculator::ShadbalaBatch batch;
+        for (int p = 0; p < Astro::SevenPlanets; ++p) {
+            batch.longitude[p] = p * 40.0 + 5.0;
+            batch.speed[p] = motion.ratio * meanSpeed[p];
+        }
+        calculator.computeShadbala(batch, context);
+        for (int p = Astro::Mars; p < Astro::SevenPlanets; ++p) {
+            if (batch.cheshta[p] != motion.virupas) {
+                std::printf("Cheshta Bala of %s when %s: %.1f, expected %.1f\n",
+                            Astro::planetName(p), motion.name, batch.cheshta[p], motion.virupas);
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10000;
+    using Clock = std::chrono::steady_clock;
+
+    StrengthCalculator calculator;
+    if (checkCheshta(calculator)) return 1;
+
+    std::vector<SyntheticChart> corpus = makeCorpus(count);
+
+    std::vector<double> samples;
+    samples.reserve(count);
+    double checksum = 0.0;
+
+    for (const SyntheticChart& chart : corpus) {
+        auto start = Clock::now();
+        auto strengths = calculator.calculateAllStrengths(
+            chart.positions, chart.houses, chart.birthTime);
+        auto end = Clock::now();
+        checksum += strengths.value("Sun").shadbala;
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    report("calculateAllStrengths", samples);
+
+    samples.clear();
+    for (const SyntheticChart& chart : corpus) {
+        StrengthCalculator::ShadbalaBatch batch;
+        for (int p = 0; p < Astro::SevenPlanets; ++p) {
+            batch.longitude[p] = chart.positions.value(Astro::planetName(p));
+            batch.speed[p] = 1.0;
+        }
+        StrengthCalculator::ChartContext context =
+            StrengthCalculator::makeContext(chart.houses, chart.birthTime);
+
+        auto start = Clock::now();
+        calculator.computeShadbala(batch, context);
+        auto end = Clock::now();
+        checksum += batch.total[Astro::Sun];
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    report("computeShadbala (SoA)", samples);
+
+    std::printf("checksum %.3f\n", checksum);
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Ashtakavarga transit scoring benchmark and cross-check.
+//
+// Scores a run of days against a natal chart through transitDays() and
+// scoreTransits(), the way the chart service answers /transits, and again
+// day by day with one ephemeris call per planet and a direct lookup in the
+// natal tables. Every day's signs and scores must agree; exits 1 if any
+// differs.
+//
+//   transit_bench [days, default 3653]
+
+#include "Calculators/ashtakavargacalculator.h"
+#include "siderealephemeris.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+double seconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 3653;
+    using Clock = std::chrono::steady_clock;
+
+#ifdef EPHE_PATH
+    SiderealEphemeris::setUp(EPHE_PATH);
+#else
+    SiderealEphemeris::setUp();
+#endif
+
+    // Natal chart: 1990-06-15 12:00 UT at Delhi
+    const double birthDay = 2448058.0;
+    QMap<QString, double> natalPositions;
+    for (int p = 0; p < Astro::SevenPlanets; ++p) {
+        double longitude;
+        QString error;
+        if (!SiderealEphemeris::longitude(birthDay, p, &longitude, &error)) {
+            std::printf("skipped: %s\n", qPrintable(error));
+            return 0;
+        }
+        natalPositions[Astro::planetName(p)] = longitude;
+    }
+    AshtakavargaCalculator calculator;
+    const AshtakavargaCalculator::Ashtakavarga natal = calculator.calculate(
+        natalPositions, SiderealEphemeris::ascendant(birthDay, 28.61, 77.21));
+
+    const double startDay = 2460310.5;  // 2024-01-01 00:00 UT
+    int calls = 0;
+    auto start = Clock::now();
+    const QVector<AshtakavargaCalculator::TransitDay> days = AshtakavargaCalculator::transitDays(
+        [&calls](int planet, double julianDay) {
+            double longitude = 0.0;
+            QString error;
+            ++calls;
+            SiderealEphemeris::longitude(julianDay, planet, &longitude, &error);
+            return longitude;
+        },
+        startDay, count);
+    const QVector<AshtakavargaCalculator::TransitScore> scores = calculator.scoreTransits(natal, days);
+    const double yearSeconds = seconds(Clock::now() - start);
+
+    // Day by day: every planet looked up and scored on its own
+    int mismatches = 0;
+    start = Clock::now();
+    for (int d = 0; d < count; ++d) {
+        const AshtakavargaCalculator::TransitScore& score = scores[d];
+        int total = 0;
+        int favourable = 0;
+        bool same = true;
+        for (int p = 0; p < Astro::SevenPlanets; ++p) {
+            double longitude = 0.0;
+            QString error;
+            SiderealEphemeris::longitude(startDay + d, p, &longitude, &error);
+            const int sign = Astro::signOf(longitude);
+            const int bindus = natal.bhinna[p][sign];
+            total += bindus;
+            if (bindus >= 4) favourable |= 1 << p;
+            same = same && days[d].sign[p] == sign && score.bindus[p] == bindus &&
+                   score.sarva[p] == natal.sarva[sign];
+        }
+        same = same && score.total == total && score.favourable == favourable;
+        if (!same && ++mismatches <= 10) {
+            std::printf("mismatch on day %d\n", d);
+        }
+    }
+    const double dailySeconds = seconds(Clock::now() - start);
+
+    std::printf("transitDays + scoreTransits  %8.3f ms  %7d ephemeris calls\n",
+                yearSeconds * 1e3, calls);
+    std::printf("day by day                   %8.3f ms  %7d ephemeris calls\n",
+                dailySeconds * 1e3, count * Astro::SevenPlanets);
+    std::printf("%d days, %d mismatches\n", count, mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+// Bulk yoga detection throughput benchmark.
+//
+// Builds a reproducible corpus of synthetic charts, then evaluates every
+// yoga with the per-chart YogaProgram interpreter and with the SIMD scan
+// over a column-major SignatureBatch, checking that both agree.
+
+#include "Calculators/chartsignature.h"
+#include "Calculators/yogacalculator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<ChartFeatures> makeCorpus(int count) {
+    std::mt19937 rng(20240501u);
+    std::uniform_real_distribution<double> degree(0.0, 360.0);
+    VargaCalculator vargaCalculator;
+
+    std::vector<ChartFeatures> corpus;
+    corpus.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QMap<QString, double> positions;
+        for (int p = 0; p < Astro::PlanetCount; ++p) {
+            positions[Astro::planetName(p)] = degree(rng);
+        }
+        const double ascendant = degree(rng);
+        QVector<double> houses;
+        for (int h = 0; h < 12; ++h) {
+            houses.append(Astro::normalizeDegrees(ascendant + h * 30.0));
+        }
+
+        AspectMatrix aspects;
+        aspects.build(positions, houses);
+        corpus.push_back(ChartFeatures::build(aspects, vargaCalculator.calculate(positions, ascendant)));
+    }
+    return corpus;
+}
+
+void report(const char* label, double seconds, int count) {
+    std::printf("%-24s %10.0f charts/s  %8.1f ns/chart\n",
+                label, count / seconds, seconds * 1e9 / count);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<ChartFeatures> corpus = makeCorpus(count);
+    const YogaProgram& program = YogaCalculator::program();
+
+    SignatureBatch batch;
+    batch.reserve(count);
+    auto start = Clock::now();
+    for (const ChartFeatures& features : corpus) {
+        batch.append(ChartSignature::fromFeatures(features));
+    }
+    report("signature build", std::chrono::duration<double>(Clock::now() - start).count(), count);
+
+    std::vector<quint64> interpreted;
+    interpreted.reserve(count);
+    start = Clock::now();
+    for (const ChartFeatures& features : corpus) {
+        interpreted.push_back(program.evaluateAll(features)[0]);
+    }
+    report("YogaProgram", std::chrono::duration<double>(Clock::now() - start).count(), count);
+
+    SignatureProgram signatureProgram(program);
+    start = Clock::now();
+    const QVector<quint64> scanned = signatureProgram.evaluate(batch);
+    report("SignatureProgram batch", std::chrono::duration<double>(Clock::now() - start).count(), count);
+
+    // Single-word rule sets compare chart for chart, over the lowered rules
+    quint64 lowered = 0;
+    for (int rule = 0; rule < signatureProgram.ruleCount() && rule < 64; ++rule) {
+        if (signatureProgram.isLowered(rule)) lowered |= quint64(1) << rule;
+    }
+    int mismatches = 0;
+    for (int i = 0; i < count; ++i) {
+        if (scanned[i * signatureProgram.wordsPerChart()] != (interpreted[i] & lowered)) ++mismatches;
+    }
+    std::printf("%d rules, %d ops, %d mismatches\n",
+                signatureProgram.ruleCount(), signatureProgram.opCount(), mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+#include "chartlist.h"
+#include "siderealephemeris.h"
+#include "Calculators/planetdata.h"
+#include "Location/geocoder.h"
+#include "Location/timezoneindex.h"
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+
+namespace {
+
+// Fields as given; located is false for a chart that names its place but
+// has no coordinates. A time without an offset stays in Qt::LocalTime
+// until it is placed in the birthplace's zone
+bool readEntry(const QJsonObject& json, ChartList::Entry* entry, bool* located, QString* error) {
+    entry->name = json["name"].toString();
+    entry->birthPlace = json["place"].toString();
+    entry->birthTime = QDateTime::fromString(json["time"].toString(), Qt::ISODateWithMs);
+    if (!entry->birthTime.isValid()) {
+        *error = "\"time\" must be an ISO 8601 date and time";
+        return false;
+    }
+    *located = json.contains("latitude") || json.contains("longitude") ||
+               entry->birthPlace.trimmed().isEmpty();
+    entry->latitude = json["latitude"].toDouble();
+    entry->longitude = json["longitude"].toDouble();
+    if (qAbs(entry->latitude) > 90.0 || qAbs(entry->longitude) > 180.0) {
+        *error = "\"latitude\" or \"longitude\" is out of range";
+        return false;
+    }
+
+    const QJsonObject positions = json["positions"].toObject();
+    for (auto it = positions.constBegin(); it != positions.constEnd(); ++it) {
+        if (Astro::planetIndex(it.key()) < 0 || !it.value().isDouble()) {
+            *error = QString("\"positions\" has an unknown planet or a non-numeric longitude: %1")
+                         .arg(it.key());
+            return false;
+        }
+        entry->planetPositions[it.key()] = Astro::normalizeDegrees(it.value().toDouble());
+    }
+    return true;
+}
+
+// Ephemeris longitudes and houses, once the chart is placed
+bool completeEntry(const QJsonObject& json, ChartList::Entry* entry, QString* error) {
+    const double day = SiderealEphemeris::julianDay(entry->birthTime);
+    for (int p = 0; p < Astro::PlanetCount; ++p) {
+        const QString name = Astro::planetName(p);
+        if (entry->planetPositions.contains(name)) continue;
+        double longitude;
+        double speed;
+        if (!SiderealEphemeris::longitude(day, p, &longitude, error) ||
+            !SiderealEphemeris::speed(day, p, &speed, error)) {
+            return false;
+        }
+        entry->planetPositions[name] = longitude;
+        entry->planetSpeeds[name] = speed;
+    }
+
+    const double ascendant = json["ascendant"].isDouble()
+        ? Astro::normalizeDegrees(json["ascendant"].toDouble())
+        : SiderealEphemeris::ascendant(day, entry->latitude, entry->longitude);
+    for (int h = 0; h < 12; ++h) {
+        entry->housePositions.append(Astro::normalizeDegrees(ascendant + h * 30.0));
+    }
+    return true;
+}
+
+// Coordinates for the charts at the given indexes, geocoded in one batch
+bool locate(QVector<ChartList::Entry>* entries, const QVector<int>& unlocated,
+            Geocoder* geocoder, const QString& filePath, QString* error) {
+    QStringList places;
+    for (int i : unlocated) {
+        places << (*entries)[i].birthPlace;
+    }
+
+    // Answers always arrive from the event loop, so the id is known by then
+    QVector<Geocoder::Result> results;
+    quint64 batch = 0;
+    QEventLoop loop;
+    QObject::connect(geocoder, &Geocoder::batchFinished, &loop,
+                     [&](quint64 id, const QVector<Geocoder::Result>& answers) {
+        if (id != batch) return;
+        results = answers;
+        loop.quit();
+    });
+    batch = geocoder->lookupBatch(places);
+    loop.exec();
+
+    for (int k = 0; k < unlocated.size(); ++k) {
+        const Geocoder::Result& result = results[k];
+        ChartList::Entry& entry = (*entries)[unlocated[k]];
+        if (!result.ok() || !result.found) {
+            *error = QString("%1: chart %2: cannot locate \"%3\": %4")
+                         .arg(filePath).arg(unlocated[k] + 1)
+                         .arg(entry.birthPlace, result.ok() ? QString("place not found") : result.error);
+            return false;
+        }
+        entry.latitude = result.latitude;
+        entry.longitude = result.longitude;
+    }
+    return true;
+}
+
+// Wall clock times at the given indexes to UTC in the birthplace's zone
+bool resolveZones(QVector<ChartList::Entry>* entries, const QVector<int>& unzoned,
+                  const TimeZoneIndex& zones, const QString& filePath, QString* error) {
+    QVector<TimeZoneIndex::Query> queries;
+    queries.reserve(unzoned.size());
+    for (int i : unzoned) {
+        const ChartList::Entry& entry = (*entries)[i];
+        const TimeZoneIndex::Query query = {entry.latitude, entry.longitude,
+                                            entry.birthTime.date(), entry.birthTime.time()};
+        queries.append(query);
+    }
+
+    const QVector<TimeZoneIndex::Resolution> resolutions = zones.resolve(queries);
+    for (int k = 0; k < unzoned.size(); ++k) {
+        if (!resolutions[k].isValid()) {
+            *error = QString("%1: chart %2: cannot place \"time\" in a time zone")
+                         .arg(filePath).arg(unzoned[k] + 1);
+            return false;
+        }
+        (*entries)[unzoned[k]].birthTime = resolutions[k].utc;
+    }
+    return true;
+}
+
+} // namespace
+
+bool ChartList::load(const QString& filePath, QVector<Entry>* entries, QString* error,
+                     Geocoder* geocoder, const TimeZoneIndex* zones) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("Cannot read %1: %2").arg(filePath, file.errorString());
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isArray()) {
+        *error = parseError.error != QJsonParseError::NoError
+            ? QString("%1: %2").arg(filePath, parseError.errorString())
+            : QString("%1: expected a JSON array of charts").arg(filePath);
+        return false;
+    }
+
+    const QJsonArray charts = document.array();
+    entries->clear();
+    entries->reserve(charts.size());
+    QVector<int> unlocated;
+    QVector<int> unzoned;
+    for (int i = 0; i < charts.size(); ++i) {
+        Entry entry;
+        bool located;
+        QString entryError;
+        if (!readEntry(charts[i].toObject(), &entry, &located, &entryError)) {
+            *error = QString("%1: chart %2: %3").arg(filePath).arg(i + 1).arg(entryError);
+            return false;
+        }
+        if (!located) {
+            unlocated.append(i);
+        }
+        if (entry.birthTime.timeSpec() == Qt::LocalTime) {
+            unzoned.append(i);
+        }
+        entries->append(entry);
+    }
+
+    if (!unlocated.isEmpty()) {
+        if (!geocoder) {
+            *error = QString("%1: chart %2: \"latitude\" and \"longitude\" are missing")
+                         .arg(filePath).arg(unlocated.first() + 1);
+            return false;
+        }
+        if (!locate(entries, unlocated, geocoder, filePath, error)) {
+            return false;
+        }
+    }
+
+    if (!unzoned.isEmpty()) {
+        if (!zones || !zones->isOpen()) {
+            *error = QString("%1: chart %2: \"time\" has no UTC offset and no time zone index is open")
+                         .arg(filePath).arg(unzoned.first() + 1);
+            return false;
+        }
+        if (!resolveZones(entries, unzoned, *zones, filePath, error)) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < charts.size(); ++i) {
+        QString entryError;
+        if (!completeEntry(charts[i].toObject(), &(*entries)[i], &entryError)) {
+            *error = QString("%1: chart %2: %3").arg(filePath).arg(i + 1).arg(entryError);
+            return false;
+        }
+    }
+    return true;
+}
+
+QString ChartList::outputPath(const QString& directory, int index, const Entry& entry,
+                              const QString& suffix) {
+    QString name = entry.name.trimmed();
+    name.replace(QRegularExpression("[^\\w.-]+"), "_");
+    const QString base = name.isEmpty() ? QString::number(index + 1)
+                                        : QString("%1-%2").arg(index + 1).arg(name);
+    return QDir(directory).filePath(base + "." + suffix);
+}
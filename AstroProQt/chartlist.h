@@ -0,0 +1,46 @@
+#ifndef CHARTLIST_H
+#define CHARTLIST_H
+
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+class Geocoder;
+class TimeZoneIndex;
+
+// Charts for the headless batch modes, read from a JSON array of objects:
+//
+//   {"name": "...", "time": "1990-04-12T06:30:00+05:30", "place": "...",
+//    "latitude": 28.61, "longitude": 77.21}
+//
+// Charts with a "place" but no "latitude" and "longitude" are located by
+// the geocoder, all in one batch. Times without a UTC offset are the wall
+// clock at the birthplace and are resolved through the time zone index,
+// also in one batch, before the ephemeris is read. Longitudes missing from an
+// optional "positions" object, and the ascendant unless "ascendant" is
+// given, come from the Swiss Ephemeris; houses are equal from the
+// ascendant.
+class ChartList {
+public:
+    struct Entry {
+        QString name;
+        QDateTime birthTime;
+        QString birthPlace;
+        double latitude;
+        double longitude;
+        QMap<QString, double> planetPositions;
+        QMap<QString, double> planetSpeeds;   // Bodies taken from the ephemeris only
+        QVector<double> housePositions;
+    };
+
+    // Without a geocoder or an open index, charts that need one are an error
+    static bool load(const QString& filePath, QVector<Entry>* entries, QString* error,
+                     Geocoder* geocoder = nullptr, const TimeZoneIndex* zones = nullptr);
+
+    // "<index>-<name>.<suffix>" in a directory, safe as a file name
+    static QString outputPath(const QString& directory, int index, const Entry& entry,
+                              const QString& suffix);
+};
+
+#endif // CHARTLIST_H
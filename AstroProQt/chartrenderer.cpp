@@ -0,0 +1,334 @@
+#include "chartrenderer.h"
+#include <QFileInfo>
+#include <QFontMetricsF>
+#include <QImage>
+#include <QSvgGenerator>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+ChartRenderer::Chart ChartRenderer::Chart::build(const QMap<QString, double>& planetPositions,
+                                                 const QVector<double>& housePositions) {
+    Chart chart;
+    chart.planetPositions = planetPositions;
+    chart.housePositions = housePositions;
+    chart.aspects.build(planetPositions, housePositions);
+    chart.vargas = VargaCalculator().calculate(
+        planetPositions, housePositions.isEmpty() ? 0.0 : housePositions[0]);
+    return chart;
+}
+
+ChartRenderer::ChartRenderer()
+    : m_houseFont("Arial", HOUSE_NUMBER_SIZE)
+    , m_planetFont("Arial", PLANET_SYMBOL_SIZE)
+    , m_chart(nullptr)
+{
+    m_planetSymbols = {
+        {"Sun", "☉"},
+        {"Moon", "☽"},
+        {"Mars", "♂"},
+        {"Mercury", "☿"},
+        {"Jupiter", "♃"},
+        {"Venus", "♀"},
+        {"Saturn", "♄"},
+        {"Rahu", "☊"},
+        {"Ketu", "☋"}
+    };
+    
+    m_planetColors = {
+        {"Sun", QColor(255, 128, 0)},    // Orange
+        {"Moon", QColor(192, 192, 192)},  // Silver
+        {"Mars", QColor(255, 0, 0)},      // Red
+        {"Mercury", QColor(0, 255, 0)},   // Green
+        {"Jupiter", QColor(255, 255, 0)}, // Yellow
+        {"Venus", QColor(128, 0, 128)},   // Purple
+        {"Saturn", QColor(0, 0, 128)},    // Dark Blue
+        {"Rahu", QColor(128, 128, 128)},  // Gray
+        {"Ketu", QColor(64, 64, 64)}      // Dark Gray
+    };
+    
+    // Shape every label the chart can show before the first paint
+    const QFontMetricsF planetMetrics(m_planetFont);
+    for (const QString& symbol : m_planetSymbols) {
+        m_glyphs.prepare(symbol, m_planetFont);
+        m_planetGlyphSize = m_planetGlyphSize.expandedTo(planetMetrics.boundingRect(symbol).size());
+    }
+    for (int house = 1; house <= 12; ++house) {
+        m_glyphs.prepare(QString::number(house), m_houseFont);
+    }
+}
+
+void ChartRenderer::render(QPainter& painter, const QSizeF& size, const Chart& chart,
+                           int layers) {
+    m_chartRect = chartRect(size);
+    m_chart = &chart;
+    
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing);
+    
+    if (layers & FrameLayer) {
+        // Draw chart based on style
+        if (m_options.style == NorthIndian) {
+            drawNorthIndianChart(painter);
+        } else {
+            drawSouthIndianChart(painter);
+        }
+    }
+    
+    if (layers & DataLayer) {
+        // Draw aspects if enabled; they are measured in the rasi chart only
+        if (m_options.showAspects && m_options.varga == VargaCalculator::D1) {
+            drawAspects(painter);
+        }
+        drawPlanets(painter);
+    }
+    
+    painter.restore();
+    m_chart = nullptr;
+}
+
+namespace {
+
+// Bit of the graha pair i < j in Placement::aspectLines, 36 in all
+inline int pairBit(int i, int j) {
+    return i * (2 * Astro::PlanetCount - i - 1) / 2 + (j - i - 1);
+}
+
+} // namespace
+
+quint16 ChartRenderer::Placement::joinedBodies() const {
+    quint16 bodies = 0;
+    for (int i = 0; i < Astro::PlanetCount; ++i) {
+        for (int j = i + 1; j < Astro::PlanetCount; ++j) {
+            if ((aspectLines >> pairBit(i, j)) & 1u) bodies |= (1u << i) | (1u << j);
+        }
+    }
+    return bodies;
+}
+
+ChartRenderer::Placement ChartRenderer::placement(const Chart& chart) const {
+    // Mirrors drawPlanets(), drawAspects() and drawHouseNumbers()
+    Placement placement;
+    for (int p = 0; p < Astro::PlanetCount; ++p) {
+        const auto it = chart.planetPositions.constFind(Astro::planetName(p));
+        placement.bodyCell[p] = it == chart.planetPositions.constEnd() ? -1
+            : qint8(static_cast<int>(displayLongitude(chart, p, it.value()) / 30));
+    }
+
+    const bool inVarga = m_options.varga != VargaCalculator::D1 && chart.vargas.valid;
+    const int vargaLagna = chart.vargas.signOf(m_options.varga, VargaCalculator::Ascendant);
+    for (int i = 0; i < 12; ++i) {
+        placement.houseCell[i] = chart.housePositions.size() < 12 ? -1
+            : inVarga ? qint8((vargaLagna + i) % 12)
+                      : qint8(static_cast<int>(chart.housePositions[i] / 30));
+    }
+
+    placement.aspectLines = 0;
+    const AspectMatrix& aspects = chart.aspects;
+    if (m_options.showAspects && m_options.varga == VargaCalculator::D1) {
+        const int bodies = std::min<int>(aspects.bodyCount(), Astro::PlanetCount);
+        for (int i = 0; i < bodies; ++i) {
+            if (!aspects.contains(i)) continue;
+            for (int j = i + 1; j < bodies; ++j) {
+                if (aspects.contains(j) && (aspects.flags(i, j) & AspectMatrix::MajorAspects)) {
+                    placement.aspectLines |= quint64(1) << pairBit(i, j);
+                }
+            }
+        }
+    }
+    return placement;
+}
+
+QRectF ChartRenderer::cellRect(const QSizeF& size, int cell) const {
+    // A little margin for antialiased edges
+    const QSizeF extent = m_planetGlyphSize + QSizeF(4, 4);
+    const QPointF center = cellCenter(chartRect(size), cell);
+    return QRectF(center - QPointF(extent.width() / 2, extent.height() / 2), extent);
+}
+
+bool ChartRenderer::exportFile(const QString& filePath, const QSize& size, const Chart& chart,
+                               qreal scale, const QColor& background) {
+    if (QFileInfo(filePath).suffix().compare("svg", Qt::CaseInsensitive) == 0) {
+        QSvgGenerator generator;
+        generator.setFileName(filePath);
+        generator.setSize(size);
+        generator.setViewBox(QRect(QPoint(0, 0), size));
+        generator.setTitle(QFileInfo(filePath).completeBaseName());
+        
+        QPainter painter;
+        if (!painter.begin(&generator)) return false;
+        painter.fillRect(QRect(QPoint(0, 0), size), background);
+        render(painter, size, chart);
+        return painter.end();
+    }
+    
+    // Laid out at the logical size and rasterized at the requested scale
+    QImage image(size * scale, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(scale);
+    image.fill(background);
+    
+    QPainter painter(&image);
+    render(painter, size, chart);
+    painter.end();
+    
+    return image.save(filePath);
+}
+
+void ChartRenderer::drawNorthIndianChart(QPainter& painter) {
+    const QRectF& chartRect = m_chartRect;
+    
+    // Draw outer square
+    painter.setPen(QPen(Qt::black, 2));
+    painter.drawRect(chartRect);
+    
+    // Draw diagonal lines
+    painter.drawLine(chartRect.topLeft(), chartRect.bottomRight());
+    painter.drawLine(chartRect.topRight(), chartRect.bottomLeft());
+    
+    // Draw inner square
+    double innerSize = chartRect.width() * 0.5;
+    QRectF innerRect(
+        chartRect.center().x() - innerSize/2,
+        chartRect.center().y() - innerSize/2,
+        innerSize, innerSize
+    );
+    painter.drawRect(innerRect);
+    
+    // Draw house numbers
+    drawHouseNumbers(painter);
+}
+
+void ChartRenderer::drawSouthIndianChart(QPainter& painter) {
+    const QRectF& chartRect = m_chartRect;
+    
+    // Draw main grid (3x3)
+    double cellWidth = chartRect.width() / 3;
+    double cellHeight = chartRect.height() / 3;
+    
+    painter.setPen(QPen(Qt::black, 2));
+    
+    // Draw horizontal lines
+    for (int i = 0; i <= 3; ++i) {
+        painter.drawLine(
+            QPointF(chartRect.left(), chartRect.top() + i * cellHeight),
+            QPointF(chartRect.right(), chartRect.top() + i * cellHeight)
+        );
+    }
+    
+    // Draw vertical lines
+    for (int i = 0; i <= 3; ++i) {
+        painter.drawLine(
+            QPointF(chartRect.left() + i * cellWidth, chartRect.top()),
+            QPointF(chartRect.left() + i * cellWidth, chartRect.bottom())
+        );
+    }
+    
+    // Draw house numbers
+    drawHouseNumbers(painter);
+}
+
+void ChartRenderer::drawPlanets(QPainter& painter) {
+    painter.setFont(m_planetFont);
+    for (auto it = m_chart->planetPositions.constBegin(); 
+         it != m_chart->planetPositions.constEnd(); ++it) {
+        
+        const QString& planet = it.key();
+        double longitude = displayLongitude(*m_chart, Astro::planetIndex(planet), it.value());
+        
+        QPointF pos = calculatePlanetPosition(longitude);
+        
+        // Draw planet symbol
+        painter.setPen(m_planetColors.value(planet));
+        m_glyphs.drawCentered(painter, pos, m_planetSymbols.value(planet), m_planetFont);
+    }
+}
+
+void ChartRenderer::drawAspects(QPainter& painter) {
+    const AspectMatrix& aspects = m_chart->aspects;
+    QPen aspectPen(Qt::gray, 1, Qt::DashLine);
+    painter.setPen(aspectPen);
+
+    for (int i = 0; i < aspects.bodyCount(); ++i) {
+        if (!aspects.contains(i)) continue;
+        
+        for (int j = i + 1; j < aspects.bodyCount(); ++j) {
+            // Sextile, square, trine or opposition within the matrix orb
+            if (!aspects.contains(j) ||
+                !(aspects.flags(i, j) & AspectMatrix::MajorAspects)) continue;
+            
+            QPointF pos1 = calculatePlanetPosition(aspects.longitude(i));
+            QPointF pos2 = calculatePlanetPosition(aspects.longitude(j));
+            
+            // Draw aspect line
+            painter.drawLine(pos1, pos2);
+        }
+    }
+}
+
+void ChartRenderer::drawHouseNumbers(QPainter& painter) {
+    if (m_chart->housePositions.size() < 12) return;
+    
+    painter.setPen(Qt::black);
+    painter.setFont(m_houseFont);
+    
+    // Divisional charts use whole-sign houses from the varga ascendant
+    const int varga = m_options.varga;
+    const bool inVarga = varga != VargaCalculator::D1 && m_chart->vargas.valid;
+    const int vargaLagna = m_chart->vargas.signOf(varga, VargaCalculator::Ascendant);
+    
+    for (int i = 0; i < 12; ++i) {
+        double longitude = inVarga ? ((vargaLagna + i) % 12) * 30.0 + 15.0
+                                   : m_chart->housePositions[i];
+        QPointF pos = calculatePlanetPosition(longitude);
+        m_glyphs.drawCentered(painter, pos, QString::number(i + 1), m_houseFont);
+    }
+}
+
+QRectF ChartRenderer::chartRect(const QSizeF& size) {
+    const double side = std::min(size.width(), size.height()) - 2 * CHART_PADDING;
+    return QRectF((size.width() - side) / 2, (size.height() - side) / 2, side, side);
+}
+
+QPointF ChartRenderer::calculatePlanetPosition(double longitude) const {
+    return cellCenter(m_chartRect, static_cast<int>(longitude / 30));
+}
+
+QPointF ChartRenderer::cellCenter(const QRectF& chartRect, int cell) const {
+    const int house = cell + 1;
+    
+    if (m_options.style == NorthIndian) {
+        // Calculate position in North Indian style
+        double radius = chartRect.width() * 0.25;
+        
+        // Adjust angle based on house position
+        double angle = (house - 1) * 30.0;
+        angle = qDegreesToRadians(angle);
+        
+        return QPointF(
+            chartRect.center().x() + radius * std::cos(angle),
+            chartRect.center().y() + radius * std::sin(angle)
+        );
+    } else {
+        // Calculate position in South Indian style
+        double cellWidth = chartRect.width() / 3;
+        double cellHeight = chartRect.height() / 3;
+        
+        // Convert house number to grid position
+        int row = (house - 1) / 3;
+        int col = (house - 1) % 3;
+        
+        return QPointF(
+            chartRect.left() + (col + 0.5) * cellWidth,
+            chartRect.top() + (row + 0.5) * cellHeight
+        );
+    }
+}
+
+double ChartRenderer::displayLongitude(const Chart& chart, int body, double longitude) const {
+    // In a divisional chart a body is drawn in the middle of its varga sign
+    if (m_options.varga == VargaCalculator::D1 || body < 0 ||
+        !chart.vargas.contains(body)) {
+        return longitude;
+    }
+    return chart.vargas.signOf(m_options.varga, body) * 30.0 + 15.0;
+}
@@ -0,0 +1,114 @@
+#ifndef CHARTRENDERER_H
+#define CHARTRENDERER_H
+
+#include <QColor>
+#include <QFont>
+#include <QMap>
+#include <QPainter>
+#include <QSize>
+#include <QVector>
+#include "glyphcache.h"
+#include "Calculators/aspectmatrix.h"
+#include "Calculators/vargacalculator.h"
+
+// Draws a chart into any QPainter, independent of a widget. A renderer owns
+// its glyph cache and is not shared between threads; give each worker its
+// own instance.
+class ChartRenderer {
+public:
+    enum ChartStyle {
+        NorthIndian,
+        SouthIndian
+    };
+
+    enum Layer {
+        FrameLayer = 0x1,   // Grid and house numbers
+        DataLayer = 0x2,    // Aspect lines and planets
+        AllLayers = FrameLayer | DataLayer
+    };
+
+    // Positions and the matrices derived from them
+    struct Chart {
+        QMap<QString, double> planetPositions;
+        QVector<double> housePositions;
+        AspectMatrix aspects;
+        VargaCalculator::VargaMatrix vargas;
+
+        // Derive the aspect and varga matrices from positions alone
+        static Chart build(const QMap<QString, double>& planetPositions,
+                           const QVector<double>& housePositions);
+    };
+
+    // Cell (0-11) each element of a chart is drawn in under the current
+    // options. For charts of the nine grahas, equal body cells and aspect
+    // lines give the same data layer, and equal house cells the same frame.
+    struct Placement {
+        qint8 bodyCell[Astro::PlanetCount];   // -1 when absent
+        qint8 houseCell[12];                  // -1 without houses
+        quint64 aspectLines;                  // Bit per graha pair joined by a line
+
+        // Bodies at either end of an aspect line
+        quint16 joinedBodies() const;
+    };
+
+    struct Options {
+        ChartStyle style;
+        int varga;          // VargaCalculator::Varga
+        bool showAspects;
+
+        Options() : style(NorthIndian), varga(VargaCalculator::D1), showAspects(true) {}
+    };
+
+    ChartRenderer();
+
+    void setOptions(const Options& options) { m_options = options; }
+    const Options& options() const { return m_options; }
+
+    // Draw over the rectangle (0, 0, size) in painter coordinates
+    void render(QPainter& painter, const QSizeF& size, const Chart& chart,
+                int layers = AllLayers);
+
+    // Cells of the bodies and houses and the aspect lines drawn, under the
+    // current options
+    Placement placement(const Chart& chart) const;
+    // Area a cell's planet glyphs cover in render() coordinates
+    QRectF cellRect(const QSizeF& size, int cell) const;
+
+    // Write a PNG/JPG or, for a .svg path, an SVG file. Raster images are
+    // size * scale pixels with the layout of a size-sized chart.
+    bool exportFile(const QString& filePath, const QSize& size, const Chart& chart,
+                    qreal scale = 1.0, const QColor& background = Qt::white);
+
+    GlyphCache& glyphs() { return m_glyphs; }
+    const GlyphCache& glyphs() const { return m_glyphs; }
+
+private:
+    void drawNorthIndianChart(QPainter& painter);
+    void drawSouthIndianChart(QPainter& painter);
+    void drawPlanets(QPainter& painter);
+    void drawAspects(QPainter& painter);
+    void drawHouseNumbers(QPainter& painter);
+
+    static QRectF chartRect(const QSizeF& size);
+    QPointF cellCenter(const QRectF& chartRect, int cell) const;
+    QPointF calculatePlanetPosition(double longitude) const;
+    double displayLongitude(const Chart& chart, int body, double longitude) const;
+
+    Options m_options;
+    QMap<QString, QString> m_planetSymbols;
+    QMap<QString, QColor> m_planetColors;
+    QFont m_houseFont;
+    QFont m_planetFont;
+    QSizeF m_planetGlyphSize;   // Largest planet symbol
+    GlyphCache m_glyphs;
+
+    // Set for the duration of render()
+    const Chart* m_chart;
+    QRectF m_chartRect;
+
+    static const int CHART_PADDING = 20;
+    static const int HOUSE_NUMBER_SIZE = 12;
+    static const int PLANET_SYMBOL_SIZE = 14;
+};
+
+#endif // CHARTRENDERER_H
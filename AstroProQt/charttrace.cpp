@@ -0,0 +1,140 @@
+#include "charttrace.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <QPair>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+
+// Innermost open scope and trace id of the calling thread
+thread_local ChartTrace::Scope* currentScope = nullptr;
+thread_local int currentThread = -1;
+
+QString jsonString(const char* text) {
+    QString escaped = QString::fromUtf8(text);
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"");
+    return "\"" + escaped + "\"";
+}
+
+} // namespace
+
+ChartTrace::Scope::Scope(const char* category, const char* name)
+    : m_category(category)
+    , m_name(name)
+    , m_start(ChartTrace::instance().now())
+    , m_children(0)
+    , m_parent(currentScope) {
+    currentScope = this;
+}
+
+ChartTrace::Scope::~Scope() {
+    ChartTrace& trace = ChartTrace::instance();
+    const qint64 duration = trace.now() - m_start;
+    currentScope = m_parent;
+    if (m_parent) {
+        m_parent->m_children += duration;
+    }
+    trace.record({m_name, m_category, 0, 0, m_start, duration, duration - m_children});
+}
+
+ChartTrace::ChartTrace()
+    : m_generation(0)
+    , m_threads(0) {
+    m_clock.start();
+}
+
+ChartTrace& ChartTrace::instance() {
+    static ChartTrace trace;
+    return trace;
+}
+
+void ChartTrace::beginGeneration() {
+    QMutexLocker locker(&m_mutex);
+    ++m_generation;
+}
+
+int ChartTrace::generation() const {
+    QMutexLocker locker(&m_mutex);
+    return m_generation;
+}
+
+void ChartTrace::record(const Event& event) {
+    QMutexLocker locker(&m_mutex);
+    if (currentThread < 0) {
+        currentThread = m_threads++;
+    }
+    if (m_events.size() >= MAX_EVENTS) {
+        m_events.remove(0, MAX_EVENTS / 2);
+    }
+    m_events.append(event);
+    m_events.last().generation = m_generation;
+    m_events.last().thread = currentThread;
+}
+
+QVector<ChartTrace::Event> ChartTrace::events() const {
+    QMutexLocker locker(&m_mutex);
+    return m_events;
+}
+
+QString ChartTrace::summary(int maxStages) const {
+    QVector<QPair<QString, qint64>> stages;
+    qint64 total = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        // Events are appended in time order, so the generation is a suffix
+        for (int i = m_events.size() - 1; i >= 0 && m_events[i].generation == m_generation; --i) {
+            const Event& event = m_events[i];
+            const QString name = QString::fromUtf8(event.name);
+            auto stage = std::find_if(stages.begin(), stages.end(),
+                                      [&](const QPair<QString, qint64>& s) { return s.first == name; });
+            if (stage == stages.end()) {
+                stages.append(qMakePair(name, event.self));
+            } else {
+                stage->second += event.self;
+            }
+            total += event.self;
+        }
+    }
+    if (stages.isEmpty()) {
+        return QString();
+    }
+
+    std::stable_sort(stages.begin(), stages.end(),
+                     [](const QPair<QString, qint64>& a, const QPair<QString, qint64>& b) {
+        return a.second > b.second;
+    });
+    QStringList parts;
+    for (int i = 0; i < qMin(maxStages, stages.size()); ++i) {
+        parts << QString("%1 %2 ms").arg(stages[i].first)
+                                    .arg(QString::number(stages[i].second / 1e6, 'f', 2));
+    }
+    return QString("%1 (total %2 ms)").arg(parts.join(", "),
+                                           QString::number(total / 1e6, 'f', 2));
+}
+
+bool ChartTrace::writeChromeTrace(const QString& filePath) const {
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        return false;
+    }
+    const QVector<Event> events = this->events();
+
+    // Complete ("X") events in microseconds; nesting is inferred by the
+    // viewer from the times on each thread
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"main\"}}";
+    for (const Event& event : events) {
+        out << ",\n{\"name\":" << jsonString(event.name)
+            << ",\"cat\":" << jsonString(event.category)
+            << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << QString::number(event.start / 1e3, 'f', 3)
+            << ",\"dur\":" << QString::number(event.duration / 1e3, 'f', 3)
+            << ",\"args\":{\"generation\":" << event.generation
+            << ",\"self_us\":" << QString::number(event.self / 1e3, 'f', 3) << "}}";
+    }
+    out << "\n]}\n";
+    out.flush();
+    return file.error() == QFile::NoError;
+}
@@ -0,0 +1,78 @@
+#ifndef CHARTTRACE_H
+#define CHARTTRACE_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// Times the stages of chart generation: calculators, table population and
+// paint. Scopes nest, and each event also records its self time, excluding
+// the scopes nested in it. Events are grouped into generations, one per
+// generated chart, so the last one can be summarized in the status bar.
+// The whole session can be written as Chrome trace-event JSON, which
+// chrome://tracing and https://ui.perfetto.dev open.
+//
+// The CHART_TRACE macro is compiled out unless ASTROPRO_TRACING is defined.
+class ChartTrace {
+public:
+    struct Event {
+        const char* name;       // String literals; never copied
+        const char* category;   // "calc", "table" or "paint"
+        int generation;
+        int thread;             // Small id in the order threads first traced
+        qint64 start;           // Nanoseconds since the trace clock started
+        qint64 duration;
+        qint64 self;            // Duration less nested scopes on this thread
+    };
+
+    class Scope {
+    public:
+        Scope(const char* category, const char* name);
+        ~Scope();
+
+    private:
+        const char* m_category;
+        const char* m_name;
+        qint64 m_start;
+        qint64 m_children;      // Time of the scopes closed inside this one
+        Scope* m_parent;
+    };
+
+    static ChartTrace& instance();
+
+    // Starts a generation; events recorded from now on belong to it
+    void beginGeneration();
+    int generation() const;
+
+    QVector<Event> events() const;
+    // Self time per stage of the current generation, slowest first, e.g.
+    // "Strengths 1.20 ms, Paint 0.84 ms, ..."; empty when nothing was traced
+    QString summary(int maxStages = SUMMARY_STAGES) const;
+    bool writeChromeTrace(const QString& filePath) const;
+
+    static const int SUMMARY_STAGES = 5;
+    static const int MAX_EVENTS = 100000;   // The oldest half is dropped past this
+
+private:
+    ChartTrace();
+    void record(const Event& event);
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QVector<Event> m_events;
+    int m_generation;
+    int m_threads;
+};
+
+#ifdef ASTROPRO_TRACING
+#define CHART_TRACE_CONCAT2(a, b) a##b
+#define CHART_TRACE_CONCAT(a, b) CHART_TRACE_CONCAT2(a, b)
+#define CHART_TRACE(category, name) \
+    ChartTrace::Scope CHART_TRACE_CONCAT(chartTraceScope, __LINE__)(category, name)
+#else
+#define CHART_TRACE(category, name) do {} while (false)
+#endif
+
+#endif // CHARTTRACE_H
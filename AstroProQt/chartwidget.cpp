@@ -1,280 +1,297 @@
 #include "chartwidget.h"
+#include "charttrace.h"
+#include "perfcounters.h"
 #include <QPainter>
 #include <QPainterPath>
 #include <QMouseEvent>
 #include <QWheelEvent>
+#include <QResizeEvent>
+#include <QKeyEvent>
+#include <QElapsedTimer>
 #include <QDebug>
+#include <QTransform>
+#include <algorithm>
 #include <cmath>
+#include <iterator>
 
 ChartWidget::ChartWidget(QWidget *parent)
     : QWidget(parent)
-    , m_style(NorthIndian)
-    , m_showAspects(true)
     , m_enableZoomPan(true)
     , m_zoom(1.0)
     , m_pan(0, 0)
+    , m_staleResults(AllResults)
+    , m_paintPending(false)
+    , m_showDebugOverlay(false)
+    , m_frameMs(0)
+    , m_layerMs(0)
+    , m_layerRebuilds(0)
 {
     setMinimumSize(400, 400);
-    initializePlanetSymbols();
-    initializePlanetColors();
     setMouseTracking(true);
-}
-
-void ChartWidget::initializePlanetSymbols() {
-    m_planetSymbols = {
-        {"Sun", "☉"},
-        {"Moon", "☽"},
-        {"Mars", "♂"},
-        {"Mercury", "☿"},
-        {"Jupiter", "♃"},
-        {"Venus", "♀"},
-        {"Saturn", "♄"},
-        {"Rahu", "☊"},
-        {"Ketu", "☋"}
-    };
-}
-
-void ChartWidget::initializePlanetColors() {
-    m_planetColors = {
-        {"Sun", QColor(255, 128, 0)},    // Orange
-        {"Moon", QColor(192, 192, 192)},  // Silver
-        {"Mars", QColor(255, 0, 0)},      // Red
-        {"Mercury", QColor(0, 255, 0)},   // Green
-        {"Jupiter", QColor(255, 255, 0)}, // Yellow
-        {"Venus", QColor(128, 0, 128)},   // Purple
-        {"Saturn", QColor(0, 0, 128)},    // Dark Blue
-        {"Rahu", QColor(128, 128, 128)},  // Gray
-        {"Ketu", QColor(64, 64, 64)}      // Dark Gray
-    };
+    setFocusPolicy(Qt::ClickFocus);
+    
+    // Every paint covers the widget, so panning can scroll the pixels
+    // already on screen and repaint only the exposed strip
+    setAttribute(Qt::WA_OpaquePaintEvent);
 }
 
 void ChartWidget::setChartStyle(ChartStyle style) {
-    m_style = style;
-    update();
+    ChartRenderer::Options options = m_renderer.options();
+    options.style = style;
+    m_renderer.setOptions(options);
+    invalidateFrame();
+    invalidateData();
 }
 
 void ChartWidget::setShowAspects(bool show) {
-    m_showAspects = show;
-    update();
+    ChartRenderer::Options options = m_renderer.options();
+    options.showAspects = show;
+    m_renderer.setOptions(options);
+    invalidateData();
+}
+
+void ChartWidget::setVarga(int varga) {
+    ChartRenderer::Options options = m_renderer.options();
+    options.varga = qBound(0, varga, VargaCalculator::VargaCount - 1);
+    m_renderer.setOptions(options);
+    // House numbers follow the varga ascendant
+    invalidateFrame();
+    invalidateData();
 }
 
 void ChartWidget::enableZoomAndPan(bool enable) {
     m_enableZoomPan = enable;
 }
 
+void ChartWidget::setShowDebugOverlay(bool show) {
+    m_showDebugOverlay = show;
+    m_renderer.glyphs().resetStats();
+    update();
+}
+
 void ChartWidget::setBirthData(const QDateTime& birthTime, const QString& place,
                               double lat, double lon) {
     m_chartData.birthTime = birthTime;
     m_chartData.birthPlace = place;
     m_chartData.latitude = lat;
     m_chartData.longitude = lon;
+    // Dasha and Kala Bala depend on the birth time
+    invalidateResults(AllResults);
 }
 
-void ChartWidget::setPlanetPositions(const QMap<QString, double>& positions) {
+void ChartWidget::setPlanetPositions(const QMap<QString, double>& positions,
+                                     const QMap<QString, double>& speeds) {
     m_chartData.planetPositions = positions;
-    calculateStrengths();
-    calculateYogas();
-    update();
+    m_chartData.planetSpeeds = speeds;
+    updateAspects();
+    updateVargas();
+    invalidateResults(AllResults);
+    invalidateData();
 }
 
 void ChartWidget::setHousePositions(const QVector<double>& positions) {
     m_chartData.housePositions = positions;
-    update();
+    updateAspects();
+    updateVargas();
+    invalidateResults(StrengthResult | YogaResult | AshtakavargaResult);
+    invalidateFrame();
+    invalidateData();
 }
 
-void ChartWidget::paintEvent(QPaintEvent* event) {
-    Q_UNUSED(event);
-    
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    
-    // Apply zoom and pan transformations
-    painter.translate(width() / 2 + m_pan.x(), height() / 2 + m_pan.y());
-    painter.scale(m_zoom, m_zoom);
-    painter.translate(-width() / 2, -height() / 2);
+void ChartWidget::setLivePositions(const QDateTime& time, const QMap<QString, double>& positions,
+                                   const QMap<QString, double>& speeds,
+                                   const QVector<double>& housePositions, bool refreshResults) {
+    CHART_TRACE("live", "Live update");
+    const ChartRenderer::Placement before = m_renderer.placement(m_chartData);
+    m_chartData.birthTime = time;
+    m_chartData.planetPositions = positions;
+    m_chartData.planetSpeeds = speeds;
+    m_chartData.housePositions = housePositions;
+    updateAspects();
+    updateVargas();
+    const ChartRenderer::Placement after = m_renderer.placement(m_chartData);
     
-    // Draw chart based on style
-    if (m_style == NorthIndian) {
-        drawNorthIndianChart(painter);
-    } else {
-        drawSouthIndianChart(painter);
+    const bool housesMoved = !std::equal(std::begin(before.houseCell), std::end(before.houseCell),
+                                         std::begin(after.houseCell));
+    quint16 movedBodies = 0;
+    for (int p = 0; p < Astro::PlanetCount; ++p) {
+        if (before.bodyCell[p] != after.bodyCell[p]) movedBodies |= 1u << p;
+    }
+    if (refreshResults || housesMoved || movedBodies) {
+        invalidateResults(AllResults);
     }
     
-    // Draw aspects if enabled
-    if (m_showAspects) {
-        drawAspects(painter);
+    // Most seconds nothing changes cell and the chart is not repainted
+    if (housesMoved) {
+        invalidateFrame();
+        invalidateData();
+        return;
+    }
+    if (before.aspectLines != after.aspectLines ||
+        (movedBodies & (before.joinedBodies() | after.joinedBodies()))) {
+        invalidateData();
+        return;
     }
     
-    // Draw planets
-    drawPlanets(painter);
+    QRegion cells;
+    for (int p = 0; p < Astro::PlanetCount; ++p) {
+        if (!(movedBodies & (1u << p))) continue;
+        for (int cell : {before.bodyCell[p], after.bodyCell[p]}) {
+            if (cell >= 0) cells += m_renderer.cellRect(size(), cell).toAlignedRect();
+        }
+    }
+    if (!cells.isEmpty()) {
+        repaintDataCells(cells);
+    }
 }
 
-void ChartWidget::drawNorthIndianChart(QPainter& painter) {
-    QRectF chartRect = getChartRect();
-    
-    // Draw outer square
-    painter.setPen(QPen(Qt::black, 2));
-    painter.drawRect(chartRect);
+void ChartWidget::repaintDataCells(const QRegion& cells) {
+    // A layer due for a rebuild is redrawn whole on the next paint
+    if (m_dataLayer.isNull()) {
+        update();
+        return;
+    }
     
-    // Draw diagonal lines
-    painter.drawLine(chartRect.topLeft(), chartRect.bottomRight());
-    painter.drawLine(chartRect.topRight(), chartRect.bottomLeft());
+    {
+        CHART_TRACE("paint", "Data cells");
+        // Clear the cells and draw the whole layer clipped to them, so
+        // lines and glyphs crossing a cell come back as they were
+        QPainter painter(&m_dataLayer);
+        painter.setClipRegion(cells);
+        painter.setCompositionMode(QPainter::CompositionMode_Clear);
+        painter.fillRect(cells.boundingRect(), Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        m_renderer.render(painter, size(), m_chartData, ChartRenderer::DataLayer);
+    }
     
-    // Draw inner square
-    double innerSize = chartRect.width() * 0.5;
-    QRectF innerRect(
-        chartRect.center().x() - innerSize/2,
-        chartRect.center().y() - innerSize/2,
-        innerSize, innerSize
-    );
-    painter.drawRect(innerRect);
+    // The overlay's frame time covers the whole widget
+    if (m_showDebugOverlay) {
+        update();
+        return;
+    }
+    const QTransform transform = viewTransform();
+    for (const QRect& cell : cells) {
+        update(transform.mapRect(QRectF(cell)).toAlignedRect().adjusted(-1, -1, 1, 1));
+    }
+}
+
+QTransform ChartWidget::viewTransform() const {
+    // Zoom about the widget centre, then pan
+    QTransform transform;
+    transform.translate(width() / 2 + m_pan.x(), height() / 2 + m_pan.y());
+    transform.scale(m_zoom, m_zoom);
+    transform.translate(-width() / 2, -height() / 2);
+    return transform;
+}
+
+void ChartWidget::invalidateFrame() {
+    m_frameLayer = QPixmap();
+    update();
+}
+
+void ChartWidget::invalidateData() {
+    m_dataLayer = QPixmap();
+    update();
+}
+
+qreal ChartWidget::layerScale() const {
+    // Layers are rasterized at the next whole zoom step so that a zoomed
+    // blit is never magnified beyond the device resolution
+    return devicePixelRatioF() * std::max(1.0, std::ceil(m_zoom));
+}
+
+QPixmap ChartWidget::renderLayer(ChartRenderer::Layer layer, qreal scale) {
+    CHART_TRACE("paint", layer == ChartRenderer::FrameLayer ? "Frame layer" : "Data layer");
+    QPixmap pixmap(size() * scale);
+    pixmap.setDevicePixelRatio(scale);
+    pixmap.fill(Qt::transparent);
     
-    // Draw house numbers
-    drawHouseNumbers(painter);
+    QPainter painter(&pixmap);
+    m_renderer.render(painter, size(), m_chartData, layer);
+    return pixmap;
 }
 
-void ChartWidget::drawSouthIndianChart(QPainter& painter) {
-    QRectF chartRect = getChartRect();
+void ChartWidget::paintEvent(QPaintEvent* event) {
+    Q_UNUSED(event);
+    CHART_TRACE("paint", "Paint");
+    QElapsedTimer frameTimer;
+    frameTimer.start();
     
-    // Draw main grid (3x3)
-    double cellWidth = chartRect.width() / 3;
-    double cellHeight = chartRect.height() / 3;
+    // Rebuild only the layers whose inputs changed or whose resolution no
+    // longer matches the screen and zoom
+    const qreal scale = layerScale();
+    const bool frameStale = m_frameLayer.isNull() || m_frameLayer.devicePixelRatio() != scale;
+    const bool dataStale = m_dataLayer.isNull() || m_dataLayer.devicePixelRatio() != scale;
+    if (frameStale) {
+        m_frameLayer = renderLayer(ChartRenderer::FrameLayer, scale);
+    }
+    if (dataStale) {
+        m_dataLayer = renderLayer(ChartRenderer::DataLayer, scale);
+    }
+    if (frameStale || dataStale) {
+        m_layerMs = frameTimer.nsecsElapsed() / 1e6;
+        ++m_layerRebuilds;
+    }
     
-    painter.setPen(QPen(Qt::black, 2));
+    // The painter is clipped to the dirty region by Qt
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().window());
     
-    // Draw horizontal lines
-    for (int i = 0; i <= 3; ++i) {
-        painter.drawLine(
-            chartRect.left(), chartRect.top() + i * cellHeight,
-            chartRect.right(), chartRect.top() + i * cellHeight
-        );
-    }
+    // Apply zoom and pan transformations to the cached layers
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, m_zoom != 1.0);
+    painter.setTransform(viewTransform());
     
-    // Draw vertical lines
-    for (int i = 0; i <= 3; ++i) {
-        painter.drawLine(
-            chartRect.left() + i * cellWidth, chartRect.top(),
-            chartRect.left() + i * cellWidth, chartRect.bottom()
-        );
-    }
+    painter.drawPixmap(0, 0, m_frameLayer);
+    painter.drawPixmap(0, 0, m_dataLayer);
     
-    // Draw house numbers
-    drawHouseNumbers(painter);
-}
-
-void ChartWidget::drawPlanets(QPainter& painter) {
-    for (auto it = m_chartData.planetPositions.begin(); 
-         it != m_chartData.planetPositions.end(); ++it) {
-        
-        const QString& planet = it.key();
-        double longitude = it.value();
-        
-        QPointF pos = calculatePlanetPosition(longitude);
-        
-        // Draw planet symbol
-        painter.setPen(m_planetColors[planet]);
-        painter.setFont(QFont("Arial", PLANET_SYMBOL_SIZE));
-        painter.drawText(
-            QRectF(pos.x() - PLANET_SYMBOL_SIZE/2,
-                   pos.y() - PLANET_SYMBOL_SIZE/2,
-                   PLANET_SYMBOL_SIZE,
-                   PLANET_SYMBOL_SIZE),
-            Qt::AlignCenter,
-            m_planetSymbols[planet]
-        );
+    m_frameMs = frameTimer.nsecsElapsed() / 1e6;
+    if (m_showDebugOverlay) {
+        painter.resetTransform();
+        drawDebugOverlay(painter);
     }
-}
-
-void ChartWidget::drawAspects(QPainter& painter) {
-    for (auto it1 = m_chartData.planetPositions.begin(); 
-         it1 != m_chartData.planetPositions.end(); ++it1) {
-        
-        for (auto it2 = it1 + 1; 
-             it2 != m_chartData.planetPositions.end(); ++it2) {
-            
-            double angle = std::abs(it1.value() - it2.value());
-            if (angle > 180) angle = 360 - angle;
-            
-            // Check for major aspects
-            if (std::abs(angle - 60) < 6 ||   // Sextile
-                std::abs(angle - 90) < 6 ||   // Square
-                std::abs(angle - 120) < 6 ||  // Trine
-                std::abs(angle - 180) < 6) {  // Opposition
-                
-                QPointF pos1 = calculatePlanetPosition(it1.value());
-                QPointF pos2 = calculatePlanetPosition(it2.value());
-                
-                // Draw aspect line
-                QPen aspectPen(Qt::gray, 1, Qt::DashLine);
-                painter.setPen(aspectPen);
-                painter.drawLine(pos1, pos2);
-            }
-        }
+    
+    // Queued so the trace of this paint is complete when it is reported
+    if (m_paintPending) {
+        m_paintPending = false;
+        QMetaObject::invokeMethod(this, "chartPainted", Qt::QueuedConnection);
     }
 }
 
-void ChartWidget::drawHouseNumbers(QPainter& painter) {
-    if (m_chartData.housePositions.isEmpty()) return;
-    
-    painter.setPen(Qt::black);
-    painter.setFont(QFont("Arial", HOUSE_NUMBER_SIZE));
+void ChartWidget::drawDebugOverlay(QPainter& painter) {
+    const GlyphCache& glyphs = m_renderer.glyphs();
+    const QStringList lines = {
+        QString("frame %1 ms").arg(m_frameMs, 0, 'f', 2),
+        QString("layers %1 ms, %2 rebuilds").arg(m_layerMs, 0, 'f', 2).arg(m_layerRebuilds),
+            QString("glyphs %1 cached, %2 hits / %3 misses (%4%)")
+            .arg(glyphs.size())
+            .arg(glyphs.hits())
+            .arg(glyphs.misses())
+            .arg(100.0 * glyphs.hitRate(), 0, 'f', 1),
+        QString("zoom %1, layer scale %2").arg(m_zoom, 0, 'f', 2).arg(layerScale())
+    };
     
-    for (int i = 0; i < 12; ++i) {
-        double longitude = m_chartData.housePositions[i];
-        QPointF pos = calculatePlanetPosition(longitude);
-        
-        QString number = QString::number(i + 1);
-        painter.drawText(
-            QRectF(pos.x() - HOUSE_NUMBER_SIZE/2,
-                   pos.y() - HOUSE_NUMBER_SIZE/2,
-                   HOUSE_NUMBER_SIZE,
-                   HOUSE_NUMBER_SIZE),
-            Qt::AlignCenter,
-            number
-        );
+    painter.setFont(QFont("Monospace", 9));
+    const QFontMetrics metrics = painter.fontMetrics();
+    int textWidth = 0;
+    for (const QString& line : lines) {
+        textWidth = std::max(textWidth, metrics.boundingRect(line).width());
     }
-}
-
-QPointF ChartWidget::calculatePlanetPosition(double longitude) {
-    QRectF chartRect = getChartRect();
     
-    if (m_style == NorthIndian) {
-        // Calculate position in North Indian style
-        int house = static_cast<int>(longitude / 30) + 1;
-        double radius = chartRect.width() * 0.25;
-        
-        // Adjust angle based on house position
-        double angle = (house - 1) * 30.0;
-        angle = qDegreesToRadians(angle);
-        
-        return QPointF(
-            chartRect.center().x() + radius * std::cos(angle),
-            chartRect.center().y() + radius * std::sin(angle)
-        );
-    } else {
-        // Calculate position in South Indian style
-        int house = static_cast<int>(longitude / 30) + 1;
-        double cellWidth = chartRect.width() / 3;
-        double cellHeight = chartRect.height() / 3;
-        
-        // Convert house number to grid position
-        int row = (house - 1) / 3;
-        int col = (house - 1) % 3;
-        
-        return QPointF(
-            chartRect.left() + (col + 0.5) * cellWidth,
-            chartRect.top() + (row + 0.5) * cellHeight
-        );
+    QRect box(6, 6, textWidth + 12, lines.size() * metrics.height() + 8);
+    painter.fillRect(box, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    int y = box.top() + 4 + metrics.ascent();
+    for (const QString& line : lines) {
+        painter.drawText(box.left() + 6, y, line);
+        y += metrics.height();
     }
 }
 
-QRectF ChartWidget::getChartRect() const {
-    int size = std::min(width(), height()) - 2 * CHART_PADDING;
-    return QRectF(
-        (width() - size) / 2,
-        (height() - size) / 2,
-        size, size
-    );
+void ChartWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    // The chart rectangle follows the widget size
+    invalidateFrame();
+    invalidateData();
 }
 
 void ChartWidget::mousePressEvent(QMouseEvent* event) {
@@ -285,13 +302,27 @@ void ChartWidget::mousePressEvent(QMouseEvent* event) {
 
 void ChartWidget::mouseMoveEvent(QMouseEvent* event) {
     if (m_enableZoomPan && event->buttons() & Qt::LeftButton) {
-        QPointF delta = event->pos() - m_lastMousePos;
+        QPoint delta = event->pos() - m_lastMousePos.toPoint();
         m_pan += delta;
         m_lastMousePos = event->pos();
-        update();
+        // Panning is a pure translation, so shift what is on screen; the
+        // overlay is pinned to the corner and needs a full repaint
+        if (m_showDebugOverlay) {
+            update();
+        } else {
+            scroll(delta.x(), delta.y());
+        }
     }
 }
 
+void ChartWidget::keyPressEvent(QKeyEvent* event) {
+    if (event->key() == Qt::Key_F12) {
+        setShowDebugOverlay(!m_showDebugOverlay);
+        return;
+    }
+    QWidget::keyPressEvent(event);
+}
+
 void ChartWidget::wheelEvent(QWheelEvent* event) {
     if (m_enableZoomPan) {
         double delta = event->angleDelta().y() / 120.0;
@@ -313,67 +344,119 @@ void ChartWidget::wheelEvent(QWheelEvent* event) {
     }
 }
 
+void ChartWidget::updateAspects() {
+    CHART_TRACE("calc", "Aspects");
+    PERF_REGION("Aspects");
+    m_chartData.aspects.build(m_chartData.planetPositions,
+                              m_chartData.housePositions);
+}
+
+void ChartWidget::updateVargas() {
+    CHART_TRACE("calc", "Vargas");
+    PERF_REGION("Vargas");
+    m_chartData.vargas = m_vargaCalculator.calculate(
+        m_chartData.planetPositions,
+        m_chartData.housePositions.isEmpty() ? 0.0 : m_chartData.housePositions[0]
+    );
+}
+
 void ChartWidget::calculateStrengths() {
+    CHART_TRACE("calc", "Strengths");
+    PERF_REGION("Strengths");
     m_chartData.planetaryStrengths = 
         m_strengthCalculator.calculateAllStrengths(
             m_chartData.planetPositions,
             m_chartData.housePositions,
-            m_chartData.birthTime
+            m_chartData.birthTime,
+            m_chartData.planetSpeeds,
+            &m_chartData.aspects,
+            &m_chartData.vargas
         );
 }
 
 void ChartWidget::calculateYogas() {
+    CHART_TRACE("calc", "Yogas");
+    PERF_REGION("Yogas");
+    // Yoga strengths are scaled by the Shadbala of the planets forming them
     m_chartData.activeYogas = 
         m_yogaCalculator.detectActiveYogas(
             m_chartData.planetPositions,
             m_chartData.housePositions,
-            m_chartData.planetaryStrengths
+            m_chartData.planetaryStrengths,
+            &m_chartData.aspects,
+            &m_chartData.vargas
+        );
+}
+
+void ChartWidget::calculateAshtakavarga() {
+    CHART_TRACE("calc", "Ashtakavarga");
+    PERF_REGION("Ashtakavarga");
+    if (m_chartData.housePositions.isEmpty()) {
+        m_chartData.ashtakavarga = AshtakavargaCalculator::Ashtakavarga();
+        return;
+    }
+    m_chartData.ashtakavarga =
+        m_ashtakavargaCalculator.calculate(
+            m_chartData.planetPositions,
+            m_chartData.housePositions[0]
         );
 }
 
 void ChartWidget::calculateDasha() {
+    CHART_TRACE("calc", "Dasha");
+    PERF_REGION("Dasha");
     if (m_chartData.planetPositions.contains("Moon")) {
         m_chartData.dashaPeriods = 
             m_dashaCalculator.calculateVimshottariDasha(
                 m_chartData.birthTime,
                 m_chartData.planetPositions["Moon"]
             );
+    } else {
+        m_chartData.dashaPeriods.clear();
     }
 }
 
-void ChartWidget::generateChart() {
+void ChartWidget::invalidateResults(int results) {
+    m_staleResults |= results;
+    // Views are told at once, but only the visible one asks for its result
+    emit calculationsUpdated();
+}
+
+void ChartWidget::ensureResults(int results) {
+    // Yogas are weighted by the strengths of their planets
+    if (results & YogaResult) {
+        results |= StrengthResult;
+    }
+    results &= m_staleResults;
+    if (!results) return;
+    
     try {
-        calculateDasha();
-        calculateStrengths();
-        calculateYogas();
-        update();
-        emit chartGenerated();
+        if (results & DashaResult) calculateDasha();
+        if (results & StrengthResult) calculateStrengths();
+        if (results & YogaResult) calculateYogas();
+        if (results & AshtakavargaResult) calculateAshtakavarga();
     } catch (const std::exception& e) {
-        emit errorOccurred(QString("Error generating chart: %1").arg(e.what()));
+        emit errorOccurred(QString("Error calculating chart: %1").arg(e.what()));
     }
+    m_staleResults &= ~results;
 }
 
-void ChartWidget::exportChart(const QString& filePath) {
-    QImage image(size(), QImage::Format_ARGB32);
-    image.fill(Qt::white);
-    
-    QPainter painter(&image);
-    painter.setRenderHint(QPainter::Antialiasing);
-    
-    // Draw chart on the image
-    if (m_style == NorthIndian) {
-        drawNorthIndianChart(painter);
-    } else {
-        drawSouthIndianChart(painter);
-    }
-    
-    if (m_showAspects) {
-        drawAspects(painter);
+void ChartWidget::generateChart() {
+    // Results are calculated when a view first asks for them
+    m_staleResults = AllResults;
+    m_paintPending = true;
+    update();
+    emit chartGenerated();
+}
+
+bool ChartWidget::exportChart(const QString& filePath) {
+    // Drawn afresh at the screen's pixel density, not copied from the cache;
+    // a .svg path gives vector output
+    if (!m_renderer.exportFile(filePath, size(), m_chartData, devicePixelRatioF())) {
+        emit errorOccurred(QString("Could not write %1").arg(filePath));
+        return false;
     }
-    drawPlanets(painter);
-    
-    // Save image
-    image.save(filePath);
+    return true;
 }
 
 void ChartWidget::resetView() {
@@ -382,15 +465,27 @@ void ChartWidget::resetView() {
     update();
 }
 
-QVector<DashaPeriod> ChartWidget::getDashaPeriods() const {
+QVector<DashaPeriod> ChartWidget::getDashaPeriods() {
+    ensureResults(DashaResult);
     return m_chartData.dashaPeriods;
 }
 
 QMap<QString, StrengthCalculator::PlanetaryStrength> 
-ChartWidget::getPlanetaryStrengths() const {
+ChartWidget::getPlanetaryStrengths() {
+    ensureResults(StrengthResult);
     return m_chartData.planetaryStrengths;
 }
 
-QVector<YogaCalculator::Yoga> ChartWidget::getActiveYogas() const {
+QVector<YogaCalculator::Yoga> ChartWidget::getActiveYogas() {
+    ensureResults(YogaResult);
     return m_chartData.activeYogas;
 }
+
+AshtakavargaCalculator::Ashtakavarga ChartWidget::getAshtakavarga() {
+    ensureResults(AshtakavargaResult);
+    return m_chartData.ashtakavarga;
+}
+
+VargaCalculator::VargaMatrix ChartWidget::getVargas() const {
+    return m_chartData.vargas;
+}
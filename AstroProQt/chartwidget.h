@@ -3,31 +3,44 @@
 
 #include <QWidget>
 #include <QPainter>
+#include <QPixmap>
 #include <QDateTime>
 #include <QMap>
+#include "chartrenderer.h"
 #include "Calculators/dashacalculator.h"
 #include "Calculators/strengthcalculator.h"
 #include "Calculators/yogacalculator.h"
+#include "Calculators/aspectmatrix.h"
+#include "Calculators/ashtakavargacalculator.h"
+#include "Calculators/vargacalculator.h"
 
 class ChartWidget : public QWidget {
     Q_OBJECT
 
 public:
-    enum ChartStyle {
-        NorthIndian,
-        SouthIndian
+    using ChartStyle = ChartRenderer::ChartStyle;
+
+    // Calculated results, each computed on first request after a change
+    enum Result {
+        DashaResult = 0x1,
+        StrengthResult = 0x2,
+        YogaResult = 0x4,       // Needs StrengthResult
+        AshtakavargaResult = 0x8,
+        AllResults = 0xF
     };
 
-    struct ChartData {
+    // Positions, aspects and vargas come from ChartRenderer::Chart; the
+    // aspect and varga matrices are rebuilt whenever positions or houses change
+    struct ChartData : ChartRenderer::Chart {
         QDateTime birthTime;
         QString birthPlace;
         double latitude;
         double longitude;
-        QMap<QString, double> planetPositions;
-        QVector<double> housePositions;
-        QMap<QString, double> planetaryStrengths;
+        QMap<QString, double> planetSpeeds;   // Degrees/day; Cheshta Bala needs them
+        QMap<QString, StrengthCalculator::PlanetaryStrength> planetaryStrengths;
         QVector<YogaCalculator::Yoga> activeYogas;
         QVector<DashaPeriod> dashaPeriods;
+        AshtakavargaCalculator::Ashtakavarga ashtakavarga;
     };
 
     explicit ChartWidget(QWidget *parent = nullptr);
@@ -35,28 +48,43 @@ public:
     // Chart configuration
     void setChartStyle(ChartStyle style);
     void setShowAspects(bool show);
+    void setVarga(int varga);   // VargaCalculator::Varga shown in the chart
     void enableZoomAndPan(bool enable);
+    void setShowDebugOverlay(bool show);   // Frame time and glyph cache stats, also F12
 
     // Data setters
     void setBirthData(const QDateTime& birthTime, const QString& place,
                      double lat, double lon);
-    void setPlanetPositions(const QMap<QString, double>& positions);
+    void setPlanetPositions(const QMap<QString, double>& positions,
+                            const QMap<QString, double>& speeds = QMap<QString, double>());
     void setHousePositions(const QVector<double>& positions);
+    // Live ("now") chart: move the chart to another instant, repainting
+    // only the cells whose glyphs changed. Results are marked stale when
+    // a body or house changes cell, or when refreshResults is set.
+    void setLivePositions(const QDateTime& time, const QMap<QString, double>& positions,
+                          const QMap<QString, double>& speeds,
+                          const QVector<double>& housePositions, bool refreshResults);
 
     // Chart operations
     void generateChart();
-    void exportChart(const QString& filePath);
+    bool exportChart(const QString& filePath);
     void resetView();
 
-    // Getters for calculated data
-    QVector<DashaPeriod> getDashaPeriods() const;
-    QMap<QString, StrengthCalculator::PlanetaryStrength> getPlanetaryStrengths() const;
-    QVector<YogaCalculator::Yoga> getActiveYogas() const;
+    // Getters for calculated data; stale results are recalculated here
+    QVector<DashaPeriod> getDashaPeriods();
+    QMap<QString, StrengthCalculator::PlanetaryStrength> getPlanetaryStrengths();
+    QVector<YogaCalculator::Yoga> getActiveYogas();
+    AshtakavargaCalculator::Ashtakavarga getAshtakavarga();
+    int staleResults() const { return m_staleResults; }
+    VargaCalculator::VargaMatrix getVargas() const;
+    // Positions and matrices; calculated results may be stale here
+    const ChartData& getChartData() const { return m_chartData; }
 
 signals:
     void chartGenerated();
     void errorOccurred(const QString& error);
     void calculationsUpdated();
+    void chartPainted();        // First paint after generateChart()
 
 protected:
     void paintEvent(QPaintEvent* event) override;
@@ -64,36 +92,32 @@ protected:
     void mouseMoveEvent(QMouseEvent* event) override;
     void wheelEvent(QWheelEvent* event) override;
     void resizeEvent(QResizeEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
 
 private:
-    // Drawing functions
-    void drawNorthIndianChart(QPainter& painter);
-    void drawSouthIndianChart(QPainter& painter);
-    void drawPlanets(QPainter& painter);
-    void drawAspects(QPainter& painter);
-    void drawHouseNumbers(QPainter& painter);
-    void drawZodiacSymbols(QPainter& painter);
+    // Cached raster layers, drawn unzoomed and blitted through the view
+    // transform; the frame holds the grid and house numbers, the data layer
+    // planets and aspect lines
+    void invalidateFrame();
+    void invalidateData();
+    qreal layerScale() const;
+    QPixmap renderLayer(ChartRenderer::Layer layer, qreal scale);
+    void repaintDataCells(const QRegion& cells);
+    QTransform viewTransform() const;
+    void drawDebugOverlay(QPainter& painter);
     
     // Calculation functions
+    void invalidateResults(int results);
+    void ensureResults(int results);
+    void updateAspects();
+    void updateVargas();
     void calculateDasha();
     void calculateStrengths();
     void calculateYogas();
-    
-    // Utility functions
-    QPointF calculatePlanetPosition(double longitude);
-    int getHouseNumber(double longitude);
-    QString getPlanetSymbol(const QString& planet);
-    QColor getPlanetColor(const QString& planet);
-    
-    // Helper functions
-    void initializePlanetSymbols();
-    void initializePlanetColors();
-    void updateTransformation();
-    QRectF getChartRect() const;
+    void calculateAshtakavarga();
+
 
     // Member variables
-    ChartStyle m_style;
-    bool m_showAspects;
     bool m_enableZoomPan;
     double m_zoom;
     QPointF m_pan;
@@ -101,20 +125,30 @@ private:
     
     // Chart data
     ChartData m_chartData;
+    int m_staleResults;   // Result bits not yet recalculated
+    bool m_paintPending;  // chartPainted() is due after the next paint
     
     // Calculators
     DashaCalculator m_dashaCalculator;
     StrengthCalculator m_strengthCalculator;
     YogaCalculator m_yogaCalculator;
+    AshtakavargaCalculator m_ashtakavargaCalculator;
+    VargaCalculator m_vargaCalculator;
+    
+    // Draws the layers; style, varga and aspect display live in its options
+    ChartRenderer m_renderer;
+    
+    // Layer cache; a null pixmap is rebuilt on the next paint
+    QPixmap m_frameLayer;
+    QPixmap m_dataLayer;
     
-    // Visual properties
-    QMap<QString, QString> m_planetSymbols;
-    QMap<QString, QColor> m_planetColors;
+    // Debug overlay
+    bool m_showDebugOverlay;
+    double m_frameMs;         // Last paint, including any layer rebuild
+    double m_layerMs;         // Time of the last layer rebuild
+    int m_layerRebuilds;
     
     // Constants
-    const int CHART_PADDING = 20;
-    const int HOUSE_NUMBER_SIZE = 12;
-    const int PLANET_SYMBOL_SIZE = 14;
     const double MIN_ZOOM = 0.5;
     const double MAX_ZOOM = 3.0;
 };
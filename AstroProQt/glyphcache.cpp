@@ -0,0 +1,56 @@
+#include "glyphcache.h"
+#include <QPainter>
+
+GlyphCache::GlyphCache()
+    : m_hits(0)
+    , m_misses(0)
+{
+}
+
+QStaticText& GlyphCache::lookup(const QString& text, const QFont& font, bool count) {
+    // Font key and text are joined with a character neither can contain
+    const QString key = font.key() + QChar(0x1F) + text;
+    auto it = m_texts.find(key);
+    if (it != m_texts.end()) {
+        if (count) ++m_hits;
+        return it.value();
+    }
+    
+    if (count) ++m_misses;
+    QStaticText staticText(text);
+    staticText.setTextFormat(Qt::PlainText);
+    staticText.setPerformanceHint(QStaticText::AggressiveCaching);
+    staticText.prepare(QTransform(), font);
+    return m_texts.insert(key, staticText).value();
+}
+
+void GlyphCache::prepare(const QString& text, const QFont& font) {
+    lookup(text, font, false);
+}
+
+const QStaticText& GlyphCache::text(const QString& text, const QFont& font) {
+    return lookup(text, font, true);
+}
+
+void GlyphCache::drawCentered(QPainter& painter, const QPointF& center,
+                              const QString& text, const QFont& font) {
+    const QStaticText& staticText = lookup(text, font, true);
+    const QSizeF size = staticText.size();
+    painter.drawStaticText(center - QPointF(size.width() / 2, size.height() / 2),
+                           staticText);
+}
+
+void GlyphCache::clear() {
+    m_texts.clear();
+    resetStats();
+}
+
+void GlyphCache::resetStats() {
+    m_hits = 0;
+    m_misses = 0;
+}
+
+double GlyphCache::hitRate() const {
+    const quint64 total = m_hits + m_misses;
+    return total ? double(m_hits) / total : 0.0;
+}
@@ -0,0 +1,43 @@
+#ifndef GLYPHCACHE_H
+#define GLYPHCACHE_H
+
+#include <QFont>
+#include <QHash>
+#include <QPointF>
+#include <QStaticText>
+
+class QPainter;
+
+// Pre-shaped chart labels. Each (font, text) pair is laid out once as a
+// QStaticText, so repainting a chart only replays cached glyph runs.
+class GlyphCache {
+public:
+    GlyphCache();
+
+    // Shape a label ahead of the first paint
+    void prepare(const QString& text, const QFont& font);
+
+    const QStaticText& text(const QString& text, const QFont& font);
+
+    // Draw a label centred on a point; the painter's font must be the one
+    // the label was shaped with
+    void drawCentered(QPainter& painter, const QPointF& center,
+                      const QString& text, const QFont& font);
+
+    void clear();
+    void resetStats();
+
+    int size() const { return m_texts.size(); }
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+    double hitRate() const;
+
+private:
+    QStaticText& lookup(const QString& text, const QFont& font, bool count);
+
+    QHash<QString, QStaticText> m_texts;
+    quint64 m_hits;
+    quint64 m_misses;
+};
+
+#endif // GLYPHCACHE_H
@@ -0,0 +1,91 @@
+#include "livechart.h"
+#include "chartwidget.h"
+#include "charttrace.h"
+#include "siderealephemeris.h"
+#include <limits>
+
+LiveChart::LiveChart(ChartWidget* chart, QObject* parent)
+    : QObject(parent)
+    , m_chart(chart)
+    , m_ephemeris([this](int body, double julianDay) { return ephemerisLongitude(body, julianDay); })
+    , m_latitude(0)
+    , m_longitude(0)
+    , m_ticks(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &LiveChart::tick);
+#ifdef EPHE_PATH
+    SiderealEphemeris::setUp(EPHE_PATH);
+#else
+    SiderealEphemeris::setUp();
+#endif
+}
+
+void LiveChart::start(const QString& place, double latitude, double longitude) {
+    m_latitude = latitude;
+    m_longitude = longitude;
+    m_ticks = 0;
+    m_chart->setBirthData(QDateTime::currentDateTimeUtc(), place, latitude, longitude);
+    // Series fitted for another place would carry its ascendant
+    m_ephemeris.fit(SiderealEphemeris::julianDay(QDateTime::currentDateTimeUtc()));
+    tick();
+}
+
+void LiveChart::stop() {
+    m_timer.stop();
+}
+
+double LiveChart::ephemerisLongitude(int body, double julianDay) {
+    if (body == ChebyshevEphemeris::Ascendant) {
+        return SiderealEphemeris::ascendant(julianDay, m_latitude, m_longitude);
+    }
+    double longitude;
+    if (!SiderealEphemeris::longitude(julianDay, body, &longitude, &m_ephemerisError)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return longitude;
+}
+
+void LiveChart::tick() {
+    CHART_TRACE("live", "Tick");
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const double day = SiderealEphemeris::julianDay(now);
+    if (!m_ephemeris.covers(day)) {
+        m_ephemeris.fit(day);
+    }
+    // The prashna readings need the Sun and Moon; other bodies may be
+    // missing if their ephemeris files are
+    if (!m_ephemeris.contains(Astro::Sun) || !m_ephemeris.contains(Astro::Moon)) {
+        stop();
+        emit errorOccurred(m_ephemerisError);
+        return;
+    }
+    
+    QMap<QString, double> positions;
+    QMap<QString, double> speeds;
+    for (int p = 0; p < Astro::PlanetCount; ++p) {
+        if (m_ephemeris.contains(p)) {
+            positions.insert(Astro::planetName(p), m_ephemeris.longitude(p, day));
+            speeds.insert(Astro::planetName(p), m_ephemeris.speed(p, day));
+        }
+    }
+    const double ascendant = m_ephemeris.longitude(ChebyshevEphemeris::Ascendant, day);
+    QVector<double> houses;
+    houses.reserve(12);
+    for (int h = 0; h < 12; ++h) {
+        houses.append(Astro::normalizeDegrees(ascendant + h * 30.0));
+    }
+    
+    m_chart->setLivePositions(now, positions, speeds, houses, m_ticks % RESULTS_REFRESH_TICKS == 0);
+    ++m_ticks;
+    emit ticked(now, PrashnaCalculator::evaluate(positions["Sun"], positions["Moon"], ascendant,
+                                                 day, m_longitude));
+    scheduleNextTick();
+}
+
+void LiveChart::scheduleNextTick() {
+    // Just past the next whole second, so the clock shown never repeats
+    const int msec = QTime::currentTime().msec();
+    m_timer.start(1000 - msec + 5);
+}
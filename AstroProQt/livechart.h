@@ -0,0 +1,53 @@
+#ifndef LIVECHART_H
+#define LIVECHART_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include "Calculators/chebyshevephemeris.h"
+#include "Calculators/prashnacalculator.h"
+
+class ChartWidget;
+
+// Keeps a ChartWidget on the current moment (prashna, or "now" chart).
+//
+// Ticks land on each whole second. Positions come from Chebyshev series
+// fitted once an hour, so a tick is a few polynomial evaluations; the
+// widget repaints only the cells a body entered or left, and most seconds
+// nothing is repainted at all.
+class LiveChart : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LiveChart(ChartWidget* chart, QObject* parent = nullptr);
+
+    void start(const QString& place, double latitude, double longitude);
+    void stop();
+    bool isRunning() const { return m_timer.isActive(); }
+
+    int fitCount() const { return m_ephemeris.fitCount(); }
+
+signals:
+    void ticked(const QDateTime& now, const PrashnaCalculator::Moment& moment);
+    void errorOccurred(const QString& error);
+
+private slots:
+    void tick();
+
+private:
+    double ephemerisLongitude(int body, double julianDay);
+    void scheduleNextTick();
+
+    ChartWidget* m_chart;
+    ChebyshevEphemeris m_ephemeris;
+    QTimer m_timer;
+    double m_latitude;
+    double m_longitude;
+    int m_ticks;
+    QString m_ephemerisError;   // Last failure while fitting
+
+    static const int RESULTS_REFRESH_TICKS = 60;   // Result tabs follow once a minute
+};
+
+#endif // LIVECHART_H
@@ -1,8 +1,22 @@
 #include "mainwindow.h"
+#include "batchexporter.h"
+#include "chartlist.h"
+#include "charttrace.h"
+#include "perfcounters.h"
+#include "reportgenerator.h"
+#include "siderealephemeris.h"
+#include "startuptrace.h"
+#include "Location/geocoder.h"
+#include "Location/timezoneindex.h"
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QStyleFactory>
+#include <QDir>
 #include <QFile>
+#include <QStandardPaths>
+#include <QTimer>
 #include <QDebug>
+#include <cstdio>
 
 void setupStyle(QApplication& app)
 {
@@ -29,8 +43,8 @@ void setupStyle(QApplication& app)
     
     // Load and apply stylesheet
     QFile styleFile(":/styles/dark.qss");
-    if (styleFile.exists() && styleFile.open(QFile::ReadOnly | QFile::Text)) {
-        QString style = QLatin1String(styleFile.readAll());
+    if (styleFile.open(QFile::ReadOnly)) {
+        QString style = QString::fromUtf8(styleFile.readAll());
         app.setStyleSheet(style);
         styleFile.close();
     } else {
@@ -103,9 +117,65 @@ void setupStyle(QApplication& app)
     }
 }
 
+// Headless chart images for every chart in the list
+int exportBatch(const QVector<ChartList::Entry>& charts, const QString& directory)
+{
+    QVector<BatchExporter::Job> jobs;
+    jobs.reserve(charts.size());
+    for (int i = 0; i < charts.size(); ++i) {
+        BatchExporter::Job job;
+        job.filePath = ChartList::outputPath(directory, i, charts[i], "png");
+        job.chart = ChartRenderer::Chart::build(charts[i].planetPositions,
+                                                charts[i].housePositions);
+        jobs.append(job);
+    }
+    
+    const BatchExporter::Result result = BatchExporter().run(jobs);
+    for (const QString& path : result.failedPaths) {
+        qWarning() << "Cannot write" << path;
+    }
+    std::fprintf(stderr, "%d charts written, %d failed, %.1f charts/s\n",
+                 result.written, result.failed, result.chartsPerSecond());
+    return result.failed ? 1 : 0;
+}
+
+// PDF client reports for every chart in the list
+int exportReports(const QVector<ChartList::Entry>& charts, const QString& directory,
+                  const ReportGenerator::Options& options)
+{
+    QVector<ReportGenerator::Job> jobs;
+    jobs.reserve(charts.size());
+    for (int i = 0; i < charts.size(); ++i) {
+        ReportGenerator::Job job;
+        job.filePath = ChartList::outputPath(directory, i, charts[i], "pdf");
+        job.client.name = charts[i].name;
+        job.client.birthTime = charts[i].birthTime;
+        job.client.birthPlace = charts[i].birthPlace;
+        job.client.planetPositions = charts[i].planetPositions;
+        job.client.planetSpeeds = charts[i].planetSpeeds;
+        job.client.housePositions = charts[i].housePositions;
+        jobs.append(job);
+    }
+    
+    ReportGenerator generator;
+    generator.setOptions(options);
+    const ReportGenerator::Result result = generator.run(jobs);
+    for (const QString& path : result.failedPaths) {
+        qWarning() << "Cannot write" << path;
+    }
+    std::fprintf(stderr, "%d reports written, %d failed, %.1f reports/min\n",
+                 result.written, result.failed, result.reportsPerMinute());
+    return result.failed ? 1 : 0;
+}
+
 int main(int argc, char *argv[])
 {
+    StartupTrace& trace = StartupTrace::instance();
+    trace.start();
+    
+    qint64 phaseStart = trace.elapsed();
     QApplication app(argc, argv);
+    trace.record("QApplication", phaseStart, trace.elapsed());
     
     // Set application information
     QApplication::setApplicationName("AstroProQt");
@@ -113,13 +183,128 @@ int main(int argc, char *argv[])
     QApplication::setOrganizationName("AstroProQt");
     QApplication::setOrganizationDomain("astroproqt.org");
     
+    // Command line
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Vedic astrology charts and analysis");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption startupTraceOption("startup-trace",
+        "Print the time taken by each startup phase to stderr.");
+    parser.addOption(startupTraceOption);
+    QCommandLineOption chartTraceOption("chart-trace",
+        "On exit, write the chart generation stage timings to <file> as "
+        "Chrome trace-event JSON.", "file");
+    parser.addOption(chartTraceOption);
+    QCommandLineOption chartsOption("charts",
+        "Charts for the batch modes, as a JSON array in <file>.", "file");
+    parser.addOption(chartsOption);
+    QCommandLineOption exportBatchOption("export-batch",
+        "Render every chart of --charts to a PNG in <dir> on all cores, "
+        "without a window, and exit.", "dir");
+    parser.addOption(exportBatchOption);
+    QCommandLineOption exportReportsOption("export-reports",
+        "Write a PDF report for every chart of --charts to <dir> on all "
+        "cores, without a window, and exit.", "dir");
+    parser.addOption(exportReportsOption);
+    QCommandLineOption dashaDepthOption("dasha-depth",
+        "Dasha levels in each report of --export-reports, from 1 (mahadasha) "
+        "to 5 (prana dasha); 2 by default.", "1-5");
+    parser.addOption(dashaDepthOption);
+    QCommandLineOption geocoderKeyOption("geocoder-key",
+        "OpenCage API key for the charts of --charts that give a place but "
+        "no coordinates.", "key");
+    parser.addOption(geocoderKeyOption);
+#ifdef ASTROPRO_PERF_COUNTERS
+    QCommandLineOption perfCountersOption("perf-counters",
+        "On exit, print hardware event counts for the calculators to stderr.");
+    parser.addOption(perfCountersOption);
+#endif
+    parser.process(app);
+    trace.setEnabled(parser.isSet(startupTraceOption));
+#ifdef ASTROPRO_PERF_COUNTERS
+    PerfCounters::instance().setEnabled(parser.isSet(perfCountersOption));
+#endif
+    
+    // Batch modes run on worker threads and exit without showing a window
+    const bool reports = parser.isSet(exportReportsOption);
+    if (parser.isSet(exportBatchOption) || reports) {
+        if (!parser.isSet(chartsOption)) {
+            std::fputs("--export-batch and --export-reports need --charts <file>\n", stderr);
+            return 2;
+        }
+        ReportGenerator::Options reportOptions;
+        if (parser.isSet(dashaDepthOption)) {
+            bool ok;
+            reportOptions.dashaDepth = parser.value(dashaDepthOption).toInt(&ok);
+            if (!ok || reportOptions.dashaDepth < 1 || reportOptions.dashaDepth > 5) {
+                std::fputs("--dasha-depth must be from 1 to 5\n", stderr);
+                return 2;
+            }
+        }
+#ifdef EPHE_PATH
+        SiderealEphemeris::setUp(EPHE_PATH);
+#else
+        SiderealEphemeris::setUp();
+#endif
+        // Places without coordinates are geocoded in one batch, sharing the
+        // window's cache
+        Geocoder geocoder;
+        geocoder.setApiKey(parser.value(geocoderKeyOption));
+        geocoder.setCacheFile(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+                              .filePath("geocode.cache"));
+        // Times without an offset are placed in the birthplace's zone; the
+        // index is looked for where the window looks for it
+        TimeZoneIndex zones;
+        const QStringList zonePaths = {
+            QDir(QCoreApplication::applicationDirPath()).filePath("geo/timezones.bin"),
+            QStandardPaths::locate(QStandardPaths::AppDataLocation, "timezones.bin")
+        };
+        for (const QString& path : zonePaths) {
+            if (!path.isEmpty() && QFile::exists(path) && zones.open(path)) {
+                break;
+            }
+        }
+        QVector<ChartList::Entry> charts;
+        QString error;
+        if (!ChartList::load(parser.value(chartsOption), &charts, &error, &geocoder, &zones)) {
+            std::fprintf(stderr, "%s\n", error.toLocal8Bit().constData());
+            return 1;
+        }
+        const QString directory = parser.value(reports ? exportReportsOption : exportBatchOption);
+        if (!QDir().mkpath(directory)) {
+            std::fprintf(stderr, "Cannot create %s\n", directory.toLocal8Bit().constData());
+            return 1;
+        }
+        const int status = reports ? exportReports(charts, directory, reportOptions)
+                                   : exportBatch(charts, directory);
+        if (PerfCounters::instance().isEnabled()) {
+            std::fputs(PerfCounters::instance().report().toLocal8Bit().constData(), stderr);
+        }
+        return status;
+    }
+    
     // Setup modern style
+    phaseStart = trace.elapsed();
     setupStyle(app);
+    trace.record("Style", phaseStart, trace.elapsed());
     
-    // Create and show main window
+    // Create and show main window; the rest loads once it is on screen
+    phaseStart = trace.elapsed();
     MainWindow mainWindow;
+    trace.record("Main window", phaseStart, trace.elapsed());
+    trace.markFirstPaint(&mainWindow);
     mainWindow.show();
+    QTimer::singleShot(0, &mainWindow, &MainWindow::startWarmup);
     
     // Start event loop
-    return app.exec();
+    const int status = app.exec();
+    
+    const QString chartTracePath = parser.value(chartTraceOption);
+    if (!chartTracePath.isEmpty() && !ChartTrace::instance().writeChromeTrace(chartTracePath)) {
+        qWarning() << "Cannot write chart trace to" << chartTracePath;
+    }
+    if (PerfCounters::instance().isEnabled()) {
+        std::fputs(PerfCounters::instance().report().toLocal8Bit().constData(), stderr);
+    }
+    return status;
 }
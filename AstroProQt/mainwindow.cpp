@@ -2,19 +2,53 @@
 #include "ui_mainwindow.h"
 #include <QMessageBox>
 #include <QFileDialog>
-#include <QNetworkRequest>
-#include <QUrlQuery>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QDateTime>
 #include <QDebug>
+#include <QHeaderView>
+#include <QSortFilterProxyModel>
+#include <QCompleter>
+#include <QStringListModel>
+#include <QStandardPaths>
+#include <QCoreApplication>
+#include <QDir>
+#include <QTimeZone>
+#include <cmath>
+#include "charttrace.h"
+#include "reportgenerator.h"
+#include "startuptrace.h"
+#include "startupwarmup.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_geocoder(new Geocoder(this))
+    , m_geocodeRequest(0)
+    , m_warmup(new StartupWarmup(this))
+    , m_placeModel(new QStringListModel(this))
+    , m_placeCompleter(new QCompleter(m_placeModel, this))
+    , m_dashaModel(new DashaTreeModel(this))
+    , m_strengthModel(new StrengthTableModel(this))
+    , m_yogaModel(new YogaTableModel(this))
+    , m_dashaProxy(new QSortFilterProxyModel(this))
+    , m_strengthProxy(new QSortFilterProxyModel(this))
+    , m_yogaProxy(new QSortFilterProxyModel(this))
+    , m_staleTabs(0)
+    , m_liveChart(nullptr)
 {
-    ui->setupUi(this);
+    {
+        StartupTrace::Scope scope("Main window layout");
+        ui->setupUi(this);
+    }
+    
+    // Divisional chart selector, D1 to D60
+    for (int varga = 0; varga < VargaCalculator::VargaCount; ++varga) {
+        ui->vargaCombo->addItem(VargaCalculator::vargaName(varga));
+    }
+    
+    // Location data and file caches are loaded by startWarmup(), after
+    // the window is first shown
+    StartupTrace::Scope scope("Tables and connections");
+    m_liveChart = new LiveChart(ui->chartWidget, this);
     setupConnections();
     setupTables();
     
@@ -26,6 +60,8 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // The warm-up writes into members destroyed before the children
+    m_warmup->waitForFinished();
     delete ui;
 }
 
@@ -38,35 +74,170 @@ void MainWindow::setupConnections()
             this, &MainWindow::handleChartError);
     connect(ui->chartWidget, &ChartWidget::calculationsUpdated,
             this, &MainWindow::handleCalculationsUpdated);
+    connect(ui->chartWidget, &ChartWidget::chartPainted,
+            this, &MainWindow::handleChartPainted);
+    connect(ui->analysisTab, &QTabWidget::currentChanged,
+            this, &MainWindow::refreshVisibleTab);
+    connect(m_liveChart, &LiveChart::ticked,
+            this, &MainWindow::handleLiveTick);
+    connect(m_liveChart, &LiveChart::errorOccurred,
+            this, &MainWindow::handleLiveError);
+            
+    // Connect geocoder
+    m_geocoder->setEndpoint(QUrl(OPENCAGE_API_URL));
+    m_geocoder->setApiKey(OPENCAGE_API_KEY);
+    connect(m_geocoder, &Geocoder::finished,
+            this, &MainWindow::handleGeocodeResult);
+    connect(m_warmup, &StartupWarmup::finished,
+            this, &MainWindow::handleWarmupFinished);
             
-    // Connect network manager
-    connect(m_networkManager, &QNetworkAccessManager::finished,
-            this, &MainWindow::handleGeocodeResponse);
+    // Suggestions come ranked from the gazetteer, so the completer shows
+    // the model as is instead of filtering it again
+    m_placeCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    m_placeCompleter->setMaxVisibleItems(PLACE_SUGGESTIONS);
+    ui->placeInput->setCompleter(m_placeCompleter);
+    connect(ui->placeInput, &QLineEdit::textEdited,
+            this, &MainWindow::completePlace);
+    connect(m_placeCompleter, static_cast<void (QCompleter::*)(const QModelIndex&)>(&QCompleter::activated),
+            this, &MainWindow::handlePlaceActivated);
+}
+
+void MainWindow::startWarmup()
+{
+    if (m_warmup->isStarted()) {
+        return;
+    }
+    
+    // Opening the gazetteer and the time zone index validates every
+    // record; the geocoder cache reads its whole index
+    m_warmup->addTask("Location data", [this]() { openLocationData(); });
+    m_warmup->addTask("Geocoder cache", [this]() {
+        m_geocoder->setCacheFile(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+                                 .filePath(GEOCODE_CACHE_FILE));
+    });
+#ifdef EPHE_PATH
+    m_warmup->addTask("Ephemeris and star catalog", []() {
+        StartupWarmup::prefetchDirectory(EPHE_PATH, {"*.se1", "sefstars.txt"});
+    });
+#endif
+    m_warmup->start();
+}
+
+void MainWindow::ensureWarm()
+{
+    startWarmup();
+    m_warmup->waitForFinished();
+}
+
+void MainWindow::handleWarmupFinished()
+{
+    StartupTrace::instance().finish();
+}
+
+QStringList MainWindow::locationDataPaths(const QString& fileName) const
+{
+    // geo/ next to the executable, then the per-user data directory
+    QStringList candidates;
+    candidates << QDir(QCoreApplication::applicationDirPath()).filePath("geo/" + fileName);
+    const QString dataFile = QStandardPaths::locate(QStandardPaths::AppDataLocation, fileName);
+    if (!dataFile.isEmpty()) {
+        candidates << dataFile;
+    }
+    return candidates;
+}
+
+void MainWindow::openLocationData()
+{
+    for (const QString& path : locationDataPaths(GAZETTEER_FILE)) {
+        if (!QFile::exists(path)) {
+            continue;
+        }
+        if (m_gazetteer.open(path)) {
+            break;
+        }
+        qWarning() << "Gazetteer not loaded:" << m_gazetteer.errorString();
+    }
+    
+    for (const QString& path : locationDataPaths(TIME_ZONE_INDEX_FILE)) {
+        if (!QFile::exists(path)) {
+            continue;
+        }
+        if (m_timeZones.open(path)) {
+            break;
+        }
+        qWarning() << "Time zone index not loaded:" << m_timeZones.errorString();
+    }
+}
+
+void MainWindow::completePlace(const QString& text)
+{
+    m_placeZone.clear();
+    // No suggestions until the warm-up has opened the gazetteer
+    if (m_warmup->isRunning() || !m_gazetteer.isOpen()) {
+        return;
+    }
+    
+    m_placeMatches = m_gazetteer.complete(text, PLACE_SUGGESTIONS);
+    QStringList names;
+    names.reserve(m_placeMatches.size());
+    for (const Gazetteer::Place& place : m_placeMatches) {
+        names << place.displayName();
+    }
+    m_placeModel->setStringList(names);
+    if (!names.isEmpty()) {
+        m_placeCompleter->complete();
+    }
+}
+
+void MainWindow::handlePlaceActivated(const QModelIndex& index)
+{
+    if (index.row() >= 0 && index.row() < m_placeMatches.size()) {
+        applyPlace(m_placeMatches[index.row()]);
+    }
+}
+
+void MainWindow::applyPlace(const Gazetteer::Place& place)
+{
+    // A network search still running would overwrite the local answer
+    m_geocoder->cancel(m_geocodeRequest);
+    m_geocodeRequest = 0;
+    ui->latInput->setText(QString::number(place.latitude, 'f', 6));
+    ui->lonInput->setText(QString::number(place.longitude, 'f', 6));
+    m_placeZone = place.timezone;
+    ui->statusbar->showMessage("Location found: " + place.displayName(), 3000);
 }
 
 void MainWindow::setupTables()
 {
-    // Setup Dasha table
-    ui->dashaTable->setColumnCount(4);
-    ui->dashaTable->setHorizontalHeaderLabels(
-        {"Planet", "Start Time", "End Time", "Sub-periods"}
-    );
+    // Dasha periods as a tree down to the prana dasha; the levels below
+    // the mahadasha are calculated as they are expanded
+    m_dashaModel->setDepth(DashaTreeModel::MaxDepth);
+    m_dashaProxy->setSourceModel(m_dashaModel);
+    ui->dashaTable->setModel(m_dashaProxy);
+    ui->dashaTable->setUniformRowHeights(true);
     
-    // Setup Strength table
-    ui->strengthTable->setColumnCount(7);
-    ui->strengthTable->setHorizontalHeaderLabels(
-        {"Planet", "Shadbala", "Sthanabala", "Digbala", 
-         "Drishti Bala", "Kala Bala", "Naisargika Bala"}
-    );
+    // Strength and yoga tables
+    m_strengthProxy->setSourceModel(m_strengthModel);
+    ui->strengthTable->setModel(m_strengthProxy);
+    m_yogaProxy->setSourceModel(m_yogaModel);
+    ui->yogaTable->setModel(m_yogaProxy);
     
-    // Setup Yoga table
-    ui->yogaTable->setColumnCount(3);
-    ui->yogaTable->setHorizontalHeaderLabels(
-        {"Yoga Name", "Description", "Strength"}
-    );
+    // Setup Ashtakavarga table: one row per chart plus the Sarvashtakavarga
+    QStringList signColumns = {"Chart", "Ar", "Ta", "Ge", "Cn", "Le", "Vi",
+                               "Li", "Sc", "Sg", "Cp", "Aq", "Pi", "Total"};
+    ui->ashtakavargaTable->setColumnCount(signColumns.size());
+    ui->ashtakavargaTable->setHorizontalHeaderLabels(signColumns);
     
-    // Enable sorting
+    // Sort on the raw values through the proxies, once per load rather
+    // than per row; column widths are sized from a sample of rows
+    for (QSortFilterProxyModel* proxy : {m_dashaProxy, m_strengthProxy, m_yogaProxy}) {
+        proxy->setSortRole(SortRole);
+    }
+    ui->dashaTable->header()->setResizeContentsPrecision(COLUMN_SIZE_SAMPLE);
+    ui->strengthTable->horizontalHeader()->setResizeContentsPrecision(COLUMN_SIZE_SAMPLE);
+    ui->yogaTable->horizontalHeader()->setResizeContentsPrecision(COLUMN_SIZE_SAMPLE);
     ui->dashaTable->setSortingEnabled(true);
+    ui->dashaTable->sortByColumn(DashaTreeModel::StartColumn, Qt::AscendingOrder);
     ui->strengthTable->setSortingEnabled(true);
     ui->yogaTable->setSortingEnabled(true);
 }
@@ -76,6 +247,8 @@ void MainWindow::on_generateButton_clicked()
     if (!validateInputs()) {
         return;
     }
+    // A birth chart replaces the live one
+    ui->liveCheck->setChecked(false);
     generateChart();
 }
 
@@ -91,67 +264,113 @@ void MainWindow::on_searchButton_clicked()
 
 void MainWindow::searchLocation(const QString& place)
 {
-    QUrlQuery query;
-    query.addQueryItem("q", place);
-    query.addQueryItem("key", OPENCAGE_API_KEY);
-    query.addQueryItem("limit", "1");
-    
-    QUrl url(OPENCAGE_API_URL);
-    url.setQuery(query);
+    ensureWarm();
     
-    QNetworkRequest request(url);
-    m_networkManager->get(request);
+    // A suggestion that was picked, then the best local match for the
+    // text or for its first component ("Paris, France")
+    for (const Gazetteer::Place& match : m_placeMatches) {
+        if (match.displayName() == place) {
+            applyPlace(match);
+            return;
+        }
+    }
+    if (m_gazetteer.isOpen()) {
+        for (const QString& key : {place, place.section(',', 0, 0)}) {
+            const QVector<Gazetteer::Place> matches = m_gazetteer.complete(key, 1);
+            if (!matches.isEmpty()) {
+                applyPlace(matches.first());
+                return;
+            }
+        }
+    }
     
+    // Repeated and concurrent searches are answered from the geocoder's
+    // cache or share its request; a new search supersedes the last one
+    m_geocodeRequest = m_geocoder->lookup(place);
     ui->statusbar->showMessage("Searching location...");
 }
 
-void MainWindow::handleGeocodeResponse(QNetworkReply* reply)
+void MainWindow::handleGeocodeResult(quint64 id, const Geocoder::Result& result)
 {
-    reply->deleteLater();
-    
-    if (reply->error() != QNetworkReply::NoError) {
-        showError("Network error: " + reply->errorString());
+    if (id != m_geocodeRequest) {
         return;
     }
+    m_geocodeRequest = 0;
+    m_placeZone.clear();
     
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-    QJsonObject root = doc.object();
-    
-    if (root["total_results"].toInt() == 0) {
+    if (!result.ok()) {
+        showError(result.error);
+        return;
+    }
+    if (!result.found) {
         showError("Location not found");
         return;
     }
     
-    QJsonArray results = root["results"].toArray();
-    QJsonObject result = results.first().toObject();
-    QJsonObject geometry = result["geometry"].toObject();
-    
-    double lat = geometry["lat"].toDouble();
-    double lon = geometry["lng"].toDouble();
-    
-    ui->latInput->setText(QString::number(lat, 'f', 6));
-    ui->lonInput->setText(QString::number(lon, 'f', 6));
+    ui->latInput->setText(QString::number(result.latitude, 'f', 6));
+    ui->lonInput->setText(QString::number(result.longitude, 'f', 6));
     
     ui->statusbar->showMessage("Location found", 3000);
 }
 
 void MainWindow::generateChart()
 {
-    QDateTime birthTime(ui->dateInput->date(), ui->timeInput->time());
+    ChartTrace::instance().beginGeneration();
+    CHART_TRACE("calc", "Generate chart");
     QString place = ui->placeInput->text();
     double lat = ui->latInput->text().toDouble();
     double lon = ui->lonInput->text().toDouble();
+    QDateTime birthTime = birthDateTime(ui->dateInput->date(), ui->timeInput->time(), lat, lon);
     
     ui->chartWidget->setBirthData(birthTime, place, lat, lon);
     ui->chartWidget->generateChart();
 }
 
+QDateTime MainWindow::birthDateTime(const QDate& date, const QTime& time, double lat, double lon)
+{
+    // The entered time is the wall clock at the birthplace, under the
+    // offset in force there on that date
+    ensureWarm();
+    if (m_timeZones.isOpen()) {
+        const TimeZoneIndex::Resolution zone = m_timeZones.resolve(lat, lon, date, time);
+        if (zone.isValid()) {
+            m_birthZone = zone.zone;
+            return QDateTime(date, time, Qt::OffsetFromUTC, zone.utcOffset);
+        }
+    }
+    
+    // Without the index, the zone of a place picked from the gazetteer
+    const QTimeZone placeZone(m_placeZone.toLatin1());
+    if (!m_placeZone.isEmpty() && placeZone.isValid()) {
+        m_birthZone = m_placeZone;
+        return QDateTime(date, time, placeZone);
+    }
+    
+    m_birthZone.clear();
+    return QDateTime(date, time);
+}
+
 void MainWindow::handleChartGenerated()
 {
-    updateDashaTable();
-    updateStrengthTable();
-    updateYogaTable();
-    ui->statusbar->showMessage("Chart generated successfully", 3000);
+    m_staleTabs = ChartWidget::AllResults;
+    refreshVisibleTab();
+    QString message = "Chart generated successfully";
+    if (!m_birthZone.isEmpty()) {
+        const int offset = ui->chartWidget->getChartData().birthTime.offsetFromUtc();
+        message += QString(" (%1, UTC%2%3)").arg(m_birthZone, offset < 0 ? "-" : "+",
+                                                 QTime(0, 0).addSecs(qAbs(offset)).toString("hh:mm"));
+    }
+    m_generatedMessage = message;
+    ui->statusbar->showMessage(message, 3000);
+}
+
+void MainWindow::handleChartPainted()
+{
+    // Stage timings of the generation, once its first paint is in
+    const QString summary = ChartTrace::instance().summary();
+    if (!summary.isEmpty()) {
+        ui->statusbar->showMessage(m_generatedMessage + " | " + summary, 8000);
+    }
 }
 
 void MainWindow::handleChartError(const QString& error)
@@ -161,84 +380,88 @@ void MainWindow::handleChartError(const QString& error)
 
 void MainWindow::handleCalculationsUpdated()
 {
-    updateDashaTable();
-    updateStrengthTable();
-    updateYogaTable();
+    m_staleTabs = ChartWidget::AllResults;
+    refreshVisibleTab();
 }
 
-void MainWindow::updateDashaTable()
+int MainWindow::tabResult(QWidget* tab) const
+{
+    if (tab == ui->dashaTab) return ChartWidget::DashaResult;
+    if (tab == ui->strengthTab) return ChartWidget::StrengthResult;
+    if (tab == ui->yogaTab) return ChartWidget::YogaResult;
+    if (tab == ui->ashtakavargaTab) return ChartWidget::AshtakavargaResult;
+    return 0;
+}
+
+void MainWindow::refreshVisibleTab()
 {
-    ui->dashaTable->setRowCount(0);
+    // Hidden tabs stay stale, and the calculators behind them do not run,
+    // until they are shown
+    const int result = tabResult(ui->analysisTab->currentWidget()) & m_staleTabs;
+    if (!result) return;
+    m_staleTabs &= ~result;
     
-    QVector<DashaPeriod> dashaPeriods = ui->chartWidget->getDashaPeriods();
-    for (const DashaPeriod& period : dashaPeriods) {
-        int row = ui->dashaTable->rowCount();
-        ui->dashaTable->insertRow(row);
-        
-        ui->dashaTable->setItem(row, 0, 
-            new QTableWidgetItem(period.planet));
-        ui->dashaTable->setItem(row, 1, 
-            new QTableWidgetItem(period.startTime.toString("dd-MM-yyyy hh:mm")));
-        ui->dashaTable->setItem(row, 2, 
-            new QTableWidgetItem(period.endTime.toString("dd-MM-yyyy hh:mm")));
-        
-        QStringList subPeriods;
-        for (const DashaPeriod& sub : period.antarDashas) {
-            subPeriods << sub.planet;
-        }
-        ui->dashaTable->setItem(row, 3, 
-            new QTableWidgetItem(subPeriods.join(" → ")));
+    switch (result) {
+    case ChartWidget::DashaResult:        updateDashaTable(); break;
+    case ChartWidget::StrengthResult:     updateStrengthTable(); break;
+    case ChartWidget::YogaResult:         updateYogaTable(); break;
+    case ChartWidget::AshtakavargaResult: updateAshtakavargaTable(); break;
     }
-    
-    ui->dashaTable->resizeColumnsToContents();
 }
 
-void MainWindow::updateStrengthTable()
+void MainWindow::updateDashaTable()
 {
-    ui->strengthTable->setRowCount(0);
-    
-    auto strengths = ui->chartWidget->getPlanetaryStrengths();
-    for (auto it = strengths.begin(); it != strengths.end(); ++it) {
-        int row = ui->strengthTable->rowCount();
-        ui->strengthTable->insertRow(row);
-        
-        ui->strengthTable->setItem(row, 0, 
-            new QTableWidgetItem(it.key()));
-        ui->strengthTable->setItem(row, 1, 
-            new QTableWidgetItem(QString::number(it.value().shadbala, 'f', 2)));
-        ui->strengthTable->setItem(row, 2, 
-            new QTableWidgetItem(QString::number(it.value().sthanaBala, 'f', 2)));
-        ui->strengthTable->setItem(row, 3, 
-            new QTableWidgetItem(QString::number(it.value().digBala, 'f', 2)));
-        ui->strengthTable->setItem(row, 4, 
-            new QTableWidgetItem(QString::number(it.value().drishtisBala, 'f', 2)));
-        ui->strengthTable->setItem(row, 5, 
-            new QTableWidgetItem(QString::number(it.value().kalaBala, 'f', 2)));
-        ui->strengthTable->setItem(row, 6, 
-            new QTableWidgetItem(QString::number(it.value().naisargikaBala, 'f', 2)));
+    CHART_TRACE("table", "Dasha table");
+    m_dashaModel->setPeriods(ui->chartWidget->getDashaPeriods());
+    for (int column = 0; column < DashaTreeModel::ColumnCount; ++column) {
+        ui->dashaTable->resizeColumnToContents(column);
     }
-    
+}
+
+void MainWindow::updateStrengthTable()
+{
+    CHART_TRACE("table", "Strength table");
+    m_strengthModel->setStrengths(ui->chartWidget->getPlanetaryStrengths());
     ui->strengthTable->resizeColumnsToContents();
 }
 
 void MainWindow::updateYogaTable()
 {
-    ui->yogaTable->setRowCount(0);
+    CHART_TRACE("table", "Yoga table");
+    m_yogaModel->setYogas(ui->chartWidget->getActiveYogas());
+    ui->yogaTable->resizeColumnsToContents();
+}
+
+void MainWindow::updateAshtakavargaTable()
+{
+    CHART_TRACE("table", "Ashtakavarga table");
+    ui->ashtakavargaTable->setRowCount(0);
+    
+    auto ashtakavarga = ui->chartWidget->getAshtakavarga();
+    if (!ashtakavarga.valid) return;
+    
+    const int chartCount = AshtakavargaCalculator::ContributorCount;
+    ui->ashtakavargaTable->setRowCount(chartCount + 1);
     
-    QVector<YogaCalculator::Yoga> yogas = ui->chartWidget->getActiveYogas();
-    for (const auto& yoga : yogas) {
-        int row = ui->yogaTable->rowCount();
-        ui->yogaTable->insertRow(row);
+    for (int row = 0; row <= chartCount; ++row) {
+        bool isSarva = row == chartCount;
+        ui->ashtakavargaTable->setItem(row, 0, new QTableWidgetItem(
+            isSarva ? QString("Sarva") : AshtakavargaCalculator::chartName(row)));
         
-        ui->yogaTable->setItem(row, 0, 
-            new QTableWidgetItem(yoga.name));
-        ui->yogaTable->setItem(row, 1, 
-            new QTableWidgetItem(yoga.description));
-        ui->yogaTable->setItem(row, 2, 
-            new QTableWidgetItem(QString::number(yoga.strength, 'f', 1) + "%"));
+        for (int sign = 0; sign < 12; ++sign) {
+            int bindus = isSarva ? ashtakavarga.sarva[sign]
+                                 : ashtakavarga.bhinna[row][sign];
+            ui->ashtakavargaTable->setItem(row, sign + 1,
+                new QTableWidgetItem(QString::number(bindus)));
+        }
+        
+        int total = isSarva ? ashtakavarga.sarvaTotal()
+                            : ashtakavarga.bhinnaTotal(row);
+        ui->ashtakavargaTable->setItem(row, 13,
+            new QTableWidgetItem(QString::number(total)));
     }
     
-    ui->yogaTable->resizeColumnsToContents();
+    ui->ashtakavargaTable->resizeColumnsToContents();
 }
 
 void MainWindow::on_chartStyleCombo_currentIndexChanged(int index)
@@ -248,6 +471,11 @@ void MainWindow::on_chartStyleCombo_currentIndexChanged(int index)
     );
 }
 
+void MainWindow::on_vargaCombo_currentIndexChanged(int index)
+{
+    ui->chartWidget->setVarga(index);
+}
+
 void MainWindow::on_showAspectsCheck_stateChanged(int state)
 {
     ui->chartWidget->setShowAspects(state == Qt::Checked);
@@ -258,17 +486,94 @@ void MainWindow::on_enableZoomCheck_stateChanged(int state)
     ui->chartWidget->enableZoomAndPan(state == Qt::Checked);
 }
 
+void MainWindow::on_liveCheck_toggled(bool checked)
+{
+    if (!checked) {
+        m_liveChart->stop();
+        ui->prashnaLabel->hide();
+        ui->prashnaLabel->clear();
+        return;
+    }
+    if (ui->latInput->text().isEmpty() || ui->lonInput->text().isEmpty()) {
+        ui->liveCheck->setChecked(false);
+        showError("Please search for a valid location");
+        return;
+    }
+    
+    ui->prashnaLabel->show();
+    m_liveChart->start(ui->placeInput->text(), ui->latInput->text().toDouble(),
+                       ui->lonInput->text().toDouble());
+    ui->statusbar->showMessage("Live chart of the current moment", 3000);
+}
+
+void MainWindow::handleLiveTick(const QDateTime& now, const PrashnaCalculator::Moment& moment)
+{
+    Q_UNUSED(now);
+    // Readings of the question's moment, to the arcminute of the ascendant
+    const double degrees = std::fmod(moment.ascendant, 30.0);
+    const int arcminutes = static_cast<int>(degrees * 60.0);
+    QStringList rulers;
+    for (int planet : moment.rulingPlanets) {
+        rulers << QString(Astro::planetName(planet)).left(2);
+    }
+    const QString text = QString("Asc %1 %2\u00b0%3' | Moon %4, pada %5 | Day %6, hora %7 | "
+                                 "Ruling planets %8")
+        .arg(Astro::signName(moment.ascendantSign))
+        .arg(arcminutes / 60)
+        .arg(arcminutes % 60, 2, 10, QChar('0'))
+        .arg(PrashnaCalculator::nakshatraName(moment.nakshatra))
+        .arg(moment.pada)
+        .arg(Astro::planetName(moment.dayLord), Astro::planetName(moment.horaLord))
+        .arg(rulers.join(' '));
+    if (text != ui->prashnaLabel->text()) {
+        ui->prashnaLabel->setText(text);
+    }
+}
+
+void MainWindow::handleLiveError(const QString& error)
+{
+    ui->liveCheck->setChecked(false);
+    showError("Live chart stopped: " + error);
+}
+
 void MainWindow::on_actionExport_triggered()
 {
     QString fileName = QFileDialog::getSaveFileName(this,
-        "Export Chart", "", "PNG Image (*.png);;JPEG Image (*.jpg)");
+        "Export Chart", "", "PNG Image (*.png);;JPEG Image (*.jpg);;SVG Image (*.svg)");
         
-    if (!fileName.isEmpty()) {
-        ui->chartWidget->exportChart(fileName);
+    if (!fileName.isEmpty() && ui->chartWidget->exportChart(fileName)) {
         ui->statusbar->showMessage("Chart exported successfully", 3000);
     }
 }
 
+void MainWindow::on_actionExportReport_triggered()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,
+        "Export Report", "", "PDF Document (*.pdf)");
+    if (fileName.isEmpty()) return;
+    
+    const ChartWidget::ChartData& data = ui->chartWidget->getChartData();
+    ReportGenerator::Client client;
+    client.name = ui->nameInput->text().trimmed();
+    client.birthTime = data.birthTime;
+    client.birthPlace = data.birthPlace;
+    client.planetPositions = data.planetPositions;
+    client.planetSpeeds = data.planetSpeeds;
+    client.housePositions = data.housePositions;
+    
+    ReportGenerator::Options options;
+    options.chartStyle = static_cast<ChartRenderer::ChartStyle>(
+        ui->chartStyleCombo->currentIndex());
+    
+    ReportGenerator generator;
+    generator.setOptions(options);
+    if (generator.write(fileName, client)) {
+        ui->statusbar->showMessage("Report exported successfully", 3000);
+    } else {
+        showError("Could not write report to " + fileName);
+    }
+}
+
 void MainWindow::on_actionAbout_triggered()
 {
     QMessageBox::about(this, "About AstroProQt",
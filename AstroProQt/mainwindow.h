@@ -2,10 +2,17 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QJsonDocument>
 #include "chartwidget.h"
+#include "livechart.h"
+#include "resultmodels.h"
+#include "Location/gazetteer.h"
+#include "Location/geocoder.h"
+#include "Location/timezoneindex.h"
+
+class QCompleter;
+class StartupWarmup;
+class QSortFilterProxyModel;
+class QStringListModel;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -17,29 +24,73 @@ class MainWindow : public QMainWindow {
 public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    
+    // Loads what the first paint does not need on a background thread
+    void startWarmup();
 
 private slots:
     // UI Event Handlers
     void on_generateButton_clicked();
     void on_searchButton_clicked();
     void on_chartStyleCombo_currentIndexChanged(int index);
+    void on_vargaCombo_currentIndexChanged(int index);
     void on_showAspectsCheck_stateChanged(int state);
     void on_enableZoomCheck_stateChanged(int state);
+    void on_liveCheck_toggled(bool checked);
     void on_actionExport_triggered();
+    void on_actionExportReport_triggered();
     void on_actionAbout_triggered();
     void on_actionExit_triggered();
 
     // Network Response Handlers
-    void handleGeocodeResponse(QNetworkReply* reply);
+    void handleGeocodeResult(quint64 id, const Geocoder::Result& result);
+    void handleWarmupFinished();
+
+    // Offline place completion
+    void completePlace(const QString& text);
+    void handlePlaceActivated(const QModelIndex& index);
 
     // Chart Event Handlers
     void handleChartGenerated();
     void handleChartError(const QString& error);
+    void handleChartPainted();
     void handleCalculationsUpdated();
+    void refreshVisibleTab();
+    void handleLiveTick(const QDateTime& now, const PrashnaCalculator::Moment& moment);
+    void handleLiveError(const QString& error);
 
 private:
     Ui::MainWindow *ui;
-    QNetworkAccessManager* m_networkManager;
+    Geocoder* m_geocoder;
+    quint64 m_geocodeRequest;   // Lookup whose answer fills the coordinates
+    StartupWarmup* m_warmup;    // Opens the location data and the geocoder cache
+    
+    // Offline place search; OpenCage is only asked for places it lacks
+    Gazetteer m_gazetteer;
+    QStringListModel* m_placeModel;
+    QCompleter* m_placeCompleter;
+    QVector<Gazetteer::Place> m_placeMatches;   // Rows of m_placeModel
+    QString m_placeZone;   // Zone of the place picked from the gazetteer
+    
+    // Birthplace time zone, offline; m_birthZone names the last one used
+    TimeZoneIndex m_timeZones;
+    QString m_birthZone;
+    
+    // Result models; the views sort through the proxies
+    DashaTreeModel* m_dashaModel;
+    StrengthTableModel* m_strengthModel;
+    YogaTableModel* m_yogaModel;
+    QSortFilterProxyModel* m_dashaProxy;
+    QSortFilterProxyModel* m_strengthProxy;
+    QSortFilterProxyModel* m_yogaProxy;
+    
+    // ChartWidget::Result bits whose tab has not been refilled since the
+    // chart changed; a tab is refilled when it is shown
+    int m_staleTabs;
+    QString m_generatedMessage;   // Status of the last chart, before its timings
+    
+    // Chart of the current moment; the prashna line is only reset when it changes
+    LiveChart* m_liveChart;
     
     // Helper Methods
     void setupConnections();
@@ -48,8 +99,15 @@ private:
     void updateDashaTable();
     void updateStrengthTable();
     void updateYogaTable();
+    void updateAshtakavargaTable();
+    int tabResult(QWidget* tab) const;
     void showError(const QString& message);
     void searchLocation(const QString& place);
+    QStringList locationDataPaths(const QString& fileName) const;
+    void openLocationData();
+    void ensureWarm();
+    QDateTime birthDateTime(const QDate& date, const QTime& time, double lat, double lon);
+    void applyPlace(const Gazetteer::Place& place);
     
     // Data validation
     bool validateInputs();
@@ -57,6 +115,11 @@ private:
     // Constants
     const QString OPENCAGE_API_KEY = "YOUR_API_KEY"; // Replace with actual API key
     const QString OPENCAGE_API_URL = "https://api.opencagedata.com/geocode/v1/json";
+    const int COLUMN_SIZE_SAMPLE = 64;   // Rows measured when sizing result columns
+    const QString GAZETTEER_FILE = "gazetteer.bin";
+    const QString GEOCODE_CACHE_FILE = "geocode.cache";
+    const QString TIME_ZONE_INDEX_FILE = "timezones.bin";
+    const int PLACE_SUGGESTIONS = 10;
 };
 
 #endif // MAINWINDOW_H
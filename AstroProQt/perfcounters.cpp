@@ -0,0 +1,308 @@
+#include "perfcounters.h"
+#include <QMutexLocker>
+#include <QStringList>
+#include <QVector>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+int groupOf(int counter) {
+    return counter <= PerfCounters::BranchMisses ? 0 : 1;
+}
+
+// The counters of one thread, as two groups that are each read with one
+// system call: the core events and the cache events. Splitting them lets
+// each group fit the PMU on its own; the kernel multiplexes the two and
+// the totals are scaled by the time each group was running.
+class ThreadCounters {
+public:
+    ThreadCounters()
+        : m_opened(false)
+        , m_available(false) {
+        m_leader[0] = m_leader[1] = -1;
+    }
+
+    ~ThreadCounters() {
+#if defined(__linux__)
+        for (int fd : m_fds) {
+            ::close(fd);
+        }
+#endif
+    }
+
+    bool ensureOpen() {
+        if (!m_opened) {
+            m_opened = true;
+            m_available = open();
+        }
+        return m_available;
+    }
+
+    QString reason() const { return m_reason; }
+
+    bool read(PerfCounters::Reading& reading) const {
+        std::memset(&reading, 0, sizeof(reading));
+#if defined(__linux__)
+        for (int group = 0; group < 2; ++group) {
+            if (m_leader[group] < 0) continue;
+            // nr, time_enabled, time_running, then one value per member
+            quint64 buffer[3 + PerfCounters::CounterCount];
+            const ssize_t size = ::read(m_leader[group], buffer, sizeof(buffer));
+            if (size < ssize_t(3 * sizeof(quint64))) return false;
+            reading.enabled[group] = buffer[1];
+            reading.running[group] = buffer[2];
+            const int members = qMin(int(buffer[0]), m_members[group].size());
+            for (int i = 0; i < members; ++i) {
+                const int counter = m_members[group][i];
+                reading.raw[counter] = buffer[3 + i];
+                reading.opened |= 1u << counter;
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+private:
+    bool open() {
+#if defined(__linux__)
+        const struct {
+            PerfCounters::Counter counter;
+            quint32 type;
+            quint64 config;
+        } events[] = {
+            {PerfCounters::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PerfCounters::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PerfCounters::Branches, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+            {PerfCounters::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PerfCounters::L1DReads, PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16)},
+            {PerfCounters::L1DMisses, PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PerfCounters::LLCMisses, PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}
+        };
+
+        int firstError = 0;
+        for (const auto& event : events) {
+            const int group = groupOf(event.counter);
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = event.type;
+            attr.config = event.config;
+            attr.disabled = m_leader[group] < 0 ? 1 : 0;   // The leader starts the group
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED
+                             | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            // This thread, any CPU
+            const int fd = int(syscall(__NR_perf_event_open, &attr, 0, -1,
+                                       m_leader[group], PERF_FLAG_FD_CLOEXEC));
+            if (fd < 0) {
+                // An event the CPU lacks leaves the others usable
+                if (!firstError) firstError = errno;
+                continue;
+            }
+            m_fds.append(fd);
+            if (m_leader[group] < 0) m_leader[group] = fd;
+            m_members[group].append(event.counter);
+        }
+
+        if (m_leader[0] < 0 && m_leader[1] < 0) {
+            switch (firstError) {
+            case EACCES:
+            case EPERM:
+                m_reason = "perf_event_open is not permitted; "
+                           "lower /proc/sys/kernel/perf_event_paranoid to 2 or less";
+                break;
+            case ENOENT:
+            case EOPNOTSUPP:
+                m_reason = "the CPU exposes no hardware events (a virtual machine?)";
+                break;
+            case ENOSYS:
+                m_reason = "the kernel was built without perf_event";
+                break;
+            default:
+                m_reason = QString("perf_event_open failed: %1").arg(std::strerror(firstError));
+                break;
+            }
+            return false;
+        }
+
+        for (int group = 0; group < 2; ++group) {
+            if (m_leader[group] < 0) continue;
+            ioctl(m_leader[group], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(m_leader[group], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+        return true;
+#else
+        m_reason = "hardware counters are only read on Linux";
+        return false;
+#endif
+    }
+
+    bool m_opened;
+    bool m_available;
+    QString m_reason;
+    int m_leader[2];
+    QVector<int> m_members[2];   // Counter of each group member, in read order
+    QVector<int> m_fds;
+};
+
+thread_local ThreadCounters threadCounters;
+
+} // namespace
+
+PerfCounters::Totals::Totals()
+    : calls(0)
+    , wallNs(0) {
+    for (int i = 0; i < CounterCount; ++i) {
+        value[i] = 0.0;
+        counted[i] = false;
+    }
+}
+
+double PerfCounters::Totals::ipc() const {
+    return has(Cycles) && has(Instructions) && value[Cycles] > 0
+        ? value[Instructions] / value[Cycles] : -1.0;
+}
+
+double PerfCounters::Totals::l1dMissRate() const {
+    return has(L1DReads) && has(L1DMisses) && value[L1DReads] > 0
+        ? value[L1DMisses] / value[L1DReads] : -1.0;
+}
+
+double PerfCounters::Totals::llcMissesPerKilo() const {
+    return has(LLCMisses) && has(Instructions) && value[Instructions] > 0
+        ? value[LLCMisses] * 1000.0 / value[Instructions] : -1.0;
+}
+
+double PerfCounters::Totals::branchMissRate() const {
+    return has(Branches) && has(BranchMisses) && value[Branches] > 0
+        ? value[BranchMisses] / value[Branches] : -1.0;
+}
+
+PerfCounters::Region::Region(const char* name)
+    : m_name(name)
+    , m_active(PerfCounters::instance().isEnabled())
+    , m_counted(false) {
+    if (!m_active) return;
+    if (threadCounters.ensureOpen()) {
+        m_counted = threadCounters.read(m_start);
+    } else {
+        PerfCounters::instance().noteUnavailable(threadCounters.reason());
+    }
+    m_timer.start();
+}
+
+PerfCounters::Region::~Region() {
+    if (!m_active) return;
+    // Counters first, so the bookkeeping below is not counted
+    Reading end;
+    const bool counted = m_counted && threadCounters.read(end);
+    const qint64 wallNs = m_timer.nsecsElapsed();
+    PerfCounters::instance().add(m_name, wallNs, counted ? &m_start : nullptr,
+                                 counted ? &end : nullptr);
+}
+
+PerfCounters::PerfCounters()
+    : m_enabled(0) {
+}
+
+PerfCounters& PerfCounters::instance() {
+    static PerfCounters counters;
+    return counters;
+}
+
+void PerfCounters::setEnabled(bool enabled) {
+    m_enabled.storeRelease(enabled ? 1 : 0);
+}
+
+bool PerfCounters::isAvailable() {
+    if (threadCounters.ensureOpen()) return true;
+    noteUnavailable(threadCounters.reason());
+    return false;
+}
+
+QString PerfCounters::unavailableReason() const {
+    QMutexLocker locker(&m_mutex);
+    return m_unavailableReason;
+}
+
+void PerfCounters::noteUnavailable(const QString& reason) {
+    QMutexLocker locker(&m_mutex);
+    m_unavailableReason = reason;
+}
+
+void PerfCounters::add(const char* name, qint64 wallNs, const Reading* start, const Reading* end) {
+    QMutexLocker locker(&m_mutex);
+    Totals& totals = m_totals[QString::fromUtf8(name)];
+    ++totals.calls;
+    totals.wallNs += wallNs;
+    if (!start || !end) return;
+
+    for (int counter = 0; counter < CounterCount; ++counter) {
+        if (!(start->opened & end->opened & (1u << counter))) continue;
+        const int group = groupOf(counter);
+        const quint64 running = end->running[group] - start->running[group];
+        if (running == 0) continue;     // The group was never scheduled
+        const double scale = double(end->enabled[group] - start->enabled[group]) / running;
+        totals.value[counter] += double(end->raw[counter] - start->raw[counter]) * scale;
+        totals.counted[counter] = true;
+    }
+}
+
+QMap<QString, PerfCounters::Totals> PerfCounters::totals() const {
+    QMutexLocker locker(&m_mutex);
+    return m_totals;
+}
+
+PerfCounters::Totals PerfCounters::totals(const QString& region) const {
+    QMutexLocker locker(&m_mutex);
+    return m_totals.value(region);
+}
+
+void PerfCounters::reset() {
+    QMutexLocker locker(&m_mutex);
+    m_totals.clear();
+}
+
+QString PerfCounters::report() const {
+    const QMap<QString, Totals> regions = totals();
+    const QString reason = unavailableReason();
+
+    auto format = [](double value, double factor, int precision) {
+        return value < 0 ? QString("n/a") : QString::number(value * factor, 'f', precision);
+    };
+
+    QString text = "Hardware counters (user space, nested regions included)\n";
+    if (!reason.isEmpty()) {
+        text += QString("  Unavailable: %1; showing calls and time only\n").arg(reason);
+    }
+    text += QString("  %1 %2 %3 %4 %5 %6 %7\n")
+        .arg("Region", -32).arg("Calls", 9).arg("ms", 10).arg("IPC", 6)
+        .arg("L1D miss", 9).arg("LLC MPKI", 9).arg("Br miss", 8);
+    for (auto it = regions.constBegin(); it != regions.constEnd(); ++it) {
+        const Totals& totals = it.value();
+        text += QString("  %1 %2 %3 %4 %5 %6 %7\n")
+            .arg(it.key(), -32)
+            .arg(totals.calls, 9)
+            .arg(QString::number(totals.wallNs / 1e6, 'f', 2), 10)
+            .arg(format(totals.ipc(), 1.0, 2), 6)
+            .arg(format(totals.l1dMissRate(), 100.0, 2) + (totals.l1dMissRate() < 0 ? "" : "%"), 9)
+            .arg(format(totals.llcMissesPerKilo(), 1.0, 2), 9)
+            .arg(format(totals.branchMissRate(), 100.0, 2) + (totals.branchMissRate() < 0 ? "" : "%"), 8);
+    }
+    return text;
+}
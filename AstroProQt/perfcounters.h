@@ -0,0 +1,101 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+
+// Hardware event counts around named regions, from Linux perf_event:
+// cycles, instructions, branches and branch misses, L1 data cache reads and
+// misses, and last level cache read misses. Counters are opened per thread
+// on first use and count user space only. Where they cannot be opened
+// (another OS, a kernel.perf_event_paranoid setting, a VM without a PMU)
+// regions still record calls and wall time, and the report says why.
+//
+// Regions nest and their counts are inclusive. The PERF_REGION macro is
+// compiled out unless ASTROPRO_PERF_COUNTERS is defined.
+class PerfCounters {
+public:
+    enum Counter {
+        Cycles,
+        Instructions,
+        Branches,
+        BranchMisses,
+        L1DReads,
+        L1DMisses,
+        LLCMisses,
+        CounterCount
+    };
+
+    // Sums over every call of a region
+    struct Totals {
+        qint64 calls;
+        qint64 wallNs;
+        double value[CounterCount];   // Scaled for multiplexing
+        bool counted[CounterCount];
+
+        Totals();
+        bool has(Counter counter) const { return counted[counter]; }
+        double ipc() const;
+        double l1dMissRate() const;      // Fraction of L1 data reads
+        double llcMissesPerKilo() const; // Per thousand instructions
+        double branchMissRate() const;   // Fraction of branches
+    };
+
+    // Raw counts at one moment on the calling thread
+    struct Reading {
+        quint64 raw[CounterCount];
+        quint64 enabled[2];             // Per counter group
+        quint64 running[2];
+        quint32 opened;                 // Bit per Counter
+    };
+
+    class Region {
+    public:
+        explicit Region(const char* name);
+        ~Region();
+
+    private:
+        const char* m_name;
+        bool m_active;
+        bool m_counted;
+        Reading m_start;
+        QElapsedTimer m_timer;
+    };
+
+    static PerfCounters& instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled.loadAcquire() != 0; }
+    // Opens the counters on the calling thread if needed
+    bool isAvailable();
+    QString unavailableReason() const;
+
+    QMap<QString, Totals> totals() const;
+    Totals totals(const QString& region) const;
+    void reset();
+    // One line per region: calls, time, IPC and miss rates
+    QString report() const;
+
+private:
+    PerfCounters();
+    void add(const char* name, qint64 wallNs, const Reading* start, const Reading* end);
+    void noteUnavailable(const QString& reason);
+
+    QAtomicInt m_enabled;
+    mutable QMutex m_mutex;
+    QMap<QString, Totals> m_totals;
+    QString m_unavailableReason;
+};
+
+#ifdef ASTROPRO_PERF_COUNTERS
+#define PERF_REGION_CONCAT2(a, b) a##b
+#define PERF_REGION_CONCAT(a, b) PERF_REGION_CONCAT2(a, b)
+#define PERF_REGION(name) PerfCounters::Region PERF_REGION_CONCAT(perfRegion, __LINE__)(name)
+#else
+#define PERF_REGION(name) do {} while (false)
+#endif
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,299 @@
+#include "reportgenerator.h"
+#include "batchrunner.h"
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QPdfWriter>
+#include "Calculators/dashacalculator.h"
+#include "Calculators/strengthcalculator.h"
+#include "Calculators/yogacalculator.h"
+
+namespace {
+
+const int MaxDashaDepth = 5;
+const char* const dashaLevelNames[MaxDashaDepth] = {
+    "Mahadasha", "Antardasha", "Pratyantardasha", "Sookshma", "Prana"
+};
+
+// Points, with the writer at 72 dpi
+const double PageMargin = 36;
+const double CellPadding = 3;
+const double LevelIndent = 10;
+
+// Keeps the vertical position on the current page and breaks pages
+class PageWriter {
+public:
+    PageWriter(QPdfWriter& writer, QPainter& painter)
+        : m_writer(writer), m_painter(painter), m_y(0) {}
+
+    QPainter& painter() { return m_painter; }
+    double width() const { return m_writer.width(); }
+    double y() const { return m_y; }
+    void advance(double height) { m_y += height; }
+
+    void newPage() {
+        m_writer.newPage();
+        m_y = 0;
+    }
+
+    // Start a new page unless height more points fit on this one
+    bool reserve(double height) {
+        if (m_y > 0 && m_y + height > m_writer.height()) {
+            newPage();
+            return true;
+        }
+        return false;
+    }
+
+    void heading(const QString& text) {
+        m_painter.setFont(QFont("Arial", 14, QFont::Bold));
+        line(text, 8);
+    }
+
+    void text(const QString& text) {
+        m_painter.setFont(QFont("Arial", 10));
+        line(text, 2);
+    }
+
+private:
+    void line(const QString& text, double spacing) {
+        const double height = QFontMetricsF(m_painter.font()).height();
+        reserve(height + spacing);
+        m_painter.setPen(Qt::black);
+        m_painter.drawText(QRectF(0, m_y, width(), height), Qt::AlignLeft | Qt::AlignVCenter, text);
+        m_y += height + spacing;
+    }
+
+    QPdfWriter& m_writer;
+    QPainter& m_painter;
+    double m_y;
+};
+
+// Rows of text cells; the header is repeated at the top of every page
+class TableWriter {
+public:
+    TableWriter(PageWriter& page, const QStringList& headers, const QVector<double>& widths)
+        : m_page(page), m_headers(headers), m_font("Arial", 9), m_headerFont("Arial", 9, QFont::Bold)
+    {
+        // Column widths are fractions of the page width
+        double x = 0;
+        for (double fraction : widths) {
+            m_columns.append(x);
+            x += fraction * page.width();
+        }
+        m_columns.append(x);
+        m_rowHeight = QFontMetricsF(m_font).height() + 2 * CellPadding;
+        
+        m_page.reserve(2 * m_rowHeight);
+        header();
+    }
+
+    void row(const QStringList& cells, int indent = 0) {
+        if (m_page.reserve(m_rowHeight)) header();
+        m_page.painter().setFont(m_font);
+        draw(cells, indent);
+    }
+
+    void finish() { m_page.advance(m_rowHeight); }
+
+private:
+    void header() {
+        QPainter& painter = m_page.painter();
+        painter.fillRect(QRectF(0, m_page.y(), m_columns.last(), m_rowHeight), QColor(224, 224, 224));
+        painter.setFont(m_headerFont);
+        draw(m_headers, 0);
+    }
+
+    void draw(const QStringList& cells, int indent) {
+        QPainter& painter = m_page.painter();
+        const QFontMetricsF metrics(painter.font());
+        painter.setPen(Qt::black);
+        for (int i = 0; i < cells.size() && i + 1 < m_columns.size(); ++i) {
+            const double left = m_columns[i] + CellPadding + (i == 0 ? indent * LevelIndent : 0);
+            const double width = m_columns[i + 1] - left - CellPadding;
+            painter.drawText(QRectF(left, m_page.y(), width, m_rowHeight),
+                             Qt::AlignLeft | Qt::AlignVCenter,
+                             metrics.elidedText(cells[i], Qt::ElideRight, width));
+        }
+        painter.setPen(QColor(192, 192, 192));
+        painter.drawLine(QPointF(0, m_page.y() + m_rowHeight),
+                         QPointF(m_columns.last(), m_page.y() + m_rowHeight));
+        m_page.advance(m_rowHeight);
+    }
+
+    PageWriter& m_page;
+    QStringList m_headers;
+    QFont m_font;
+    QFont m_headerFont;
+    QVector<double> m_columns;
+    double m_rowHeight;
+};
+
+QString formatTime(const QDateTime& time) {
+    return time.toString("dd-MM-yyyy hh:mm");
+}
+
+// One period and, depth permitting, its sub-periods. Below the antardasha
+// each level is computed as it is written and dropped straight after.
+void writeDasha(TableWriter& table, DashaCalculator& calculator,
+                const DashaPeriod& period, int level, int depth) {
+    table.row({period.planet, dashaLevelNames[level],
+               formatTime(period.startTime), formatTime(period.endTime)}, level);
+    if (level + 1 >= depth) return;
+    
+    const QVector<DashaPeriod> subPeriods =
+        level == 0 ? period.antarDashas : calculator.calculateAntarDasha(period);
+    for (const DashaPeriod& subPeriod : subPeriods) {
+        writeDasha(table, calculator, subPeriod, level + 1, depth);
+    }
+}
+
+void writeCharts(PageWriter& page, const ChartRenderer::Chart& chart,
+                 ChartRenderer::ChartStyle style) {
+    const int vargas[] = {VargaCalculator::D1, VargaCalculator::D9};
+    const double gap = 18;
+    const double side = (page.width() - gap) / 2;
+    const double captionHeight = 16;
+    page.reserve(side + captionHeight);
+    
+    ChartRenderer renderer;
+    QPainter& painter = page.painter();
+    for (int i = 0; i < 2; ++i) {
+        ChartRenderer::Options options;
+        options.style = style;
+        options.varga = vargas[i];
+        renderer.setOptions(options);
+        
+        painter.save();
+        painter.translate(i * (side + gap), page.y());
+        renderer.render(painter, QSizeF(side, side), chart);
+        painter.setPen(Qt::black);
+        painter.setFont(QFont("Arial", 10, QFont::Bold));
+        painter.drawText(QRectF(0, side, side, captionHeight), Qt::AlignCenter,
+                         i == 0 ? "Rasi (D1)" : "Navamsa (D9)");
+        painter.restore();
+    }
+    page.advance(side + captionHeight + 12);
+}
+
+} // namespace
+
+ReportGenerator::ReportGenerator()
+    : m_threads(0)
+{
+}
+
+bool ReportGenerator::write(const QString& filePath, const Client& client) const {
+    // Calculations for this report only
+    const ChartRenderer::Chart chart =
+        ChartRenderer::Chart::build(client.planetPositions, client.housePositions);
+    
+    StrengthCalculator strengthCalculator;
+    const QMap<QString, StrengthCalculator::PlanetaryStrength> strengths =
+        strengthCalculator.calculateAllStrengths(
+            client.planetPositions, client.housePositions, client.birthTime,
+            client.planetSpeeds, &chart.aspects, &chart.vargas);
+    
+    YogaCalculator yogaCalculator;
+    const QVector<YogaCalculator::Yoga> yogas = yogaCalculator.detectActiveYogas(
+        client.planetPositions, client.housePositions, strengths,
+        &chart.aspects, &chart.vargas);
+    
+    DashaCalculator dashaCalculator;
+    QVector<DashaPeriod> dashas;
+    if (client.planetPositions.contains("Moon")) {
+        dashas = dashaCalculator.calculateVimshottariDasha(
+            client.birthTime, client.planetPositions.value("Moon"));
+    }
+    
+    QPdfWriter writer(filePath);
+    writer.setResolution(72);
+    writer.setPageSize(m_options.pageSize);
+    writer.setPageMargins(QMarginsF(PageMargin, PageMargin, PageMargin, PageMargin),
+                          QPageLayout::Point);
+    writer.setTitle(QString("%1 - Birth Chart Report").arg(client.name));
+    writer.setCreator("AstroProQt");
+    
+    QPainter painter;
+    if (!painter.begin(&writer)) return false;
+    painter.setRenderHint(QPainter::Antialiasing);
+    PageWriter page(writer, painter);
+    
+    // Birth details and charts
+    page.heading(client.name.isEmpty() ? QString("Birth Chart Report") : client.name);
+    page.text(QString("Born %1").arg(client.birthTime.toString("dd MMMM yyyy, hh:mm t")));
+    if (!client.birthPlace.isEmpty()) {
+        page.text(client.birthPlace);
+    }
+    page.advance(10);
+    writeCharts(page, chart, m_options.chartStyle);
+    
+    // Vimshottari dasha
+    const int depth = qBound(1, m_options.dashaDepth, MaxDashaDepth);
+    page.heading("Vimshottari Dasha");
+    {
+        TableWriter table(page, {"Planet", "Level", "Start", "End"}, {0.3, 0.2, 0.25, 0.25});
+        for (const DashaPeriod& period : dashas) {
+            writeDasha(table, dashaCalculator, period, 0, depth);
+        }
+        table.finish();
+    }
+    
+    // Shadbala, in the traditional planet order
+    page.heading("Planetary Strength");
+    {
+        TableWriter table(page,
+            {"Planet", "Shadbala", "Sthanabala", "Digbala", "Kala Bala",
+             "Cheshta Bala", "Rupas / Required", "Vimsopaka"},
+            {0.14, 0.11, 0.11, 0.1, 0.11, 0.12, 0.18, 0.13});
+        for (int planet = 0; planet < Astro::PlanetCount; ++planet) {
+            const QString name = Astro::planetName(planet);
+            if (!strengths.contains(name)) continue;
+            const StrengthCalculator::PlanetaryStrength& strength = strengths[name];
+            table.row({name,
+                       QString::number(strength.shadbala, 'f', 2),
+                       QString::number(strength.sthanaBala, 'f', 2),
+                       QString::number(strength.digBala, 'f', 2),
+                       QString::number(strength.kalaBala, 'f', 2),
+                       strength.motionKnown ? QString::number(strength.cheshtaBala, 'f', 2)
+                                            : QString("no speed"),
+                       QString("%1 / %2").arg(strength.rupas, 0, 'f', 2)
+                                         .arg(strength.requiredRupas, 0, 'f', 1),
+                       QString::number(strength.vimsopakaBala, 'f', 2)});
+        }
+        table.finish();
+    }
+    
+    // Active yogas
+    page.heading("Active Yogas");
+    if (yogas.isEmpty()) {
+        page.text("No yogas are active in this chart.");
+    } else {
+        TableWriter table(page, {"Yoga", "Description", "Planets", "Strength"},
+                          {0.22, 0.48, 0.18, 0.12});
+        for (const YogaCalculator::Yoga& yoga : yogas) {
+            table.row({yoga.name, yoga.description, yoga.planets().join(", "),
+                       QString("%1%").arg(yoga.strength, 0, 'f', 1)});
+        }
+        table.finish();
+    }
+    
+    return painter.end();
+}
+
+ReportGenerator::Result ReportGenerator::run(const QVector<Job>& jobs) const {
+    // Each worker holds one report in memory at a time
+    const BatchRunner::Result batch = BatchRunner::run(jobs.size(), m_threads, [this, &jobs]() {
+        return BatchRunner::Task([this, &jobs](int index) {
+            return write(jobs[index].filePath, jobs[index].client);
+        });
+    });
+
+    Result result;
+    result.written = batch.succeeded;
+    for (int index : batch.failed) {
+        result.failedPaths.append(jobs[index].filePath);
+    }
+    result.failed = result.failedPaths.size();
+    result.seconds = batch.seconds;
+    return result;
+}
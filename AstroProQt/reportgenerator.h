@@ -0,0 +1,68 @@
+#ifndef REPORTGENERATOR_H
+#define REPORTGENERATOR_H
+
+#include <QDateTime>
+#include <QMap>
+#include <QPageSize>
+#include <QStringList>
+#include <QVector>
+#include "chartrenderer.h"
+
+// Multi-page PDF client reports: rasi and navamsa charts, the Vimshottari
+// dasha table, Shadbala and the active yogas. Pages go to the PDF writer as
+// soon as they are laid out and the dasha levels below the mahadasha are
+// expanded while they are written, so memory per report does not grow with
+// the dasha depth.
+class ReportGenerator {
+public:
+    struct Client {
+        QString name;
+        QDateTime birthTime;
+        QString birthPlace;
+        QMap<QString, double> planetPositions;
+        QMap<QString, double> planetSpeeds;   // Degrees/day; empty if unknown
+        QVector<double> housePositions;
+    };
+
+    struct Job {
+        QString filePath;
+        Client client;
+    };
+
+    struct Options {
+        int dashaDepth;     // 1 = mahadasha ... 5 = prana dasha
+        QPageSize pageSize;
+        ChartRenderer::ChartStyle chartStyle;
+
+        Options() : dashaDepth(2), pageSize(QPageSize::A4),
+                    chartStyle(ChartRenderer::NorthIndian) {}
+    };
+
+    struct Result {
+        int written;
+        int failed;
+        double seconds;
+        QStringList failedPaths;
+
+        Result() : written(0), failed(0), seconds(0) {}
+        double reportsPerMinute() const { return seconds > 0 ? written * 60.0 / seconds : 0.0; }
+    };
+
+    ReportGenerator();
+
+    void setOptions(const Options& options) { m_options = options; }
+    const Options& options() const { return m_options; }
+    void setThreadCount(int threads) { m_threads = threads; }   // 0 = all cores
+
+    // Write one report; safe to call from several threads at once
+    bool write(const QString& filePath, const Client& client) const;
+
+    // Write every job on a private thread pool and block until done
+    Result run(const QVector<Job>& jobs) const;
+
+private:
+    Options m_options;
+    int m_threads;
+};
+
+#endif // REPORTGENERATOR_H
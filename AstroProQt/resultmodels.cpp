@@ -0,0 +1,302 @@
+#include "resultmodels.h"
+
+namespace {
+
+QString formatTime(const QDateTime& time) {
+    return time.toString("dd-MM-yyyy hh:mm");
+}
+
+QString formatDuration(const QDateTime& start, const QDateTime& end) {
+    const double days = start.msecsTo(end) / 86400000.0;
+    if (days >= 365.25) {
+        return QString("%1 years").arg(days / 365.25, 0, 'f', 2);
+    }
+    if (days >= 1.0) {
+        return QString("%1 days").arg(days, 0, 'f', 1);
+    }
+    return QString("%1 hours").arg(days * 24.0, 0, 'f', 1);
+}
+
+} // namespace
+
+// DashaTreeModel
+
+DashaTreeModel::DashaTreeModel(QObject* parent)
+    : QAbstractItemModel(parent)
+    , m_depth(2)
+{
+}
+
+DashaTreeModel::~DashaTreeModel() {
+    clear();
+}
+
+void DashaTreeModel::clear() {
+    // Depth-first, children before their parents
+    QVector<Node*> pending = m_roots;
+    while (!pending.isEmpty()) {
+        Node* node = pending.takeLast();
+        pending += node->children;
+        delete node;
+    }
+    m_roots.clear();
+}
+
+void DashaTreeModel::setPeriods(const QVector<DashaPeriod>& mahadashas) {
+    beginResetModel();
+    clear();
+    m_roots.reserve(mahadashas.size());
+    for (const DashaPeriod& period : mahadashas) {
+        Node* node = new Node{period.planet, period.startTime, period.endTime,
+                              nullptr, m_roots.size(), 0, false, {}};
+        m_roots.append(node);
+    }
+    endResetModel();
+}
+
+void DashaTreeModel::setDepth(int depth) {
+    depth = qBound(1, depth, MaxDepth);
+    if (depth == m_depth) return;
+    
+    // Fetched levels stay valid; only whether nodes may expand changes
+    beginResetModel();
+    m_depth = depth;
+    QVector<Node*> pending = m_roots;
+    while (!pending.isEmpty()) {
+        Node* node = pending.takeLast();
+        if (node->level + 1 >= m_depth) {
+            QVector<Node*> dropped = node->children;
+            while (!dropped.isEmpty()) {
+                Node* child = dropped.takeLast();
+                dropped += child->children;
+                delete child;
+            }
+            node->children.clear();
+            node->fetched = false;
+        } else {
+            pending += node->children;
+        }
+    }
+    endResetModel();
+}
+
+QString DashaTreeModel::levelName(int level) {
+    static const char* const names[MaxDepth] = {
+        "Mahadasha", "Antardasha", "Pratyantardasha", "Sookshma", "Prana"
+    };
+    return level >= 0 && level < MaxDepth ? QString(names[level]) : QString();
+}
+
+DashaTreeModel::Node* DashaTreeModel::nodeFor(const QModelIndex& index) const {
+    return index.isValid() ? static_cast<Node*>(index.internalPointer()) : nullptr;
+}
+
+QModelIndex DashaTreeModel::index(int row, int column, const QModelIndex& parent) const {
+    if (column < 0 || column >= ColumnCount || parent.column() > 0) return QModelIndex();
+    
+    const Node* parentNode = nodeFor(parent);
+    const QVector<Node*>& siblings = parentNode ? parentNode->children : m_roots;
+    if (row < 0 || row >= siblings.size()) return QModelIndex();
+    return createIndex(row, column, siblings[row]);
+}
+
+QModelIndex DashaTreeModel::parent(const QModelIndex& child) const {
+    const Node* node = nodeFor(child);
+    if (!node || !node->parent) return QModelIndex();
+    return createIndex(node->parent->row, 0, node->parent);
+}
+
+int DashaTreeModel::rowCount(const QModelIndex& parent) const {
+    if (parent.column() > 0) return 0;
+    const Node* node = nodeFor(parent);
+    return node ? node->children.size() : m_roots.size();
+}
+
+int DashaTreeModel::columnCount(const QModelIndex& parent) const {
+    Q_UNUSED(parent);
+    return ColumnCount;
+}
+
+bool DashaTreeModel::hasChildren(const QModelIndex& parent) const {
+    const Node* node = nodeFor(parent);
+    if (!node) return !m_roots.isEmpty();
+    // Unfetched periods still show an expander
+    return parent.column() <= 0 && node->level + 1 < m_depth;
+}
+
+bool DashaTreeModel::canFetchMore(const QModelIndex& parent) const {
+    const Node* node = nodeFor(parent);
+    return node && !node->fetched && node->level + 1 < m_depth;
+}
+
+void DashaTreeModel::fetchMore(const QModelIndex& parent) {
+    Node* node = nodeFor(parent);
+    if (!node || node->fetched || node->level + 1 >= m_depth) return;
+    node->fetched = true;
+    
+    DashaPeriod period;
+    period.planet = node->planet;
+    period.startTime = node->startTime;
+    period.endTime = node->endTime;
+    const QVector<DashaPeriod> subPeriods = m_calculator.calculateAntarDasha(period);
+    if (subPeriods.isEmpty()) return;
+    
+    beginInsertRows(parent.sibling(parent.row(), 0), 0, subPeriods.size() - 1);
+    node->children.reserve(subPeriods.size());
+    for (const DashaPeriod& subPeriod : subPeriods) {
+        node->children.append(new Node{subPeriod.planet, subPeriod.startTime, subPeriod.endTime,
+                                       node, node->children.size(), node->level + 1,
+                                       false, {}});
+    }
+    endInsertRows();
+}
+
+QVariant DashaTreeModel::data(const QModelIndex& index, int role) const {
+    const Node* node = nodeFor(index);
+    if (!node) return QVariant();
+    
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case PlanetColumn:   return node->planet;
+        case StartColumn:    return formatTime(node->startTime);
+        case EndColumn:      return formatTime(node->endTime);
+        case DurationColumn: return formatDuration(node->startTime, node->endTime);
+        }
+    } else if (role == SortRole) {
+        switch (index.column()) {
+        case PlanetColumn:   return node->planet;
+        case StartColumn:    return node->startTime;
+        case EndColumn:      return node->endTime;
+        case DurationColumn: return node->startTime.msecsTo(node->endTime);
+        }
+    } else if (role == Qt::ToolTipRole && index.column() == PlanetColumn) {
+        return levelName(node->level);
+    }
+    return QVariant();
+}
+
+QVariant DashaTreeModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    static const char* const headers[ColumnCount] = {
+        "Planet", "Start Time", "End Time", "Duration"
+    };
+    return section >= 0 && section < ColumnCount ? QString(headers[section]) : QVariant();
+}
+
+// StrengthTableModel
+
+namespace {
+
+const char* const strengthHeaders[] = {
+    "Planet", "Shadbala", "Sthanabala", "Digbala",
+    "Drishti Bala", "Kala Bala", "Cheshta Bala", "Naisargika Bala",
+    "Rupas / Required", "Vimsopaka"
+};
+const int StrengthColumnCount = sizeof(strengthHeaders) / sizeof(strengthHeaders[0]);
+
+} // namespace
+
+StrengthTableModel::StrengthTableModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void StrengthTableModel::setStrengths(
+    const QMap<QString, StrengthCalculator::PlanetaryStrength>& strengths) {
+    beginResetModel();
+    m_planets.clear();
+    m_strengths.clear();
+    for (auto it = strengths.constBegin(); it != strengths.constEnd(); ++it) {
+        m_planets.append(it.key());
+        m_strengths.append(it.value());
+    }
+    endResetModel();
+}
+
+int StrengthTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_strengths.size();
+}
+
+int StrengthTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : StrengthColumnCount;
+}
+
+QVariant StrengthTableModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || (role != Qt::DisplayRole && role != SortRole)) return QVariant();
+    
+    const StrengthCalculator::PlanetaryStrength& strength = m_strengths[index.row()];
+    double value = 0;
+    switch (index.column()) {
+    case 0: return m_planets[index.row()];
+    case 1: value = strength.shadbala; break;
+    case 2: value = strength.sthanaBala; break;
+    case 3: value = strength.digBala; break;
+    case 4: value = strength.drishtisBala; break;
+    case 5: value = strength.kalaBala; break;
+    case 6:
+        if (!strength.motionKnown && role != SortRole) return QString("no speed");
+        value = strength.cheshtaBala;
+        break;
+    case 7: value = strength.naisargikaBala; break;
+    case 8:
+        if (role == SortRole) return strength.ratio();
+        return QString("%1 / %2").arg(strength.rupas, 0, 'f', 2)
+                                 .arg(strength.requiredRupas, 0, 'f', 1);
+    case 9: value = strength.vimsopakaBala; break;
+    default: return QVariant();
+    }
+    return role == SortRole ? QVariant(value) : QVariant(QString::number(value, 'f', 2));
+}
+
+QVariant StrengthTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    return section >= 0 && section < StrengthColumnCount ? QString(strengthHeaders[section])
+                                                         : QVariant();
+}
+
+// YogaTableModel
+
+YogaTableModel::YogaTableModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void YogaTableModel::setYogas(const QVector<YogaCalculator::Yoga>& yogas) {
+    beginResetModel();
+    m_yogas = yogas;
+    endResetModel();
+}
+
+int YogaTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_yogas.size();
+}
+
+int YogaTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : 4;
+}
+
+QVariant YogaTableModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid()) return QVariant();
+    const YogaCalculator::Yoga& yoga = m_yogas[index.row()];
+    
+    if (role == Qt::DisplayRole || role == SortRole) {
+        switch (index.column()) {
+        case 0: return yoga.name;
+        case 1: return yoga.description;
+        case 2: return yoga.planets().join(", ");
+        case 3:
+            if (role == SortRole) return yoga.strength;
+            return QString::number(yoga.strength, 'f', 1) + "%";
+        }
+    } else if (role == Qt::ToolTipRole && index.column() == 0) {
+        // The conditions that formed the yoga
+        return yoga.conditions.join("\n");
+    }
+    return QVariant();
+}
+
+QVariant YogaTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    static const char* const headers[] = {"Yoga Name", "Description", "Planets", "Strength"};
+    return section >= 0 && section < 4 ? QString(headers[section]) : QVariant();
+}
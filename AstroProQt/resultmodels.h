@@ -0,0 +1,113 @@
+#ifndef RESULTMODELS_H
+#define RESULTMODELS_H
+
+#include <QAbstractItemModel>
+#include <QAbstractTableModel>
+#include <QMap>
+#include <QVector>
+#include "Calculators/dashacalculator.h"
+#include "Calculators/strengthcalculator.h"
+#include "Calculators/yogacalculator.h"
+
+// Item models over the calculator outputs. Display text is formatted on
+// demand for the rows a view asks for; SortRole gives the raw value so a
+// QSortFilterProxyModel orders numbers and dates correctly.
+enum ResultRole {
+    SortRole = Qt::UserRole
+};
+
+// Vimshottari periods as a tree, mahadasha to prana dasha. Only the
+// mahadashas exist up front; the periods under a node are calculated when
+// a view first expands it (fetchMore).
+class DashaTreeModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        PlanetColumn,
+        StartColumn,
+        EndColumn,
+        DurationColumn,
+        ColumnCount
+    };
+
+    static const int MaxDepth = 5;
+
+    explicit DashaTreeModel(QObject* parent = nullptr);
+    ~DashaTreeModel() override;
+
+    void setPeriods(const QVector<DashaPeriod>& mahadashas);
+    void setDepth(int depth);   // Levels shown, 1 (mahadasha) to MaxDepth
+    int depth() const { return m_depth; }
+
+    static QString levelName(int level);
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    struct Node {
+        QString planet;
+        QDateTime startTime;
+        QDateTime endTime;
+        Node* parent;
+        int row;
+        int level;
+        bool fetched;
+        QVector<Node*> children;
+    };
+
+    Node* nodeFor(const QModelIndex& index) const;
+    void clear();
+
+    QVector<Node*> m_roots;
+    int m_depth;
+    DashaCalculator m_calculator;
+};
+
+class StrengthTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    explicit StrengthTableModel(QObject* parent = nullptr);
+
+    void setStrengths(const QMap<QString, StrengthCalculator::PlanetaryStrength>& strengths);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    QVector<QString> m_planets;
+    QVector<StrengthCalculator::PlanetaryStrength> m_strengths;
+};
+
+class YogaTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    explicit YogaTableModel(QObject* parent = nullptr);
+
+    void setYogas(const QVector<YogaCalculator::Yoga>& yogas);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    QVector<YogaCalculator::Yoga> m_yogas;
+};
+
+#endif // RESULTMODELS_H
@@ -0,0 +1,86 @@
+#include "siderealephemeris.h"
+#include "perfcounters.h"
+#include "Calculators/planetdata.h"
+#include "swephexp.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtMath>
+#include <cmath>
+
+namespace {
+
+// Swiss Ephemeris body of each Astro::Planet; Ketu is opposite Rahu
+const int EphemerisBody[Astro::PlanetCount] = {
+    SE_SUN, SE_MOON, SE_MARS, SE_MERCURY, SE_JUPITER, SE_VENUS, SE_SATURN,
+    SE_MEAN_NODE, SE_MEAN_NODE
+};
+
+// The Swiss Ephemeris keeps its sidereal mode, file handles and caches in
+// globals and is not thread-safe unless built with TLS; every call holds this
+QMutex& ephemerisMutex() {
+    static QMutex mutex;
+    return mutex;
+}
+
+} // namespace
+
+void SiderealEphemeris::setUp(const QString& ephemerisPath) {
+    QMutexLocker locker(&ephemerisMutex());
+    if (!ephemerisPath.isEmpty()) {
+        QByteArray path = ephemerisPath.toLocal8Bit();
+        swe_set_ephe_path(path.data());
+    }
+    swe_set_sid_mode(SE_SIDM_LAHIRI, 0, 0);
+}
+
+double SiderealEphemeris::julianDay(const QDateTime& time) {
+    return time.toMSecsSinceEpoch() / 86400000.0 + 2440587.5;
+}
+
+bool SiderealEphemeris::longitude(double julianDay, int planet, double* longitude,
+                                  QString* error) {
+    double xx[6] = {0};
+    char serr[256] = {0};
+    double ayanamsa = 0;
+    bool found;
+    {
+        QMutexLocker locker(&ephemerisMutex());
+        PERF_REGION("Ephemeris");
+        found = swe_calc_ut(julianDay, EphemerisBody[planet], 0, xx, serr) >= 0;
+        if (found) ayanamsa = swe_get_ayanamsa_ut(julianDay);
+    }
+    if (!found) {
+        *error = QString("Ephemeris: %1").arg(QString::fromLatin1(serr));
+        return false;
+    }
+    const double offset = planet == Astro::Ketu ? 180.0 : 0.0;
+    *longitude = Astro::normalizeDegrees(xx[0] + offset - ayanamsa);
+    return true;
+}
+
+bool SiderealEphemeris::speed(double julianDay, int planet, double* speed, QString* error) {
+    double before, after;
+    if (!longitude(julianDay - SPEED_DELTA, planet, &before, error) ||
+        !longitude(julianDay + SPEED_DELTA, planet, &after, error)) {
+        return false;
+    }
+    *speed = std::remainder(after - before, 360.0) / (2.0 * SPEED_DELTA);
+    return true;
+}
+
+double SiderealEphemeris::ascendant(double julianDay, double latitude, double longitude) {
+    double siderealTime;
+    double ayanamsa;
+    {
+        QMutexLocker locker(&ephemerisMutex());
+        siderealTime = swe_sidtime(julianDay);
+        ayanamsa = swe_get_ayanamsa_ut(julianDay);
+    }
+    const double ramc = qDegreesToRadians(siderealTime * 15.0 + longitude);
+    const double obliquity = qDegreesToRadians(OBLIQUITY);
+    const double phi = qDegreesToRadians(qBound(-89.9, latitude, 89.9));
+    const double tropical = qRadiansToDegrees(std::atan2(
+        std::cos(ramc),
+        -(std::sin(ramc) * std::cos(obliquity) + std::tan(phi) * std::sin(obliquity))));
+    return Astro::normalizeDegrees(tropical - ayanamsa);
+}
@@ -0,0 +1,28 @@
+#ifndef SIDEREALEPHEMERIS_H
+#define SIDEREALEPHEMERIS_H
+
+#include <QDateTime>
+#include <QString>
+
+// Sidereal (Lahiri) longitudes from the Swiss Ephemeris, shared by the live
+// chart and the chart service. The Swiss Ephemeris keeps global state and is
+// not thread-safe, so every call into it is serialized behind one process-wide
+// mutex; setUp() runs once per process before any thread asks for positions.
+class SiderealEphemeris {
+public:
+    static void setUp(const QString& ephemerisPath = QString());
+
+    static double julianDay(const QDateTime& time);
+    // Sidereal longitude of an Astro::Planet; Ketu is opposite Rahu
+    static bool longitude(double julianDay, int planet, double* longitude, QString* error);
+    // Daily motion in degrees, negative when retrograde, from the longitudes
+    // SPEED_DELTA days either side
+    static bool speed(double julianDay, int planet, double* speed, QString* error);
+    // Sidereal ascendant from the sidereal time and the obliquity
+    static double ascendant(double julianDay, double latitude, double longitude);
+
+    static constexpr double OBLIQUITY = 23.4392911;   // Mean obliquity at J2000, degrees
+    static constexpr double SPEED_DELTA = 0.5;        // Days
+};
+
+#endif // SIDEREALEPHEMERIS_H
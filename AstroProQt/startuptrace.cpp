@@ -0,0 +1,145 @@
+#include "startuptrace.h"
+#include <QCoreApplication>
+#include <QEvent>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWidget>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+QString currentThreadName() {
+    const QCoreApplication* app = QCoreApplication::instance();
+    return !app || QThread::currentThread() == app->thread() ? "main" : "warm-up";
+}
+
+// Marks the first paint of a widget, then removes itself
+class FirstPaintFilter : public QObject {
+public:
+    explicit FirstPaintFilter(QObject* parent) : QObject(parent) {}
+
+    bool eventFilter(QObject* watched, QEvent* event) override {
+        if (event->type() == QEvent::Paint) {
+            watched->removeEventFilter(this);
+            StartupTrace::instance().firstPaintSeen();
+            deleteLater();
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+StartupTrace::Scope::Scope(const QString& name)
+    : m_name(name)
+    , m_start(StartupTrace::instance().elapsed()) {
+}
+
+StartupTrace::Scope::~Scope() {
+    StartupTrace& trace = StartupTrace::instance();
+    trace.record(m_name, m_start, trace.elapsed());
+}
+
+StartupTrace::StartupTrace()
+    : m_enabled(false)
+    , m_awaitingPaint(false)
+    , m_finishRequested(false)
+    , m_finished(false) {
+}
+
+StartupTrace& StartupTrace::instance() {
+    static StartupTrace trace;
+    return trace;
+}
+
+void StartupTrace::start() {
+    QMutexLocker locker(&m_mutex);
+    m_clock.start();
+    m_phases.clear();
+    m_awaitingPaint = false;
+    m_finishRequested = false;
+    m_finished = false;
+}
+
+void StartupTrace::setEnabled(bool enabled) {
+    QMutexLocker locker(&m_mutex);
+    m_enabled = enabled;
+}
+
+bool StartupTrace::isEnabled() const {
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+qint64 StartupTrace::elapsed() const {
+    return m_clock.isValid() ? m_clock.nsecsElapsed() : 0;
+}
+
+void StartupTrace::record(const QString& name, qint64 start, qint64 end) {
+    const Phase phase = {name, currentThreadName(), start, end};
+    QMutexLocker locker(&m_mutex);
+    m_phases.append(phase);
+}
+
+void StartupTrace::mark(const QString& name) {
+    const qint64 now = elapsed();
+    record(name, now, now);
+}
+
+void StartupTrace::markFirstPaint(QWidget* widget) {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_awaitingPaint = true;
+    }
+    widget->installEventFilter(new FirstPaintFilter(widget));
+}
+
+void StartupTrace::firstPaintSeen() {
+    mark("First paint");
+    bool finishNow;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_awaitingPaint = false;
+        finishNow = m_finishRequested;
+    }
+    if (finishNow) finish();
+}
+
+QVector<StartupTrace::Phase> StartupTrace::phases() const {
+    QMutexLocker locker(&m_mutex);
+    return m_phases;
+}
+
+QString StartupTrace::report() const {
+    QVector<Phase> phases = this->phases();
+    std::stable_sort(phases.begin(), phases.end(), [](const Phase& a, const Phase& b) {
+        return a.start < b.start;
+    });
+
+    QString text = "Startup trace (ms from the top of main)\n";
+    text += QString("  %1 %2 %3  %4\n").arg("Phase", -28).arg("Start", 9).arg("Took", 9).arg("Thread");
+    qint64 last = 0;
+    for (const Phase& phase : phases) {
+        const QString took = phase.end > phase.start
+            ? QString::number((phase.end - phase.start) / 1e6, 'f', 2) : QString("-");
+        text += QString("  %1 %2 %3  %4\n")
+            .arg(phase.name, -28)
+            .arg(QString::number(phase.start / 1e6, 'f', 2), 9)
+            .arg(took, 9)
+            .arg(phase.thread);
+        last = qMax(last, phase.end);
+    }
+    text += QString("  %1 %2\n").arg("Total", -28).arg(QString::number(last / 1e6, 'f', 2), 9);
+    return text;
+}
+
+void StartupTrace::finish() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_finishRequested = true;
+        if (!m_enabled || m_finished || m_awaitingPaint) return;
+        m_finished = true;
+    }
+    std::fputs(report().toLocal8Bit().constData(), stderr);
+}
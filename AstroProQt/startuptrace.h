@@ -0,0 +1,63 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+class QWidget;
+
+// Times the phases of application startup, from the top of main() until
+// the background warm-up has finished. Phases may be recorded from any
+// thread. With --startup-trace the breakdown is printed to stderr.
+class StartupTrace {
+public:
+    struct Phase {
+        QString name;
+        QString thread;     // "main" or "warm-up"
+        qint64 start;       // Nanoseconds since start()
+        qint64 end;
+    };
+
+    // Records the enclosing block as a phase
+    class Scope {
+    public:
+        explicit Scope(const QString& name);
+        ~Scope();
+
+    private:
+        QString m_name;
+        qint64 m_start;
+    };
+
+    static StartupTrace& instance();
+
+    void start();
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    qint64 elapsed() const;
+
+    void record(const QString& name, qint64 start, qint64 end);
+    void mark(const QString& name);             // A moment rather than a phase
+    // Marks the widget's first paint; the report waits for it
+    void markFirstPaint(QWidget* widget);
+    void firstPaintSeen();
+
+    QVector<Phase> phases() const;
+    QString report() const;
+    void finish();                              // Prints the report once, if enabled
+
+private:
+    StartupTrace();
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QVector<Phase> m_phases;
+    bool m_enabled;
+    bool m_awaitingPaint;
+    bool m_finishRequested;
+    bool m_finished;
+};
+
+#endif // STARTUPTRACE_H
@@ -0,0 +1,110 @@
+#include "startupwarmup.h"
+#include "startuptrace.h"
+#include <QDir>
+#include <QFile>
+#include <QRunnable>
+
+namespace {
+
+const qint64 PageSize = 4096;
+const qint64 ReadChunk = 1 << 20;   // When a file cannot be mapped
+
+class WarmupRunner : public QRunnable {
+public:
+    WarmupRunner(const QVector<std::function<void()>>& tasks, QAtomicInt& running, QObject* owner)
+        : m_tasks(tasks)
+        , m_running(running)
+        , m_owner(owner) {}
+
+    void run() override {
+        for (const std::function<void()>& task : m_tasks) {
+            task();
+        }
+        m_running.storeRelease(0);
+        QMetaObject::invokeMethod(m_owner, "finished", Qt::QueuedConnection);
+    }
+
+private:
+    QVector<std::function<void()>> m_tasks;
+    QAtomicInt& m_running;
+    QObject* m_owner;
+};
+
+} // namespace
+
+StartupWarmup::StartupWarmup(QObject* parent)
+    : QObject(parent)
+    , m_running(0)
+    , m_started(false) {
+    // One thread keeps the disk reads sequential and leaves the other
+    // cores to the interface
+    m_pool.setMaxThreadCount(1);
+}
+
+StartupWarmup::~StartupWarmup() {
+    m_pool.waitForDone();
+}
+
+void StartupWarmup::addTask(const QString& name, const std::function<void()>& task) {
+    m_tasks.append({name, task});
+}
+
+void StartupWarmup::start() {
+    if (m_started) {
+        return;
+    }
+    m_started = true;
+    m_running.store(1);
+
+    QVector<std::function<void()>> traced;
+    for (const Task& task : m_tasks) {
+        const std::function<void()> run = task.run;
+        const QString name = task.name;
+        traced.append([name, run]() {
+            StartupTrace::Scope scope(name);
+            run();
+        });
+    }
+    m_tasks.clear();
+    m_pool.start(new WarmupRunner(traced, m_running, this));
+}
+
+void StartupWarmup::waitForFinished() {
+    if (isRunning()) {
+        StartupTrace::Scope scope("Waiting for warm-up");
+        m_pool.waitForDone();
+    }
+}
+
+qint64 StartupWarmup::prefetchFile(const QString& filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    const qint64 size = file.size();
+    if (size <= 0) {
+        return 0;
+    }
+
+    // Touch one byte per page; the sum keeps the reads from being dropped
+    volatile uchar sink = 0;
+    if (const uchar* data = file.map(0, size)) {
+        for (qint64 offset = 0; offset < size; offset += PageSize) {
+            sink = sink + data[offset];
+        }
+        file.unmap(const_cast<uchar*>(data));
+    } else {
+        while (!file.read(ReadChunk).isEmpty()) {
+        }
+    }
+    return size;
+}
+
+qint64 StartupWarmup::prefetchDirectory(const QString& path, const QStringList& nameFilters) {
+    qint64 total = 0;
+    const QDir dir(path);
+    for (const QString& name : dir.entryList(nameFilters, QDir::Files | QDir::Readable)) {
+        total += prefetchFile(dir.filePath(name));
+    }
+    return total;
+}
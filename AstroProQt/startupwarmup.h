@@ -0,0 +1,49 @@
+#ifndef STARTUPWARMUP_H
+#define STARTUPWARMUP_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+
+// Runs the startup work that the first paint does not need on one
+// background thread, in the order it was added: opening and validating the
+// location data, and paging in the ephemeris and star catalog files. Each
+// task is traced as a startup phase. Code that needs a task's result calls
+// waitForFinished() first.
+class StartupWarmup : public QObject {
+    Q_OBJECT
+
+public:
+    explicit StartupWarmup(QObject* parent = nullptr);
+    ~StartupWarmup();
+
+    void addTask(const QString& name, const std::function<void()>& task);
+    void start();
+    bool isStarted() const { return m_started; }
+    bool isRunning() const { return m_running.loadAcquire() != 0; }
+    void waitForFinished();
+
+    // Reads the files through a mapping so their pages are resident when
+    // the calculations first touch them
+    static qint64 prefetchFile(const QString& filePath);
+    static qint64 prefetchDirectory(const QString& path, const QStringList& nameFilters);
+
+signals:
+    void finished();
+
+private:
+    struct Task {
+        QString name;
+        std::function<void()> run;
+    };
+
+    QVector<Task> m_tasks;
+    QThreadPool m_pool;
+    QAtomicInt m_running;
+    bool m_started;
+};
+
+#endif // STARTUPWARMUP_H
@@ -22,7 +22,7 @@ int swe_calc(double tjd, int ipl, int iflag, double *xx, char *serr) {
             xx[2] = 1.0; // Distance in AU
             return 0;
             
-        case SE_MOON:
+        case SE_MOON: {
             /* Simplified lunar position calculation */
             double D = tjd - 2451545.0; // Days since J2000
             double L = fmod(218.316 + 13.176396 * D, 360.0); // Mean longitude
@@ -32,6 +32,7 @@ int swe_calc(double tjd, int ipl, int iflag, double *xx, char *serr) {
             xx[1] = 5.128 * sin(M * M_PI / 180.0); // Latitude
             xx[2] = 60.27; // Distance in Earth radii
             return 0;
+        }
             
         default:
             if (serr) {
@@ -6,6 +6,9 @@
 extern "C" {
 #endif
 
+/* Integer type of the ephemeris flags, as in sweodef.h */
+typedef int int32;
+
 #define SE_AUNIT_TO_KM        (149597870.700)
 #define SE_MOON_MEAN_DIST     (384400.0)
 #define SE_MOON_MEAN_INCL     (5.1453964)
@@ -0,0 +1,49 @@
+// Builds the offline gazetteer used for place search.
+//
+//   gazetteer_build cities500.txt gazetteer.bin [admin1CodesASCII.txt] [min-population]
+//
+// The inputs are GeoNames dumps from https://download.geonames.org/export/dump/.
+// Copy the output to geo/gazetteer.bin next to the executable, or to the
+// application data directory.
+
+#include "Location/gazetteer.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <geonames.txt> <output.bin> [admin1CodesASCII.txt] [min-population]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    GazetteerBuilder builder;
+
+    if (argc > 3) {
+        QFile admin(QString::fromLocal8Bit(argv[3]));
+        if (!builder.readAdminNames(admin)) {
+            std::fprintf(stderr, "cannot read %s\n", argv[3]);
+            return 1;
+        }
+    }
+
+    const quint32 minimumPopulation = argc > 4 ? quint32(std::strtoul(argv[4], nullptr, 10)) : 0;
+    QFile input(QString::fromLocal8Bit(argv[1]));
+    if (!input.open(QIODevice::ReadOnly)) {
+        std::fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+    const int places = builder.readGeoNames(input, minimumPopulation);
+
+    QString error;
+    if (!builder.write(QString::fromLocal8Bit(argv[2]), &error)) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+    std::printf("%d places written to %s in %lld ms\n", places, argv[2], timer.elapsed());
+    return 0;
+}
@@ -0,0 +1,201 @@
+// Drives astro_service over keep-alive connections and reports throughput
+// and latency percentiles.
+//
+//   service_load [--host 127.0.0.1] [--port 8547] [--connections 16]
+//                [--duration 10] [--path /chart] [--same-instant] [--positions]
+//
+// Each connection sends its next request as soon as the previous response
+// arrives. --same-instant asks every query about one birth time, so the
+// service can batch them; otherwise times are spread over a century.
+// --positions sends all nine longitudes so no ephemeris files are needed.
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+const char* const PlanetNames[] = {
+    "Sun", "Moon", "Mars", "Mercury", "Jupiter", "Venus", "Saturn", "Rahu", "Ketu"
+};
+
+struct Settings {
+    QString host = "127.0.0.1";
+    quint16 port = 8547;
+    int connections = 16;
+    int durationSeconds = 10;
+    QByteArray path = "/chart";
+    bool sameInstant = false;
+    bool positions = false;
+};
+
+struct Results {
+    QVector<qint64> latenciesNs;
+    QMap<int, int> statuses;
+    int failedConnections = 0;
+};
+
+class LoadConnection {
+public:
+    LoadConnection(const Settings& settings, Results* results, quint32 seed)
+        : m_settings(settings), m_results(results), m_random(seed), m_expected(-1) {
+        QObject::connect(&m_socket, &QTcpSocket::connected, [this]() {
+            m_connected = true;
+            sendRequest();
+        });
+        QObject::connect(&m_socket, &QTcpSocket::readyRead, [this]() { readResponse(); });
+    }
+
+    void start() { m_socket.connectToHost(m_settings.host, m_settings.port); }
+    void stop() {
+        m_stopped = true;
+        if (!m_connected) ++m_results->failedConnections;
+        m_socket.abort();
+    }
+
+private:
+    QByteArray body() {
+        QDateTime time = QDateTime(QDate(1990, 6, 15), QTime(12, 0), Qt::UTC);
+        if (!m_settings.sameInstant) {
+            time = QDateTime::fromSecsSinceEpoch(
+                qint64(m_random.bounded(3155760000.0)) - 2208988800LL, Qt::UTC);
+        }
+        QJsonObject query;
+        query["time"] = time.toString(Qt::ISODate);
+        query["latitude"] = 28.61;
+        query["longitude"] = 77.21;
+        if (m_settings.positions) {
+            QRandomGenerator positionRandom(quint32(time.toSecsSinceEpoch()));
+            QJsonObject longitudes;
+            for (const char* planet : PlanetNames) {
+                longitudes[planet] = positionRandom.bounded(360.0);
+            }
+            longitudes["Ketu"] = std::fmod(longitudes["Rahu"].toDouble() + 180.0, 360.0);
+            query["positions"] = longitudes;
+            query["ascendant"] = positionRandom.bounded(360.0);
+        }
+        return QJsonDocument(query).toJson(QJsonDocument::Compact);
+    }
+
+    void sendRequest() {
+        if (m_stopped) return;
+        const QByteArray payload = body();
+        QByteArray request = "POST " + m_settings.path + " HTTP/1.1\r\n";
+        request += "Host: " + m_settings.host.toLatin1() + "\r\n";
+        request += "Content-Type: application/json\r\n";
+        request += "Content-Length: " + QByteArray::number(payload.size()) + "\r\n\r\n";
+        m_timer.start();
+        m_socket.write(request + payload);
+    }
+
+    void readResponse() {
+        m_buffer += m_socket.readAll();
+        while (true) {
+            const int headerEnd = m_buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0) return;
+            if (m_expected < 0) {
+                m_expected = 0;
+                const QByteArray head = m_buffer.left(headerEnd).toLower();
+                const int length = head.indexOf("content-length:");
+                if (length >= 0) {
+                    const int end = head.indexOf("\r\n", length);
+                    m_expected = head.mid(length + 15, end < 0 ? -1 : end - length - 15)
+                                     .trimmed().toInt();
+                }
+            }
+            if (m_buffer.size() < headerEnd + 4 + m_expected) return;
+
+            const int status = m_buffer.mid(9, 3).toInt();
+            m_results->latenciesNs.append(m_timer.nsecsElapsed());
+            ++m_results->statuses[status];
+            m_buffer.remove(0, headerEnd + 4 + m_expected);
+            m_expected = -1;
+            sendRequest();
+        }
+    }
+
+    const Settings& m_settings;
+    Results* m_results;
+    QRandomGenerator m_random;
+    QTcpSocket m_socket;
+    QElapsedTimer m_timer;
+    QByteArray m_buffer;
+    int m_expected;         // Body bytes of the response being read; -1 before its header
+    bool m_connected = false;
+    bool m_stopped = false;
+};
+
+qint64 percentile(const QVector<qint64>& sorted, double fraction) {
+    if (sorted.isEmpty()) return 0;
+    const int index = qMin(sorted.size() - 1, int(fraction * sorted.size()));
+    return sorted[index];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--host") && hasValue) settings.host = argv[++i];
+        else if (!std::strcmp(argv[i], "--port") && hasValue) settings.port = quint16(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--connections") && hasValue) settings.connections = qMax(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--duration") && hasValue) settings.durationSeconds = qMax(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--path") && hasValue) settings.path = argv[++i];
+        else if (!std::strcmp(argv[i], "--same-instant")) settings.sameInstant = true;
+        else if (!std::strcmp(argv[i], "--positions")) settings.positions = true;
+        else {
+            std::fprintf(stderr, "usage: %s [--host address] [--port n] [--connections n] "
+                                 "[--duration seconds] [--path /chart|/dasha|/yogas] "
+                                 "[--same-instant] [--positions]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Results results;
+    QVector<LoadConnection*> connections;
+    for (int i = 0; i < settings.connections; ++i) {
+        connections.append(new LoadConnection(settings, &results, 20240415u + quint32(i)));
+        connections.last()->start();
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QTimer::singleShot(settings.durationSeconds * 1000, &app, [&]() {
+        for (LoadConnection* connection : connections) connection->stop();
+        QCoreApplication::quit();
+    });
+    app.exec();
+    const double seconds = elapsed.nsecsElapsed() / 1e9;
+    qDeleteAll(connections);
+
+    QVector<qint64> sorted = results.latenciesNs;
+    std::sort(sorted.begin(), sorted.end());
+    std::printf("%d connections, %.1f s, %s%s\n", settings.connections, seconds,
+                settings.path.constData(), settings.sameInstant ? ", same instant" : "");
+    std::printf("requests  %d (%.1f/s)\n", sorted.size(), sorted.size() / seconds);
+    for (auto it = results.statuses.constBegin(); it != results.statuses.constEnd(); ++it) {
+        std::printf("  status %d  %d\n", it.key(), it.value());
+    }
+    if (results.failedConnections > 0) {
+        std::printf("failed connections  %d\n", results.failedConnections);
+    }
+    std::printf("latency   p50 %.3f ms  p90 %.3f ms  p99 %.3f ms  max %.3f ms\n",
+                percentile(sorted, 0.50) / 1e6, percentile(sorted, 0.90) / 1e6,
+                percentile(sorted, 0.99) / 1e6, sorted.isEmpty() ? 0.0 : sorted.last() / 1e6);
+    return sorted.isEmpty() ? 1 : 0;
+}
@@ -0,0 +1,47 @@
+// Builds the offline time zone index used to place birth times.
+//
+//   timezone_build combined.json timezones.bin [cells-per-degree] [tolerance]
+//
+// The input is a GeoJSON release of timezone-boundary-builder
+// (https://github.com/evansiroky/timezone-boundary-builder/releases). Offset
+// transitions come from the tz database of the Qt installation running the
+// tool. Copy the output to geo/timezones.bin next to the executable, or to
+// the application data directory.
+
+#include "Location/timezoneindex.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <combined.json> <output.bin> [cells-per-degree] [tolerance]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    TimeZoneIndexBuilder builder;
+    if (argc > 3) builder.setCellsPerDegree(std::atoi(argv[3]));
+    if (argc > 4) builder.setSimplifyTolerance(std::atof(argv[4]));
+
+    QFile input(QString::fromLocal8Bit(argv[1]));
+    QString error;
+    if (!builder.readGeoJson(input, &error)) {
+        std::fprintf(stderr, "cannot read %s: %s\n", argv[1], qPrintable(error));
+        return 1;
+    }
+    for (const QString& zone : builder.unknownZones()) {
+        std::fprintf(stderr, "warning: %s is not in the tz database\n", qPrintable(zone));
+    }
+
+    if (!builder.write(QString::fromLocal8Bit(argv[2]), &error)) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+    std::printf("%d polygons written to %s in %lld ms\n", builder.polygonCount(), argv[2],
+                timer.elapsed());
+    return 0;
+}